@@ -0,0 +1,79 @@
+#include "backtest/synthetic_feed.h"
+#include "market_data/bar_aggregator.h"
+#include "websocket/mock_kraken_feed.h"
+#include "websocket/trade_message_parser.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+
+// Trade prints for a synthetic pair, as the mock server would send them.
+const std::vector<std::string_view>& TradeMessages() {
+    static const MockFeed feed = [] {
+        MockFeedOptions options;
+        options.book = false;
+        return BuildMockFeed(GeneratePairCandles(2000, "BTC/USD", "ETH/USD", 0), options);
+    }();
+    static const std::vector<std::string_view> messages = [] {
+        std::vector<std::string_view> trades;
+        for (const MockFeedMessage& message : feed.messages) {
+            if (message.channel == MockChannel::TRADE) trades.push_back(feed.Text(message));
+        }
+        return trades;
+    }();
+    return messages;
+}
+
+const std::vector<TradeTick>& Trades() {
+    static const std::vector<TradeTick> trades = [] {
+        std::vector<TradeTick> ticks;
+        TradeTick scratch = {};
+        for (std::string_view message : TradeMessages()) {
+            ParseTradeMessage(message.data(), message.size(), scratch,
+                              [&ticks](const TradeTick& trade) { ticks.push_back(trade); });
+        }
+        return ticks;
+    }();
+    return trades;
+}
+
+// One OnTrade per item; the bar callback stands in for the pipeline.
+void BM_AggregateTrades(benchmark::State& state, BarSpec spec) {
+    const std::vector<TradeTick>& trades = Trades();
+    BarAggregator aggregator(spec);
+    aggregator.SetBarCallback([](const Candle& bar) { benchmark::DoNotOptimize(bar.close); });
+
+    for (auto _ : state) {
+        for (const TradeTick& trade : trades) {
+            aggregator.OnTrade(trade);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * trades.size()));
+    state.counters["bars"] = static_cast<double>(aggregator.BarsEmitted());
+}
+
+// Parse and aggregate, as the trade socket thread runs them.
+void BM_ParseAndAggregateTrades(benchmark::State& state) {
+    const std::vector<std::string_view>& messages = TradeMessages();
+    BarAggregator aggregator(BarSpec{BarType::TIME, 1.0});
+    aggregator.SetBarCallback([](const Candle& bar) { benchmark::DoNotOptimize(bar.close); });
+    TradeTick scratch = {};
+    std::function<void(const TradeTick&)> on_trade = [&aggregator](const TradeTick& trade) {
+        aggregator.OnTrade(trade);
+    };
+
+    for (auto _ : state) {
+        for (std::string_view message : messages) {
+            benchmark::DoNotOptimize(ParseTradeMessage(message.data(), message.size(), scratch, on_trade));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * messages.size()));
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_AggregateTrades, time_1s, BarSpec{BarType::TIME, 1.0});
+BENCHMARK_CAPTURE(BM_AggregateTrades, tick_100, BarSpec{BarType::TICK, 100.0});
+BENCHMARK_CAPTURE(BM_AggregateTrades, volume_10, BarSpec{BarType::VOLUME, 10.0});
+BENCHMARK_CAPTURE(BM_AggregateTrades, dollar_1m, BarSpec{BarType::DOLLAR, 1e6});
+BENCHMARK(BM_ParseAndAggregateTrades);
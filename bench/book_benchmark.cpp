@@ -0,0 +1,88 @@
+#include "backtest/synthetic_feed.h"
+#include "websocket/book_message_parser.h"
+#include "websocket/mock_kraken_feed.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Book snapshots and updates for a synthetic pair, as the mock server
+// would send them, in arrival order.
+const std::vector<std::string_view>& BookMessages() {
+    static const MockFeed feed = [] {
+        MockFeedOptions options;
+        options.trades = false;
+        return BuildMockFeed(GeneratePairCandles(2000, "BTC/USD", "ETH/USD", 0), options);
+    }();
+    static const std::vector<std::string_view> messages = [] {
+        std::vector<std::string_view> books;
+        for (const MockFeedMessage& message : feed.messages) {
+            if (message.channel == MockChannel::BOOK) books.push_back(feed.Text(message));
+        }
+        return books;
+    }();
+    return messages;
+}
+
+// Keeps one book per symbol and checks every checksum, like the stream.
+class VerifyingHandler : public BookMessageHandler {
+public:
+    explicit VerifyingHandler(size_t depth) : books_(SymbolRegistry::kMaxSymbols), depth_(depth), mismatches_(0) {}
+
+    OrderBook* BeginBook(SymbolId symbol, bool snapshot) override {
+        if (!books_[symbol]) books_[symbol] = std::make_unique<OrderBook>(depth_);
+        if (snapshot) books_[symbol]->Clear();
+        return books_[symbol].get();
+    }
+
+    void EndBook(SymbolId symbol, OrderBook& book, uint32_t checksum, int64_t timestamp) override {
+        (void)timestamp;
+        if (book.Checksum() != checksum) mismatches_++;
+        if (book.HasTop()) benchmark::DoNotOptimize(book.Top(symbol, timestamp).Microprice());
+    }
+
+    uint64_t Mismatches() const { return mismatches_; }
+
+private:
+    std::vector<std::unique_ptr<OrderBook>> books_;
+    size_t depth_;
+    uint64_t mismatches_;
+};
+
+// Parse, apply in place, truncate and verify, per message.
+void BM_ApplyBookFeed(benchmark::State& state) {
+    const std::vector<std::string_view>& messages = BookMessages();
+    VerifyingHandler handler(10);
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (std::string_view message : messages) {
+            benchmark::DoNotOptimize(ParseBookMessage(message.data(), message.size(), handler));
+            bytes += message.size();
+        }
+    }
+    if (handler.Mismatches() != 0) {
+        state.SkipWithError("book checksum mismatch");
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * messages.size()));
+}
+
+// The checksum alone over a full ten-level book.
+void BM_BookChecksum(benchmark::State& state) {
+    OrderBook book(10);
+    book.SetDecimals(1, 8);
+    for (int64_t i = 0; i < 10; i++) {
+        book.ApplyBid(650000 - i * 7, 12345678 + i);
+        book.ApplyAsk(650007 + i * 7, 87654321 - i);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(book.Checksum());
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_ApplyBookFeed);
+BENCHMARK(BM_BookChecksum);
@@ -0,0 +1,64 @@
+#include "market_data/decimal.h"
+#include <benchmark/benchmark.h>
+#include <charconv>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+
+// Prices and quantities as Kraken prints them.
+const std::string_view kTexts[] = {
+    "68123.4", "0.10000000", "3009.27", "1.50901623", "0.000012", "152.45", "0.00500000", "2.1e-05"
+};
+
+void BM_DecimalFromChars(benchmark::State& state) {
+    Decimal value;
+    for (auto _ : state) {
+        for (std::string_view text : kTexts) {
+            benchmark::DoNotOptimize(FromChars(text.data(), text.data() + text.size(), value));
+            benchmark::DoNotOptimize(value);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * std::size(kTexts)));
+}
+
+// What the same fields cost parsed as doubles.
+void BM_StrtodBaseline(benchmark::State& state) {
+    for (auto _ : state) {
+        for (std::string_view text : kTexts) {
+            benchmark::DoNotOptimize(std::strtod(text.data(), nullptr));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * std::size(kTexts)));
+}
+
+// Formatting an order's quantity and limit price.
+void BM_DecimalToChars(benchmark::State& state) {
+    const Decimal values[] = {{150901623, 8}, {681234, 1}, {500000, 8}, {21, 6}};
+    char buffer[32];
+    for (auto _ : state) {
+        for (const Decimal& value : values) {
+            benchmark::DoNotOptimize(ToChars(buffer, buffer + sizeof(buffer), value));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * std::size(values)));
+}
+
+// The fixed-notation double formatting orders used before.
+void BM_DoubleToCharsBaseline(benchmark::State& state) {
+    const double values[] = {1.50901623, 68123.4, 0.005, 0.000021};
+    char buffer[64];
+    for (auto _ : state) {
+        for (double value : values) {
+            benchmark::DoNotOptimize(std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * std::size(values)));
+}
+
+}  // namespace
+
+BENCHMARK(BM_DecimalFromChars);
+BENCHMARK(BM_StrtodBaseline);
+BENCHMARK(BM_DecimalToChars);
+BENCHMARK(BM_DoubleToCharsBaseline);
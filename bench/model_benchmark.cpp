@@ -0,0 +1,43 @@
+#include "backtest/synthetic_feed.h"
+#include "models/statistical_arbitrage_model.h"
+#include <benchmark/benchmark.h>
+
+namespace {
+
+const size_t kPriceCount = 1 << 16;
+
+const std::vector<PairPrice>& Prices() {
+    static const std::vector<PairPrice> prices = GeneratePairPrices(kPriceCount);
+    return prices;
+}
+
+// One GenerateSignal call per iteration on a warmed-up window, cycling
+// through the same prices so every mode sees identical input.
+void BM_GenerateSignal(benchmark::State& state, HedgeRatioMode mode) {
+    const size_t lookback = static_cast<size_t>(state.range(0));
+    const std::vector<PairPrice>& prices = Prices();
+    StatisticalArbitrageModel model(lookback, 2.0, 0.5, mode);
+    model.SetVerbose(false);
+
+    size_t i = 0;
+    for (; i < lookback * 2; i++) {
+        model.GenerateSignal(prices[i].y, prices[i].x);
+    }
+
+    for (auto _ : state) {
+        const PairPrice& price = prices[i];
+        benchmark::DoNotOptimize(model.GenerateSignal(price.y, price.x));
+        i = (i + 1) & (kPriceCount - 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_GenerateSignal, incremental_ols, HedgeRatioMode::INCREMENTAL_OLS)
+    ->Arg(20)->Arg(100)->Arg(500)->Arg(2000);
+BENCHMARK_CAPTURE(BM_GenerateSignal, kalman, HedgeRatioMode::KALMAN)
+    ->Arg(20)->Arg(100)->Arg(500)->Arg(2000);
+// A full solve per tick; kept as the baseline the incremental modes replace.
+BENCHMARK_CAPTURE(BM_GenerateSignal, eigen_ols, HedgeRatioMode::EIGEN_OLS)
+    ->Arg(20)->Arg(100)->Arg(500);
@@ -0,0 +1,75 @@
+#include "backtest/synthetic_feed.h"
+#include "traders/multi_pair_arbitrage_engine.h"
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t kBars = 1024;
+
+// kBars one-minute bars for each of symbols synthetic symbols, interleaved
+// by bar as the merged stream delivers them.
+std::vector<Candle> UniverseCandles(size_t symbols) {
+    std::vector<std::vector<PairPrice>> prices;
+    std::vector<SymbolId> ids;
+    for (size_t s = 0; s < symbols; s++) {
+        prices.push_back(GeneratePairPrices(kBars, 42 + s));
+        ids.push_back(SymbolRegistry::Global().Intern("BENCH" + std::to_string(s) + "/USD"));
+    }
+
+    std::vector<Candle> candles;
+    candles.reserve(kBars * symbols);
+    for (size_t bar = 0; bar < kBars; bar++) {
+        for (size_t s = 0; s < symbols; s++) {
+            int64_t begin = static_cast<int64_t>(bar) * 60LL * 1000000000LL;
+            candles.push_back(FlatCandle(ids[s], begin, s % 2 == 0 ? prices[s][bar].y : prices[s][bar].x));
+        }
+    }
+    return candles;
+}
+
+// One OnCandle per iteration over a universe of range(0) symbols, each the
+// y leg of range(1) pairs. Every pair updates once per bar, so a candle
+// costs range(1) pair updates on average however large the universe is.
+void BM_MultiPairOnCandle(benchmark::State& state) {
+    const size_t symbols = static_cast<size_t>(state.range(0));
+    const size_t pairs_per_symbol = static_cast<size_t>(state.range(1));
+    const std::vector<Candle> candles = UniverseCandles(symbols);
+
+    MultiPairArbitrageEngine engine(100, 2.0, 0.5);
+    for (size_t s = 0; s < symbols; s++) {
+        for (size_t k = 1; k <= pairs_per_symbol; k++) {
+            engine.AddPair("BENCH" + std::to_string(s) + "/USD",
+                           "BENCH" + std::to_string((s + k) % symbols) + "/USD");
+        }
+    }
+
+    // Past the lookback, so every update runs the full model.
+    size_t i = 0;
+    for (; i < symbols * 200; i++) {
+        engine.OnCandle(candles[i]);
+    }
+
+    // Replays the history again later on the clock, since the engine
+    // ignores bars older than the open one.
+    int64_t offset = 0;
+    for (auto _ : state) {
+        Candle candle = candles[i];
+        candle.interval_begin += offset;
+        engine.OnCandle(candle);
+        if (++i == candles.size()) {
+            i = 0;
+            offset += static_cast<int64_t>(kBars) * 60LL * 1000000000LL;
+        }
+    }
+    benchmark::DoNotOptimize(engine.GetEquity());
+    state.SetItemsProcessed(state.iterations());
+    state.counters["pairs"] = static_cast<double>(engine.PairCount());
+}
+
+}  // namespace
+
+BENCHMARK(BM_MultiPairOnCandle)
+    ->Args({8, 1})->Args({64, 1})->Args({512, 1})
+    ->Args({64, 4})->Args({64, 16});
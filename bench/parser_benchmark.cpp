@@ -0,0 +1,86 @@
+#include "websocket/ohlc_message_parser.h"
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Kraken v2 messages as received on an ohlc subscription: acks, status,
+// per-symbol snapshots, updates and heartbeats, one per line.
+const std::vector<std::string>& CapturedMessages() {
+    static const std::vector<std::string> messages = [] {
+        std::string path = std::string(BENCH_DATA_DIR) + "/kraken_ohlc.jsonl";
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+        std::vector<std::string> lines;
+        for (std::string line; std::getline(file, line);) {
+            if (!line.empty()) lines.push_back(line);
+        }
+        return lines;
+    }();
+    return messages;
+}
+
+const std::string& FirstMessageWith(const char* text) {
+    for (const std::string& message : CapturedMessages()) {
+        if (message.find(text) != std::string::npos) return message;
+    }
+    throw std::runtime_error(std::string("No captured message contains ") + text);
+}
+
+void ParseRepeatedly(benchmark::State& state, const std::string& message) {
+    Candle scratch = {};
+    size_t candles = 0;
+    std::function<void(const Candle&)> on_candle = [&candles](const Candle& candle) {
+        benchmark::DoNotOptimize(candle.close);
+        candles++;
+    };
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(ParseOhlcMessage(message.data(), message.size(), scratch, on_candle));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * message.size()));
+    state.counters["candles/s"] = benchmark::Counter(static_cast<double>(candles), benchmark::Counter::kIsRate);
+}
+
+void BM_ParseOhlcUpdate(benchmark::State& state) {
+    ParseRepeatedly(state, FirstMessageWith("\"type\":\"update\",\"timestamp\""));
+}
+
+void BM_ParseOhlcSnapshot(benchmark::State& state) {
+    ParseRepeatedly(state, FirstMessageWith("\"type\":\"snapshot\""));
+}
+
+void BM_ParseHeartbeat(benchmark::State& state) {
+    ParseRepeatedly(state, FirstMessageWith("heartbeat"));
+}
+
+// The whole capture in arrival order, as the socket thread would see it.
+void BM_ParseCapturedFeed(benchmark::State& state) {
+    const std::vector<std::string>& messages = CapturedMessages();
+    Candle scratch = {};
+    std::function<void(const Candle&)> on_candle = [](const Candle& candle) {
+        benchmark::DoNotOptimize(candle.close);
+    };
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        for (const std::string& message : messages) {
+            benchmark::DoNotOptimize(ParseOhlcMessage(message.data(), message.size(), scratch, on_candle));
+            bytes += message.size();
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * messages.size()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_ParseOhlcUpdate);
+BENCHMARK(BM_ParseOhlcSnapshot);
+BENCHMARK(BM_ParseHeartbeat);
+BENCHMARK(BM_ParseCapturedFeed);
@@ -0,0 +1,200 @@
+#include "backtest_engine.h"
+#include "../storage/candle_store.h"
+#include "../market_data/timestamp.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const double kMinutesPerYear = 525600.0;
+
+// Returns the next comma- or newline-terminated field and advances cursor.
+const char* NextField(const char*& cursor, const char* end, size_t& length) {
+    const char* start = cursor;
+    while (cursor < end && *cursor != ',' && *cursor != '\n' && *cursor != '\r') {
+        cursor++;
+    }
+    length = cursor - start;
+    if (cursor < end && *cursor == ',') cursor++;
+    return start;
+}
+
+double ParseDouble(const char* start, size_t length) {
+    char buffer[64];
+    if (length >= sizeof(buffer)) length = sizeof(buffer) - 1;
+    std::copy(start, start + length, buffer);
+    buffer[length] = '\0';
+    return std::strtod(buffer, nullptr);
+}
+
+int ParseInt(const char* start, size_t length) {
+    return static_cast<int>(ParseDouble(start, length));
+}
+
+// The engine evaluates a bar once the next one starts, so the last bar of
+// a replay has to be closed explicitly.
+void FinishReplay(StatisticalArbitrageTrader&) {}
+
+void FinishReplay(MultiPairArbitrageEngine& engine) {
+    engine.CloseBar();
+}
+
+// The replay loop shared by both strategies; the caller fills in trades.
+template <typename Strategy>
+BacktestResult Replay(const std::vector<Candle>& candles, Strategy& strategy) {
+    BacktestResult result = {};
+
+    // Equity is sampled once per bar to build the return series for Sharpe.
+    double last_equity = 0.0;
+    double peak_equity = 0.0;
+    double sum_returns = 0.0;
+    double sum_squared_returns = 0.0;
+    size_t bars = 0;
+    int interval = 1;
+    int64_t last_bar = 0;
+    bool first = true;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const auto& candle : candles) {
+        if (!first && last_bar != candle.interval_begin) {
+            double equity = strategy.GetEquity();
+            double change = equity - last_equity;
+            sum_returns += change;
+            sum_squared_returns += change * change;
+            bars++;
+            last_equity = equity;
+            peak_equity = std::max(peak_equity, equity);
+            result.max_drawdown = std::max(result.max_drawdown, peak_equity - equity);
+        }
+        last_bar = candle.interval_begin;
+        first = false;
+        if (candle.interval > 0) interval = candle.interval;
+
+        strategy.OnCandle(candle);
+    }
+    FinishReplay(strategy);
+
+    auto end = std::chrono::steady_clock::now();
+
+    result.candles = candles.size();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.candles_per_second = result.seconds > 0.0 ? result.candles / result.seconds : 0.0;
+    result.pnl = strategy.GetEquity();
+
+    if (bars > 1) {
+        double mean = sum_returns / bars;
+        double variance = sum_squared_returns / bars - mean * mean;
+        if (variance > 1e-18) {
+            result.sharpe = mean / std::sqrt(variance) * std::sqrt(kMinutesPerYear / interval);
+        }
+    }
+
+    return result;
+}
+
+}  // namespace
+
+std::vector<Candle> LoadCandlesFromCSV(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open candle file: " + filename);
+    }
+
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    const std::string data = contents.str();
+
+    std::vector<Candle> candles;
+    candles.reserve(std::count(data.begin(), data.end(), '\n'));
+
+    const char* cursor = data.data();
+    const char* end = cursor + data.size();
+    bool header = true;
+    size_t line_number = 0;
+
+    while (cursor < end) {
+        const char* line_end = std::find(cursor, end, '\n');
+        line_number++;
+        if (header || line_end == cursor || *cursor == '\r') {
+            header = false;
+            cursor = line_end < end ? line_end + 1 : end;
+            continue;
+        }
+
+        size_t length;
+        Candle candle = {};
+        const char* field = NextField(cursor, line_end, length);
+        candle.symbol = SymbolRegistry::Global().Intern(std::string_view(field, length));
+        if (candle.symbol == kInvalidSymbol) {
+            throw std::runtime_error("Symbol registry is full while loading " + filename);
+        }
+        field = NextField(cursor, line_end, length);
+        if (!ParseTimestampNanos(field, length, candle.interval_begin)) {
+            throw std::runtime_error("Bad interval_begin on line " + std::to_string(line_number) +
+                                     " of " + filename);
+        }
+        SymbolPrecision precision = MarketPrecision(candle.symbol);
+        int64_t* values[] = {&candle.open, &candle.high, &candle.low, &candle.close, &candle.vwap, &candle.volume};
+        for (int64_t* value : values) {
+            int scale = value == &candle.volume ? precision.qty_decimals : precision.price_decimals;
+            field = NextField(cursor, line_end, length);
+            if (!ParseMantissa(std::string_view(field, length), scale, *value)) {
+                throw std::runtime_error("Bad price or volume on line " + std::to_string(line_number) +
+                                         " of " + filename);
+            }
+        }
+        field = NextField(cursor, line_end, length);
+        candle.trades = static_cast<uint32_t>(ParseInt(field, length));
+        field = NextField(cursor, line_end, length);
+        candle.interval = static_cast<uint16_t>(length > 0 ? ParseInt(field, length) : 1);
+
+        candles.push_back(candle);
+        cursor = line_end < end ? line_end + 1 : end;
+    }
+
+    return candles;
+}
+
+std::vector<Candle> LoadCandlesFromStore(const std::string& directory) {
+    CandleStoreReader reader(directory);
+    return reader.ReadCandles(0, reader.Size());
+}
+
+std::vector<Candle> MergeCandleStreams(std::vector<std::vector<Candle>> streams) {
+    std::vector<Candle> merged;
+    size_t total = 0;
+    for (const auto& stream : streams) {
+        total += stream.size();
+    }
+    merged.reserve(total);
+
+    for (auto& stream : streams) {
+        std::move(stream.begin(), stream.end(), std::back_inserter(merged));
+    }
+
+    std::stable_sort(merged.begin(), merged.end(), [](const Candle& a, const Candle& b) {
+        return a.interval_begin < b.interval_begin;
+    });
+
+    return merged;
+}
+
+BacktestEngine::BacktestEngine(const std::vector<Candle>& candles) : candles_(candles) {}
+
+BacktestResult BacktestEngine::Run(StatisticalArbitrageTrader& trader) const {
+    BacktestResult result = Replay(candles_, trader);
+    result.trades = static_cast<size_t>(trader.TradeCount());
+    return result;
+}
+
+BacktestResult BacktestEngine::Run(MultiPairArbitrageEngine& engine) const {
+    BacktestResult result = Replay(candles_, engine);
+    result.trades = static_cast<size_t>(engine.TradeCount());
+    return result;
+}
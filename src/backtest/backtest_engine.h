@@ -0,0 +1,48 @@
+#ifndef BACKTEST_ENGINE_H
+#define BACKTEST_ENGINE_H
+
+#include "../market_data/candle.h"
+#include "../traders/multi_pair_arbitrage_engine.h"
+#include "../traders/statistical_arbitrage_trader.h"
+#include <string>
+#include <vector>
+
+struct BacktestResult {
+    size_t candles;
+    size_t trades;
+    double seconds;
+    double candles_per_second;
+    double pnl;
+    double sharpe;
+    double max_drawdown;
+};
+
+// Loads candles recorded as CSV with the header
+// symbol,interval_begin,open,high,low,close,vwap,volume,trades,interval
+// Throws std::runtime_error if the file cannot be read.
+std::vector<Candle> LoadCandlesFromCSV(const std::string& filename);
+
+// Loads every row of a candle store directory written by CandleStoreWriter.
+std::vector<Candle> LoadCandlesFromStore(const std::string& directory);
+
+// Orders candles from several per-symbol files into one replay stream by
+// interval_begin, keeping file order for candles of the same bar.
+std::vector<Candle> MergeCandleStreams(std::vector<std::vector<Candle>> streams);
+
+// Replays a recorded candle history through the OnCandle of a
+// StatisticalArbitrageTrader or MultiPairArbitrageEngine, the same entry
+// point the live stream drives, with no network or sleeps.
+// The history is borrowed read-only, so one engine can serve many runs.
+class BacktestEngine {
+public:
+    explicit BacktestEngine(const std::vector<Candle>& candles);
+
+    BacktestResult Run(StatisticalArbitrageTrader& trader) const;
+    // Same replay and statistics over every pair of engine; pnl is the sum.
+    BacktestResult Run(MultiPairArbitrageEngine& engine) const;
+
+private:
+    const std::vector<Candle>& candles_;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "parameter_sweep.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+std::vector<double> ExpandRange(const SweepRange& range) {
+    std::vector<double> values;
+    if (range.step <= 0.0 || range.stop <= range.start) {
+        values.push_back(range.start);
+        return values;
+    }
+
+    size_t steps = static_cast<size_t>(std::floor((range.stop - range.start) / range.step + 1e-9));
+    for (size_t i = 0; i <= steps; i++) {
+        values.push_back(range.start + i * range.step);
+    }
+    return values;
+}
+
+}  // namespace
+
+std::vector<SweepParameters> BuildParameterGrid(const SweepRange& lookback,
+                                                const SweepRange& z_entry,
+                                                const SweepRange& z_exit) {
+    std::vector<SweepParameters> grid;
+
+    for (double window : ExpandRange(lookback)) {
+        for (double entry : ExpandRange(z_entry)) {
+            for (double exit : ExpandRange(z_exit)) {
+                if (window < 2.0 || exit >= entry) continue;
+                grid.push_back({static_cast<size_t>(window), entry, exit});
+            }
+        }
+    }
+
+    return grid;
+}
+
+std::vector<SweepParameters> BuildRandomSearch(const SweepRange& lookback,
+                                               const SweepRange& z_entry,
+                                               const SweepRange& z_exit,
+                                               size_t samples, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> window(lookback.start, std::max(lookback.start, lookback.stop));
+    std::uniform_real_distribution<double> entry(z_entry.start, std::max(z_entry.start, z_entry.stop));
+    std::uniform_real_distribution<double> exit(z_exit.start, std::max(z_exit.start, z_exit.stop));
+
+    std::vector<SweepParameters> search;
+    search.reserve(samples);
+
+    // Bounded retries so an impossible range (exit always >= entry) terminates.
+    for (size_t attempts = 0; search.size() < samples && attempts < samples * 100; attempts++) {
+        SweepParameters parameters = {static_cast<size_t>(std::round(window(rng))), entry(rng), exit(rng)};
+        if (parameters.lookback < 2 || parameters.z_exit >= parameters.z_entry) continue;
+        search.push_back(parameters);
+    }
+
+    return search;
+}
+
+std::vector<SweepResult> RunParameterSweep(const std::vector<Candle>& candles,
+                                           const std::vector<SweepParameters>& parameters,
+                                           const SweepConfig& config) {
+    std::vector<SweepResult> results(parameters.size());
+    BacktestEngine engine(candles);
+
+    WorkStealingPool pool(config.threads);
+    for (size_t i = 0; i < parameters.size(); i++) {
+        pool.Submit([&engine, &parameters, &results, &config, i] {
+            const SweepParameters& knobs = parameters[i];
+            StatisticalArbitrageTrader trader(knobs.lookback, knobs.z_entry, knobs.z_exit,
+                                              config.hedge_ratio_mode, config.y_symbol, config.x_symbol);
+            trader.SetVerbose(false);
+
+            results[i].parameters = knobs;
+            results[i].backtest = engine.Run(trader);
+        });
+    }
+    pool.Wait();
+
+    return results;
+}
+
+void RankSweepResults(std::vector<SweepResult>& results) {
+    std::stable_sort(results.begin(), results.end(), [](const SweepResult& a, const SweepResult& b) {
+        if (a.backtest.sharpe != b.backtest.sharpe) return a.backtest.sharpe > b.backtest.sharpe;
+        if (a.backtest.pnl != b.backtest.pnl) return a.backtest.pnl > b.backtest.pnl;
+        return a.backtest.trades > b.backtest.trades;
+    });
+}
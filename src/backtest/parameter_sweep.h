@@ -0,0 +1,58 @@
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#include "backtest_engine.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The three StatisticalArbitrageTrader constructor knobs.
+struct SweepParameters {
+    size_t lookback;
+    double z_entry;
+    double z_exit;
+};
+
+struct SweepResult {
+    SweepParameters parameters;
+    BacktestResult backtest;
+};
+
+// Settings shared by every configuration of one sweep.
+struct SweepConfig {
+    std::string y_symbol = "BTC/USD";
+    std::string x_symbol = "ETH/USD";
+    HedgeRatioMode hedge_ratio_mode = HedgeRatioMode::INCREMENTAL_OLS;
+    // Worker threads, 0 for one per core.
+    size_t threads = 0;
+};
+
+// Inclusive range; a zero step yields just start.
+struct SweepRange {
+    double start;
+    double stop;
+    double step;
+};
+
+// Cartesian product of the three ranges, skipping z_exit >= z_entry.
+std::vector<SweepParameters> BuildParameterGrid(const SweepRange& lookback,
+                                                const SweepRange& z_entry,
+                                                const SweepRange& z_exit);
+
+// Uniform samples inside the same bounds, reproducible for a given seed.
+std::vector<SweepParameters> BuildRandomSearch(const SweepRange& lookback,
+                                               const SweepRange& z_entry,
+                                               const SweepRange& z_exit,
+                                               size_t samples, uint64_t seed);
+
+// Backtests every configuration on a work-stealing pool. Each task builds its
+// own trader and model; the candle history is shared read-only. Results are
+// returned in the order of parameters.
+std::vector<SweepResult> RunParameterSweep(const std::vector<Candle>& candles,
+                                           const std::vector<SweepParameters>& parameters,
+                                           const SweepConfig& config = SweepConfig());
+
+// Sorts best first by Sharpe, then PnL, then trade count.
+void RankSweepResults(std::vector<SweepResult>& results);
+
+#endif
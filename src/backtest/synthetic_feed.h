@@ -0,0 +1,80 @@
+#ifndef SYNTHETIC_FEED_H
+#define SYNTHETIC_FEED_H
+
+#include "../market_data/candle.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+struct PairPrice {
+    double y;
+    double x;
+};
+
+// Deterministic cointegrated pair: x follows a geometric random walk and
+// y = hedge * x plus mean-reverting noise, so the spread crosses entry and
+// exit thresholds about as often as a real BTC/ETH pair does.
+inline std::vector<PairPrice> GeneratePairPrices(size_t count, uint64_t seed = 42) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<double> step(0.0, 1.0);
+
+    std::vector<PairPrice> prices;
+    prices.reserve(count);
+    double x = 3000.0;
+    double noise = 0.0;
+    const double hedge = 20.0;
+    for (size_t i = 0; i < count; i++) {
+        x *= std::exp(0.0008 * step(rng));
+        noise = 0.97 * noise + 40.0 * step(rng);
+        prices.push_back({hedge * x + noise, x});
+    }
+    return prices;
+}
+
+// A one-minute candle that opens and closes at price, rounded to the
+// symbol's MarketPrecision().
+inline Candle FlatCandle(SymbolId symbol, int64_t interval_begin, double price) {
+    SymbolPrecision precision = MarketPrecision(symbol);
+    Decimal close = {};
+    Decimal volume = {};
+    DecimalFromDouble(price, precision.price_decimals, close);
+    DecimalFromDouble(1.5, precision.qty_decimals, volume);
+
+    Candle candle = {};
+    candle.interval_begin = interval_begin;
+    candle.open = close.mantissa;
+    candle.high = close.mantissa;
+    candle.low = close.mantissa;
+    candle.close = close.mantissa;
+    candle.vwap = close.mantissa;
+    candle.volume = volume.mantissa;
+    candle.trades = 10;
+    candle.interval = 1;
+    candle.symbol = symbol;
+    return candle;
+}
+
+// GeneratePairPrices as flat one-minute candles for y_symbol and x_symbol,
+// interleaved by bar, from start_ns.
+inline std::vector<Candle> GeneratePairCandles(size_t bars, const std::string& y_symbol,
+                                               const std::string& x_symbol, int64_t start_ns,
+                                               uint64_t seed = 42) {
+    const int64_t minute_ns = 60LL * 1000000000LL;
+    SymbolId y = SymbolRegistry::Global().Intern(y_symbol);
+    SymbolId x = SymbolRegistry::Global().Intern(x_symbol);
+    std::vector<PairPrice> prices = GeneratePairPrices(bars, seed);
+
+    std::vector<Candle> candles;
+    candles.reserve(bars * 2);
+    for (size_t i = 0; i < bars; i++) {
+        int64_t begin = start_ns + static_cast<int64_t>(i) * minute_ns;
+        candles.push_back(FlatCandle(y, begin, prices[i].y));
+        candles.push_back(FlatCandle(x, begin, prices[i].x));
+    }
+    return candles;
+}
+
+#endif
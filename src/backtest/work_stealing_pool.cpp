@@ -0,0 +1,106 @@
+#include "work_stealing_pool.h"
+
+WorkStealingPool::WorkStealingPool(size_t threads)
+    : next_queue_(0), queued_(0), outstanding_(0), stopping_(false) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+        if (threads == 0) threads = 1;
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers_.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::Submit(std::function<void()> task) {
+    size_t index = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+    // Count the task before publishing it so a worker that grabs it early
+    // never drives the counters below zero.
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        outstanding_++;
+        queued_.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    idle_.wait(lock, [this] { return outstanding_ == 0; });
+}
+
+size_t WorkStealingPool::ThreadCount() const {
+    return workers_.size();
+}
+
+bool WorkStealingPool::PopLocal(size_t index, std::function<void()>& task) {
+    WorkerQueue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::Steal(size_t thief, std::function<void()>& task) {
+    for (size_t offset = 1; offset < queues_.size(); offset++) {
+        WorkerQueue& victim = *queues_[(thief + offset) % queues_.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) continue;
+
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::FinishTask() {
+    bool idle;
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        idle = --outstanding_ == 0;
+    }
+    if (idle) idle_.notify_all();
+}
+
+void WorkStealingPool::WorkerLoop(size_t index) {
+    std::function<void()> task;
+
+    while (true) {
+        if (PopLocal(index, task) || Steal(index, task)) {
+            queued_.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            task = nullptr;
+            FinishTask();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait(lock, [this] {
+            return stopping_ || queued_.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping_ && queued_.load(std::memory_order_acquire) == 0) return;
+    }
+}
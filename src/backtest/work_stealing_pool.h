@@ -0,0 +1,57 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool where every worker owns a task deque. Workers pop
+// their own newest task first and steal the oldest task from a sibling when
+// they run dry, which keeps long and short tasks balanced without a single
+// contended queue. Intended for coarse-grained jobs such as whole backtests.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void Submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished.
+    void Wait();
+
+    size_t ThreadCount() const;
+
+private:
+    // Padded to a cache line so neighbouring workers' locks do not false-share.
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+
+    std::atomic<size_t> next_queue_;
+    std::atomic<size_t> queued_;
+    size_t outstanding_;
+    bool stopping_;
+
+    void WorkerLoop(size_t index);
+    bool PopLocal(size_t index, std::function<void()>& task);
+    bool Steal(size_t thief, std::function<void()>& task);
+    void FinishTask();
+};
+
+#endif
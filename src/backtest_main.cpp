@@ -0,0 +1,326 @@
+#include "backtest/backtest_engine.h"
+#include "backtest/parameter_sweep.h"
+#include "traders/multi_pair_arbitrage_engine.h"
+#include "traders/statistical_arbitrage_trader.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <CANDLES.csv|STORE_DIR> [...] [options]" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --lookback N     regression window in bars (default 100)" << std::endl;
+    std::cerr << "  --z-entry X      entry z-score threshold (default 2.0)" << std::endl;
+    std::cerr << "  --z-exit X       exit z-score threshold (default 0.5)" << std::endl;
+    std::cerr << "  --pair Y,X       symbols to trade (default BTC/USD,ETH/USD)" << std::endl;
+    std::cerr << "  --pairs Y:X,...  trade several pairs at once, one model each" << std::endl;
+    std::cerr << "  --screen N       add the N most cointegrated pairs over the first window of bars" << std::endl;
+    std::cerr << "                   and trade them on the bars after it" << std::endl;
+    std::cerr << "  --screen-window BARS  bars to screen over (default 500)" << std::endl;
+    std::cerr << "  --hedge MODE     ols (default), eigen or kalman" << std::endl;
+    std::cerr << "  --trades FILE    write the trade log as CSV" << std::endl;
+    std::cerr << "  --verbose        print per-tick model output" << std::endl;
+    std::cerr << "Sweep options:" << std::endl;
+    std::cerr << "  --sweep                  search parameters instead of a single run, with --hedge" << std::endl;
+    std::cerr << "  --lookback-range A:B:S   lookback grid (default 50:500:50)" << std::endl;
+    std::cerr << "  --z-entry-range A:B:S    entry grid (default 1.5:3:0.25)" << std::endl;
+    std::cerr << "  --z-exit-range A:B:S     exit grid (default 0:1:0.25)" << std::endl;
+    std::cerr << "  --random N               sample N random configurations within the ranges" << std::endl;
+    std::cerr << "  --seed S                 random search seed (default 42)" << std::endl;
+    std::cerr << "  --threads N              worker threads (default all cores)" << std::endl;
+    std::cerr << "  --top K                  configurations to print (default 20)" << std::endl;
+    std::cerr << "Example: " << program << " btc_usd_1m.csv eth_usd_1m.csv --lookback 240" << std::endl;
+    std::cerr << "Example: " << program << " data/1m --pairs BTC/USD:ETH/USD,SOL/USD:ETH/USD" << std::endl;
+}
+
+SweepRange parseRange(const std::string& text) {
+    SweepRange range = {0.0, 0.0, 0.0};
+    size_t first = text.find(':');
+    size_t second = first == std::string::npos ? std::string::npos : text.find(':', first + 1);
+
+    range.start = std::stod(text.substr(0, first));
+    range.stop = first == std::string::npos ? range.start : std::stod(text.substr(first + 1, second - first - 1));
+    range.step = second == std::string::npos ? 0.0 : std::stod(text.substr(second + 1));
+    return range;
+}
+
+// True if any candle is for symbol.
+bool hasCandles(const std::vector<Candle>& candles, const std::string& symbol) {
+    SymbolId id = SymbolRegistry::Global().Find(symbol);
+    if (id == kInvalidSymbol) return false;
+    for (const Candle& candle : candles) {
+        if (candle.symbol == id) return true;
+    }
+    return false;
+}
+
+void printSweep(std::vector<SweepResult>& results, size_t top) {
+    RankSweepResults(results);
+
+    std::cout << "\n=== PARAMETER SWEEP (" << results.size() << " configurations) ===" << std::endl;
+    std::cout << " rank | lookback | z_entry | z_exit |  sharpe |        pnl | trades | max_dd" << std::endl;
+    for (size_t i = 0; i < results.size() && i < top; i++) {
+        const auto& r = results[i];
+        std::cout << std::fixed
+                  << std::setw(5) << i + 1 << " | "
+                  << std::setw(8) << r.parameters.lookback << " | "
+                  << std::setw(7) << std::setprecision(2) << r.parameters.z_entry << " | "
+                  << std::setw(6) << r.parameters.z_exit << " | "
+                  << std::setw(7) << std::setprecision(3) << r.backtest.sharpe << " | "
+                  << std::setw(10) << std::setprecision(2) << r.backtest.pnl << " | "
+                  << std::setw(6) << r.backtest.trades << " | "
+                  << r.backtest.max_drawdown << std::endl;
+    }
+}
+
+// Feeds bars to screener, every symbol in candles being one of its
+// symbols, until it holds a full window. Returns the index of the first
+// candle of the next bar, which the screener never saw.
+size_t screenHistory(const std::vector<Candle>& candles, PairScreener& screener) {
+    std::vector<uint32_t> ids;
+    for (const Candle& candle : candles) {
+        if (candle.symbol >= ids.size()) ids.resize(candle.symbol + 1, UINT32_MAX);
+        if (ids[candle.symbol] == UINT32_MAX) {
+            ids[candle.symbol] = screener.AddSymbol(SymbolRegistry::Global().Name(candle.symbol));
+        }
+    }
+
+    for (size_t i = 0; i < candles.size(); i++) {
+        if (i > 0 && candles[i].interval_begin != candles[i - 1].interval_begin) {
+            screener.CloseBar();
+            if (screener.Ready()) return i;
+        }
+        screener.UpdatePrice(ids[candles[i].symbol], PriceDecimal(candles[i].symbol, candles[i].close));
+    }
+    return candles.size();
+}
+
+void printPairs(const MultiPairArbitrageEngine& strategy) {
+    std::vector<size_t> trades(strategy.PairCount(), 0);
+    for (const PairTrade& trade : strategy.RecentTrades()) {
+        trades[trade.pair]++;
+    }
+
+    std::cout << "\n=== PAIRS ===" << std::endl;
+    for (uint32_t pair = 0; pair < strategy.PairCount(); pair++) {
+        const StatisticalArbitrageModel& model = strategy.PairModel(pair);
+        std::cout << std::fixed << std::setprecision(3)
+                  << strategy.PairYSymbol(pair) << " / " << strategy.PairXSymbol(pair)
+                  << ": " << trades[pair] << " trades | hedge " << model.GetCurrentHedgeRatio()
+                  << " | z " << model.GetCurrentZScore() << std::endl;
+    }
+}
+
+void printResult(const BacktestResult& result) {
+    std::cout << "\n=== BACKTEST ===" << std::endl;
+    std::cout << "Candles:      " << result.candles << std::endl;
+    std::cout << "Elapsed:      " << std::fixed << std::setprecision(3) << result.seconds << " s" << std::endl;
+    std::cout << "Throughput:   " << std::setprecision(0) << result.candles_per_second << " candles/s" << std::endl;
+    std::cout << "Trades:       " << result.trades << std::endl;
+    std::cout << "Final PnL:    " << std::setprecision(2) << result.pnl << std::endl;
+    std::cout << "Sharpe:       " << std::setprecision(3) << result.sharpe << std::endl;
+    std::cout << "Max drawdown: " << std::setprecision(2) << result.max_drawdown << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> files;
+    size_t lookback = 100;
+    double z_entry = 2.0;
+    double z_exit = 0.5;
+    std::string trades_file;
+    bool verbose = false;
+    HedgeRatioMode hedge_ratio_mode = HedgeRatioMode::INCREMENTAL_OLS;
+    std::string pair = "BTC/USD,ETH/USD";
+    std::string pairs_text;
+    size_t screen_pairs = 0;
+    PairScreenerConfig screen_config;
+
+    bool sweep = false;
+    SweepRange lookback_range = {50, 500, 50};
+    SweepRange z_entry_range = {1.5, 3.0, 0.25};
+    SweepRange z_exit_range = {0.0, 1.0, 0.25};
+    size_t random_samples = 0;
+    uint64_t seed = 42;
+    SweepConfig sweep_config;
+    size_t top = 20;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--lookback" && i + 1 < argc) {
+            lookback = std::stoul(argv[++i]);
+        } else if (arg == "--z-entry" && i + 1 < argc) {
+            z_entry = std::stod(argv[++i]);
+        } else if (arg == "--z-exit" && i + 1 < argc) {
+            z_exit = std::stod(argv[++i]);
+        } else if (arg == "--pair" && i + 1 < argc) {
+            pair = argv[++i];
+        } else if (arg == "--pairs" && i + 1 < argc) {
+            pairs_text = argv[++i];
+        } else if (arg == "--screen" && i + 1 < argc) {
+            screen_pairs = std::stoul(argv[++i]);
+        } else if (arg == "--screen-window" && i + 1 < argc) {
+            screen_config.window = std::stoul(argv[++i]);
+        } else if (arg == "--hedge" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "ols") {
+                hedge_ratio_mode = HedgeRatioMode::INCREMENTAL_OLS;
+            } else if (mode == "eigen") {
+                hedge_ratio_mode = HedgeRatioMode::EIGEN_OLS;
+            } else if (mode == "kalman") {
+                hedge_ratio_mode = HedgeRatioMode::KALMAN;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--trades" && i + 1 < argc) {
+            trades_file = argv[++i];
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "--sweep") {
+            sweep = true;
+        } else if (arg == "--lookback-range" && i + 1 < argc) {
+            lookback_range = parseRange(argv[++i]);
+        } else if (arg == "--z-entry-range" && i + 1 < argc) {
+            z_entry_range = parseRange(argv[++i]);
+        } else if (arg == "--z-exit-range" && i + 1 < argc) {
+            z_exit_range = parseRange(argv[++i]);
+        } else if (arg == "--random" && i + 1 < argc) {
+            random_samples = std::stoul(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            sweep_config.threads = std::stoul(argv[++i]);
+        } else if (arg == "--top" && i + 1 < argc) {
+            top = std::stoul(argv[++i]);
+        } else if (arg.rfind("--", 0) == 0) {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    // --pairs and --screen replace --pair, so it is only checked without them.
+    bool multi_pair = !pairs_text.empty() || screen_pairs > 0;
+    size_t comma = pair.find(',');
+    if (files.empty() || (!multi_pair && comma == std::string::npos)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    std::string y_symbol = multi_pair ? std::string() : pair.substr(0, comma);
+    std::string x_symbol = multi_pair ? std::string() : pair.substr(comma + 1);
+    std::vector<std::pair<std::string, std::string>> pairs;
+    if ((!pairs_text.empty() && !ParsePairList(pairs_text, pairs)) || (multi_pair && sweep)) {
+        std::cerr << "Error: --pairs takes Y:X[,Y:X...], each pair once; --pairs and --screen cannot be swept" << std::endl;
+        return 1;
+    }
+    if (!multi_pair) {
+        pairs.emplace_back(y_symbol, x_symbol);
+    }
+
+    std::vector<Candle> candles;
+    try {
+        std::vector<std::vector<Candle>> streams;
+        for (const auto& file : files) {
+            if (std::filesystem::is_directory(file)) {
+                streams.push_back(LoadCandlesFromStore(file));
+            } else {
+                streams.push_back(LoadCandlesFromCSV(file));
+            }
+        }
+        candles = MergeCandleStreams(std::move(streams));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    for (const auto& legs : pairs) {
+        for (const std::string& symbol : {legs.first, legs.second}) {
+            if (!hasCandles(candles, symbol)) {
+                std::cerr << "Error: no " << symbol << " candles in the input" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if (multi_pair) {
+        MultiPairArbitrageEngine strategy(lookback, z_entry, z_exit, hedge_ratio_mode);
+        strategy.SetVerbose(verbose);
+        for (const auto& legs : pairs) {
+            strategy.AddPair(legs.first, legs.second);
+        }
+
+        // Pairs are picked on the screening window only and traded on the
+        // bars after it, so the ranking never sees the prices it trades.
+        if (screen_pairs > 0) {
+            PairScreener screener(screen_config);
+            size_t split = screenHistory(candles, screener);
+            if (!screener.Ready()) {
+                std::cerr << "Error: fewer than " << screen_config.window << " bars to screen" << std::endl;
+                return 1;
+            }
+            std::vector<PairScore> ranked = screener.Screen();
+            size_t added = strategy.AddScreenedPairs(ranked, screen_pairs);
+            std::cout << "Screened " << screener.SymbolCount() << " symbols over " << screener.BarCount()
+                      << " bars: " << added << " cointegrated pair(s) added" << std::endl;
+            for (size_t i = 0, shown = 0; i < ranked.size() && shown < added; i++) {
+                if (!ranked[i].cointegrated) continue;
+                std::cout << std::fixed << std::setprecision(2) << "  " << ranked[i].y_name << " / "
+                          << ranked[i].x_name << ": ADF " << ranked[i].adf_statistic << " | half-life "
+                          << ranked[i].half_life << " bars" << std::endl;
+                shown++;
+            }
+            candles.erase(candles.begin(), candles.begin() + static_cast<std::ptrdiff_t>(split));
+        }
+        if (strategy.PairCount() == 0) {
+            std::cerr << "Error: no pairs to trade" << std::endl;
+            return 1;
+        }
+
+        BacktestEngine engine(candles);
+        BacktestResult result = engine.Run(strategy);
+        printPairs(strategy);
+        printResult(result);
+
+        if (!trades_file.empty()) {
+            strategy.SaveTradesToCSV(trades_file);
+        }
+        return 0;
+    }
+
+    if (sweep) {
+        std::vector<SweepParameters> parameters = random_samples > 0
+            ? BuildRandomSearch(lookback_range, z_entry_range, z_exit_range, random_samples, seed)
+            : BuildParameterGrid(lookback_range, z_entry_range, z_exit_range);
+
+        auto start = std::chrono::steady_clock::now();
+        sweep_config.y_symbol = y_symbol;
+        sweep_config.x_symbol = x_symbol;
+        sweep_config.hedge_ratio_mode = hedge_ratio_mode;
+        std::vector<SweepResult> results = RunParameterSweep(candles, parameters, sweep_config);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        printSweep(results, top);
+        std::cout << "\nSwept " << parameters.size() << " configurations over "
+                  << candles.size() << " candles in " << std::setprecision(3) << seconds << " s" << std::endl;
+        return 0;
+    }
+
+    StatisticalArbitrageTrader trader(lookback, z_entry, z_exit, hedge_ratio_mode, y_symbol, x_symbol);
+    trader.SetVerbose(verbose);
+
+    BacktestEngine engine(candles);
+    BacktestResult result = engine.Run(trader);
+
+    trader.PrintTradeLog();
+    printResult(result);
+
+    if (!trades_file.empty()) {
+        trader.SaveTradesToCSV(trades_file);
+    }
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include "storage/trade_journal.h"
+#include "market_data/timestamp.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+// Exports a journal directory written by TradeJournal (main --journal) as
+// CSV, one row per entry in sequence order. Trade and order entries get
+// their own columns; a journal holds one kind in practice.
+
+namespace {
+
+// Mirror TradeAction, OrderState, OrderSide and OrderType, which are stored
+// as raw values so this tool does not link the trader or the gateway.
+const char* const kTradeActions[] = {"LONG_SPREAD", "SHORT_SPREAD", "EXIT"};
+const char* const kOrderStates[] = {"FREE", "PENDING", "ACCEPTED", "REJECTED", "CANCEL_PENDING", "CANCELLED", "UNKNOWN",
+                                     "CLAIMING"};
+const char* const kOrderSides[] = {"buy", "sell"};
+const char* const kOrderTypes[] = {"market", "limit"};
+
+template <size_t N>
+const char* NameOf(const char* const (&names)[N], uint8_t value) {
+    return value < N ? names[value] : "UNKNOWN";
+}
+
+// Fixed-size string fields are NUL-padded but written by other processes;
+// never read past the field.
+std::string FieldString(const char* field, size_t size) {
+    return std::string(field, strnlen(field, size));
+}
+
+void WriteTrade(std::ostream& out, const JournalEntry& entry) {
+    TradeJournalRecord record;
+    std::memset(&record, 0, sizeof(record));
+    std::memcpy(&record, entry.payload, std::min<size_t>(entry.length, sizeof(record)));
+    out << entry.sequence << ","
+        << FormatTimestampNanos(entry.written_ns) << ","
+        << FormatTimestampNanos(record.timestamp) << ","
+        << NameOf(kTradeActions, record.action) << ","
+        << FieldString(record.y_symbol, sizeof(record.y_symbol)) << ","
+        << FieldString(record.x_symbol, sizeof(record.x_symbol)) << ","
+        << std::fixed << std::setprecision(2) << record.y_price << ","
+        << record.x_price << ","
+        << std::setprecision(4) << record.hedge_ratio << ","
+        << std::setprecision(3) << record.z_score << ","
+        << std::setprecision(2) << record.pnl << "\n";
+}
+
+void WriteOrder(std::ostream& out, const JournalEntry& entry) {
+    OrderJournalRecord record;
+    std::memset(&record, 0, sizeof(record));
+    std::memcpy(&record, entry.payload, std::min<size_t>(entry.length, sizeof(record)));
+    out << entry.sequence << ","
+        << FormatTimestampNanos(entry.written_ns) << ","
+        << record.req_id << ","
+        << FieldString(record.symbol, sizeof(record.symbol)) << ","
+        << NameOf(kOrderSides, record.side) << ","
+        << NameOf(kOrderTypes, record.order_type) << ","
+        << std::fixed << std::setprecision(8) << record.quantity << ","
+        << record.limit_price << ","
+        << NameOf(kOrderStates, record.state) << ","
+        << (record.success ? "true" : "false") << ","
+        << FieldString(record.order_id, sizeof(record.order_id)) << ","
+        << (record.ack_ns - record.sent_ns) / 1000 << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <JOURNAL_DIR> [OUTPUT_CSV]" << std::endl;
+        std::cerr << "Example: " << argv[0] << " journal/trades trades.csv" << std::endl;
+        return 1;
+    }
+
+    std::ofstream file;
+    if (argc >= 3) {
+        file.open(argv[2]);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file: " << argv[2] << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = argc >= 3 ? static_cast<std::ostream&>(file) : std::cout;
+
+    uint16_t header_type = 0;
+    size_t rows = 0;
+    size_t skipped = 0;
+    bool found;
+    try {
+        found = ReadJournal(argv[1], [&](const JournalEntry& entry) {
+            if (header_type == 0) {
+                header_type = entry.type;
+                if (entry.type == static_cast<uint16_t>(JournalEntryType::TRADE)) {
+                    out << "sequence,written_at,timestamp,action,y_symbol,x_symbol,y_price,x_price,"
+                           "hedge_ratio,z_score,pnl\n";
+                } else if (entry.type == static_cast<uint16_t>(JournalEntryType::ORDER)) {
+                    out << "sequence,written_at,req_id,symbol,side,type,quantity,limit_price,"
+                           "state,success,order_id,latency_us\n";
+                }
+            }
+            if (entry.type != header_type) {
+                skipped++;
+                return;
+            }
+            if (entry.type == static_cast<uint16_t>(JournalEntryType::TRADE)) {
+                WriteTrade(out, entry);
+            } else if (entry.type == static_cast<uint16_t>(JournalEntryType::ORDER)) {
+                WriteOrder(out, entry);
+            } else {
+                skipped++;
+                return;
+            }
+            rows++;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    if (!found) {
+        std::cerr << "No journal segments in " << argv[1] << std::endl;
+        return 1;
+    }
+    std::cerr << "Exported " << rows << " entries";
+    if (skipped > 0) {
+        std::cerr << " (skipped " << skipped << " of another type)";
+    }
+    std::cerr << std::endl;
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "logging/log_format.h"
+#include "market_data/timestamp.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Prints a binary log written by AsyncLogger (LoggerConfig::binary_path),
+// one timestamped line per record.
+
+namespace {
+
+const char kBinaryMagic[8] = {'A', 'L', 'O', 'G', 'B', 'I', 'N', '1'};
+
+class ByteReader {
+public:
+    ByteReader(const std::vector<char>& data) : data_(data), offset_(0) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        if (data_.size() - offset_ < sizeof(T)) return false;
+        std::memcpy(&value, data_.data() + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return true;
+    }
+
+    bool ReadBytes(size_t length, const char*& bytes) {
+        if (data_.size() - offset_ < length) return false;
+        bytes = data_.data() + offset_;
+        offset_ += length;
+        return true;
+    }
+
+    bool AtEnd() const {
+        return offset_ == data_.size();
+    }
+
+    size_t Offset() const {
+        return offset_;
+    }
+
+private:
+    const std::vector<char>& data_;
+    size_t offset_;
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <LOG_FILE>" << std::endl;
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << argv[1] << std::endl;
+        return 1;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(kBinaryMagic) || std::memcmp(data.data(), kBinaryMagic, sizeof(kBinaryMagic)) != 0) {
+        std::cerr << "Not an async log file: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    ByteReader reader(data);
+    const char* magic;
+    reader.ReadBytes(sizeof(kBinaryMagic), magic);
+
+    std::unordered_map<uint16_t, LogFormat> formats;
+    std::string line;
+    size_t records = 0;
+    while (!reader.AtEnd()) {
+        size_t entry_offset = reader.Offset();
+        uint8_t kind = 0;
+        uint16_t id = 0;
+        bool ok = reader.Read(kind) && reader.Read(id);
+
+        if (ok && kind == 'F') {
+            uint8_t arg_count = 0;
+            uint32_t length = 0;
+            LogFormat format;
+            ok = reader.Read(arg_count);
+            for (uint8_t i = 0; ok && i < arg_count; i++) {
+                uint8_t type = 0;
+                ok = reader.Read(type);
+                format.args.push_back(static_cast<LogArgType>(type));
+            }
+            const char* text = nullptr;
+            ok = ok && reader.Read(length) && reader.ReadBytes(length, text);
+            if (ok) {
+                format.format.assign(text, length);
+                formats[id] = std::move(format);
+            }
+        } else if (ok && kind == 'R') {
+            int64_t timestamp = 0;
+            uint16_t length = 0;
+            const char* payload = nullptr;
+            ok = reader.Read(timestamp) && reader.Read(length) && reader.ReadBytes(length, payload);
+            if (ok) {
+                line = FormatTimestampNanos(timestamp);
+                line += "  ";
+                auto it = formats.find(id);
+                if (it == formats.end()) {
+                    line += "(unknown format " + std::to_string(id) + ")";
+                } else {
+                    FormatLogMessage(it->second, reinterpret_cast<const uint8_t*>(payload), length, line);
+                }
+                std::cout << line << "\n";
+                records++;
+            }
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            // A log cut off mid-write by a crash ends in a partial entry.
+            std::cerr << "Stopped at byte " << entry_offset << ": truncated or corrupt entry" << std::endl;
+            break;
+        }
+    }
+
+    std::cerr << records << " record(s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,272 @@
+#include "async_logger.h"
+#include "../pipeline/thread_affinity.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+const char kBinaryMagic[8] = {'A', 'L', 'O', 'G', 'B', 'I', 'N', '1'};
+const uint8_t kFormatEntry = 'F';
+const uint8_t kRecordEntry = 'R';
+
+// Records taken from one ring per round, so a chatty thread cannot delay
+// the others' output indefinitely.
+const size_t kDrainBatch = 1024;
+const size_t kFlushThreshold = 1 << 16;
+const auto kIdleSleep = std::chrono::milliseconds(1);
+
+thread_local AsyncLogger* t_ring_owner = nullptr;
+thread_local uint64_t t_ring_generation = 0;
+thread_local void* t_ring = nullptr;
+
+template <typename T>
+void AppendRaw(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void WriteAll(int fd, const std::string& data) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    ssize_t written = ::write(fd, data.data() + offset, data.size() - offset);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    offset += static_cast<size_t>(written);
+  }
+}
+
+}  // namespace
+
+AsyncLogger& AsyncLogger::Global() {
+  static AsyncLogger logger;
+  return logger;
+}
+
+AsyncLogger::AsyncLogger()
+    : formats_(new LogFormat[kMaxFormats]),
+      format_count_(0),
+      ring_generation_(0),
+      active_producers_(0),
+      running_(false),
+      dropped_(0),
+      binary_file_(nullptr),
+      anchor_tsc_(0),
+      anchor_epoch_ns_(0) {
+  // Id 0 absorbs call sites registered after the table is full.
+  formats_[0].format = "(log format table full)";
+  format_count_.store(1, std::memory_order_release);
+}
+
+AsyncLogger::~AsyncLogger() {
+  Stop();
+}
+
+void AsyncLogger::Start(const LoggerConfig& config) {
+  if (running_.load()) return;
+
+  config_ = config;
+  if (!config_.binary_path.empty()) {
+    binary_file_ = std::fopen(config_.binary_path.c_str(), "wb");
+    if (!binary_file_) {
+      throw std::runtime_error("Failed to open log file: " + config_.binary_path);
+    }
+    binary_buffer_.assign(kBinaryMagic, sizeof(kBinaryMagic));
+  }
+  format_written_.assign(kMaxFormats, 0);
+  text_buffer_.reserve(kFlushThreshold * 2);
+  binary_buffer_.reserve(kFlushThreshold * 2);
+
+  TscClock::Calibrate();
+  anchor_tsc_ = TscNow();
+  anchor_epoch_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+
+  running_.store(true, std::memory_order_release);
+  writer_ = std::thread(&AsyncLogger::WriterLoop, this);
+}
+
+void AsyncLogger::Stop() {
+  if (!running_.exchange(false)) return;
+  if (writer_.joinable()) {
+    writer_.join();
+  }
+
+  // A producer that saw running_ before the exchange may still be pushing;
+  // any later one logs synchronously instead.
+  while (active_producers_.load(std::memory_order_acquire) != 0) {
+    std::this_thread::yield();
+  }
+
+  // Records pushed while the writer was finishing its last round.
+  std::vector<LogRecord> batch;
+  while (DrainOnce(batch) > 0) {}
+  FlushOutput();
+
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    rings_.clear();
+    ring_snapshot_.clear();
+    ring_generation_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (binary_file_) {
+    std::fclose(binary_file_);
+    binary_file_ = nullptr;
+  }
+  uint64_t dropped = Dropped();
+  if (dropped > 0) {
+    std::cerr << "Logger dropped " << dropped << " record(s): ring full" << std::endl;
+  }
+}
+
+bool AsyncLogger::Running() const {
+  return running_.load(std::memory_order_acquire);
+}
+
+uint64_t AsyncLogger::Dropped() const {
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+uint16_t AsyncLogger::RegisterFormat(const char* format, std::vector<LogArgType> args) {
+  std::lock_guard<std::mutex> lock(format_mutex_);
+  uint16_t id = format_count_.load(std::memory_order_relaxed);
+  if (id >= kMaxFormats) return 0;
+
+  formats_[id].format = format;
+  formats_[id].args = std::move(args);
+  format_count_.store(static_cast<uint16_t>(id + 1), std::memory_order_release);
+  return id;
+}
+
+AsyncLogger::ThreadRing* AsyncLogger::RingForThisThread() {
+  uint64_t generation = ring_generation_.load(std::memory_order_relaxed);
+  if (t_ring_owner == this && t_ring_generation == generation) {
+    return static_cast<ThreadRing*>(t_ring);
+  }
+
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  rings_.push_back(std::make_unique<ThreadRing>(config_.ring_capacity));
+  t_ring_owner = this;
+  t_ring_generation = generation;
+  t_ring = rings_.back().get();
+  return rings_.back().get();
+}
+
+void AsyncLogger::Submit(const LogRecord& record) {
+  // Both sequentially consistent: either Stop() sees this producer and
+  // waits for it, or this producer sees the stop and logs synchronously.
+  active_producers_.fetch_add(1, std::memory_order_seq_cst);
+  if (running_.load(std::memory_order_seq_cst)) {
+    if (!RingForThisThread()->queue.TryPush(record)) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    active_producers_.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+  active_producers_.fetch_sub(1, std::memory_order_release);
+
+  // Synchronous fallback; stdio keeps ordering with std::cout.
+  std::string line;
+  FormatLogMessage(formats_[record.format_id], record.payload, record.length, line);
+  line.push_back('\n');
+  std::fwrite(line.data(), 1, line.size(), stdout);
+}
+
+void AsyncLogger::WriterLoop() {
+  SetCurrentThreadName("log-writer");
+  std::vector<LogRecord> batch;
+  batch.reserve(kDrainBatch);
+
+  while (running_.load(std::memory_order_acquire)) {
+    size_t written = DrainOnce(batch);
+    FlushOutput();
+    if (written == 0) {
+      std::this_thread::sleep_for(kIdleSleep);
+    }
+  }
+  while (DrainOnce(batch) > 0) {}
+  FlushOutput();
+}
+
+size_t AsyncLogger::DrainOnce(std::vector<LogRecord>& batch) {
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    ring_snapshot_.clear();
+    for (const auto& ring : rings_) ring_snapshot_.push_back(ring.get());
+  }
+
+  batch.clear();
+  LogRecord record;
+  for (ThreadRing* ring : ring_snapshot_) {
+    size_t popped = 0;
+    while (popped < kDrainBatch && ring->queue.TryPop(record)) {
+      batch.push_back(record);
+      popped++;
+    }
+  }
+
+  // Interleave threads in time order; each ring is already ordered.
+  std::stable_sort(batch.begin(), batch.end(),
+                   [](const LogRecord& a, const LogRecord& b) { return a.tsc < b.tsc; });
+  for (const LogRecord& entry : batch) {
+    Emit(entry);
+  }
+  return batch.size();
+}
+
+void AsyncLogger::Emit(const LogRecord& record) {
+  if (config_.text_fd >= 0) {
+    FormatLogMessage(formats_[record.format_id], record.payload, record.length, text_buffer_);
+    text_buffer_.push_back('\n');
+  }
+
+  if (binary_file_) {
+    if (!format_written_[record.format_id]) {
+      WriteFormatDefinition(record.format_id);
+    }
+    AppendRaw(binary_buffer_, kRecordEntry);
+    AppendRaw(binary_buffer_, record.format_id);
+    AppendRaw(binary_buffer_, ToEpochNanos(record.tsc));
+    AppendRaw(binary_buffer_, record.length);
+    binary_buffer_.append(reinterpret_cast<const char*>(record.payload), record.length);
+  }
+
+  if (text_buffer_.size() >= kFlushThreshold || binary_buffer_.size() >= kFlushThreshold) {
+    FlushOutput();
+  }
+}
+
+void AsyncLogger::WriteFormatDefinition(uint16_t id) {
+  const LogFormat& format = formats_[id];
+  AppendRaw(binary_buffer_, kFormatEntry);
+  AppendRaw(binary_buffer_, id);
+  AppendRaw(binary_buffer_, static_cast<uint8_t>(format.args.size()));
+  for (LogArgType type : format.args) {
+    AppendRaw(binary_buffer_, static_cast<uint8_t>(type));
+  }
+  AppendRaw(binary_buffer_, static_cast<uint32_t>(format.format.size()));
+  binary_buffer_.append(format.format);
+  format_written_[id] = 1;
+}
+
+void AsyncLogger::FlushOutput() {
+  if (!text_buffer_.empty()) {
+    WriteAll(config_.text_fd, text_buffer_);
+    text_buffer_.clear();
+  }
+  if (binary_file_ && !binary_buffer_.empty()) {
+    std::fwrite(binary_buffer_.data(), 1, binary_buffer_.size(), binary_file_);
+    std::fflush(binary_file_);
+    binary_buffer_.clear();
+  }
+}
+
+int64_t AsyncLogger::ToEpochNanos(uint64_t tsc) const {
+  int64_t ticks = static_cast<int64_t>(tsc - anchor_tsc_);
+  return anchor_epoch_ns_ + static_cast<int64_t>(static_cast<double>(ticks) * TscClock::NanosPerTick());
+}
@@ -0,0 +1,137 @@
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include "log_format.h"
+#include "../pipeline/spsc_queue.h"
+#include "../pipeline/tsc_clock.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One log call: the call site's format id, a TSC stamp and the raw
+// argument bytes. Formatting happens on the writer thread.
+struct alignas(64) LogRecord {
+  uint64_t tsc;
+  uint16_t format_id;
+  uint16_t length;
+  uint8_t payload[116];
+};
+
+static_assert(sizeof(LogRecord) == 128, "LogRecord must stay two cache lines");
+
+struct LoggerConfig {
+  // Text output, formatted without timestamps; -1 disables it.
+  int text_fd = 1;
+  // Binary log for offline decoding with log_decoder; empty disables it.
+  std::string binary_path;
+  // Records per producer thread; a full ring drops and counts.
+  size_t ring_capacity = 4096;
+};
+
+// Asynchronous logger for the hot path. Each producing thread copies its
+// arguments into a LogRecord on its own SPSC ring (claimed on that thread's
+// first log call) and returns; a background thread drains every ring,
+// orders each batch by timestamp, then formats text and/or appends binary
+// records and writes them in large chunks. Producers never lock, allocate
+// after their first call, or make a syscall.
+//
+// Before Start(), or after Stop(), messages are formatted and written
+// synchronously to stdout, so tools that never start the writer still see
+// their output.
+class AsyncLogger {
+ public:
+  static AsyncLogger& Global();
+
+  ~AsyncLogger();
+
+  void Start(const LoggerConfig& config = LoggerConfig());
+  // Joins the writer, waits for producers mid-call, drains every ring,
+  // flushes and frees the rings. Later calls log synchronously.
+  void Stop();
+  bool Running() const;
+
+  // Returns a stable id for a call site's format; used by ASYNC_LOG.
+  uint16_t RegisterFormat(const char* format, std::vector<LogArgType> args);
+
+  template <typename... Args>
+  void Write(uint16_t format_id, const Args&... args) {
+    LogRecord record;
+    record.tsc = TscNow();
+    record.format_id = format_id;
+    LogArgWriter writer(record.payload, sizeof(record.payload));
+    (writer.Put(args), ...);
+    record.length = static_cast<uint16_t>(writer.Length());
+    Submit(record);
+  }
+
+  uint64_t Dropped() const;
+
+  static constexpr size_t kMaxFormats = 4096;
+
+ private:
+  AsyncLogger();
+
+  struct ThreadRing {
+    explicit ThreadRing(size_t capacity) : queue(capacity) {}
+    SpscQueue<LogRecord> queue;
+  };
+
+  void Submit(const LogRecord& record);
+  ThreadRing* RingForThisThread();
+  void WriterLoop();
+  // Returns the number of records written.
+  size_t DrainOnce(std::vector<LogRecord>& batch);
+  void Emit(const LogRecord& record);
+  void WriteFormatDefinition(uint16_t id);
+  void FlushOutput();
+  int64_t ToEpochNanos(uint64_t tsc) const;
+
+  LoggerConfig config_;
+  std::unique_ptr<LogFormat[]> formats_;
+  std::atomic<uint16_t> format_count_;
+  std::mutex format_mutex_;
+
+  std::mutex rings_mutex_;
+  std::vector<std::unique_ptr<ThreadRing>> rings_;
+  // Bumped when Stop() frees the rings, so a thread's cached ring from an
+  // earlier run is never reused.
+  std::atomic<uint64_t> ring_generation_;
+  // Producers between their running_ check and their push; Stop() waits
+  // for zero before the final drain.
+  std::atomic<uint32_t> active_producers_;
+
+  std::atomic<bool> running_;
+  std::atomic<uint64_t> dropped_;
+  std::thread writer_;
+
+  // Writer thread state.
+  std::string text_buffer_;
+  std::string binary_buffer_;
+  std::vector<ThreadRing*> ring_snapshot_;
+  std::FILE* binary_file_;
+  std::vector<uint8_t> format_written_;
+  uint64_t anchor_tsc_;
+  int64_t anchor_epoch_ns_;
+};
+
+// Logs through the global AsyncLogger. Each call site registers its format
+// string once, on first use:
+//   ASYNC_LOG("Z-Score: {.3} | Hedge: {.4}", z_score, hedge_ratio);
+#define ASYNC_LOG(format, ...) \
+  ::AsyncLogLine([]() -> const char* { return format; }, ##__VA_ARGS__)
+
+template <typename FormatSite, typename... Args>
+inline void AsyncLogLine(FormatSite site, const Args&... args) {
+  // FormatSite is a distinct lambda type per call site, so this static is
+  // too; a function-local static initialises thread-safely.
+  static const uint16_t format_id = AsyncLogger::Global().RegisterFormat(
+      site(), {LogArgTraits<Args>::kType...});
+  AsyncLogger::Global().Write(format_id, args...);
+}
+
+#endif
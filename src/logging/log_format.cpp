@@ -0,0 +1,116 @@
+#include "log_format.h"
+#include "../market_data/timestamp.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+template <typename T>
+bool ReadRaw(const uint8_t*& cursor, const uint8_t* end, T& value) {
+  if (static_cast<size_t>(end - cursor) < sizeof(T)) return false;
+  std::memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return true;
+}
+
+// Placeholder spec between the braces.
+struct ArgSpec {
+  int decimals = -1;
+  bool timestamp = false;
+};
+
+void AppendArg(LogArgType type, const ArgSpec& spec, const uint8_t*& cursor, const uint8_t* end, std::string& out) {
+  char buffer[64];
+  int written = 0;
+  switch (type) {
+    case LogArgType::INT64: {
+      int64_t value;
+      if (!ReadRaw(cursor, end, value)) break;
+      if (spec.timestamp) {
+        out += FormatTimestampNanos(value);
+        return;
+      }
+      written = std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+      break;
+    }
+    case LogArgType::UINT64: {
+      uint64_t value;
+      if (!ReadRaw(cursor, end, value)) break;
+      written = std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+      break;
+    }
+    case LogArgType::DOUBLE: {
+      double value;
+      if (!ReadRaw(cursor, end, value)) break;
+      // Default matches an unadorned ostream: six significant digits.
+      written = spec.decimals >= 0 ? std::snprintf(buffer, sizeof(buffer), "%.*f", spec.decimals, value)
+                              : std::snprintf(buffer, sizeof(buffer), "%g", value);
+      break;
+    }
+    case LogArgType::DECIMAL: {
+      Decimal value;
+      uint8_t scale;
+      if (!ReadRaw(cursor, end, value.mantissa) || !ReadRaw(cursor, end, scale) || scale > kMaxDecimalScale) break;
+      value.scale = scale;
+      if (spec.decimals >= 0) Rescale(value, std::min(spec.decimals, kMaxDecimalScale));
+      written = static_cast<int>(ToChars(buffer, buffer + sizeof(buffer), value).ptr - buffer);
+      break;
+    }
+    case LogArgType::STRING: {
+      uint16_t length;
+      if (!ReadRaw(cursor, end, length)) break;
+      length = static_cast<uint16_t>(std::min<size_t>(length, static_cast<size_t>(end - cursor)));
+      out.append(reinterpret_cast<const char*>(cursor), length);
+      cursor += length;
+      return;
+    }
+  }
+
+  if (written > 0) {
+    out.append(buffer, std::min<size_t>(static_cast<size_t>(written), sizeof(buffer) - 1));
+  } else {
+    out.push_back('?');
+    cursor = end;
+  }
+}
+
+}  // namespace
+
+void FormatLogMessage(const LogFormat& format, const uint8_t* payload, size_t length, std::string& out) {
+  const std::string& text = format.format;
+  const uint8_t* cursor = payload;
+  const uint8_t* end = payload + length;
+  size_t next_arg = 0;
+
+  for (size_t i = 0; i < text.size(); i++) {
+    char c = text[i];
+    if (c != '{') {
+      out.push_back(c);
+      continue;
+    }
+    if (i + 1 < text.size() && text[i + 1] == '{') {
+      out.push_back('{');
+      i++;
+      continue;
+    }
+
+    size_t close = text.find('}', i);
+    if (close == std::string::npos) {
+      out.append(text, i, std::string::npos);
+      return;
+    }
+
+    ArgSpec spec;
+    if (close > i + 2 && text[i + 1] == '.') {
+      spec.decimals = std::atoi(text.c_str() + i + 2);
+    } else if (close == i + 2 && text[i + 1] == 't') {
+      spec.timestamp = true;
+    }
+    if (next_arg < format.args.size()) {
+      AppendArg(format.args[next_arg++], spec, cursor, end, out);
+    } else {
+      out.push_back('?');
+    }
+    i = close;
+  }
+}
@@ -0,0 +1,119 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include "../market_data/decimal.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+enum class LogArgType : uint8_t {
+  INT64,
+  UINT64,
+  DOUBLE,
+  // uint16 length followed by the bytes, truncated to fit the record.
+  STRING,
+  // int64 mantissa followed by a uint8 scale, rendered without rounding
+  // through double.
+  DECIMAL
+};
+
+// A registered format string and the types of the arguments its call site
+// passes. Placeholders are "{}" for the default rendering, "{.N}" for a
+// double or decimal with N decimals and "{t}" for an integer of nanoseconds
+// since the epoch as an RFC 3339 timestamp; "{{" is a literal brace.
+struct LogFormat {
+  std::string format;
+  std::vector<LogArgType> args;
+};
+
+// Renders one record's argument bytes through its format, appending to out.
+// Missing or truncated arguments render as "?".
+void FormatLogMessage(const LogFormat& format, const uint8_t* payload, size_t length, std::string& out);
+
+template <typename T, typename Enable = void>
+struct LogArgTraits;
+
+template <typename T>
+struct LogArgTraits<T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type> {
+  static constexpr LogArgType kType = LogArgType::INT64;
+};
+
+template <typename T>
+struct LogArgTraits<T, typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type> {
+  static constexpr LogArgType kType = LogArgType::UINT64;
+};
+
+template <typename T>
+struct LogArgTraits<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static constexpr LogArgType kType = LogArgType::DOUBLE;
+};
+
+template <typename T>
+struct LogArgTraits<T, typename std::enable_if<std::is_convertible<const T&, std::string_view>::value>::type> {
+  static constexpr LogArgType kType = LogArgType::STRING;
+};
+
+template <>
+struct LogArgTraits<Decimal> {
+  static constexpr LogArgType kType = LogArgType::DECIMAL;
+};
+
+// Appends arguments to a fixed payload buffer. Numbers are stored as raw
+// 8-byte values; strings that do not fit are cut short, never overrun.
+class LogArgWriter {
+ public:
+  LogArgWriter(uint8_t* buffer, size_t capacity) : out_(buffer), begin_(buffer), end_(buffer + capacity) {}
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type Put(T value) {
+    PutRaw(static_cast<int64_t>(value));
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type Put(T value) {
+    PutRaw(static_cast<uint64_t>(value));
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_floating_point<T>::value>::type Put(T value) {
+    PutRaw(static_cast<double>(value));
+  }
+
+  void Put(const Decimal& value) {
+    if (static_cast<size_t>(end_ - out_) < sizeof(int64_t) + sizeof(uint8_t)) return;
+    PutRaw(value.mantissa);
+    PutRaw(static_cast<uint8_t>(value.scale));
+  }
+
+  void Put(std::string_view value) {
+    if (static_cast<size_t>(end_ - out_) < sizeof(uint16_t)) return;
+    uint16_t length = static_cast<uint16_t>(
+        std::min(value.size(), static_cast<size_t>(end_ - out_) - sizeof(uint16_t)));
+    std::memcpy(out_, &length, sizeof(length));
+    std::memcpy(out_ + sizeof(length), value.data(), length);
+    out_ += sizeof(length) + length;
+  }
+
+  size_t Length() const {
+    return static_cast<size_t>(out_ - begin_);
+  }
+
+ private:
+  template <typename T>
+  void PutRaw(T value) {
+    if (static_cast<size_t>(end_ - out_) < sizeof(T)) return;
+    std::memcpy(out_, &value, sizeof(T));
+    out_ += sizeof(T);
+  }
+
+  uint8_t* out_;
+  uint8_t* begin_;
+  uint8_t* end_;
+};
+
+#endif
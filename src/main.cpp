@@ -1,9 +1,32 @@
 #include "rest/kraken_base.h"
-#include "websocket/kraken_websocket_candle_stream.h"
+#include "rest/kraken_asset_pairs.h"
+#include "rest/kraken_ohlc_history.h"
+#include "websocket/sharded_candle_client.h"
+#include "websocket/kraken_websocket_book_stream.h"
+#include "websocket/kraken_websocket_trade_stream.h"
+#include "market_data/bar_aggregator.h"
+#include "storage/candle_store.h"
+#include "storage/trade_journal.h"
+#include "storage/snapshot_file.h"
+#include "pipeline/strategy_pipeline.h"
+#include "pipeline/latency_recorder.h"
+#include "logging/async_logger.h"
+#include "traders/multi_pair_arbitrage_engine.h"
+#include "traders/spread_order_router.h"
 #include <iostream>
 #include <cstdlib>
 #include <csignal>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #define RESET   "\033[0m"
 #define BOLD    "\033[1m"
@@ -14,49 +37,206 @@
 #define CYAN    "\033[36m"
 #define MAGENTA "\033[35m"
 
-KrakenCandleStream* g_stream = nullptr;
+ShardedCandleClient* g_client = nullptr;
+KrakenOrderGateway* g_gateway = nullptr;
+KrakenBookStream* g_book_stream = nullptr;
+KrakenTradeStream* g_trade_stream = nullptr;
 
+void printPipelineStats(const PipelineStats& stats) {
+    std::cout << "Pipeline: published " << stats.published
+              << " | consumed " << stats.consumed
+              << " | dropped " << stats.dropped
+              << " | max depth " << stats.max_depth << "/" << stats.capacity << std::endl;
+}
+
+// Only async-signal-safe work here: Stop() sets an atomic flag and writes to
+// the loop's eventfd. Flushing and teardown happen once Run() returns.
 void signalHandler(int signal) {
-    std::cout << "\n" << YELLOW << "Shutting down gracefully..." << RESET << std::endl;
-    if (g_stream) {
-        g_stream->Stop();
+    (void)signal;
+    if (g_client) {
+        g_client->Stop();
+    }
+    if (g_gateway) {
+        g_gateway->Stop();
+    }
+    if (g_book_stream) {
+        g_book_stream->Stop();
+    }
+    if (g_trade_stream) {
+        g_trade_stream->Stop();
     }
-    exit(0);
 }
 
+// SIGUSR1: only flags the request; the reporter thread prints.
+void dumpLatencyHandler(int signal) {
+    (void)signal;
+    LatencyRecorder::RequestDump();
+}
+
+// Runs on the strategy thread; the logger formats and writes the block on
+// its own thread, so a candle costs one ring push instead of nine flushes.
 void printCandle(const Candle& candle) {
-    static double last_close = 0;
+    static std::vector<int64_t> last_closes(SymbolRegistry::kMaxSymbols, 0);
+    int64_t& last_close = last_closes[candle.symbol];
     bool is_up = (last_close == 0 || candle.close >= last_close);
+    int scale = MarketPrecision(candle.symbol).price_decimals;
     
-    std::cout << BOLD << CYAN << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━" << RESET << std::endl;
-    std::cout << BOLD << BLUE << candle.symbol << RESET 
-              << " | " << MAGENTA << candle.interval_begin << RESET << std::endl;
-    std::cout << std::fixed << std::setprecision(2);
-    
-    std::cout << "  Open:   " << YELLOW << "$" << candle.open << RESET << std::endl;
-    std::cout << "  High:   " << GREEN << "$" << candle.high << RESET << std::endl;
-    std::cout << "  Low:    " << RED << "$" << candle.low << RESET << std::endl;
-    std::cout << "  Close:  " << (is_up ? GREEN : RED) << "$" << candle.close 
-              << " " << (is_up ? "▲" : "▼") << RESET << std::endl;
-    std::cout << "  Volume: " << CYAN << candle.volume << RESET << std::endl;
-    std::cout << "  VWAP:   " << YELLOW << "$" << candle.vwap << RESET << std::endl;
-    std::cout << "  Trades: " << candle.trades << std::endl;
+    ASYNC_LOG(BOLD CYAN "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━" RESET "\n"
+              BOLD BLUE "{}" RESET " | " MAGENTA "{t}" RESET "\n"
+              "  Open:   " YELLOW "${.2}" RESET "\n"
+              "  High:   " GREEN "${.2}" RESET "\n"
+              "  Low:    " RED "${.2}" RESET "\n"
+              "  Close:  {}${.2} {}" RESET "\n"
+              "  Volume: " CYAN "{.2}" RESET "\n"
+              "  VWAP:   " YELLOW "${.2}" RESET "\n"
+              "  Trades: {}",
+              SymbolRegistry::Global().Name(candle.symbol), candle.interval_begin,
+              Decimal{candle.open, scale}, Decimal{candle.high, scale}, Decimal{candle.low, scale},
+              is_up ? GREEN : RED, Decimal{candle.close, scale}, is_up ? "▲" : "▼",
+              QtyDecimal(candle.symbol, candle.volume), Decimal{candle.vwap, scale}, candle.trades);
     
     last_close = candle.close;
 }
 
 int main(int argc, char* argv[]) {
     std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+    std::signal(SIGUSR1, dumpLatencyHandler);
     
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <SYMBOL> [INTERVAL]" << std::endl;
+    std::vector<std::string> args;
+    std::string record_dir;
+    std::string journal_dir;
+    std::string snapshot_path;
+    LoggerConfig logger_config;
+    PipelineConfig pipeline_config;
+    int network_cpu = -1;
+    size_t shards = 1;
+    std::string trade_pair;
+    std::string pairs_text;
+    size_t screen_pairs = 0;
+    double order_size = 0.0;
+    bool live_orders = false;
+    size_t book_depth = 0;
+    std::string bar_text;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc) {
+            record_dir = argv[++i];
+        } else if (arg == "--journal" && i + 1 < argc) {
+            journal_dir = argv[++i];
+        } else if (arg == "--snapshot" && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else if (arg == "--log" && i + 1 < argc) {
+            logger_config.binary_path = argv[++i];
+        } else if (arg == "--queue" && i + 1 < argc) {
+            pipeline_config.queue_capacity = std::stoul(argv[++i]);
+        } else if (arg == "--busy-poll") {
+            pipeline_config.wait_mode = WaitMode::BUSY_POLL;
+        } else if (arg == "--strategy-cpu" && i + 1 < argc) {
+            pipeline_config.strategy_cpu = std::stoi(argv[++i]);
+        } else if (arg == "--network-cpu" && i + 1 < argc) {
+            network_cpu = std::stoi(argv[++i]);
+        } else if (arg == "--shards" && i + 1 < argc) {
+            shards = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--trade" && i + 1 < argc) {
+            trade_pair = argv[++i];
+        } else if (arg == "--pairs" && i + 1 < argc) {
+            pairs_text = argv[++i];
+        } else if (arg == "--screen" && i + 1 < argc) {
+            screen_pairs = std::stoul(argv[++i]);
+        } else if (arg == "--order-size" && i + 1 < argc) {
+            order_size = std::stod(argv[++i]);
+        } else if (arg == "--live") {
+            live_orders = true;
+        } else if (arg == "--book" && i + 1 < argc) {
+            book_depth = std::stoul(argv[++i]);
+        } else if (arg == "--bars" && i + 1 < argc) {
+            bar_text = argv[++i];
+        } else {
+            args.push_back(arg);
+        }
+    }
+    
+    if (args.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <SYMBOL[,SYMBOL...]> [INTERVAL] [--record STORE_DIR] [--log LOG_FILE]"
+                  << " [--shards N] [--queue N] [--busy-poll] [--strategy-cpu N] [--network-cpu N] [--book DEPTH]"
+                  << " [--bars time:SEC|tick:N|volume:QTY|dollar:NOTIONAL] [--pairs Y:X,...] [--screen N]"
+                  << " [--trade Y,X --order-size QTY [--live] [--journal DIR] [--snapshot FILE]]" << std::endl;
         std::cerr << "Example: " << argv[0] << " BTC/USD 1" << std::endl;
-        std::cerr << "Example: " << argv[0] << " ETH/USD 60" << std::endl;
+        std::cerr << "Example: " << argv[0] << " BTC/USD,ETH/USD,SOL/USD,XRP/USD 1 --shards 2" << std::endl;
+        std::cerr << "Example: " << argv[0] << " ETH/USD 60 --record data/eth_60" << std::endl;
+        std::cerr << "Example: " << argv[0] << " BTC/USD,ETH/USD 1 --trade BTC/USD,ETH/USD --order-size 0.001" << std::endl;
+        std::cerr << "Example: " << argv[0] << " BTC/USD,ETH/USD 1 --trade BTC/USD,ETH/USD --order-size 0.001 --bars time:5"
+                  << std::endl;
+        std::cerr << "Example: " << argv[0] << " BTC/USD,ETH/USD,SOL/USD 1 --pairs BTC/USD:ETH/USD,SOL/USD:ETH/USD"
+                  << std::endl;
+        std::cerr << "Example: " << argv[0] << " BTC/USD,ETH/USD,SOL/USD,XRP/USD,ADA/USD 1 --screen 3" << std::endl;
+        return 1;
+    }
+    
+    std::vector<std::string> symbols;
+    std::stringstream symbol_list(args[0]);
+    for (std::string symbol; std::getline(symbol_list, symbol, ',');) {
+        if (!symbol.empty()) symbols.push_back(symbol);
+    }
+    if (symbols.empty()) {
+        std::cerr << RED << "Error: no symbols given" << RESET << std::endl;
         return 1;
     }
+    int interval = (args.size() >= 2) ? std::stoi(args[1]) : 1;
     
-    std::string symbol = argv[1];
-    int interval = (argc >= 3) ? std::stoi(argv[2]) : 1;
+    // --pairs runs one model per pair over the subscribed symbols on the
+    // strategy thread and logs their signals; orders only go out for the
+    // --trade pair. --screen ranks every subscribed symbol over the first
+    // window of bars and adds the N most cointegrated pairs to the same
+    // engine.
+    std::unique_ptr<MultiPairArbitrageEngine> pair_engine;
+    std::unique_ptr<PairScreener> screener;
+    if (!pairs_text.empty() || screen_pairs > 0) {
+        std::vector<std::pair<std::string, std::string>> pairs;
+        if (!pairs_text.empty() && !ParsePairList(pairs_text, pairs)) {
+            std::cerr << RED << "Error: --pairs takes Y:X[,Y:X...], each pair once" << RESET << std::endl;
+            return 1;
+        }
+        if (screen_pairs > 0 && symbols.size() < 2) {
+            std::cerr << RED << "Error: --screen needs at least two symbols" << RESET << std::endl;
+            return 1;
+        }
+        pair_engine = std::make_unique<MultiPairArbitrageEngine>();
+        // Signals are logged as they happen; memory holds the latest only.
+        pair_engine->SetTradeLogCapacity(1024);
+        for (const auto& legs : pairs) {
+            for (const std::string& symbol : {legs.first, legs.second}) {
+                if (std::find(symbols.begin(), symbols.end(), symbol) == symbols.end()) {
+                    std::cerr << RED << "Error: --pairs leg " << symbol << " is not subscribed" << RESET << std::endl;
+                    return 1;
+                }
+            }
+            pair_engine->AddPair(legs.first, legs.second);
+        }
+        pair_engine->SetSignalCallback([&pair_engine](const PairTrade& trade) {
+            ASYNC_LOG("Pair {} / {} {} | Z: {} | Hedge: {}", pair_engine->PairYSymbol(trade.pair),
+                      pair_engine->PairXSymbol(trade.pair),
+                      trade.signal == Signal::LONG_SPREAD ? "LONG_SPREAD"
+                      : trade.signal == Signal::SHORT_SPREAD ? "SHORT_SPREAD" : "EXIT",
+                      trade.z_score, trade.hedge_ratio);
+        });
+        if (screen_pairs > 0) {
+            screener = std::make_unique<PairScreener>();
+            for (const std::string& symbol : symbols) {
+                screener->AddSymbol(symbol);
+            }
+        }
+    }
+    
+    // With --bars the trader runs on bars built from the trade stream; the
+    // ohlc candles are still printed and recorded.
+    BarSpec bar_spec;
+    bool trade_bars = !bar_text.empty();
+    if (trade_bars && !ParseBarSpec(bar_text, bar_spec)) {
+        std::cerr << RED << "Error: --bars takes time:SEC, tick:N, volume:QTY or dollar:NOTIONAL" << RESET << std::endl;
+        return 1;
+    }
     
     const char* api_key = std::getenv("KRAKEN_API_KEY");
     const char* api_secret = std::getenv("KRAKEN_PRIVATE_KEY");
@@ -68,26 +248,390 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    std::string y_symbol;
+    std::string x_symbol;
+    if (!trade_pair.empty()) {
+        size_t comma = trade_pair.find(',');
+        if (comma == std::string::npos || !api_key || !api_secret || order_size <= 0.0) {
+            std::cerr << RED << "Error: --trade needs Y,X, --order-size and KRAKEN_API_KEY/KRAKEN_PRIVATE_KEY"
+                      << RESET << std::endl;
+            return 1;
+        }
+        y_symbol = trade_pair.substr(0, comma);
+        x_symbol = trade_pair.substr(comma + 1);
+    }
+    
+    AsyncLogger::Global().Start(logger_config);
+    
+    // Without keys only public endpoints (AssetPairs, OHLC) can be used.
+    auto kraken = std::make_unique<KrakenBase>(api_key ? api_key : "", api_secret ? api_secret : "", base_endpoint);
     if (api_key && api_secret) {
-        KrakenBase kraken(api_key, api_secret, base_endpoint);
         std::cout << BOLD << "Fetching balance..." << RESET << std::endl;
-        std::string balance = kraken.GetAccountBalance();
+        std::string balance = kraken->GetAccountBalance();
         std::cout << balance << "\n" << std::endl;
     }
     
+    // Trades and order acks are journaled as they happen, each by the one
+    // thread that produces them; export with journal_export.
+    std::unique_ptr<TradeJournal> trade_journal;
+    std::unique_ptr<TradeJournal> order_journal;
+    if (!trade_pair.empty() && !journal_dir.empty()) {
+        trade_journal = std::make_unique<TradeJournal>(journal_dir + "/trades");
+        order_journal = std::make_unique<TradeJournal>(journal_dir + "/orders");
+        std::cout << "Journaling trades and orders to " << journal_dir << std::endl;
+    }
+    
+    // Order entry runs on its own authenticated socket and thread, so order
+    // writes never queue behind market data.
+    std::unique_ptr<StatisticalArbitrageTrader> trader;
+    std::unique_ptr<KrakenOrderGateway> gateway;
+    std::unique_ptr<SpreadOrderRouter> router;
+    std::thread gateway_thread;
+    if (!trade_pair.empty()) {
+        trader = std::make_unique<StatisticalArbitrageTrader>(
+            100, 2.0, 0.5, HedgeRatioMode::INCREMENTAL_OLS, y_symbol, x_symbol);
+        // The journal keeps the full history; memory holds the latest only.
+        trader->SetTradeLogCapacity(1024);
+        trader->SetJournal(trade_journal.get());
+        // The snapshot restores the windows and position as of the last bar
+        // it saw. The router always starts flat and cannot tell which legs
+        // filled before the restart, so it would drop the EXIT of a restored
+        // spread and strand its legs; with live orders that is refused
+        // before any order can go out.
+        if (!snapshot_path.empty() && trader->LoadSnapshot(snapshot_path)) {
+            std::cout << "Restored model state from " << snapshot_path << std::endl;
+            if (live_orders && trader->CurrentPosition() != Position::NONE) {
+                std::cerr << RED << "Error: " << snapshot_path << " holds an open spread; close both legs"
+                          << " on the exchange and remove the snapshot before trading live" << RESET << std::endl;
+                return 1;
+            }
+        }
+
+        const char* ws_auth_endpoint = std::getenv("BASE_WS_AUTH_ENDPOINT");
+        gateway = std::make_unique<KrakenOrderGateway>(
+            ws_auth_endpoint ? ws_auth_endpoint : "wss://ws-auth.kraken.com/v2", *kraken);
+        gateway->SetValidateOnly(!live_orders);
+        gateway->SetReconnect(true);
+        // The router follows the acks to know which legs are really open,
+        // so it exists before the gateway can deliver any.
+        router = std::make_unique<SpreadOrderRouter>(*gateway, order_size);
+        gateway->SetOrderCallback([&order_journal, &router](const OrderAck& ack) {
+            router->OnOrderAck(ack);
+            ASYNC_LOG("Order {} {} {} {} in {} us", ack.req_id, OrderStateName(ack.state),
+                      ack.order_id, ack.error, (ack.ack_ns - ack.sent_ns) / 1000);
+            if (order_journal) {
+                OrderJournalRecord record;
+                std::memset(&record, 0, sizeof(record));
+                record.req_id = ack.req_id;
+                record.sent_ns = ack.sent_ns;
+                record.ack_ns = ack.ack_ns;
+                record.quantity = ack.request.quantity.ToDouble();
+                record.limit_price = ack.request.limit_price.ToDouble();
+                CopyJournalString(record.symbol, sizeof(record.symbol),
+                                  SymbolRegistry::Global().Name(ack.request.symbol));
+                CopyJournalString(record.order_id, sizeof(record.order_id), ack.order_id);
+                record.state = static_cast<uint8_t>(ack.state);
+                record.side = static_cast<uint8_t>(ack.request.side);
+                record.order_type = static_cast<uint8_t>(ack.request.type);
+                record.success = ack.success ? 1 : 0;
+                order_journal->Append(JournalEntryType::ORDER, record);
+            }
+        });
+        gateway->Authenticate();
+        gateway->Connect();
+        g_gateway = gateway.get();
+        gateway_thread = std::thread([&gateway]() { gateway->Run(); });
+
+        // Orders go out at each pair's lot size and books at its tick.
+        try {
+            FetchPairPrecision(*kraken, {y_symbol, x_symbol});
+        } catch (const std::exception& e) {
+            std::cerr << YELLOW << "Pair precision unknown, using 8 volume decimals: " << e.what()
+                      << RESET << std::endl;
+        }
+        trader->SetTradeCallback([&router](const Trade& trade) { router->OnTrade(trade); });
+        
+        // Warm start: REST history fills the bars since the snapshot (or a
+        // full lookback when starting cold), and the trader ignores the
+        // stream's replay of anything already folded in.
+        int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        int64_t interval_ns = static_cast<int64_t>(interval) * 60 * 1000000000LL;
+        int64_t since_ns = trader->LastBarTime() != std::numeric_limits<int64_t>::min()
+            ? trader->LastBarTime()
+            : now_ns - static_cast<int64_t>(trader->WarmUpBars() + 1) * interval_ns;
+        // REST history only matches bars sampled like the ohlc stream.
+        bool rest_history = !trade_bars || (bar_spec.type == BarType::TIME && bar_spec.size == interval * 60.0);
+        if (rest_history) {
+            try {
+                auto fetch_start = std::chrono::steady_clock::now();
+                std::vector<Candle> history = FetchOhlcHistory(*kraken, {y_symbol, x_symbol}, interval,
+                                                               since_ns, now_ns);
+                trader->WarmUp(history);
+                std::cout << "Warmed up on " << history.size() << " historical bars in "
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now() - fetch_start).count()
+                          << " ms" << (trader->IsWarm() ? "" : " (window not full yet)") << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << YELLOW << "Warm-up skipped: " << e.what() << RESET << std::endl;
+            }
+        } else {
+            std::cout << YELLOW << "Warm-up skipped: REST history has no " << bar_text << " bars" << RESET << std::endl;
+        }
+        
+        std::cout << (live_orders ? RED : YELLOW) << "Trading " << y_symbol << " vs " << x_symbol
+                  << (live_orders ? " with LIVE orders" : " (validate only)") << RESET << std::endl;
+    }
+    
     std::cout << BOLD << GREEN << "Connecting to Kraken WebSocket..." << RESET << std::endl;
-    KrakenCandleStream candleStream(ws_endpoint);
-    g_stream = &candleStream;
+    ShardedCandleClient client(ws_endpoint, std::min(shards, symbols.size()));
+    client.SetReconnect(true);
+    
+    std::unique_ptr<CandleStoreWriter> recorder;
+    if (!record_dir.empty()) {
+        recorder = std::make_unique<CandleStoreWriter>(record_dir);
+        std::cout << "Recording candles to " << record_dir << std::endl;
+    }
     
-    candleStream.SetCandleCallback(printCandle);
-    candleStream.Connect();
-    candleStream.SubscribeCandles(symbol, interval);
+    // Socket threads only parse and publish, each into its own ring;
+    // printing and recording run on the strategy thread so they never hold
+    // up the next read.
+    // Books stream on their own socket and thread, publishing into the lane
+    // after the shards'; they cover the traded pair, or every symbol.
+    std::unique_ptr<KrakenBookStream> book_stream;
+    std::thread book_thread;
+    std::vector<std::string> book_symbols = trade_pair.empty() ? symbols : std::vector<std::string>{y_symbol, x_symbol};
+    if (book_depth > 0) {
+        book_stream = std::make_unique<KrakenBookStream>(ws_endpoint, book_depth);
+        book_stream->SetReconnect(true);
+        // Books are built at each pair's listed decimals; guessed ones fail
+        // the checksum until the book resyncs.
+        std::vector<std::string> unpinned;
+        for (const std::string& symbol : book_symbols) {
+            SymbolPrecision precision;
+            if (!PrecisionTable::Global().Find(SymbolRegistry::Global().Find(symbol), precision)) {
+                unpinned.push_back(symbol);
+            }
+        }
+        if (!unpinned.empty()) {
+            try {
+                FetchPairPrecision(*kraken, unpinned);
+            } catch (const std::exception& e) {
+                std::cerr << YELLOW << "Book precision unknown, checksums may fail until resync: " << e.what()
+                          << RESET << std::endl;
+            }
+        }
+    }
+    // Trades likewise get their own socket, thread and lane; bars are built
+    // on that thread as trades arrive.
+    std::unique_ptr<KrakenTradeStream> trade_stream;
+    std::unique_ptr<BarAggregator> aggregator;
+    std::thread trade_thread;
+    if (trade_bars) {
+        trade_stream = std::make_unique<KrakenTradeStream>(ws_endpoint);
+        trade_stream->SetReconnect(true);
+        aggregator = std::make_unique<BarAggregator>(bar_spec);
+    }
+    pipeline_config.producers = client.ShardCount() + (book_stream ? 1 : 0) + (trade_stream ? 1 : 0);
+    StrategyPipeline pipeline(pipeline_config);
+    // The strategy thread serializes the trader just before the first update
+    // of each new bar, so a snapshot only ever covers finished bars; the
+    // reporter thread does the file I/O.
+    std::mutex snapshot_mutex;
+    std::string pending_snapshot;
+    int64_t snapshot_bar = std::numeric_limits<int64_t>::min();
+    MarketEventType trader_bars = trade_bars ? MarketEventType::BAR : MarketEventType::CANDLE;
+    int64_t screen_bar = std::numeric_limits<int64_t>::min();
+    pipeline.Start([&recorder, &trader, &pair_engine, &screener, &snapshot_path, &snapshot_mutex,
+                    &pending_snapshot, &snapshot_bar, &screen_bar, screen_pairs, trader_bars](const MarketEvent& event) {
+        if (event.type == MarketEventType::TOP_OF_BOOK) {
+            if (trader) {
+                trader->OnTopOfBook(event.top_of_book);
+            }
+            return;
+        }
+        if (event.type == MarketEventType::CANDLE && recorder) {
+            recorder->Append(event.candle);
+        }
+        if (trader && event.type == trader_bars) {
+            if (!snapshot_path.empty() && event.candle.interval_begin > snapshot_bar) {
+                if (snapshot_bar != std::numeric_limits<int64_t>::min()) {
+                    std::lock_guard<std::mutex> lock(snapshot_mutex);
+                    pending_snapshot.clear();
+                    trader->WriteSnapshot(pending_snapshot);
+                }
+                snapshot_bar = event.candle.interval_begin;
+            }
+            trader->OnCandle(event.candle);
+        }
+        if (screener && event.type == trader_bars) {
+            // A new bar closes the last one; once the window is full the
+            // ranking seeds the engine and the screener is done.
+            if (event.candle.interval_begin > screen_bar) {
+                if (screen_bar != std::numeric_limits<int64_t>::min()) {
+                    screener->CloseBar();
+                }
+                screen_bar = event.candle.interval_begin;
+            }
+            if (screener->Ready()) {
+                size_t added = pair_engine->AddScreenedPairs(screener->Screen(), screen_pairs);
+                ASYNC_LOG("Screened {} symbols over {} bars: {} pair(s) added", screener->SymbolCount(),
+                          screener->BarCount(), added);
+                screener.reset();
+            } else {
+                screener->UpdatePrice(SymbolRegistry::Global().Name(event.candle.symbol),
+                                      PriceDecimal(event.candle.symbol, event.candle.close));
+            }
+        }
+        if (pair_engine && event.type == trader_bars) {
+            pair_engine->OnCandle(event.candle);
+        }
+        if (event.type == MarketEventType::CANDLE) {
+            printCandle(event.candle);
+        }
+    });
+    client.SetCandleCallback([&pipeline](size_t shard, const Candle& candle) {
+        pipeline.PublishCandle(candle, shard);
+    });
+    
+    if (network_cpu >= 0) {
+        std::vector<int> cpus;
+        for (size_t i = 0; i < client.ShardCount(); i++) {
+            cpus.push_back(network_cpu + static_cast<int>(i));
+        }
+        client.SetShardCpus(cpus);
+    }
+    client.SubscribeCandles(symbols, interval);
+    if (book_stream) {
+        size_t book_lane = client.ShardCount();
+        book_stream->SetTopOfBookCallback([&pipeline, book_lane](const TopOfBook& top) {
+            pipeline.PublishTopOfBook(top, book_lane);
+        });
+        book_stream->SubscribeBook(book_symbols);
+        book_stream->Connect();
+        g_book_stream = book_stream.get();
+        book_thread = std::thread([&book_stream]() { book_stream->Run(); });
+        std::cout << "Streaming books " << book_depth << " levels deep" << std::endl;
+    }
+    if (trade_stream) {
+        size_t trade_lane = client.ShardCount() + (book_stream ? 1 : 0);
+        aggregator->SetBarCallback([&pipeline, trade_lane](const Candle& bar) {
+            pipeline.PublishBar(bar, trade_lane);
+        });
+        trade_stream->SetTradeCallback([&aggregator](const TradeTick& trade) { aggregator->OnTrade(trade); });
+        if (bar_spec.type == BarType::TIME) {
+            // Quiet symbols close on the clock, a little after each boundary
+            // so prints still in flight make it into their bar.
+            const int64_t grace_ns = 200 * 1000000LL;
+            int64_t bar_ns = aggregator->BarNanos();
+            int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            int64_t delay_ns = bar_ns - now_ns % bar_ns + grace_ns;
+            // The timer runs on the monotonic clock, so each fire closes the
+            // boundary it was scheduled for rather than re-reading wall time.
+            int64_t boundary = now_ns - now_ns % bar_ns + bar_ns;
+            int64_t due_ns = EventLoop::NowNanos() + delay_ns;
+            trade_stream->Loop().AddTimer(delay_ns, bar_ns, [&aggregator, boundary, due_ns, bar_ns]() mutable {
+                // A stalled loop skips fires; catch the boundary up with them.
+                while (EventLoop::NowNanos() >= due_ns + bar_ns) {
+                    boundary += bar_ns;
+                    due_ns += bar_ns;
+                }
+                aggregator->CloseBarsBefore(boundary);
+                boundary += bar_ns;
+                due_ns += bar_ns;
+            });
+        }
+        trade_stream->SubscribeTrades(trade_pair.empty() ? symbols : std::vector<std::string>{y_symbol, x_symbol});
+        trade_stream->Connect();
+        g_trade_stream = trade_stream.get();
+        trade_thread = std::thread([&trade_stream]() { trade_stream->Run(); });
+        std::cout << "Building " << bar_text << " bars from trades" << std::endl;
+    }
     
-    std::cout << BOLD << CYAN << "\n📊 Streaming " << symbol << " candles (" 
-              << interval << " min intervals)" << RESET << std::endl;
+    std::cout << BOLD << CYAN << "\n📊 Streaming " << symbols.size() << " symbol(s) over "
+              << client.ShardCount() << " connection(s) (" << interval << " min intervals)" << RESET << std::endl;
     std::cout << YELLOW << "Press Ctrl+C to stop...\n" << RESET << std::endl;
     
-    candleStream.Run();
+    // Recording costs a few TSC reads per event; `kill -USR1 <pid>` prints
+    // the per-stage percentiles without stopping the stream.
+    LatencyRecorder::Enable();
+    std::atomic<bool> reporting(true);
+    auto write_pending_snapshot = [&snapshot_path, &snapshot_mutex, &pending_snapshot]() {
+        std::string bytes;
+        {
+            std::lock_guard<std::mutex> lock(snapshot_mutex);
+            bytes.swap(pending_snapshot);
+        }
+        if (!bytes.empty()) {
+            WriteSnapshotFile(snapshot_path, bytes);
+        }
+    };
+    std::thread latency_reporter([&reporting, &write_pending_snapshot]() {
+        while (reporting.load()) {
+            if (LatencyRecorder::TakeDumpRequest()) {
+                LatencyRecorder::Report(std::cout);
+            }
+            write_pending_snapshot();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    });
     
+    g_client = &client;
+    client.Start();
+    client.Join();
+    g_client = nullptr;
+    
+    std::cout << "\n" << YELLOW << "Shutting down gracefully..." << RESET << std::endl;
+    if (book_stream) {
+        book_stream->Stop();
+        book_thread.join();
+        g_book_stream = nullptr;
+    }
+    if (trade_stream) {
+        trade_stream->Stop();
+        trade_thread.join();
+        g_trade_stream = nullptr;
+    }
+    pipeline.Stop();
+    reporting = false;
+    latency_reporter.join();
+    // The strategy thread has stopped, so the final snapshot is taken here
+    // and covers every bar the trader saw, not only the last finished one.
+    if (trader && !snapshot_path.empty()) {
+        std::string bytes;
+        trader->WriteSnapshot(bytes);
+        WriteSnapshotFile(snapshot_path, bytes);
+    }
+    AsyncLogger::Global().Stop();
+    printPipelineStats(pipeline.Stats());
+    if (book_stream) {
+        BookStreamStats book_stats = book_stream->Stats();
+        std::cout << "Books: " << book_stats.snapshots << " snapshots | " << book_stats.updates << " updates | "
+                  << book_stats.checksum_failures << " checksum failures | " << book_stats.resyncs
+                  << " resyncs" << std::endl;
+    }
+    if (aggregator) {
+        std::cout << "Bars: " << aggregator->BarsEmitted() << " built from trades" << std::endl;
+    }
+    if (pair_engine) {
+        std::cout << "Pairs: " << pair_engine->PairCount() << " pairs | " << pair_engine->TradeCount()
+                  << " signals | equity " << std::fixed << std::setprecision(2) << pair_engine->GetEquity()
+                  << std::endl;
+    }
+    LatencyRecorder::Report(std::cout);
+    if (gateway) {
+        gateway->Stop();
+        gateway_thread.join();
+        g_gateway = nullptr;
+        trader->PrintTradeLog();
+    }
+    if (trade_journal) {
+        trade_journal->Close();
+        order_journal->Close();
+    }
+    if (recorder) {
+        recorder->Close();
+    }
     return 0;
 }
\ No newline at end of file
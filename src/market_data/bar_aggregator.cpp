@@ -0,0 +1,154 @@
+#include "bar_aggregator.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+
+const int64_t kNanosPerSecond = 1000000000LL;
+const int64_t kNanosPerMinute = 60 * kNanosPerSecond;
+
+}  // namespace
+
+bool ParseBarSpec(const std::string& text, BarSpec& spec) {
+  size_t colon = text.find(':');
+  if (colon == std::string::npos) return false;
+
+  std::string type = text.substr(0, colon);
+  BarSpec parsed;
+  if (type == "time") {
+    parsed.type = BarType::TIME;
+  } else if (type == "tick") {
+    parsed.type = BarType::TICK;
+  } else if (type == "volume") {
+    parsed.type = BarType::VOLUME;
+  } else if (type == "dollar") {
+    parsed.type = BarType::DOLLAR;
+  } else {
+    return false;
+  }
+
+  const char* begin = text.c_str() + colon + 1;
+  char* end = nullptr;
+  parsed.size = std::strtod(begin, &end);
+  if (end == begin || *end != '\0' || !(parsed.size > 0.0) || !std::isfinite(parsed.size)) return false;
+  // Time bars are whole nanoseconds; tick bars whole trades.
+  if (parsed.type == BarType::TIME && parsed.size * kNanosPerSecond < 1.0) return false;
+  if (parsed.type == BarType::TICK && parsed.size < 1.0) return false;
+
+  spec = parsed;
+  return true;
+}
+
+BarAggregator::BarAggregator(const BarSpec& spec)
+    : spec_(spec), bar_ns_(0), interval_minutes_(0), bars_emitted_(0) {
+  if (!(spec_.size > 0.0)) {
+    throw std::runtime_error("Bar size must be positive");
+  }
+  if (spec_.type == BarType::TIME) {
+    bar_ns_ = std::max<int64_t>(1, std::llround(spec_.size * kNanosPerSecond));
+    if (bar_ns_ % kNanosPerMinute == 0 && bar_ns_ / kNanosPerMinute <= UINT16_MAX) {
+      interval_minutes_ = static_cast<uint16_t>(bar_ns_ / kNanosPerMinute);
+    }
+  } else if (spec_.type == BarType::TICK) {
+    spec_.size = std::floor(spec_.size);
+  }
+}
+
+void BarAggregator::SetBarCallback(std::function<void(const Candle&)> callback) {
+  bar_callback_ = callback;
+}
+
+void BarAggregator::OnTrade(const TradeTick& trade) {
+  if (trade.symbol == kInvalidSymbol) return;
+  if (trade.symbol >= states_.size()) {
+    BarState empty = {};
+    states_.resize(static_cast<size_t>(trade.symbol) + 1, empty);
+  }
+  BarState& state = states_[trade.symbol];
+  Candle& bar = state.bar;
+
+  // A trade past the boundary closes the open bar first. Late prints from
+  // an interval already handed out fold into the open or next bar instead
+  // of reopening it.
+  if (state.open && spec_.type == BarType::TIME && trade.timestamp >= state.end) {
+    Emit(state);
+  }
+
+  if (!state.open) {
+    bar.symbol = trade.symbol;
+    bar.interval = interval_minutes_;
+    bar.open = trade.price;
+    bar.high = trade.price;
+    bar.low = trade.price;
+    bar.volume = 0;
+    bar.trades = 0;
+    state.notional = 0.0;
+    SymbolPrecision precision = MarketPrecision(trade.symbol);
+    state.fill_target = spec_.size * static_cast<double>(Pow10(precision.qty_decimals));
+    if (spec_.type == BarType::DOLLAR) state.fill_target *= static_cast<double>(Pow10(precision.price_decimals));
+    if (spec_.type == BarType::TIME) {
+      int64_t offset = trade.timestamp % bar_ns_;
+      if (offset < 0) offset += bar_ns_;
+      bar.interval_begin = std::max(trade.timestamp - offset, state.end);
+      state.end = bar.interval_begin + bar_ns_;
+    } else {
+      bar.interval_begin = trade.timestamp;
+    }
+    state.open = true;
+  }
+
+  bar.high = std::max(bar.high, trade.price);
+  bar.low = std::min(bar.low, trade.price);
+  bar.close = trade.price;
+  bar.volume += trade.qty;
+  bar.trades++;
+  state.notional += static_cast<double>(trade.price) * static_cast<double>(trade.qty);
+
+  switch (spec_.type) {
+    case BarType::TIME:
+      break;
+    case BarType::TICK:
+      if (bar.trades >= spec_.size) Emit(state);
+      break;
+    case BarType::VOLUME:
+      if (static_cast<double>(bar.volume) >= state.fill_target) Emit(state);
+      break;
+    case BarType::DOLLAR:
+      if (state.notional >= state.fill_target) Emit(state);
+      break;
+  }
+}
+
+void BarAggregator::CloseBarsBefore(int64_t time_ns) {
+  if (spec_.type != BarType::TIME) return;
+  for (BarState& state : states_) {
+    if (state.open && state.end <= time_ns) {
+      Emit(state);
+    }
+  }
+}
+
+const BarSpec& BarAggregator::Spec() const {
+  return spec_;
+}
+
+int64_t BarAggregator::BarNanos() const {
+  return bar_ns_;
+}
+
+uint64_t BarAggregator::BarsEmitted() const {
+  return bars_emitted_;
+}
+
+void BarAggregator::Emit(BarState& state) {
+  Candle& bar = state.bar;
+  // notional / volume is already at the price scale.
+  bar.vwap = bar.volume > 0 ? std::llround(state.notional / static_cast<double>(bar.volume)) : bar.close;
+  state.open = false;
+  bars_emitted_++;
+  if (bar_callback_) {
+    bar_callback_(bar);
+  }
+}
@@ -0,0 +1,91 @@
+#ifndef BAR_AGGREGATOR_H
+#define BAR_AGGREGATOR_H
+
+#include "candle.h"
+#include "trade_tick.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+enum class BarType : uint8_t {
+  // Fixed clock intervals, aligned to the epoch.
+  TIME,
+  // A fixed number of trades.
+  TICK,
+  // A fixed traded quantity of the base asset.
+  VOLUME,
+  // A fixed traded notional in the quote currency.
+  DOLLAR
+};
+
+struct BarSpec {
+  BarType type = BarType::TIME;
+  // Seconds for TIME, trades for TICK, base units for VOLUME and quote
+  // units for DOLLAR.
+  double size = 60.0;
+};
+
+// Parses "time:SECONDS", "tick:TRADES", "volume:QTY" or "dollar:NOTIONAL",
+// e.g. "time:1" or "dollar:5e5". Returns false for anything else or a size
+// that is not positive.
+bool ParseBarSpec(const std::string& text, BarSpec& spec);
+
+// Builds bars per symbol from the trade stream and hands each one out as a
+// Candle the moment it closes: on the trade that fills a tick, volume or
+// dollar bar, and for time bars on the first trade past the boundary or on
+// CloseBarsBefore(), whichever comes first. A trade is never split, so the
+// closing trade of a volume or dollar bar may overshoot its size.
+//
+// interval_begin is the bar's start on the clock for time bars and its
+// first trade otherwise; interval is the length in minutes for time bars
+// of whole minutes and 0 for every other bar. Intervals without trades
+// produce no bar.
+//
+// Not thread-safe: feed it from one thread, e.g. the trade socket's.
+class BarAggregator {
+ public:
+  // Throws std::runtime_error if spec.size is not positive.
+  explicit BarAggregator(const BarSpec& spec);
+
+  void SetBarCallback(std::function<void(const Candle&)> callback);
+
+  // Folds a trade into its symbol's open bar and emits the bar if the trade
+  // closes it. O(1); allocates only the first time a higher symbol id
+  // than any seen so far shows up.
+  void OnTrade(const TradeTick& trade);
+  // Time bars only: emits every open bar that ended at or before time_ns
+  // (nanoseconds since the epoch) without waiting for another trade.
+  void CloseBarsBefore(int64_t time_ns);
+
+  const BarSpec& Spec() const;
+  // Length of a time bar; 0 for the other types.
+  int64_t BarNanos() const;
+  uint64_t BarsEmitted() const;
+
+ private:
+  struct BarState {
+    Candle bar;
+    // Sum of price * qty in mantissa units: the vwap numerator and the
+    // dollar bar fill.
+    double notional;
+    // spec.size of a volume or dollar bar in the same units as the bar's
+    // volume or notional mantissas, set when the bar opens.
+    double fill_target;
+    // Time bars: the end of the open bar, or of the last one emitted.
+    int64_t end;
+    bool open;
+  };
+
+  void Emit(BarState& state);
+
+  BarSpec spec_;
+  int64_t bar_ns_;
+  uint16_t interval_minutes_;
+  // Indexed by SymbolId.
+  std::vector<BarState> states_;
+  std::function<void(const Candle&)> bar_callback_;
+  uint64_t bars_emitted_;
+};
+
+#endif
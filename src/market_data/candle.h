@@ -0,0 +1,35 @@
+#ifndef CANDLE_H
+#define CANDLE_H
+
+#include "decimal.h"
+#include "symbol_registry.h"
+#include <cstdint>
+#include <type_traits>
+
+// One OHLC bar, trivially copyable and exactly one cache line so it can be
+// passed by value through queues and stored in flat arrays. Resolve the
+// symbol with SymbolRegistry::Global().Name().
+//
+// Prices and volume are fixed-point mantissas at the symbol's
+// MarketPrecision(); PriceDecimal() and QtyDecimal() turn them back into
+// Decimals.
+struct alignas(64) Candle {
+  // Bar open time, nanoseconds since the Unix epoch.
+  int64_t interval_begin;
+  int64_t open;
+  int64_t high;
+  int64_t low;
+  int64_t close;
+  int64_t vwap;
+  int64_t volume;
+  SymbolId symbol;
+  // Bar length in minutes; 0 for bars BarAggregator builds on anything but
+  // whole minutes.
+  uint16_t interval;
+  uint32_t trades;
+};
+
+static_assert(sizeof(Candle) == 64, "Candle must stay one cache line");
+static_assert(std::is_trivially_copyable<Candle>::value, "Candle must stay trivially copyable");
+
+#endif
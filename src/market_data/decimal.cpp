@@ -0,0 +1,270 @@
+#include "decimal.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+const int64_t kPowersOfTen[kMaxDecimalScale + 1] = {
+  1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL,
+  1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL,
+  100000000000000LL, 1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+  1000000000000000000LL
+};
+
+const int kMaxSignificantDigits = 18;
+// Doubles at or beyond this no longer fit an int64 mantissa.
+const double kMaxMantissa = 9.2e18;
+// How close a scaled double has to be to an integer to count as exact.
+const double kDoubleSlack = 1e-6;
+
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+bool Widen(int64_t& mantissa, int shift) {
+  if (shift > kMaxDecimalScale) return mantissa == 0;
+  int64_t factor = kPowersOfTen[shift];
+  if (mantissa > std::numeric_limits<int64_t>::max() / factor ||
+      mantissa < std::numeric_limits<int64_t>::min() / factor) {
+    return false;
+  }
+  mantissa *= factor;
+  return true;
+}
+
+}  // namespace
+
+double Decimal::ToDouble() const {
+  // Both sides are exact doubles for the mantissas markets use, so this is
+  // the correctly rounded value.
+  return static_cast<double>(mantissa) / static_cast<double>(kPowersOfTen[scale]);
+}
+
+int64_t Pow10(int exponent) {
+  return kPowersOfTen[exponent];
+}
+
+std::from_chars_result FromChars(const char* first, const char* last, Decimal& value) {
+  const char* p = first;
+  bool negative = p < last && *p == '-';
+  if (negative) p++;
+
+  int64_t mantissa = 0;
+  int significant = 0;
+  int fraction = 0;
+  bool any_digit = false;
+  bool in_fraction = false;
+  for (; p < last; p++) {
+    if (*p == '.' && !in_fraction) {
+      in_fraction = true;
+      continue;
+    }
+    if (!IsDigit(*p)) break;
+    any_digit = true;
+    if (mantissa != 0 || *p != '0') {
+      if (++significant > kMaxSignificantDigits) return {p, std::errc::result_out_of_range};
+    }
+    mantissa = mantissa * 10 + (*p - '0');
+    if (in_fraction) fraction++;
+  }
+  if (!any_digit) return {first, std::errc::invalid_argument};
+  // A dangling point is not part of the number: "5." reads as 5.
+  if (in_fraction && fraction == 0) p--;
+
+  // Like std::from_chars, an exponent without digits is left unread.
+  if (p < last && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    bool negative_exponent = false;
+    if (q < last && (*q == '+' || *q == '-')) {
+      negative_exponent = *q == '-';
+      q++;
+    }
+    if (q < last && IsDigit(*q)) {
+      int exponent = 0;
+      for (; q < last && IsDigit(*q); q++) {
+        if (exponent < 1000) exponent = exponent * 10 + (*q - '0');
+      }
+      fraction += negative_exponent ? exponent : -exponent;
+      p = q;
+    }
+  }
+
+  if (fraction < 0) {
+    if (!Widen(mantissa, -fraction)) return {p, std::errc::result_out_of_range};
+    fraction = 0;
+  }
+  while (fraction > kMaxDecimalScale && mantissa % 10 == 0) {
+    if (mantissa == 0) {
+      fraction = kMaxDecimalScale;
+      break;
+    }
+    mantissa /= 10;
+    fraction--;
+  }
+  if (fraction > kMaxDecimalScale) return {p, std::errc::result_out_of_range};
+
+  value.mantissa = negative ? -mantissa : mantissa;
+  value.scale = fraction;
+  return {p, std::errc()};
+}
+
+std::from_chars_result FromChars(const char* first, const char* last, Decimal& value, int scale) {
+  Decimal parsed;
+  std::from_chars_result result = FromChars(first, last, parsed);
+  if (result.ec != std::errc()) return result;
+  if (scale < 0 || scale > kMaxDecimalScale) return {result.ptr, std::errc::result_out_of_range};
+
+  if (scale >= parsed.scale) {
+    if (!Widen(parsed.mantissa, scale - parsed.scale)) return {result.ptr, std::errc::result_out_of_range};
+  } else {
+    int64_t divisor = kPowersOfTen[parsed.scale - scale];
+    if (parsed.mantissa % divisor != 0) return {result.ptr, std::errc::result_out_of_range};
+    parsed.mantissa /= divisor;
+  }
+  parsed.scale = scale;
+  value = parsed;
+  return result;
+}
+
+std::from_chars_result FromChars(const char* first, const char* last, Decimal& value, int scale,
+                                 Rounding rounding) {
+  Decimal parsed;
+  std::from_chars_result result = FromChars(first, last, parsed);
+  if (result.ec != std::errc()) return result;
+  if (!Rescale(parsed, scale, rounding)) return {result.ptr, std::errc::result_out_of_range};
+  value = parsed;
+  return result;
+}
+
+std::to_chars_result ToChars(char* first, char* last, const Decimal& value) {
+  // Digits of the magnitude, which for INT64_MIN does not fit an int64.
+  char digits[20];
+  uint64_t magnitude = value.mantissa < 0 ? 0 - static_cast<uint64_t>(value.mantissa)
+                                          : static_cast<uint64_t>(value.mantissa);
+  std::to_chars_result printed = std::to_chars(digits, digits + sizeof(digits), magnitude);
+  int count = static_cast<int>(printed.ptr - digits);
+  int scale = value.scale;
+
+  int whole = count > scale ? count - scale : 1;
+  ptrdiff_t length = (value.mantissa < 0 ? 1 : 0) + whole + (scale > 0 ? 1 + scale : 0);
+  if (last - first < length) return {last, std::errc::value_too_large};
+
+  char* out = first;
+  if (value.mantissa < 0) *out++ = '-';
+  if (count > scale) {
+    for (int i = 0; i < whole; i++) *out++ = digits[i];
+  } else {
+    *out++ = '0';
+  }
+  if (scale > 0) {
+    *out++ = '.';
+    for (int i = count; i < scale; i++) *out++ = '0';
+    for (int i = count > scale ? whole : 0; i < count; i++) *out++ = digits[i];
+  }
+  return {out, std::errc()};
+}
+
+bool Rescale(Decimal& value, int scale, Rounding rounding) {
+  if (scale < 0 || scale > kMaxDecimalScale) return false;
+  int64_t mantissa = value.mantissa;
+
+  if (scale >= value.scale) {
+    if (!Widen(mantissa, scale - value.scale)) return false;
+  } else {
+    int64_t divisor = kPowersOfTen[value.scale - scale];
+    int64_t remainder = mantissa % divisor;
+    // Division truncates toward zero, which is already DOWN.
+    mantissa /= divisor;
+    int64_t away = value.mantissa < 0 ? -1 : 1;
+    if (rounding == Rounding::UP && remainder != 0) {
+      mantissa += away;
+    } else if (rounding == Rounding::NEAREST && std::llabs(remainder) * 2 >= divisor) {
+      mantissa += away;
+    }
+  }
+
+  value.mantissa = mantissa;
+  value.scale = scale;
+  return true;
+}
+
+bool DecimalFromDouble(double value, int scale, Decimal& result, Rounding rounding) {
+  if (!std::isfinite(value) || scale < 0 || scale > kMaxDecimalScale) return false;
+  double scaled = value * static_cast<double>(kPowersOfTen[scale]);
+  if (std::fabs(scaled) >= kMaxMantissa) return false;
+
+  double nearest = std::round(scaled);
+  double rounded = nearest;
+  if (std::fabs(scaled - nearest) > kDoubleSlack) {
+    if (rounding == Rounding::DOWN) {
+      rounded = std::trunc(scaled);
+    } else if (rounding == Rounding::UP) {
+      rounded = scaled < 0.0 ? std::floor(scaled) : std::ceil(scaled);
+    }
+  }
+
+  result.mantissa = static_cast<int64_t>(rounded);
+  result.scale = scale;
+  return true;
+}
+
+std::string ToString(const Decimal& value) {
+  // Sign, 19 digits, point and up to kMaxDecimalScale leading zeros.
+  char text[48];
+  std::to_chars_result result = ToChars(text, text + sizeof(text), value);
+  return std::string(text, result.ptr);
+}
+
+PrecisionTable& PrecisionTable::Global() {
+  static PrecisionTable table;
+  return table;
+}
+
+PrecisionTable::PrecisionTable() {
+  for (auto& slot : packed_) {
+    slot.store(0, std::memory_order_relaxed);
+  }
+}
+
+void PrecisionTable::Set(SymbolId symbol, int price_decimals, int qty_decimals) {
+  if (symbol >= packed_.size()) return;
+  uint32_t price = static_cast<uint32_t>(std::clamp(price_decimals, 0, kMaxDecimalScale));
+  uint32_t qty = static_cast<uint32_t>(std::clamp(qty_decimals, 0, kMaxDecimalScale));
+  packed_[symbol].store(1u << 16 | price << 8 | qty, std::memory_order_release);
+}
+
+bool PrecisionTable::Find(SymbolId symbol, SymbolPrecision& precision) const {
+  if (symbol >= packed_.size()) return false;
+  uint32_t packed = packed_[symbol].load(std::memory_order_acquire);
+  if (packed == 0) return false;
+  precision.price_decimals = static_cast<int>(packed >> 8 & 0xff);
+  precision.qty_decimals = static_cast<int>(packed & 0xff);
+  return true;
+}
+
+SymbolPrecision MarketPrecision(SymbolId symbol) {
+  SymbolPrecision precision;
+  if (!PrecisionTable::Global().Find(symbol, precision)) {
+    precision = SymbolPrecision{kDefaultPriceDecimals, kDefaultQtyDecimals};
+  }
+  return precision;
+}
+
+Decimal PriceDecimal(SymbolId symbol, int64_t mantissa) {
+  return Decimal{mantissa, MarketPrecision(symbol).price_decimals};
+}
+
+Decimal QtyDecimal(SymbolId symbol, int64_t mantissa) {
+  return Decimal{mantissa, MarketPrecision(symbol).qty_decimals};
+}
+
+bool ParseMantissa(std::string_view text, int scale, int64_t& mantissa) {
+  const char* end = text.data() + text.size();
+  Decimal value;
+  std::from_chars_result result = FromChars(text.data(), end, value, scale, Rounding::NEAREST);
+  if (result.ec != std::errc() || result.ptr != end) return false;
+  mantissa = value.mantissa;
+  return true;
+}
@@ -0,0 +1,111 @@
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include "symbol_registry.h"
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Exact decimal: value = mantissa / 10^scale. Exchange prices and sizes
+// parse into it without rounding and format back out with integer
+// arithmetic only, so what goes on the wire is exactly what was meant.
+struct Decimal {
+  int64_t mantissa;
+  int32_t scale;
+
+  // Nearest double; for model math only.
+  double ToDouble() const;
+};
+
+constexpr int kMaxDecimalScale = 18;
+
+// 10^exponent for exponent in [0, kMaxDecimalScale].
+int64_t Pow10(int exponent);
+
+enum class Rounding {
+  // Toward zero, e.g. quantities that must not exceed a budget.
+  DOWN,
+  NEAREST,
+  // Away from zero.
+  UP
+};
+
+// Parses decimal text as written, JSON number syntax with an optional
+// exponent, without rounding: "0.10000000" gives 10000000 at scale 8 and
+// "1.5e-05" gives 15 at scale 6. Follows std::from_chars: ptr is one past
+// the last character used, ec is invalid_argument if there is no number
+// and result_out_of_range if it has more than 18 significant digits or a
+// scale outside [0, kMaxDecimalScale].
+std::from_chars_result FromChars(const char* first, const char* last, Decimal& value);
+// Parses at a fixed scale, e.g. a pair's price precision. Fails with
+// result_out_of_range if the value overflows or has nonzero digits past
+// the scale; value is left untouched on failure.
+std::from_chars_result FromChars(const char* first, const char* last, Decimal& value, int scale);
+// Parses at a fixed scale, rounding digits past it, e.g. a VWAP quoted
+// finer than the pair's tick. Fails only on bad syntax or overflow.
+std::from_chars_result FromChars(const char* first, const char* last, Decimal& value, int scale, Rounding rounding);
+
+// Writes exactly value.scale decimals ("0.10000000", "-12.5", "7"),
+// without a trailing NUL. Follows std::to_chars: ec is value_too_large if
+// the buffer is too small.
+std::to_chars_result ToChars(char* first, char* last, const Decimal& value);
+
+// Moves value to another scale: exact when widening, rounded when
+// narrowing. Returns false, leaving value untouched, on overflow.
+bool Rescale(Decimal& value, int scale, Rounding rounding = Rounding::NEAREST);
+// The decimal at scale closest to value in the given direction. Products
+// of doubles carry representation noise (0.3 * 1e8 is 29999999.99...), so
+// anything within a millionth of a unit at scale counts as exact before
+// rounding DOWN or UP. Returns false if value is not finite or overflows.
+bool DecimalFromDouble(double value, int scale, Decimal& result, Rounding rounding = Rounding::NEAREST);
+// ToChars into a string, e.g. for CSV and console output.
+std::string ToString(const Decimal& value);
+
+// A pair's listed precision: price decimals (its tick) and quantity
+// decimals (its lot).
+struct SymbolPrecision {
+  int price_decimals;
+  int qty_decimals;
+};
+
+// Process-wide precision per SymbolId, filled at startup from the
+// exchange's pair list. Set() and Find() are lock-free and safe to call
+// from any thread.
+class PrecisionTable {
+ public:
+  static PrecisionTable& Global();
+
+  PrecisionTable();
+  PrecisionTable(const PrecisionTable&) = delete;
+  PrecisionTable& operator=(const PrecisionTable&) = delete;
+
+  void Set(SymbolId symbol, int price_decimals, int qty_decimals);
+  // False if symbol has no precision set.
+  bool Find(SymbolId symbol, SymbolPrecision& precision) const;
+
+ private:
+  // 0 when unset, otherwise 1 << 16 | price_decimals << 8 | qty_decimals.
+  std::array<std::atomic<uint32_t>, SymbolRegistry::kMaxSymbols> packed_;
+};
+
+// Scale of a symbol's market data when PrecisionTable has no entry. Kraken
+// accepts at most 8 decimals of volume on any pair; pairs with a coarser
+// lot are known once their precision has been fetched.
+constexpr int kDefaultPriceDecimals = 8;
+constexpr int kDefaultQtyDecimals = 8;
+
+// Candles and trade ticks hold bare mantissas at their symbol's
+// PrecisionTable precision, or the defaults above, so they keep their
+// fixed width. Set a symbol's precision before parsing any of its market
+// data: values parsed earlier would be read at the wrong scale.
+SymbolPrecision MarketPrecision(SymbolId symbol);
+Decimal PriceDecimal(SymbolId symbol, int64_t mantissa);
+Decimal QtyDecimal(SymbolId symbol, int64_t mantissa);
+
+// Parses all of text at scale, rounding to nearest, into a bare mantissa.
+bool ParseMantissa(std::string_view text, int scale, int64_t& mantissa);
+
+#endif
@@ -0,0 +1,189 @@
+#include "order_book.h"
+#include "decimal.h"
+#include "../websocket/book_checksum.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const size_t kChecksumLevels = 10;
+
+// Bids are sorted descending and asks ascending, so "ahead" means a better
+// price on either side and the search is the same lower bound.
+template <bool kDescending>
+void ApplyLevel(BookLevel* levels, size_t& count, size_t capacity, int64_t price, int64_t qty) {
+  BookLevel* end = levels + count;
+  BookLevel* it = std::lower_bound(levels, end, price, [](const BookLevel& level, int64_t target) {
+    return kDescending ? level.price > target : level.price < target;
+  });
+  size_t index = static_cast<size_t>(it - levels);
+  bool found = it != end && it->price == price;
+
+  if (qty == 0) {
+    if (found) {
+      std::memmove(it, it + 1, (count - index - 1) * sizeof(BookLevel));
+      count--;
+    }
+    return;
+  }
+  if (found) {
+    it->qty = qty;
+    return;
+  }
+  if (index == capacity) return;
+
+  // When full, the worst level falls off the end to make room.
+  size_t moved = std::min(count, capacity - 1) - index;
+  std::memmove(it + 1, it, moved * sizeof(BookLevel));
+  it->price = price;
+  it->qty = qty;
+  count = index + moved + 1;
+}
+
+bool Multiply(int64_t& value, int64_t factor) {
+  if (value > std::numeric_limits<int64_t>::max() / factor) return false;
+  value *= factor;
+  return true;
+}
+
+}  // namespace
+
+OrderBook::OrderBook(size_t depth)
+    : depth_(std::max<size_t>(1, depth)), capacity_(2 * depth_), bid_count_(0), ask_count_(0),
+      price_decimals_(0), qty_decimals_(0), decimals_fixed_(false), price_scale_(1.0), qty_scale_(1.0) {
+  levels_.resize(2 * capacity_);
+}
+
+void OrderBook::Clear() {
+  bid_count_ = 0;
+  ask_count_ = 0;
+}
+
+void OrderBook::SetDecimals(int price_decimals, int qty_decimals) {
+  Clear();
+  price_decimals_ = std::clamp(price_decimals, 0, kMaxDecimalScale);
+  qty_decimals_ = std::clamp(qty_decimals, 0, kMaxDecimalScale);
+  decimals_fixed_ = true;
+  Rescale();
+}
+
+bool OrderBook::DecimalsFixed() const {
+  return decimals_fixed_;
+}
+
+bool OrderBook::WidenDecimals(int price_decimals, int qty_decimals) {
+  if (decimals_fixed_ || price_decimals > kMaxDecimalScale || qty_decimals > kMaxDecimalScale) return false;
+  int64_t price_factor = Pow10(std::max(0, price_decimals - price_decimals_));
+  int64_t qty_factor = Pow10(std::max(0, qty_decimals - qty_decimals_));
+  if (price_factor == 1 && qty_factor == 1) return true;
+
+  // Check every level first so a failure leaves the book untouched.
+  auto fits = [&](const BookLevel* levels, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      int64_t price = levels[i].price;
+      int64_t qty = levels[i].qty;
+      if (!Multiply(price, price_factor) || !Multiply(qty, qty_factor)) return false;
+    }
+    return true;
+  };
+  if (!fits(&levels_[0], bid_count_) || !fits(&levels_[capacity_], ask_count_)) return false;
+
+  for (size_t i = 0; i < bid_count_; i++) {
+    levels_[i].price *= price_factor;
+    levels_[i].qty *= qty_factor;
+  }
+  for (size_t i = 0; i < ask_count_; i++) {
+    levels_[capacity_ + i].price *= price_factor;
+    levels_[capacity_ + i].qty *= qty_factor;
+  }
+  price_decimals_ = std::max(price_decimals_, price_decimals);
+  qty_decimals_ = std::max(qty_decimals_, qty_decimals);
+  Rescale();
+  return true;
+}
+
+int OrderBook::PriceDecimals() const {
+  return price_decimals_;
+}
+
+int OrderBook::QtyDecimals() const {
+  return qty_decimals_;
+}
+
+void OrderBook::ApplyBid(int64_t price, int64_t qty) {
+  ApplyLevel<true>(&levels_[0], bid_count_, capacity_, price, qty);
+}
+
+void OrderBook::ApplyAsk(int64_t price, int64_t qty) {
+  ApplyLevel<false>(&levels_[capacity_], ask_count_, capacity_, price, qty);
+}
+
+void OrderBook::Truncate() {
+  bid_count_ = std::min(bid_count_, depth_);
+  ask_count_ = std::min(ask_count_, depth_);
+}
+
+uint32_t OrderBook::Checksum() const {
+  uint32_t crc = 0;
+  for (size_t i = 0; i < std::min(ask_count_, kChecksumLevels); i++) {
+    const BookLevel& level = levels_[capacity_ + i];
+    crc = UpdateBookChecksum(crc, level.price, level.qty);
+  }
+  for (size_t i = 0; i < std::min(bid_count_, kChecksumLevels); i++) {
+    crc = UpdateBookChecksum(crc, levels_[i].price, levels_[i].qty);
+  }
+  return crc;
+}
+
+size_t OrderBook::Depth() const {
+  return depth_;
+}
+
+size_t OrderBook::BidCount() const {
+  return bid_count_;
+}
+
+size_t OrderBook::AskCount() const {
+  return ask_count_;
+}
+
+const BookLevel& OrderBook::Bid(size_t index) const {
+  return levels_[index];
+}
+
+const BookLevel& OrderBook::Ask(size_t index) const {
+  return levels_[capacity_ + index];
+}
+
+bool OrderBook::HasTop() const {
+  return bid_count_ > 0 && ask_count_ > 0;
+}
+
+double OrderBook::PriceValue(int64_t price) const {
+  return static_cast<double>(price) / price_scale_;
+}
+
+double OrderBook::QtyValue(int64_t qty) const {
+  return static_cast<double>(qty) / qty_scale_;
+}
+
+double OrderBook::Microprice() const {
+  return Top(kInvalidSymbol, 0).Microprice();
+}
+
+TopOfBook OrderBook::Top(SymbolId symbol, int64_t timestamp) const {
+  TopOfBook top;
+  top.timestamp = timestamp;
+  top.symbol = symbol;
+  top.bid_price = bid_count_ > 0 ? PriceValue(levels_[0].price) : 0.0;
+  top.bid_qty = bid_count_ > 0 ? QtyValue(levels_[0].qty) : 0.0;
+  top.ask_price = ask_count_ > 0 ? PriceValue(levels_[capacity_].price) : 0.0;
+  top.ask_qty = ask_count_ > 0 ? QtyValue(levels_[capacity_].qty) : 0.0;
+  return top;
+}
+
+void OrderBook::Rescale() {
+  price_scale_ = static_cast<double>(Pow10(price_decimals_));
+  qty_scale_ = static_cast<double>(Pow10(qty_decimals_));
+}
@@ -0,0 +1,107 @@
+#ifndef ORDER_BOOK_H
+#define ORDER_BOOK_H
+
+#include "symbol_registry.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// One price level as fixed-point mantissas: value * 10^decimals of its book.
+struct BookLevel {
+  int64_t price;
+  int64_t qty;
+};
+
+// Best bid and ask of one book in price units, trivially copyable so it
+// can ride the strategy pipeline next to candles.
+struct TopOfBook {
+  // Exchange time of the update, nanoseconds since the epoch; 0 for a
+  // snapshot, which carries none.
+  int64_t timestamp;
+  double bid_price;
+  double bid_qty;
+  double ask_price;
+  double ask_qty;
+  SymbolId symbol;
+
+  double Mid() const { return 0.5 * (bid_price + ask_price); }
+  // Mid weighted by the size resting on the opposite side: leans toward
+  // the ask when the bid is deeper, where the next trade is likelier.
+  double Microprice() const {
+    double size = bid_qty + ask_qty;
+    return size > 0.0 ? (bid_price * ask_qty + ask_price * bid_qty) / size : Mid();
+  }
+};
+
+static_assert(std::is_trivially_copyable<TopOfBook>::value, "TopOfBook must stay trivially copyable");
+
+// L2 book for one symbol: each side is a contiguous array sorted best
+// first, holding fixed-point levels, so the top is index 0 and a delta is a
+// binary search plus a memmove within a few cache lines. Storage for both
+// sides is allocated once in the constructor; nothing after it allocates.
+//
+// Decimals are either pinned to the pair's listed precision with
+// SetDecimals() or learned: the book widens to the most decimals seen so
+// far and rescales the levels it holds.
+class OrderBook {
+ public:
+  // depth: levels kept per side, as subscribed.
+  explicit OrderBook(size_t depth = 10);
+
+  // Empties both sides; decimals are kept.
+  void Clear();
+
+  void SetDecimals(int price_decimals, int qty_decimals);
+  bool DecimalsFixed() const;
+  // Rescales every level to at least these decimals. Only for learned
+  // decimals; returns false if that would overflow.
+  bool WidenDecimals(int price_decimals, int qty_decimals);
+  int PriceDecimals() const;
+  int QtyDecimals() const;
+
+  // Inserts, replaces or, for qty 0, removes a level. A level that falls
+  // past the side's capacity is dropped.
+  void ApplyBid(int64_t price, int64_t qty);
+  void ApplyAsk(int64_t price, int64_t qty);
+  // Drops levels past the subscribed depth. Kraken does not send deletes
+  // for levels pushed out of range, so call this after every message.
+  void Truncate();
+
+  // Kraken's CRC-32 over the top ten asks, then the top ten bids.
+  uint32_t Checksum() const;
+
+  size_t Depth() const;
+  size_t BidCount() const;
+  size_t AskCount() const;
+  // Index 0 is the best level.
+  const BookLevel& Bid(size_t index) const;
+  const BookLevel& Ask(size_t index) const;
+
+  bool HasTop() const;
+  double PriceValue(int64_t price) const;
+  double QtyValue(int64_t qty) const;
+  // O(1); only meaningful when HasTop().
+  double Microprice() const;
+  TopOfBook Top(SymbolId symbol, int64_t timestamp) const;
+
+ private:
+  void Rescale();
+
+  // Bids in [0, capacity_), asks in [capacity_, 2 * capacity_). Each side
+  // has room past depth for levels a message adds before its deletes.
+  std::vector<BookLevel> levels_;
+  size_t depth_;
+  size_t capacity_;
+  size_t bid_count_;
+  size_t ask_count_;
+  int price_decimals_;
+  int qty_decimals_;
+  bool decimals_fixed_;
+  // 10^decimals; dividing rather than multiplying by the inverse gives the
+  // double nearest the exact decimal.
+  double price_scale_;
+  double qty_scale_;
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "symbol_registry.h"
+
+SymbolRegistry& SymbolRegistry::Global() {
+  static SymbolRegistry registry;
+  return registry;
+}
+
+SymbolRegistry::SymbolRegistry() : size_(0) {
+  for (auto& slot : slots_) {
+    slot.store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t SymbolRegistry::Hash(std::string_view symbol) {
+  // FNV-1a; symbols are short and this only runs on lookups.
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : symbol) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return static_cast<size_t>(hash);
+}
+
+SymbolId SymbolRegistry::Find(std::string_view symbol) const {
+  size_t index = Hash(symbol) & (kTableSize - 1);
+
+  for (size_t probe = 0; probe < kTableSize; probe++) {
+    uint16_t slot = slots_[index].load(std::memory_order_acquire);
+    if (slot == 0) return kInvalidSymbol;
+
+    SymbolId id = static_cast<SymbolId>(slot - 1);
+    if (names_[id] == symbol) return id;
+
+    index = (index + 1) & (kTableSize - 1);
+  }
+  return kInvalidSymbol;
+}
+
+SymbolId SymbolRegistry::Intern(std::string_view symbol) {
+  SymbolId existing = Find(symbol);
+  if (existing != kInvalidSymbol) return existing;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  existing = Find(symbol);
+  if (existing != kInvalidSymbol) return existing;
+
+  size_t count = size_.load(std::memory_order_relaxed);
+  if (count >= kMaxSymbols) return kInvalidSymbol;
+
+  SymbolId id = static_cast<SymbolId>(count);
+  names_[id].assign(symbol.data(), symbol.size());
+
+  // The name is written before the slot is published with release, so a
+  // reader that sees the slot also sees the complete name.
+  size_t index = Hash(symbol) & (kTableSize - 1);
+  while (slots_[index].load(std::memory_order_relaxed) != 0) {
+    index = (index + 1) & (kTableSize - 1);
+  }
+  size_.store(count + 1, std::memory_order_release);
+  slots_[index].store(static_cast<uint16_t>(id + 1), std::memory_order_release);
+  return id;
+}
+
+const std::string& SymbolRegistry::Name(SymbolId id) const {
+  static const std::string unknown = "?";
+  if (id >= size_.load(std::memory_order_acquire)) return unknown;
+  return names_[id];
+}
+
+size_t SymbolRegistry::Size() const {
+  return size_.load(std::memory_order_acquire);
+}
@@ -0,0 +1,53 @@
+#ifndef SYMBOL_REGISTRY_H
+#define SYMBOL_REGISTRY_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+using SymbolId = uint16_t;
+
+constexpr SymbolId kInvalidSymbol = 0xFFFF;
+
+// Process-wide table assigning dense ids to symbols, so hot-path records can
+// carry a SymbolId and per-symbol state can live in flat arrays.
+//
+// Intern() takes a lock and may allocate; call it at subscription or load
+// time. Find() and Name() are lock-free and allocation-free and safe to call
+// from any thread concurrently with Intern(). Names are never removed.
+class SymbolRegistry {
+ public:
+  static constexpr size_t kMaxSymbols = 4096;
+
+  static SymbolRegistry& Global();
+
+  // Returns the id for symbol, assigning the next one on first use. Returns
+  // kInvalidSymbol once kMaxSymbols symbols exist.
+  SymbolId Intern(std::string_view symbol);
+  // Returns kInvalidSymbol for symbols that were never interned.
+  SymbolId Find(std::string_view symbol) const;
+
+  const std::string& Name(SymbolId id) const;
+  size_t Size() const;
+
+  SymbolRegistry();
+  SymbolRegistry(const SymbolRegistry&) = delete;
+  SymbolRegistry& operator=(const SymbolRegistry&) = delete;
+
+ private:
+  // Open-addressing hash table at 50% maximum load; slots hold id + 1.
+  static constexpr size_t kTableSize = kMaxSymbols * 2;
+
+  std::array<std::atomic<uint16_t>, kTableSize> slots_;
+  std::array<std::string, kMaxSymbols> names_;
+  std::atomic<size_t> size_;
+  std::mutex mutex_;
+
+  static size_t Hash(std::string_view symbol);
+};
+
+#endif
@@ -0,0 +1,127 @@
+#include "timestamp.h"
+#include <cstdio>
+
+namespace {
+
+const int64_t kNanosPerSecond = 1000000000LL;
+
+// Howard Hinnant's days_from_civil / civil_from_days.
+int64_t DaysFromCivil(int64_t y, unsigned m, unsigned d) {
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = static_cast<unsigned>(y - era * 400);
+  const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void CivilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+  z += 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = static_cast<unsigned>(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+bool ReadDigits(const char* text, size_t length, size_t& pos, size_t count, int64_t& value) {
+  value = 0;
+  for (size_t i = 0; i < count; i++, pos++) {
+    if (pos >= length || text[pos] < '0' || text[pos] > '9') return false;
+    value = value * 10 + (text[pos] - '0');
+  }
+  return true;
+}
+
+bool IsLeapYear(int64_t year) {
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+int64_t DaysInMonth(int64_t year, int64_t month) {
+  static const int64_t kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  return month == 2 && IsLeapYear(year) ? 29 : kDays[month - 1];
+}
+
+bool Expect(const char* text, size_t length, size_t& pos, char c) {
+  if (pos >= length || text[pos] != c) return false;
+  pos++;
+  return true;
+}
+
+}  // namespace
+
+bool ParseTimestampNanos(const char* text, size_t length, int64_t& nanos) {
+  size_t pos = 0;
+  int64_t year, month, day, hour, minute, second;
+
+  if (!ReadDigits(text, length, pos, 4, year) || !Expect(text, length, pos, '-') ||
+      !ReadDigits(text, length, pos, 2, month) || !Expect(text, length, pos, '-') ||
+      !ReadDigits(text, length, pos, 2, day) || !Expect(text, length, pos, 'T') ||
+      !ReadDigits(text, length, pos, 2, hour) || !Expect(text, length, pos, ':') ||
+      !ReadDigits(text, length, pos, 2, minute) || !Expect(text, length, pos, ':') ||
+      !ReadDigits(text, length, pos, 2, second)) {
+    return false;
+  }
+  if (month < 1 || month > 12 || day < 1 || day > DaysInMonth(year, month) || hour > 23 || minute > 59 ||
+      second > 59) {
+    return false;
+  }
+
+  int64_t fraction = 0;
+  if (pos < length && text[pos] == '.') {
+    pos++;
+    int digits = 0;
+    while (pos < length && text[pos] >= '0' && text[pos] <= '9') {
+      if (digits < 9) {
+        fraction = fraction * 10 + (text[pos] - '0');
+        digits++;
+      }
+      pos++;
+    }
+    if (digits == 0) return false;
+    for (; digits < 9; digits++) fraction *= 10;
+  }
+  if (!Expect(text, length, pos, 'Z') || pos != length) return false;
+
+  int64_t days = DaysFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+  nanos = ((days * 24 + hour) * 60 + minute) * 60 * kNanosPerSecond + second * kNanosPerSecond + fraction;
+  return true;
+}
+
+int64_t ParseTimestampNanos(const std::string& text) {
+  int64_t nanos = 0;
+  if (!ParseTimestampNanos(text.data(), text.size(), nanos)) return 0;
+  return nanos;
+}
+
+std::string FormatTimestampNanos(int64_t nanos) {
+  int64_t seconds = nanos / kNanosPerSecond;
+  int64_t fraction = nanos % kNanosPerSecond;
+  if (fraction < 0) {
+    fraction += kNanosPerSecond;
+    seconds--;
+  }
+
+  int64_t days = seconds / 86400;
+  int64_t remainder = seconds % 86400;
+  if (remainder < 0) {
+    remainder += 86400;
+    days--;
+  }
+
+  int64_t year;
+  unsigned month, day;
+  CivilFromDays(days, year, month, day);
+
+  char buffer[64];
+  std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02uT%02lld:%02lld:%02lld.%09lldZ",
+                static_cast<long long>(year), month, day,
+                static_cast<long long>(remainder / 3600),
+                static_cast<long long>((remainder / 60) % 60),
+                static_cast<long long>(remainder % 60),
+                static_cast<long long>(fraction));
+  return buffer;
+}
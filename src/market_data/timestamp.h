@@ -0,0 +1,17 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstdint>
+#include <string>
+
+// Parses Kraken's RFC 3339 timestamps ("2024-01-01T00:00:00.000000000Z") into
+// nanoseconds since the Unix epoch. Fractional digits are optional; the
+// trailing Z is not. Returns false if the text is not exactly in that form
+// or a field is out of range, e.g. 2023-02-29 or 24:00:00.
+bool ParseTimestampNanos(const char* text, size_t length, int64_t& nanos);
+int64_t ParseTimestampNanos(const std::string& text);
+
+// Formats nanoseconds since the epoch in the same form Kraken sends.
+std::string FormatTimestampNanos(int64_t nanos);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef TRADE_TICK_H
+#define TRADE_TICK_H
+
+#include "decimal.h"
+#include "symbol_registry.h"
+#include <cstdint>
+#include <type_traits>
+
+enum class TradeSide : uint8_t {
+  BUY,
+  SELL
+};
+
+// One public trade print from the exchange. Trivially copyable, filled in
+// place by the trade parser. Price and qty are mantissas at the symbol's
+// MarketPrecision(), like Candle's.
+struct TradeTick {
+  // Exchange time, nanoseconds since the Unix epoch.
+  int64_t timestamp;
+  int64_t price;
+  int64_t qty;
+  uint64_t trade_id;
+  SymbolId symbol;
+  // The taker's side.
+  TradeSide side;
+};
+
+static_assert(std::is_trivially_copyable<TradeTick>::value, "TradeTick must stay trivially copyable");
+
+#endif
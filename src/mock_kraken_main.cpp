@@ -0,0 +1,155 @@
+#include "backtest/backtest_engine.h"
+#include "backtest/synthetic_feed.h"
+#include "websocket/mock_kraken_server.h"
+#include <chrono>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// Serves a recorded or synthetic feed as a local Kraken v2 WebSocket, e.g.
+//   mock_kraken --speed 0 &
+//   BASE_ENDPOINT=http://127.0.0.1 BASE_WS_ENDPOINT=ws://127.0.0.1:8765 algo_trading BTC/USD,ETH/USD 1
+// then `kill -USR1` the client for its latency percentiles.
+
+MockKrakenServer* g_server = nullptr;
+
+void signalHandler(int signal) {
+    (void)signal;
+    if (g_server) {
+        g_server->Stop();
+    }
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [CANDLES.csv|STORE_DIR ...] [options]" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --port N              listening port (default 8765)" << std::endl;
+    std::cerr << "  --bind ADDR           bind address, \"\" for all (default 127.0.0.1)" << std::endl;
+    std::cerr << "  --speed X             multiple of real time, 0 for line rate (default 1)" << std::endl;
+    std::cerr << "  --burst N             release messages in bursts of N (default 1)" << std::endl;
+    std::cerr << "  --fragment BYTES      split messages into frames of at most BYTES" << std::endl;
+    std::cerr << "  --disconnect-every N  drop each connection after N messages" << std::endl;
+    std::cerr << "  --events-per-bar N    ohlc/trade/book events per candle (default 10)" << std::endl;
+    std::cerr << "  --no-book             omit the book channel" << std::endl;
+    std::cerr << "  --no-trades           omit the trade channel" << std::endl;
+    std::cerr << "  --bars N              synthetic bars when no feed is given (default 10000)" << std::endl;
+    std::cerr << "  --pair Y,X            synthetic symbols (default BTC/USD,ETH/USD)" << std::endl;
+    std::cerr << "  --orders MODE         accept, reject, alternate or disconnect (default accept)" << std::endl;
+    std::cerr << "Example: " << program << " data/btc_1m data/eth_1m --speed 600 --fragment 64" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> feeds;
+    MockServerConfig config;
+    MockFeedOptions feed_options;
+    size_t bars = 10000;
+    std::string pair = "BTC/USD,ETH/USD";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            config.port = std::stoi(argv[++i]);
+        } else if (arg == "--bind" && i + 1 < argc) {
+            config.bind_address = argv[++i];
+        } else if (arg == "--speed" && i + 1 < argc) {
+            config.speed = std::stod(argv[++i]);
+        } else if (arg == "--burst" && i + 1 < argc) {
+            config.burst = std::stoul(argv[++i]);
+        } else if (arg == "--fragment" && i + 1 < argc) {
+            config.fragment_bytes = std::stoul(argv[++i]);
+        } else if (arg == "--disconnect-every" && i + 1 < argc) {
+            config.disconnect_every = std::stoull(argv[++i]);
+        } else if (arg == "--events-per-bar" && i + 1 < argc) {
+            feed_options.events_per_bar = std::stoul(argv[++i]);
+        } else if (arg == "--no-book") {
+            feed_options.book = false;
+        } else if (arg == "--no-trades") {
+            feed_options.trades = false;
+        } else if (arg == "--bars" && i + 1 < argc) {
+            bars = std::stoul(argv[++i]);
+        } else if (arg == "--pair" && i + 1 < argc) {
+            pair = argv[++i];
+        } else if (arg == "--orders" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "accept") {
+                config.order_mode = MockOrderMode::ACCEPT;
+            } else if (mode == "reject") {
+                config.order_mode = MockOrderMode::REJECT;
+            } else if (mode == "alternate") {
+                config.order_mode = MockOrderMode::ALTERNATE;
+            } else if (mode == "disconnect") {
+                config.order_mode = MockOrderMode::DISCONNECT;
+            } else {
+                std::cerr << "Error: unknown --orders mode " << mode << std::endl;
+                return 1;
+            }
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            feeds.push_back(arg);
+        }
+    }
+
+    std::vector<Candle> candles;
+    try {
+        if (feeds.empty()) {
+            size_t comma = pair.find(',');
+            if (comma == std::string::npos) {
+                std::cerr << "Error: --pair needs Y,X" << std::endl;
+                return 1;
+            }
+            // Synthetic bars end now, so the timestamps look live.
+            int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            int64_t minute_ns = 60LL * 1000000000LL;
+            int64_t start_ns = now_ns / minute_ns * minute_ns - static_cast<int64_t>(bars) * minute_ns;
+            candles = GeneratePairCandles(bars, pair.substr(0, comma), pair.substr(comma + 1), start_ns);
+        } else {
+            std::vector<std::vector<Candle>> streams;
+            for (const std::string& feed : feeds) {
+                streams.push_back(std::filesystem::is_directory(feed) ? LoadCandlesFromStore(feed)
+                                                                      : LoadCandlesFromCSV(feed));
+            }
+            candles = MergeCandleStreams(std::move(streams));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    auto build_start = std::chrono::steady_clock::now();
+    MockFeed feed = BuildMockFeed(candles, feed_options);
+    double build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - build_start).count();
+    std::cout << std::fixed << std::setprecision(2) << "Feed: " << feed.messages.size() << " messages ("
+              << feed.text.size() / (1024 * 1024) << " MiB) from " << candles.size() << " candles, "
+              << static_cast<double>(feed.Duration()) / 60e9 << " min of market time, built in "
+              << build_seconds << " s" << std::endl;
+
+    MockKrakenServer server(feed, config);
+    try {
+        server.Start();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::signal(SIGINT, signalHandler);
+    std::signal(SIGTERM, signalHandler);
+    g_server = &server;
+    std::cout << "Listening on ws://" << (config.bind_address.empty() ? "0.0.0.0" : config.bind_address) << ":"
+              << config.port << " at " << (config.speed > 0.0 ? std::to_string(config.speed) + "x" : "line rate")
+              << ", Ctrl+C to stop" << std::endl;
+    server.Run();
+    g_server = nullptr;
+
+    MockServerStats stats = server.Stats();
+    std::cout << "Served " << stats.connections << " connection(s), " << stats.messages << " messages ("
+              << stats.bytes / (1024 * 1024) << " MiB), " << stats.disconnects_injected
+              << " injected disconnect(s); orders " << stats.orders_accepted << " accepted, "
+              << stats.orders_rejected << " rejected, " << stats.orders_cancelled << " cancelled" << std::endl;
+    return 0;
+}
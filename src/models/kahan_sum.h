@@ -0,0 +1,23 @@
+#ifndef KAHAN_SUM_H
+#define KAHAN_SUM_H
+
+// Kahan-compensated running sum. Subtracting is just adding a negative value,
+// so the same accumulator supports sliding-window add/evict updates.
+struct KahanSum {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    void Add(double value) {
+        double y = value - compensation;
+        double t = sum + y;
+        compensation = (t - sum) - y;
+        sum = t;
+    }
+
+    void Reset() {
+        sum = 0.0;
+        compensation = 0.0;
+    }
+};
+
+#endif
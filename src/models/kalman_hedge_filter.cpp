@@ -0,0 +1,79 @@
+#include "kalman_hedge_filter.h"
+#include <cmath>
+
+KalmanHedgeFilter::KalmanHedgeFilter(const KalmanHedgeParameters& parameters)
+    : parameters_(parameters),
+      state_noise_(parameters.delta / (1.0 - parameters.delta)) {
+    Reset();
+}
+
+void KalmanHedgeFilter::Reset() {
+    intercept_ = 0.0;
+    slope_ = 0.0;
+    p00_ = 0.0;
+    p01_ = 0.0;
+    p11_ = 0.0;
+    innovation_ = 0.0;
+    innovation_variance_ = 0.0;
+    updates_ = 0;
+}
+
+void KalmanHedgeFilter::Update(double y, double x) {
+    // Predict: random-walk state, so only the covariance grows.
+    double r00 = p00_ + state_noise_;
+    double r01 = p01_;
+    double r11 = p11_ + state_noise_;
+
+    // Observation row H = [1, x].
+    double hr0 = r00 + x * r01;
+    double hr1 = r01 + x * r11;
+    double s = hr0 + x * hr1 + parameters_.observation_variance;
+
+    innovation_ = y - (intercept_ + slope_ * x);
+    innovation_variance_ = s;
+
+    // Correct: K = R Hᵀ / s, P = R - K H R.
+    double k0 = hr0 / s;
+    double k1 = hr1 / s;
+    intercept_ += k0 * innovation_;
+    slope_ += k1 * innovation_;
+
+    p00_ = r00 - k0 * hr0;
+    p01_ = r01 - k0 * hr1;
+    p11_ = r11 - k1 * hr1;
+
+    updates_++;
+}
+
+bool KalmanHedgeFilter::IsWarm() const {
+    return updates_ > parameters_.warmup_updates;
+}
+
+size_t KalmanHedgeFilter::UpdateCount() const {
+    return updates_;
+}
+
+double KalmanHedgeFilter::Intercept() const {
+    return intercept_;
+}
+
+double KalmanHedgeFilter::Slope() const {
+    return slope_;
+}
+
+double KalmanHedgeFilter::Innovation() const {
+    return innovation_;
+}
+
+double KalmanHedgeFilter::InnovationVariance() const {
+    return innovation_variance_;
+}
+
+double KalmanHedgeFilter::InnovationZScore() const {
+    if (innovation_variance_ < 1e-20) return 0.0;
+    return innovation_ / std::sqrt(innovation_variance_);
+}
+
+const KalmanHedgeParameters& KalmanHedgeFilter::Parameters() const {
+    return parameters_;
+}
@@ -0,0 +1,55 @@
+#ifndef KALMAN_HEDGE_FILTER_H
+#define KALMAN_HEDGE_FILTER_H
+
+#include <cstddef>
+
+struct KalmanHedgeParameters {
+    // State noise as a fraction of the state; larger adapts the hedge faster.
+    double delta = 1e-4;
+    // Measurement noise variance of y given the state, in price units squared.
+    double observation_variance = 1e-3;
+    // Updates to absorb before the innovation z-score is trusted.
+    size_t warmup_updates = 30;
+};
+
+// Two-state Kalman filter tracking y = intercept + slope * x, with both states
+// following a random walk. Each update is fixed-size 2x2 arithmetic on
+// members only: constant time, no window and no allocation. The innovation
+// and its predicted variance give the spread and its z-score directly.
+class KalmanHedgeFilter {
+public:
+    explicit KalmanHedgeFilter(const KalmanHedgeParameters& parameters = KalmanHedgeParameters());
+
+    // Predicts y from x with the prior state, then corrects the state.
+    void Update(double y, double x);
+    void Reset();
+
+    bool IsWarm() const;
+    size_t UpdateCount() const;
+
+    double Intercept() const;
+    double Slope() const;
+    // y minus the prior prediction from the latest Update.
+    double Innovation() const;
+    double InnovationVariance() const;
+    double InnovationZScore() const;
+
+    const KalmanHedgeParameters& Parameters() const;
+
+private:
+    KalmanHedgeParameters parameters_;
+    double state_noise_;
+
+    double intercept_;
+    double slope_;
+    // Symmetric state covariance [[p00, p01], [p01, p11]].
+    double p00_;
+    double p01_;
+    double p11_;
+
+    double innovation_;
+    double innovation_variance_;
+    size_t updates_;
+};
+
+#endif
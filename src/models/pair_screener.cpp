@@ -0,0 +1,268 @@
+#include "pair_screener.h"
+#include "simd_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Symbols per cache tile and bars per time block in Rebuild(): a 16 x 512
+// block of anchored prices is 64 KiB, which stays resident in L2.
+const size_t kSymbolBlock = 16;
+const size_t kTimeBlock = 512;
+
+const size_t kMinimumBars = 30;
+
+}  // namespace
+
+PairScreener::PairScreener(const PairScreenerConfig& config)
+    : config_(config),
+      window_(config.window > 1 ? config.window : 2),
+      stride_(((2 * window_) + 7) & ~static_cast<size_t>(7)),
+      rebuild_interval_(config.rebuild_interval > 0 ? config.rebuild_interval : window_),
+      priced_count_(0),
+      bars_(0),
+      bars_since_rebuild_(0) {}
+
+uint32_t PairScreener::AddSymbol(const std::string& symbol) {
+    auto it = ids_.find(symbol);
+    if (it != ids_.end()) return it->second;
+
+    if (bars_ > 0) {
+        throw std::logic_error("PairScreener symbols must be added before the first bar: " + symbol);
+    }
+
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    ids_.emplace(symbol, id);
+    names_.push_back(symbol);
+    pending_.push_back(0.0);
+    priced_.push_back(0);
+    return id;
+}
+
+void PairScreener::UpdatePrice(uint32_t symbol, double close) {
+    if (symbol >= pending_.size()) return;
+
+    pending_[symbol] = close;
+    if (!priced_[symbol]) {
+        priced_[symbol] = 1;
+        priced_count_++;
+    }
+}
+
+void PairScreener::UpdatePrice(const std::string& symbol, double close) {
+    auto it = ids_.find(symbol);
+    if (it != ids_.end()) {
+        UpdatePrice(it->second, close);
+    }
+}
+
+void PairScreener::UpdatePrice(uint32_t symbol, const Decimal& close) {
+    UpdatePrice(symbol, close.ToDouble());
+}
+
+void PairScreener::UpdatePrice(const std::string& symbol, const Decimal& close) {
+    UpdatePrice(symbol, close.ToDouble());
+}
+
+void PairScreener::CloseBar() {
+    size_t n = names_.size();
+    if (n == 0 || priced_count_ < n) return;
+
+    if (bars_ == 0) {
+        history_.assign(n * stride_, 0.0);
+        anchors_.assign(pending_.begin(), pending_.end());
+        sums_.assign(n, 0.0);
+        sum_squares_.assign(n, 0.0);
+        cross_.assign(n * n, 0.0);
+        new_values_.assign(n, 0.0);
+        old_values_.assign(n, 0.0);
+    }
+
+    size_t slot = bars_ % window_;
+    bool full = bars_ >= window_;
+
+    for (size_t i = 0; i < n; i++) {
+        double* series = &history_[i * stride_];
+        double evicted = full ? series[slot] : anchors_[i];
+        series[slot] = pending_[i];
+        series[slot + window_] = pending_[i];
+
+        new_values_[i] = pending_[i] - anchors_[i];
+        old_values_[i] = evicted - anchors_[i];
+        sums_[i] += new_values_[i] - old_values_[i];
+        sum_squares_[i] += new_values_[i] * new_values_[i] - old_values_[i] * old_values_[i];
+    }
+
+    for (size_t i = 0; i + 1 < n; i++) {
+        simd::UpdateCrossRow(&cross_[i * n + i + 1], &new_values_[i + 1], &old_values_[i + 1],
+                             new_values_[i], old_values_[i], n - i - 1);
+    }
+
+    bars_++;
+    bars_since_rebuild_++;
+
+    if (bars_ >= window_ && bars_since_rebuild_ >= rebuild_interval_) {
+        Rebuild();
+    }
+}
+
+size_t PairScreener::Count() const {
+    return std::min(bars_, window_);
+}
+
+const double* PairScreener::Window(uint32_t symbol) const {
+    const double* series = &history_[symbol * stride_];
+    return bars_ >= window_ ? series + (bars_ % window_) : series;
+}
+
+void PairScreener::Rebuild() {
+    size_t n = names_.size();
+    size_t count = Count();
+    scratch_.resize(n * count);
+
+    for (uint32_t i = 0; i < n; i++) {
+        const double* window = Window(i);
+        double mean = 0.0;
+        for (size_t t = 0; t < count; t++) mean += window[t];
+        anchors_[i] = mean / count;
+        simd::AnchorSeries(window, count, anchors_[i], &scratch_[i * count], sums_[i], sum_squares_[i]);
+    }
+
+    std::fill(cross_.begin(), cross_.end(), 0.0);
+
+    for (size_t i0 = 0; i0 < n; i0 += kSymbolBlock) {
+        size_t i1 = std::min(i0 + kSymbolBlock, n);
+        for (size_t j0 = i0; j0 < n; j0 += kSymbolBlock) {
+            size_t j1 = std::min(j0 + kSymbolBlock, n);
+            for (size_t t0 = 0; t0 < count; t0 += kTimeBlock) {
+                size_t length = std::min(kTimeBlock, count - t0);
+                for (size_t i = i0; i < i1; i++) {
+                    const double* a = &scratch_[i * count + t0];
+                    for (size_t j = std::max(j0, i + 1); j < j1; j++) {
+                        cross_[i * n + j] += simd::Dot(a, &scratch_[j * count + t0], length);
+                    }
+                }
+            }
+        }
+    }
+
+    bars_since_rebuild_ = 0;
+}
+
+void PairScreener::ScorePair(uint32_t y, uint32_t x, double correlation, PairScore& score) const {
+    size_t count = Count();
+    double n = static_cast<double>(count);
+
+    uint32_t low = std::min(x, y);
+    uint32_t high = std::max(x, y);
+    double covariance = cross_[low * names_.size() + high] - sums_[x] * sums_[y] / n;
+    double variance_x = sum_squares_[x] - sums_[x] * sums_[x] / n;
+
+    double beta = variance_x > 0.0 ? covariance / variance_x : 0.0;
+    double mean_x = anchors_[x] + sums_[x] / n;
+    double mean_y = anchors_[y] + sums_[y] / n;
+    double alpha = mean_y - beta * mean_x;
+
+    simd::AdfSums adf = simd::ResidualAdfSums(Window(y), Window(x), count, alpha, beta);
+
+    double m = n - 1.0;
+    double s_lag = adf.lag_lag - adf.lag * adf.lag / m;
+    double s_lag_diff = adf.lag_diff - adf.lag * adf.diff / m;
+    double s_diff = adf.diff_diff - adf.diff * adf.diff / m;
+
+    double gamma = s_lag > 0.0 ? s_lag_diff / s_lag : 0.0;
+    double residual_variance = std::max(0.0, s_diff - gamma * s_lag_diff) / (m - 2.0);
+    double standard_error = s_lag > 0.0 ? std::sqrt(residual_variance / s_lag) : 0.0;
+
+    score.y_symbol = y;
+    score.x_symbol = x;
+    score.y_name = names_[y];
+    score.x_name = names_[x];
+    score.correlation = correlation;
+    score.hedge_ratio = beta;
+    score.intercept = alpha;
+    score.adf_statistic = standard_error > 0.0 ? gamma / standard_error : 0.0;
+    // gamma <= -1 wipes out (or overshoots) a deviation within one bar.
+    if (gamma >= 0.0) {
+        score.half_life = std::numeric_limits<double>::infinity();
+    } else if (gamma <= -1.0) {
+        score.half_life = 0.0;
+    } else {
+        score.half_life = -std::log(2.0) / std::log1p(gamma);
+    }
+    score.cointegrated = score.adf_statistic < config_.adf_critical_value;
+}
+
+std::vector<PairScore> PairScreener::Screen() const {
+    std::vector<PairScore> ranked;
+    size_t n = names_.size();
+    size_t count = Count();
+    if (n < 2 || count < kMinimumBars) return ranked;
+
+    struct Candidate {
+        uint32_t i;
+        uint32_t j;
+        double correlation;
+    };
+    std::vector<Candidate> candidates;
+
+    double bars = static_cast<double>(count);
+    for (uint32_t i = 0; i < n; i++) {
+        double variance_i = sum_squares_[i] - sums_[i] * sums_[i] / bars;
+        if (variance_i <= 0.0) continue;
+
+        for (uint32_t j = i + 1; j < n; j++) {
+            double variance_j = sum_squares_[j] - sums_[j] * sums_[j] / bars;
+            if (variance_j <= 0.0) continue;
+
+            double covariance = cross_[i * n + j] - sums_[i] * sums_[j] / bars;
+            double correlation = covariance / std::sqrt(variance_i * variance_j);
+            if (std::abs(correlation) >= config_.min_abs_correlation) {
+                candidates.push_back({i, j, correlation});
+            }
+        }
+    }
+
+    if (candidates.size() > config_.max_candidates) {
+        std::nth_element(candidates.begin(), candidates.begin() + config_.max_candidates, candidates.end(),
+                         [](const Candidate& a, const Candidate& b) {
+                             return std::abs(a.correlation) > std::abs(b.correlation);
+                         });
+        candidates.resize(config_.max_candidates);
+    }
+
+    // Engle-Granger depends on which leg is regressed on which; keep the
+    // orientation with the stronger rejection.
+    ranked.reserve(candidates.size());
+    for (const auto& candidate : candidates) {
+        PairScore forward;
+        PairScore reverse;
+        ScorePair(candidate.i, candidate.j, candidate.correlation, forward);
+        ScorePair(candidate.j, candidate.i, candidate.correlation, reverse);
+        ranked.push_back(forward.adf_statistic <= reverse.adf_statistic ? forward : reverse);
+    }
+
+    std::sort(ranked.begin(), ranked.end(), [](const PairScore& a, const PairScore& b) {
+        return a.adf_statistic < b.adf_statistic;
+    });
+
+    return ranked;
+}
+
+size_t PairScreener::SymbolCount() const {
+    return names_.size();
+}
+
+size_t PairScreener::BarCount() const {
+    return bars_;
+}
+
+bool PairScreener::Ready() const {
+    return bars_ >= window_;
+}
+
+const std::string& PairScreener::SymbolName(uint32_t symbol) const {
+    return names_.at(symbol);
+}
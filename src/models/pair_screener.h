@@ -0,0 +1,104 @@
+#ifndef PAIR_SCREENER_H
+#define PAIR_SCREENER_H
+
+#include "../market_data/decimal.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct PairScore {
+    uint32_t y_symbol;
+    uint32_t x_symbol;
+    std::string y_name;
+    std::string x_name;
+    double correlation;
+    double hedge_ratio;
+    double intercept;
+    // Engle-Granger: Dickey-Fuller t-statistic on the OLS residuals.
+    double adf_statistic;
+    // Bars for a spread deviation to halve: infinity if not mean-reverting,
+    // 0 if it reverts fully within a bar.
+    double half_life;
+    bool cointegrated;
+};
+
+struct PairScreenerConfig {
+    size_t window = 500;
+    // Only pairs at least this correlated reach the cointegration stage.
+    double min_abs_correlation = 0.8;
+    // Upper bound on pairs given the O(window) ADF test per Screen().
+    size_t max_candidates = 256;
+    // 5% Engle-Granger critical value for two series.
+    double adf_critical_value = -3.34;
+    // Full rebuild cadence in bars to reset incremental drift; 0 means window.
+    size_t rebuild_interval = 0;
+};
+
+// Screens every pair in a symbol universe for statistical arbitrage.
+//
+// Closing prices are kept per symbol in a double-written ring (each bar is
+// stored at i and i + window) so the current window is always one contiguous
+// slice. Per-symbol sums and the full cross-product matrix are slid by one bar
+// in O(N²) vectorized work per bar instead of O(N² · window), with a periodic
+// cache-blocked rebuild. Screen() turns the sums into correlations, runs the
+// Engle-Granger test on the strongest candidates and ranks them, most
+// cointegrated first, ready to become model instances.
+class PairScreener {
+public:
+    explicit PairScreener(const PairScreenerConfig& config = PairScreenerConfig());
+
+    // Symbols must be registered before the first bar is closed.
+    uint32_t AddSymbol(const std::string& symbol);
+
+    void UpdatePrice(uint32_t symbol, double close);
+    void UpdatePrice(const std::string& symbol, double close);
+    // Exact closes, e.g. from candles; converted to double here.
+    void UpdatePrice(uint32_t symbol, const Decimal& close);
+    void UpdatePrice(const std::string& symbol, const Decimal& close);
+
+    // Commits one bar. Symbols without a new price carry the last one
+    // forward; bars are skipped until every symbol has been priced once.
+    void CloseBar();
+
+    std::vector<PairScore> Screen() const;
+
+    size_t SymbolCount() const;
+    size_t BarCount() const;
+    bool Ready() const;
+    const std::string& SymbolName(uint32_t symbol) const;
+
+private:
+    PairScreenerConfig config_;
+    size_t window_;
+    size_t stride_;
+    size_t rebuild_interval_;
+
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, uint32_t> ids_;
+
+    std::vector<double> pending_;
+    std::vector<uint8_t> priced_;
+    size_t priced_count_;
+
+    std::vector<double> history_;
+    size_t bars_;
+    size_t bars_since_rebuild_;
+
+    // Sums over the window of (price - anchor), per symbol and per pair.
+    std::vector<double> anchors_;
+    std::vector<double> sums_;
+    std::vector<double> sum_squares_;
+    std::vector<double> cross_;
+
+    std::vector<double> new_values_;
+    std::vector<double> old_values_;
+    std::vector<double> scratch_;
+
+    size_t Count() const;
+    const double* Window(uint32_t symbol) const;
+    void Rebuild();
+    void ScorePair(uint32_t y, uint32_t x, double correlation, PairScore& score) const;
+};
+
+#endif
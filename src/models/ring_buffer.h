@@ -0,0 +1,53 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <cstddef>
+#include <vector>
+
+// Fixed-capacity circular buffer over one contiguous allocation made at
+// construction. push_back on a full buffer overwrites the oldest element,
+// so steady-state use never allocates. Element 0 is the oldest.
+template <typename T>
+class RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity)
+        : data_(capacity > 0 ? capacity : 1), head_(0), size_(0) {}
+
+    void push_back(const T& value) {
+        size_t tail = head_ + size_;
+        if (tail >= data_.size()) tail -= data_.size();
+        data_[tail] = value;
+
+        if (size_ < data_.size()) {
+            size_++;
+        } else {
+            head_ = (head_ + 1 == data_.size()) ? 0 : head_ + 1;
+        }
+    }
+
+    const T& operator[](size_t i) const {
+        size_t index = head_ + i;
+        if (index >= data_.size()) index -= data_.size();
+        return data_[index];
+    }
+
+    const T& front() const { return data_[head_]; }
+    const T& back() const { return (*this)[size_ - 1]; }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return data_.size(); }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == data_.size(); }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+private:
+    std::vector<T> data_;
+    size_t head_;
+    size_t size_;
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "rolling_regression.h"
+
+RollingRegression::RollingRegression(size_t reanchor_interval)
+    : reanchor_interval_(reanchor_interval > 0 ? reanchor_interval : 1),
+      count_(0), updates_since_reanchor_(0),
+      anchor_x_(0.0), anchor_y_(0.0) {}
+
+void RollingRegression::Add(double x, double y) {
+    if (count_ == 0) {
+        anchor_x_ = x;
+        anchor_y_ = y;
+    }
+
+    double dx = x - anchor_x_;
+    double dy = y - anchor_y_;
+    sum_x_.Add(dx);
+    sum_y_.Add(dy);
+    sum_xy_.Add(dx * dy);
+    sum_xx_.Add(dx * dx);
+
+    count_++;
+    updates_since_reanchor_++;
+}
+
+void RollingRegression::Remove(double x, double y) {
+    if (count_ == 0) return;
+
+    double dx = x - anchor_x_;
+    double dy = y - anchor_y_;
+    sum_x_.Add(-dx);
+    sum_y_.Add(-dy);
+    sum_xy_.Add(-dx * dy);
+    sum_xx_.Add(-dx * dx);
+
+    count_--;
+    updates_since_reanchor_++;
+}
+
+void RollingRegression::Reset() {
+    sum_x_.Reset();
+    sum_y_.Reset();
+    sum_xy_.Reset();
+    sum_xx_.Reset();
+    anchor_x_ = 0.0;
+    anchor_y_ = 0.0;
+    count_ = 0;
+    updates_since_reanchor_ = 0;
+}
+
+bool RollingRegression::NeedsReanchor() const {
+    return updates_since_reanchor_ >= reanchor_interval_;
+}
+
+size_t RollingRegression::Count() const {
+    return count_;
+}
+
+double RollingRegression::Slope(double fallback) const {
+    if (count_ < 2) return fallback;
+
+    double n = static_cast<double>(count_);
+    double sxx = sum_xx_.sum - sum_x_.sum * sum_x_.sum / n;
+    double sxy = sum_xy_.sum - sum_x_.sum * sum_y_.sum / n;
+
+    if (sxx < 1e-12 * (sum_xx_.sum + 1.0)) return fallback;
+
+    return sxy / sxx;
+}
+
+double RollingRegression::Intercept(double slope) const {
+    if (count_ == 0) return 0.0;
+
+    double n = static_cast<double>(count_);
+    double mean_x = anchor_x_ + sum_x_.sum / n;
+    double mean_y = anchor_y_ + sum_y_.sum / n;
+    return mean_y - slope * mean_x;
+}
@@ -0,0 +1,77 @@
+#ifndef ROLLING_REGRESSION_H
+#define ROLLING_REGRESSION_H
+
+#include <cstddef>
+#include "kahan_sum.h"
+
+// Sliding-window simple linear regression y = a + b * x maintained from the
+// running sums Σx, Σy, Σxy and Σx². Samples are stored relative to an anchor
+// point so the sums stay small for prices in the tens of thousands; the
+// anchor is moved to the window mean and the sums rebuilt every
+// reanchor_interval updates to flush accumulated rounding error.
+class RollingRegression {
+public:
+    explicit RollingRegression(size_t reanchor_interval);
+
+    void Add(double x, double y);
+    void Remove(double x, double y);
+    void Reset();
+
+    bool NeedsReanchor() const;
+
+    // Rebuilds the sums from the current window. Window is any container
+    // with size() and operator[], x and y aligned element for element.
+    template <typename Window>
+    void Reanchor(const Window& xs, const Window& ys) {
+        size_t n = xs.size();
+        if (n == 0) {
+            Reset();
+            return;
+        }
+
+        KahanSum mean_x;
+        KahanSum mean_y;
+        for (size_t i = 0; i < n; i++) {
+            mean_x.Add(xs[i]);
+            mean_y.Add(ys[i]);
+        }
+        anchor_x_ = mean_x.sum / n;
+        anchor_y_ = mean_y.sum / n;
+
+        sum_x_.Reset();
+        sum_y_.Reset();
+        sum_xy_.Reset();
+        sum_xx_.Reset();
+        for (size_t i = 0; i < n; i++) {
+            double dx = xs[i] - anchor_x_;
+            double dy = ys[i] - anchor_y_;
+            sum_x_.Add(dx);
+            sum_y_.Add(dy);
+            sum_xy_.Add(dx * dy);
+            sum_xx_.Add(dx * dx);
+        }
+        count_ = n;
+        updates_since_reanchor_ = 0;
+    }
+
+    size_t Count() const;
+
+    // Returns fallback when the window is too short or x has no variance.
+    double Slope(double fallback) const;
+    double Intercept(double slope) const;
+
+private:
+    size_t reanchor_interval_;
+    size_t count_;
+    size_t updates_since_reanchor_;
+
+    double anchor_x_;
+    double anchor_y_;
+
+    KahanSum sum_x_;
+    KahanSum sum_y_;
+    KahanSum sum_xy_;
+    KahanSum sum_xx_;
+};
+
+#endif
@@ -0,0 +1,49 @@
+#include "rolling_statistics.h"
+#include <cmath>
+
+RollingMeanVariance::RollingMeanVariance() : count_(0) {}
+
+void RollingMeanVariance::Add(double value) {
+    count_++;
+    double delta = value - mean_.sum;
+    mean_.Add(delta / count_);
+    m2_.Add(delta * (value - mean_.sum));
+}
+
+void RollingMeanVariance::Replace(double evicted, double value) {
+    if (count_ == 0) {
+        Add(value);
+        return;
+    }
+
+    double old_mean = mean_.sum;
+    double delta = value - evicted;
+    mean_.Add(delta / count_);
+    m2_.Add(delta * ((value - mean_.sum) + (evicted - old_mean)));
+}
+
+void RollingMeanVariance::Reset() {
+    count_ = 0;
+    mean_.Reset();
+    m2_.Reset();
+}
+
+size_t RollingMeanVariance::Count() const {
+    return count_;
+}
+
+double RollingMeanVariance::Mean() const {
+    return mean_.sum;
+}
+
+double RollingMeanVariance::Variance() const {
+    if (count_ == 0) return 0.0;
+
+    // Cancellation can leave M2 a hair below zero for a flat window.
+    double m2 = m2_.sum > 0.0 ? m2_.sum : 0.0;
+    return m2 / count_;
+}
+
+double RollingMeanVariance::StandardDeviation() const {
+    return std::sqrt(Variance());
+}
@@ -0,0 +1,30 @@
+#ifndef ROLLING_STATISTICS_H
+#define ROLLING_STATISTICS_H
+
+#include <cstddef>
+#include "kahan_sum.h"
+
+// Sliding-window mean and population variance using Welford's update, with
+// the mean and M2 accumulators Kahan-compensated so long-running windows do
+// not drift. Add() grows the window; Replace() slides it by evicting the
+// oldest sample and admitting a new one in a single O(1) step.
+class RollingMeanVariance {
+public:
+    RollingMeanVariance();
+
+    void Add(double value);
+    void Replace(double evicted, double value);
+    void Reset();
+
+    size_t Count() const;
+    double Mean() const;
+    double Variance() const;
+    double StandardDeviation() const;
+
+private:
+    size_t count_;
+    KahanSum mean_;
+    KahanSum m2_;
+};
+
+#endif
@@ -0,0 +1,279 @@
+#include "simd_kernels.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace simd {
+namespace {
+
+double DotScalar(const double* a, const double* b, size_t n) {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; i++) {
+        s0 += a[i] * b[i];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+void UpdateCrossRowScalar(double* row, const double* new_values, const double* old_values,
+                          double scale_new, double scale_old, size_t n) {
+    for (size_t j = 0; j < n; j++) {
+        row[j] += scale_new * new_values[j] - scale_old * old_values[j];
+    }
+}
+
+void AnchorSeriesScalar(const double* a, size_t n, double anchor, double* out, double& sum, double& sum_squares) {
+    double s = 0.0, ss = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        double v = a[i] - anchor;
+        out[i] = v;
+        s += v;
+        ss += v * v;
+    }
+    sum = s;
+    sum_squares = ss;
+}
+
+AdfSums ResidualAdfSumsScalar(const double* y, const double* x, size_t n, double alpha, double beta) {
+    AdfSums sums = {0.0, 0.0, 0.0, 0.0, 0.0};
+    if (n < 2) return sums;
+
+    double previous = y[0] - alpha - beta * x[0];
+    for (size_t t = 1; t < n; t++) {
+        double current = y[t] - alpha - beta * x[t];
+        double diff = current - previous;
+        sums.lag += previous;
+        sums.diff += diff;
+        sums.lag_lag += previous * previous;
+        sums.lag_diff += previous * diff;
+        sums.diff_diff += diff * diff;
+        previous = current;
+    }
+    return sums;
+}
+
+#ifdef SIMD_KERNELS_X86
+
+__attribute__((target("avx2,fma")))
+double HorizontalSum(__m256d v) {
+    __m128d low = _mm256_castpd256_pd128(v);
+    __m128d high = _mm256_extractf128_pd(v, 1);
+    low = _mm_add_pd(low, high);
+    __m128d swapped = _mm_unpackhi_pd(low, low);
+    return _mm_cvtsd_f64(_mm_add_sd(low, swapped));
+}
+
+__attribute__((target("avx2,fma")))
+double DotAvx2(const double* a, const double* b, size_t n) {
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+    }
+    double sum = HorizontalSum(_mm256_add_pd(acc0, acc1));
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+__attribute__((target("avx2,fma")))
+void UpdateCrossRowAvx2(double* row, const double* new_values, const double* old_values,
+                        double scale_new, double scale_old, size_t n) {
+    __m256d vnew = _mm256_set1_pd(scale_new);
+    __m256d vold = _mm256_set1_pd(scale_old);
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m256d r = _mm256_loadu_pd(row + j);
+        r = _mm256_fmadd_pd(vnew, _mm256_loadu_pd(new_values + j), r);
+        r = _mm256_fnmadd_pd(vold, _mm256_loadu_pd(old_values + j), r);
+        _mm256_storeu_pd(row + j, r);
+    }
+    for (; j < n; j++) {
+        row[j] += scale_new * new_values[j] - scale_old * old_values[j];
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void AnchorSeriesAvx2(const double* a, size_t n, double anchor, double* out, double& sum, double& sum_squares) {
+    __m256d vanchor = _mm256_set1_pd(anchor);
+    __m256d s = _mm256_setzero_pd();
+    __m256d ss = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_sub_pd(_mm256_loadu_pd(a + i), vanchor);
+        _mm256_storeu_pd(out + i, v);
+        s = _mm256_add_pd(s, v);
+        ss = _mm256_fmadd_pd(v, v, ss);
+    }
+    double total = HorizontalSum(s);
+    double total_squares = HorizontalSum(ss);
+    for (; i < n; i++) {
+        double v = a[i] - anchor;
+        out[i] = v;
+        total += v;
+        total_squares += v * v;
+    }
+    sum = total;
+    sum_squares = total_squares;
+}
+
+__attribute__((target("avx2,fma")))
+AdfSums ResidualAdfSumsAvx2(const double* y, const double* x, size_t n, double alpha, double beta) {
+    AdfSums sums = {0.0, 0.0, 0.0, 0.0, 0.0};
+    if (n < 2) return sums;
+
+    __m256d valpha = _mm256_set1_pd(alpha);
+    __m256d vbeta = _mm256_set1_pd(beta);
+    __m256d lag = _mm256_setzero_pd();
+    __m256d diff = _mm256_setzero_pd();
+    __m256d lag_lag = _mm256_setzero_pd();
+    __m256d lag_diff = _mm256_setzero_pd();
+    __m256d diff_diff = _mm256_setzero_pd();
+
+    size_t t = 1;
+    for (; t + 4 <= n; t += 4) {
+        __m256d previous = _mm256_sub_pd(_mm256_loadu_pd(y + t - 1),
+                                         _mm256_fmadd_pd(vbeta, _mm256_loadu_pd(x + t - 1), valpha));
+        __m256d current = _mm256_sub_pd(_mm256_loadu_pd(y + t),
+                                        _mm256_fmadd_pd(vbeta, _mm256_loadu_pd(x + t), valpha));
+        __m256d d = _mm256_sub_pd(current, previous);
+        lag = _mm256_add_pd(lag, previous);
+        diff = _mm256_add_pd(diff, d);
+        lag_lag = _mm256_fmadd_pd(previous, previous, lag_lag);
+        lag_diff = _mm256_fmadd_pd(previous, d, lag_diff);
+        diff_diff = _mm256_fmadd_pd(d, d, diff_diff);
+    }
+
+    sums.lag = HorizontalSum(lag);
+    sums.diff = HorizontalSum(diff);
+    sums.lag_lag = HorizontalSum(lag_lag);
+    sums.lag_diff = HorizontalSum(lag_diff);
+    sums.diff_diff = HorizontalSum(diff_diff);
+
+    for (; t < n; t++) {
+        double previous = y[t - 1] - alpha - beta * x[t - 1];
+        double d = (y[t] - alpha - beta * x[t]) - previous;
+        sums.lag += previous;
+        sums.diff += d;
+        sums.lag_lag += previous * previous;
+        sums.lag_diff += previous * d;
+        sums.diff_diff += d * d;
+    }
+    return sums;
+}
+
+__attribute__((target("avx512f")))
+double DotAvx512(const double* a, const double* b, size_t n) {
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), acc1);
+    }
+    if (i + 8 <= n) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+        i += 8;
+    }
+    if (i < n) {
+        __mmask8 mask = static_cast<__mmask8>((1u << (n - i)) - 1);
+        acc1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, a + i), _mm512_maskz_loadu_pd(mask, b + i), acc1);
+    }
+    // Spilled rather than _mm512_reduce_add_pd, which trips -Wuninitialized
+    // inside some GCC headers; this runs once per call.
+    alignas(64) double lanes[8];
+    _mm512_store_pd(lanes, _mm512_add_pd(acc0, acc1));
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+__attribute__((target("avx512f")))
+void UpdateCrossRowAvx512(double* row, const double* new_values, const double* old_values,
+                          double scale_new, double scale_old, size_t n) {
+    __m512d vnew = _mm512_set1_pd(scale_new);
+    __m512d vold = _mm512_set1_pd(scale_old);
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m512d r = _mm512_loadu_pd(row + j);
+        r = _mm512_fmadd_pd(vnew, _mm512_loadu_pd(new_values + j), r);
+        r = _mm512_fnmadd_pd(vold, _mm512_loadu_pd(old_values + j), r);
+        _mm512_storeu_pd(row + j, r);
+    }
+    if (j < n) {
+        __mmask8 mask = static_cast<__mmask8>((1u << (n - j)) - 1);
+        __m512d r = _mm512_maskz_loadu_pd(mask, row + j);
+        r = _mm512_fmadd_pd(vnew, _mm512_maskz_loadu_pd(mask, new_values + j), r);
+        r = _mm512_fnmadd_pd(vold, _mm512_maskz_loadu_pd(mask, old_values + j), r);
+        _mm512_mask_storeu_pd(row + j, mask, r);
+    }
+}
+
+#endif  // SIMD_KERNELS_X86
+
+struct KernelTable {
+    double (*dot)(const double*, const double*, size_t);
+    void (*update_cross_row)(double*, const double*, const double*, double, double, size_t);
+    void (*anchor_series)(const double*, size_t, double, double*, double&, double&);
+    AdfSums (*residual_adf_sums)(const double*, const double*, size_t, double, double);
+    const char* name;
+};
+
+KernelTable SelectKernels() {
+    KernelTable table = {DotScalar, UpdateCrossRowScalar, AnchorSeriesScalar, ResidualAdfSumsScalar, "scalar"};
+
+#ifdef SIMD_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        table = {DotAvx2, UpdateCrossRowAvx2, AnchorSeriesAvx2, ResidualAdfSumsAvx2, "avx2"};
+    }
+    // The ADF and anchoring passes are load-bound and gain nothing from
+    // 512-bit vectors, so they stay on AVX2.
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        table.dot = DotAvx512;
+        table.update_cross_row = UpdateCrossRowAvx512;
+        table.name = "avx512";
+    }
+#endif
+
+    return table;
+}
+
+const KernelTable& Kernels() {
+    static const KernelTable table = SelectKernels();
+    return table;
+}
+
+}  // namespace
+
+double Dot(const double* a, const double* b, size_t n) {
+    return Kernels().dot(a, b, n);
+}
+
+void UpdateCrossRow(double* row, const double* new_values, const double* old_values,
+                    double scale_new, double scale_old, size_t n) {
+    Kernels().update_cross_row(row, new_values, old_values, scale_new, scale_old, n);
+}
+
+void AnchorSeries(const double* a, size_t n, double anchor, double* out, double& sum, double& sum_squares) {
+    Kernels().anchor_series(a, n, anchor, out, sum, sum_squares);
+}
+
+AdfSums ResidualAdfSums(const double* y, const double* x, size_t n, double alpha, double beta) {
+    return Kernels().residual_adf_sums(y, x, n, alpha, beta);
+}
+
+const char* ActiveInstructionSet() {
+    return Kernels().name;
+}
+
+}  // namespace simd
@@ -0,0 +1,40 @@
+#ifndef SIMD_KERNELS_H
+#define SIMD_KERNELS_H
+
+#include <cstddef>
+
+// Vectorized inner loops for pair screening. Each kernel picks an AVX-512,
+// AVX2+FMA or scalar implementation once at first use from the running CPU,
+// so the binary needs no -march flags and still runs on older x86 and ARM.
+namespace simd {
+
+struct AdfSums {
+    double lag;
+    double diff;
+    double lag_lag;
+    double lag_diff;
+    double diff_diff;
+};
+
+// Σ a[i] * b[i]
+double Dot(const double* a, const double* b, size_t n);
+
+// row[j] += scale_new * new_values[j] - scale_old * old_values[j]
+// Slides one row of a cross-product matrix by one bar.
+void UpdateCrossRow(double* row, const double* new_values, const double* old_values,
+                    double scale_new, double scale_old, size_t n);
+
+// Σ (a[i] - anchor) and Σ (a[i] - anchor)², written to out[i] as a side effect
+// so the anchored series can be reused by Dot.
+void AnchorSeries(const double* a, size_t n, double anchor, double* out, double& sum, double& sum_squares);
+
+// Sums for the Dickey-Fuller regression Δe_t = c + γ e_{t-1} on the residuals
+// e_t = y[t] - alpha - beta * x[t], t = 1..n-1, in a single fused pass.
+AdfSums ResidualAdfSums(const double* y, const double* x, size_t n, double alpha, double beta);
+
+// "avx512", "avx2" or "scalar".
+const char* ActiveInstructionSet();
+
+}  // namespace simd
+
+#endif
@@ -1,140 +1,360 @@
-#include <Eigen/Dense>
+#include "statistical_arbitrage_model.h"
 #include <vector>
 #include <numeric>
 #include <cmath>
-#include <iostream>
-#include <map>
-#include <deque>
+#include "../logging/async_logger.h"
+#include "../storage/snapshot_file.h"
+#include <type_traits>
 
-class StatisticalArbitrageModel {
-    
-private:
-    size_t lookback_;
-    double z_entry_;
-    double z_exit_;
-    
-    std::deque<double> btc_prices_;
-    std::deque<double> eth_prices_;
-    std::deque<double> spreads_;
-    
-    double current_hedge_ratio_;
-    
-    enum class Position {
-        NONE,
-        LONG_SPREAD,
-        SHORT_SPREAD
-    };
-    
-    Position current_position_;
-    
-    void MaintainWindowSize(std::deque<double>& data) {
-        if (data.size() > lookback_) {
-            data.pop_front();
-        }
+namespace {
+
+const uint32_t kModelSnapshotMagic = 0x4D415453;  // "STAM"
+const uint32_t kModelSnapshotVersion = 1;
+
+// The estimators are plain running sums and filter states, stored as raw
+// bytes so a restored model continues bit for bit where it stopped.
+static_assert(std::is_trivially_copyable<RollingRegression>::value, "RollingRegression is snapshotted raw");
+static_assert(std::is_trivially_copyable<RollingMeanVariance>::value, "RollingMeanVariance is snapshotted raw");
+static_assert(std::is_trivially_copyable<KalmanHedgeFilter>::value, "KalmanHedgeFilter is snapshotted raw");
+
+struct ModelSnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t hedge_ratio_mode;
+    uint32_t position;
+    uint64_t lookback;
+    uint64_t price_count;
+    uint64_t spread_count;
+    double hedge_ratio;
+    double z_score;
+    // Guards against layout changes between the writing and reading builds.
+    uint32_t regression_size;
+    uint32_t spread_stats_size;
+    uint32_t kalman_size;
+    uint32_t reserved;
+};
+
+template <typename Window>
+void AppendWindow(std::string& out, const Window& window) {
+    for (size_t i = 0; i < window.size(); i++) {
+        AppendSnapshotValue(out, window[i]);
     }
-    
+}
+
+// The newest length prices of a shared ring, oldest first.
+class TailWindow {
 public:
-    StatisticalArbitrageModel(size_t lookback, double z_entry, double z_exit)
-        : lookback_(lookback), z_entry_(z_entry), z_exit_(z_exit),
-          current_hedge_ratio_(1.0), current_position_(Position::NONE) {}
-    
-    double CalculateHedgeRatio() {
-        if (btc_prices_.size() < 2) return 1.0;
-        
-        size_t n = btc_prices_.size();
-        
-        Eigen::VectorXd y(n);
-        Eigen::VectorXd x(n);
-        
-        for (size_t i = 0; i < n; i++) {
-            y(i) = btc_prices_[i];
-            x(i) = eth_prices_[i];
-        }
-        
-        Eigen::MatrixXd X(n, 2);
-        X.col(0) = Eigen::VectorXd::Ones(n);
-        X.col(1) = x;
-        
-        Eigen::VectorXd beta = (X.transpose() * X).ldlt().solve(X.transpose() * y);
-        
-        return beta(1);
-    }
-    
-    double CalculateSpread(double btc_price, double eth_price, double hedge_ratio) {
-        return btc_price - hedge_ratio * eth_price;
-    }
-    
-    double CalculateZScore() {
-        if (spreads_.size() < 2) return 0.0;
-        
-        double sum = 0.0;
-        for (const auto& s : spreads_) {
-            sum += s;
-        }
-        double mean = sum / spreads_.size();
-        
-        double sq_sum = 0.0;
-        for (const auto& s : spreads_) {
-            sq_sum += (s - mean) * (s - mean);
-        }
-        double std = std::sqrt(sq_sum / spreads_.size());
-        
-        if (std < 1e-10) return 0.0;
-        
-        return (spreads_.back() - mean) / std;
-    }
-    
-    enum class Signal {
-        NONE,
-        LONG_SPREAD,
-        SHORT_SPREAD,
-        EXIT
-    };
-    
-    Signal GenerateSignal(double btc_price, double eth_price) {
-        btc_prices_.push_back(btc_price);
-        eth_prices_.push_back(eth_price);
-        
-        MaintainWindowSize(btc_prices_);
-        MaintainWindowSize(eth_prices_);
-        
-        if (btc_prices_.size() < lookback_) {
-            return Signal::NONE;
-        }
-        
-        current_hedge_ratio_ = CalculateHedgeRatio();
-        double spread = CalculateSpread(btc_price, eth_price, current_hedge_ratio_);
-        
-        spreads_.push_back(spread);
-        MaintainWindowSize(spreads_);
-        
-        double z_score = CalculateZScore();
-        
-        std::cout << "BTC: " << btc_price 
-                  << " | ETH: " << eth_price
-                  << " | Spread: " << spread 
-                  << " | Z-Score: " << z_score 
-                  << " | Hedge: " << current_hedge_ratio_ << std::endl;
-        
-        if (current_position_ == Position::NONE) {
-            if (z_score > z_entry_) {
-                current_position_ = Position::SHORT_SPREAD;
-                return Signal::SHORT_SPREAD;
-            } else if (z_score < -z_entry_) {
-                current_position_ = Position::LONG_SPREAD;
-                return Signal::LONG_SPREAD;
-            }
-        } else {
-            if (std::abs(z_score) < z_exit_) {
-                current_position_ = Position::NONE;
-                return Signal::EXIT;
-            }
-        }
-        
+    TailWindow(const RingBuffer<double>& ring, size_t length) : ring_(ring), offset_(ring.size() - length) {}
+
+    size_t size() const { return ring_.size() - offset_; }
+    const double& operator[](size_t i) const { return ring_[offset_ + i]; }
+
+private:
+    const RingBuffer<double>& ring_;
+    size_t offset_;
+};
+
+}  // namespace
+
+StatisticalArbitrageModel::StatisticalArbitrageModel(size_t lookback, double z_entry, double z_exit,
+                                                     HedgeRatioMode hedge_ratio_mode, PriceWindows price_windows)
+    : lookback_(lookback), z_entry_(z_entry), z_exit_(z_exit),
+      // KALMAN needs no history, so its windows shrink to a single slot, as
+      // do the price windows of a SHARED model.
+      y_prices_(hedge_ratio_mode == HedgeRatioMode::KALMAN || price_windows == PriceWindows::SHARED ? 1 : lookback),
+      x_prices_(hedge_ratio_mode == HedgeRatioMode::KALMAN || price_windows == PriceWindows::SHARED ? 1 : lookback),
+      spreads_(hedge_ratio_mode == HedgeRatioMode::KALMAN ? 1 : lookback),
+      price_windows_(price_windows), shared_bars_(0),
+      hedge_ratio_mode_(hedge_ratio_mode), regression_(lookback),
+      current_hedge_ratio_(1.0), current_z_score_(0.0), current_position_(Position::NONE),
+      verbose_(true) {}
+
+template <typename Window>
+double StatisticalArbitrageModel::CalculateHedgeRatio(const Window& ys, const Window& xs) {
+    if (hedge_ratio_mode_ == HedgeRatioMode::EIGEN_OLS) {
+        return SolveHedgeRatio(ys, xs);
+    }
+
+    if (regression_.NeedsReanchor()) {
+        regression_.Reanchor(xs, ys);
+    }
+
+    return regression_.Slope(1.0);
+}
+
+double StatisticalArbitrageModel::CalculateReferenceHedgeRatio() const {
+    return SolveHedgeRatio(y_prices_, x_prices_);
+}
+
+template <typename Window>
+double StatisticalArbitrageModel::SolveHedgeRatio(const Window& ys, const Window& xs) {
+    if (ys.size() < 2) return 1.0;
+
+    size_t n = ys.size();
+
+    Eigen::VectorXd y(n);
+    Eigen::VectorXd x(n);
+
+    for (size_t i = 0; i < n; i++) {
+        y(i) = ys[i];
+        x(i) = xs[i];
+    }
+
+    Eigen::MatrixXd X(n, 2);
+    X.col(0) = Eigen::VectorXd::Ones(n);
+    X.col(1) = x;
+
+    Eigen::VectorXd beta = (X.transpose() * X).ldlt().solve(X.transpose() * y);
+
+    return beta(1);
+}
+
+double StatisticalArbitrageModel::CalculateSpread(double y_price, double x_price, double hedge_ratio) {
+    return y_price - hedge_ratio * x_price;
+}
+
+double StatisticalArbitrageModel::CalculateZScore() {
+    if (spread_stats_.Count() < 2) return 0.0;
+
+    double std = spread_stats_.StandardDeviation();
+
+    if (std < 1e-10) return 0.0;
+
+    return (spreads_.back() - spread_stats_.Mean()) / std;
+}
+
+bool StatisticalArbitrageModel::UpdateWindowEstimate(double y_price, double x_price, double& spread) {
+    if (y_prices_.full()) {
+        regression_.Remove(x_prices_.front(), y_prices_.front());
+    }
+
+    y_prices_.push_back(y_price);
+    x_prices_.push_back(x_price);
+    regression_.Add(x_price, y_price);
+
+    if (y_prices_.size() < lookback_) {
+        return false;
+    }
+
+    UpdateSpread(y_price, x_price, CalculateHedgeRatio(y_prices_, x_prices_), spread);
+    return true;
+}
+
+bool StatisticalArbitrageModel::UpdateSharedEstimate(const RingBuffer<double>& y_prices,
+                                                     const RingBuffer<double>& x_prices, double& spread) {
+    shared_bars_++;
+    if (shared_bars_ > lookback_) {
+        size_t leaving = lookback_ + 1;
+        regression_.Remove(x_prices[x_prices.size() - leaving], y_prices[y_prices.size() - leaving]);
+    }
+    regression_.Add(x_prices.back(), y_prices.back());
+
+    if (shared_bars_ < lookback_) {
+        return false;
+    }
+
+    TailWindow ys(y_prices, lookback_);
+    TailWindow xs(x_prices, lookback_);
+    UpdateSpread(y_prices.back(), x_prices.back(), CalculateHedgeRatio(ys, xs), spread);
+    return true;
+}
+
+void StatisticalArbitrageModel::UpdateSpread(double y_price, double x_price, double hedge_ratio, double& spread) {
+    current_hedge_ratio_ = hedge_ratio;
+    spread = CalculateSpread(y_price, x_price, current_hedge_ratio_);
+
+    if (spreads_.full()) {
+        spread_stats_.Replace(spreads_.front(), spread);
+    } else {
+        spread_stats_.Add(spread);
+    }
+    spreads_.push_back(spread);
+
+    current_z_score_ = CalculateZScore();
+}
+
+bool StatisticalArbitrageModel::UpdateKalmanEstimate(double y_price, double x_price, double& spread) {
+    kalman_.Update(y_price, x_price);
+    current_hedge_ratio_ = kalman_.Slope();
+
+    if (!kalman_.IsWarm()) {
+        return false;
+    }
+
+    // The innovation is the spread against the prior estimate; its predicted
+    // variance replaces the rolling spread variance.
+    spread = kalman_.Innovation();
+    current_z_score_ = kalman_.InnovationZScore();
+    return true;
+}
+
+Signal StatisticalArbitrageModel::GenerateSignal(double y_price, double x_price) {
+    double spread = 0.0;
+    bool ready = hedge_ratio_mode_ == HedgeRatioMode::KALMAN
+        ? UpdateKalmanEstimate(y_price, x_price, spread)
+        : UpdateWindowEstimate(y_price, x_price, spread);
+    return SignalFromEstimate(ready, y_price, x_price, spread);
+}
+
+Signal StatisticalArbitrageModel::GenerateSignal(const Decimal& y_price, const Decimal& x_price) {
+    return GenerateSignal(y_price.ToDouble(), x_price.ToDouble());
+}
+
+Signal StatisticalArbitrageModel::GenerateSignal(const RingBuffer<double>& y_prices,
+                                                 const RingBuffer<double>& x_prices) {
+    double spread = 0.0;
+    bool ready = hedge_ratio_mode_ == HedgeRatioMode::KALMAN
+        ? UpdateKalmanEstimate(y_prices.back(), x_prices.back(), spread)
+        : UpdateSharedEstimate(y_prices, x_prices, spread);
+    return SignalFromEstimate(ready, y_prices.back(), x_prices.back(), spread);
+}
+
+Signal StatisticalArbitrageModel::SignalFromEstimate(bool ready, double y_price, double x_price, double spread) {
+    if (!ready) {
         return Signal::NONE;
     }
-    
-    double GetCurrentHedgeRatio() const {
-        return current_hedge_ratio_;
+
+    if (verbose_) {
+        ASYNC_LOG("Y: {} | X: {} | Spread: {} | Z-Score: {} | Hedge: {}",
+                  y_price, x_price, spread, current_z_score_, current_hedge_ratio_);
     }
-};
+
+    return SignalFromZScore(current_z_score_);
+}
+
+void StatisticalArbitrageModel::WarmUp(double y_price, double x_price) {
+    double spread = 0.0;
+    if (hedge_ratio_mode_ == HedgeRatioMode::KALMAN) {
+        UpdateKalmanEstimate(y_price, x_price, spread);
+    } else {
+        UpdateWindowEstimate(y_price, x_price, spread);
+    }
+}
+
+void StatisticalArbitrageModel::WarmUp(const Decimal& y_price, const Decimal& x_price) {
+    WarmUp(y_price.ToDouble(), x_price.ToDouble());
+}
+
+bool StatisticalArbitrageModel::IsWarm() const {
+    if (hedge_ratio_mode_ == HedgeRatioMode::KALMAN) {
+        return kalman_.IsWarm();
+    }
+    if (price_windows_ == PriceWindows::SHARED) {
+        return shared_bars_ >= lookback_;
+    }
+    return y_prices_.size() >= lookback_;
+}
+
+size_t StatisticalArbitrageModel::GetLookback() const {
+    return lookback_;
+}
+
+void StatisticalArbitrageModel::WriteSnapshot(std::string& out) const {
+    ModelSnapshotHeader header = {};
+    header.magic = kModelSnapshotMagic;
+    header.version = kModelSnapshotVersion;
+    header.hedge_ratio_mode = static_cast<uint32_t>(hedge_ratio_mode_);
+    header.position = static_cast<uint32_t>(current_position_);
+    header.lookback = lookback_;
+    header.price_count = y_prices_.size();
+    header.spread_count = spreads_.size();
+    header.hedge_ratio = current_hedge_ratio_;
+    header.z_score = current_z_score_;
+    header.regression_size = sizeof(regression_);
+    header.spread_stats_size = sizeof(spread_stats_);
+    header.kalman_size = sizeof(kalman_);
+
+    AppendSnapshotValue(out, header);
+    AppendWindow(out, y_prices_);
+    AppendWindow(out, x_prices_);
+    AppendWindow(out, spreads_);
+    AppendSnapshotValue(out, regression_);
+    AppendSnapshotValue(out, spread_stats_);
+    AppendSnapshotValue(out, kalman_);
+}
+
+bool StatisticalArbitrageModel::RestoreSnapshot(const char*& data, const char* end) {
+    const char* cursor = data;
+    ModelSnapshotHeader header;
+    if (price_windows_ == PriceWindows::SHARED || !ReadSnapshotValue(cursor, end, header) ||
+        header.magic != kModelSnapshotMagic || header.version != kModelSnapshotVersion ||
+        header.hedge_ratio_mode != static_cast<uint32_t>(hedge_ratio_mode_) ||
+        header.lookback != lookback_ ||
+        header.price_count > y_prices_.capacity() || header.spread_count > spreads_.capacity() ||
+        header.position > static_cast<uint32_t>(Position::SHORT_SPREAD) ||
+        header.regression_size != sizeof(regression_) ||
+        header.spread_stats_size != sizeof(spread_stats_) ||
+        header.kalman_size != sizeof(kalman_)) {
+        return false;
+    }
+
+    size_t doubles = 2 * header.price_count + header.spread_count;
+    size_t needed = doubles * sizeof(double) + sizeof(regression_) + sizeof(spread_stats_) + sizeof(kalman_);
+    if (static_cast<size_t>(end - cursor) < needed) return false;
+
+    // Everything is validated; nothing below can fail.
+    y_prices_.clear();
+    x_prices_.clear();
+    spreads_.clear();
+    double value;
+    for (size_t i = 0; i < header.price_count; i++) {
+        ReadSnapshotValue(cursor, end, value);
+        y_prices_.push_back(value);
+    }
+    for (size_t i = 0; i < header.price_count; i++) {
+        ReadSnapshotValue(cursor, end, value);
+        x_prices_.push_back(value);
+    }
+    for (size_t i = 0; i < header.spread_count; i++) {
+        ReadSnapshotValue(cursor, end, value);
+        spreads_.push_back(value);
+    }
+    ReadSnapshotValue(cursor, end, regression_);
+    ReadSnapshotValue(cursor, end, spread_stats_);
+    ReadSnapshotValue(cursor, end, kalman_);
+
+    current_position_ = static_cast<Position>(header.position);
+    current_hedge_ratio_ = header.hedge_ratio;
+    current_z_score_ = header.z_score;
+    data = cursor;
+    return true;
+}
+
+Signal StatisticalArbitrageModel::SignalFromZScore(double z_score) {
+    if (current_position_ == Position::NONE) {
+        if (z_score > z_entry_) {
+            current_position_ = Position::SHORT_SPREAD;
+            return Signal::SHORT_SPREAD;
+        } else if (z_score < -z_entry_) {
+            current_position_ = Position::LONG_SPREAD;
+            return Signal::LONG_SPREAD;
+        }
+    } else {
+        if (std::abs(z_score) < z_exit_) {
+            current_position_ = Position::NONE;
+            return Signal::EXIT;
+        }
+    }
+
+    return Signal::NONE;
+}
+
+double StatisticalArbitrageModel::GetCurrentHedgeRatio() const {
+    return current_hedge_ratio_;
+}
+
+double StatisticalArbitrageModel::GetCurrentZScore() const {
+    return current_z_score_;
+}
+
+HedgeRatioMode StatisticalArbitrageModel::GetHedgeRatioMode() const {
+    return hedge_ratio_mode_;
+}
+
+void StatisticalArbitrageModel::SetVerbose(bool verbose) {
+    verbose_ = verbose;
+}
+
+void StatisticalArbitrageModel::SetKalmanParameters(const KalmanHedgeParameters& parameters) {
+    kalman_ = KalmanHedgeFilter(parameters);
+}
@@ -2,9 +2,14 @@
 #define STATISTICAL_ARBITRAGE_MODEL_H
 
 #include <vector>
-#include <deque>
 #include <cmath>
+#include <string>
 #include <Eigen/Dense>
+#include "../market_data/decimal.h"
+#include "kalman_hedge_filter.h"
+#include "ring_buffer.h"
+#include "rolling_regression.h"
+#include "rolling_statistics.h"
 
 enum class Signal {
     NONE,
@@ -13,36 +18,111 @@ enum class Signal {
     EXIT
 };
 
+// INCREMENTAL_OLS keeps running sums and costs O(1) per tick; EIGEN_OLS
+// re-solves the full window and is kept as the reference implementation.
+// KALMAN tracks the hedge recursively with no window at all and takes the
+// z-score from the filter innovation instead of the spread history.
+enum class HedgeRatioMode {
+    INCREMENTAL_OLS,
+    EIGEN_OLS,
+    KALMAN
+};
+
 enum class Position {
     NONE,
     LONG_SPREAD,
     SHORT_SPREAD
 };
 
+// OWNED models keep their own y and x windows. SHARED models read them from
+// rings the caller keeps, one per symbol, so pairs with a common leg hold
+// its history once (see MultiPairArbitrageEngine).
+enum class PriceWindows {
+    OWNED,
+    SHARED
+};
+
+// Pair model on two price legs: y is regressed on x and the spread is
+// y - hedge_ratio * x. LONG_SPREAD means long y / short x.
 class StatisticalArbitrageModel {
 private:
     size_t lookback_;
     double z_entry_;
     double z_exit_;
     
-    std::deque<double> btc_prices_;
-    std::deque<double> eth_prices_;
-    std::deque<double> spreads_;
+    RingBuffer<double> y_prices_;
+    RingBuffer<double> x_prices_;
+    RingBuffer<double> spreads_;
+    PriceWindows price_windows_;
+    // SHARED only: bars fed since both legs had a price.
+    size_t shared_bars_;
+    
+    HedgeRatioMode hedge_ratio_mode_;
+    RollingRegression regression_;
+    RollingMeanVariance spread_stats_;
+    KalmanHedgeFilter kalman_;
     
     double current_hedge_ratio_;
+    double current_z_score_;
     Position current_position_;
+    bool verbose_;
     
-    void MaintainWindowSize(std::deque<double>& data);
-    double CalculateHedgeRatio();
-    double CalculateSpread(double btc_price, double eth_price, double hedge_ratio);
+    template <typename Window>
+    double CalculateHedgeRatio(const Window& ys, const Window& xs);
+    template <typename Window>
+    static double SolveHedgeRatio(const Window& ys, const Window& xs);
+    double CalculateSpread(double y_price, double x_price, double hedge_ratio);
     double CalculateZScore();
+    bool UpdateWindowEstimate(double y_price, double x_price, double& spread);
+    bool UpdateSharedEstimate(const RingBuffer<double>& y_prices, const RingBuffer<double>& x_prices,
+                              double& spread);
+    void UpdateSpread(double y_price, double x_price, double hedge_ratio, double& spread);
+    bool UpdateKalmanEstimate(double y_price, double x_price, double& spread);
+    Signal SignalFromEstimate(bool ready, double y_price, double x_price, double spread);
+    Signal SignalFromZScore(double z_score);
     
 public:
-    StatisticalArbitrageModel(size_t lookback, double z_entry, double z_exit);
+    StatisticalArbitrageModel(size_t lookback, double z_entry, double z_exit,
+                              HedgeRatioMode hedge_ratio_mode = HedgeRatioMode::INCREMENTAL_OLS,
+                              PriceWindows price_windows = PriceWindows::OWNED);
     
-    Signal GenerateSignal(double btc_price, double eth_price);
+    // OWNED models only.
+    Signal GenerateSignal(double y_price, double x_price);
+    // Exact prices, e.g. candle closes; converted to double here, where the
+    // regression needs them.
+    Signal GenerateSignal(const Decimal& y_price, const Decimal& x_price);
+    // SHARED models only: y_prices and x_prices end with this bar's prices
+    // and hold at least lookback + 1 bars once that many have been fed, so
+    // the bar leaving the window is still readable. Call once per bar.
+    Signal GenerateSignal(const RingBuffer<double>& y_prices, const RingBuffer<double>& x_prices);
+    // Feeds a historical price pair through the estimators without producing
+    // a signal or changing the position, to fill the windows before going
+    // live.
+    void WarmUp(double y_price, double x_price);
+    void WarmUp(const Decimal& y_price, const Decimal& x_price);
+    // True once GenerateSignal can return something other than NONE.
+    bool IsWarm() const;
+    size_t GetLookback() const;
     double GetCurrentHedgeRatio() const;
-    double GetCurrentZScore();
+    double GetCurrentZScore() const;
+    HedgeRatioMode GetHedgeRatioMode() const;
+    
+    // Replaces the filter settings and restarts it; KALMAN mode only.
+    void SetKalmanParameters(const KalmanHedgeParameters& parameters);
+    
+    // Per-tick diagnostics to stdout; disabled for backtests and sweeps.
+    void SetVerbose(bool verbose);
+    
+    // Full Eigen solve over the current window, independent of the active
+    // mode. Used to cross-check the incremental estimator; OWNED only.
+    double CalculateReferenceHedgeRatio() const;
+    
+    // Appends the complete model state (windows, estimators and position)
+    // to out. RestoreSnapshot reads it back into a model built with the same
+    // lookback and mode and advances data past it; on any mismatch it
+    // returns false and leaves the model untouched. OWNED models only.
+    void WriteSnapshot(std::string& out) const;
+    bool RestoreSnapshot(const char*& data, const char* end);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "event_loop.h"
+#include <cerrno>
+#include <chrono>
+#include <poll.h>
+#include <stdexcept>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#else
+#include <fcntl.h>
+#endif
+
+namespace {
+
+const int kMaxEventsPerWait = 64;
+
+#if defined(__linux__)
+uint32_t ToEpollEvents(short events) {
+  uint32_t result = 0;
+  if (events & POLLIN) result |= EPOLLIN;
+  if (events & POLLOUT) result |= EPOLLOUT;
+  return result;
+}
+
+short FromEpollEvents(uint32_t events) {
+  short result = 0;
+  if (events & EPOLLIN) result |= POLLIN;
+  if (events & EPOLLOUT) result |= POLLOUT;
+  if (events & EPOLLERR) result |= POLLERR;
+  if (events & EPOLLHUP) result |= POLLHUP;
+  return result;
+}
+#endif
+
+}  // namespace
+
+int64_t EventLoop::NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#if defined(__linux__)
+
+EventLoop::EventLoop()
+    : next_timer_id_(1), stop_requested_(false),
+      epoll_fd_(-1), wake_fd_(-1), timer_fd_(-1), armed_deadline_(0) {
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  timer_fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (epoll_fd_ < 0 || wake_fd_ < 0 || timer_fd_ < 0) {
+    if (epoll_fd_ >= 0) ::close(epoll_fd_);
+    if (wake_fd_ >= 0) ::close(wake_fd_);
+    if (timer_fd_ >= 0) ::close(timer_fd_);
+    throw std::runtime_error("Failed to create event loop descriptors");
+  }
+
+  // The internal descriptors are tagged with negative ids so they can never
+  // collide with a watched fd.
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u64 = static_cast<uint64_t>(-1);
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+  event.data.u64 = static_cast<uint64_t>(-2);
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, timer_fd_, &event);
+}
+
+EventLoop::~EventLoop() {
+  ::close(timer_fd_);
+  ::close(wake_fd_);
+  ::close(epoll_fd_);
+}
+
+void EventLoop::AddFd(int fd, short events, FdCallback callback) {
+  if (fd < 0) return;
+  if (static_cast<size_t>(fd) >= fds_.size()) fds_.resize(fd + 1);
+
+  bool watched = static_cast<bool>(fds_[fd].callback);
+  if (watched) retired_.push_back(std::move(fds_[fd].callback));
+  fds_[fd].events = events;
+  fds_[fd].callback = std::move(callback);
+
+  epoll_event event = {};
+  event.events = ToEpollEvents(events);
+  event.data.u64 = static_cast<uint64_t>(fd);
+  ::epoll_ctl(epoll_fd_, watched ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event);
+}
+
+void EventLoop::ModifyFd(int fd, short events) {
+  if (fd < 0 || static_cast<size_t>(fd) >= fds_.size() || !fds_[fd].callback) return;
+  if (fds_[fd].events == events) return;
+
+  fds_[fd].events = events;
+  epoll_event event = {};
+  event.events = ToEpollEvents(events);
+  event.data.u64 = static_cast<uint64_t>(fd);
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+}
+
+void EventLoop::RemoveFd(int fd) {
+  if (fd < 0 || static_cast<size_t>(fd) >= fds_.size() || !fds_[fd].callback) return;
+
+  retired_.push_back(std::move(fds_[fd].callback));
+  fds_[fd].callback = nullptr;
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void EventLoop::Wake() {
+  uint64_t one = 1;
+  ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+  (void)written;
+}
+
+void EventLoop::DrainWakeups() {
+  uint64_t count;
+  while (::read(wake_fd_, &count, sizeof(count)) > 0) {}
+}
+
+void EventLoop::ArmTimer() {
+  int64_t deadline = NextDeadline();
+  if (deadline == armed_deadline_) return;
+  armed_deadline_ = deadline;
+
+  // An all-zero value disarms the timer; a deadline already in the past
+  // fires immediately.
+  itimerspec spec = {};
+  if (deadline > 0) {
+    spec.it_value.tv_sec = deadline / 1000000000;
+    spec.it_value.tv_nsec = deadline % 1000000000;
+  }
+  ::timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void EventLoop::RunOnce(int timeout_ms) {
+  ArmTimer();
+
+  epoll_event events[kMaxEventsPerWait];
+  int count = ::epoll_wait(epoll_fd_, events, kMaxEventsPerWait, timeout_ms);
+  if (count < 0 && errno != EINTR) {
+    throw std::runtime_error("epoll_wait failed");
+  }
+
+  for (int i = 0; i < count; i++) {
+    uint64_t tag = events[i].data.u64;
+    if (tag == static_cast<uint64_t>(-1)) {
+      DrainWakeups();
+    } else if (tag == static_cast<uint64_t>(-2)) {
+      uint64_t expirations;
+      while (::read(timer_fd_, &expirations, sizeof(expirations)) > 0) {}
+      armed_deadline_ = 0;
+    } else {
+      DispatchFd(static_cast<int>(tag), FromEpollEvents(events[i].events));
+    }
+  }
+
+  RunPostedTasks();
+  RunDueTimers();
+  retired_.clear();
+}
+
+#else
+
+EventLoop::EventLoop() : next_timer_id_(1), stop_requested_(false), poll_set_dirty_(true) {
+  if (::pipe(wake_pipe_) != 0) {
+    throw std::runtime_error("Failed to create event loop wake pipe");
+  }
+  for (int fd : wake_pipe_) {
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+}
+
+EventLoop::~EventLoop() {
+  ::close(wake_pipe_[0]);
+  ::close(wake_pipe_[1]);
+}
+
+void EventLoop::AddFd(int fd, short events, FdCallback callback) {
+  if (fd < 0) return;
+  if (static_cast<size_t>(fd) >= fds_.size()) fds_.resize(fd + 1);
+
+  if (fds_[fd].callback) retired_.push_back(std::move(fds_[fd].callback));
+  fds_[fd].events = events;
+  fds_[fd].callback = std::move(callback);
+  poll_set_dirty_ = true;
+}
+
+void EventLoop::ModifyFd(int fd, short events) {
+  if (fd < 0 || static_cast<size_t>(fd) >= fds_.size() || !fds_[fd].callback) return;
+  fds_[fd].events = events;
+  poll_set_dirty_ = true;
+}
+
+void EventLoop::RemoveFd(int fd) {
+  if (fd < 0 || static_cast<size_t>(fd) >= fds_.size() || !fds_[fd].callback) return;
+  retired_.push_back(std::move(fds_[fd].callback));
+  fds_[fd].callback = nullptr;
+  poll_set_dirty_ = true;
+}
+
+void EventLoop::Wake() {
+  char byte = 1;
+  ssize_t written = ::write(wake_pipe_[1], &byte, 1);
+  (void)written;
+}
+
+void EventLoop::DrainWakeups() {
+  char buffer[64];
+  while (::read(wake_pipe_[0], buffer, sizeof(buffer)) > 0) {}
+}
+
+void EventLoop::ArmTimer() {}
+
+void EventLoop::RunOnce(int timeout_ms) {
+  if (poll_set_dirty_) {
+    poll_set_.clear();
+    poll_set_.push_back(pollfd{wake_pipe_[0], POLLIN, 0});
+    for (size_t fd = 0; fd < fds_.size(); fd++) {
+      if (fds_[fd].callback) {
+        poll_set_.push_back(pollfd{static_cast<int>(fd), fds_[fd].events, 0});
+      }
+    }
+    poll_set_dirty_ = false;
+  }
+
+  int64_t deadline = NextDeadline();
+  if (deadline > 0) {
+    int64_t remaining_ms = (deadline - NowNanos() + 999999) / 1000000;
+    if (remaining_ms < 0) remaining_ms = 0;
+    if (timeout_ms < 0 || remaining_ms < timeout_ms) timeout_ms = static_cast<int>(remaining_ms);
+  }
+
+  int count = ::poll(poll_set_.data(), poll_set_.size(), timeout_ms);
+  if (count < 0 && errno != EINTR) {
+    throw std::runtime_error("poll failed");
+  }
+
+  if (count > 0) {
+    if (poll_set_[0].revents) DrainWakeups();
+    // Callbacks may change the watch set; iterate over a snapshot.
+    std::vector<pollfd> ready(poll_set_.begin() + 1, poll_set_.end());
+    for (const auto& entry : ready) {
+      if (entry.revents) DispatchFd(entry.fd, entry.revents);
+    }
+  }
+
+  RunPostedTasks();
+  RunDueTimers();
+  retired_.clear();
+}
+
+#endif
+
+void EventLoop::DispatchFd(int fd, short revents) {
+  // The fd may have been removed by an earlier callback in the same round.
+  if (fd < 0 || static_cast<size_t>(fd) >= fds_.size() || !fds_[fd].callback) return;
+  fds_[fd].callback(fd, revents);
+}
+
+EventLoop::TimerId EventLoop::AddTimer(int64_t delay_ns, int64_t interval_ns, Task callback) {
+  TimerId id = next_timer_id_++;
+  timers_.emplace(id, Timer{interval_ns, std::move(callback)});
+  deadlines_.push(Deadline{NowNanos() + (delay_ns > 0 ? delay_ns : 0), id});
+  return id;
+}
+
+void EventLoop::CancelTimer(TimerId id) {
+  timers_.erase(id);
+}
+
+int64_t EventLoop::NextDeadline() {
+  while (!deadlines_.empty() && !timers_.count(deadlines_.top().id)) {
+    deadlines_.pop();
+  }
+  return deadlines_.empty() ? 0 : deadlines_.top().when;
+}
+
+void EventLoop::RunDueTimers() {
+  int64_t now = NowNanos();
+  while (!deadlines_.empty() && deadlines_.top().when <= now) {
+    Deadline due = deadlines_.top();
+    deadlines_.pop();
+
+    auto it = timers_.find(due.id);
+    if (it == timers_.end()) continue;
+
+    if (it->second.interval > 0) {
+      // Schedule from the nominal deadline so periodic timers do not drift,
+      // but skip missed periods rather than firing a burst.
+      int64_t next = due.when + it->second.interval;
+      if (next <= now) next = now + it->second.interval;
+      deadlines_.push(Deadline{next, due.id});
+      // Moved out rather than copied, so a firing allocates nothing, and
+      // kept alive even if the callback cancels its own timer; it goes
+      // back unless it did.
+      Task callback = std::move(it->second.callback);
+      callback();
+      it = timers_.find(due.id);
+      if (it != timers_.end()) {
+        it->second.callback = std::move(callback);
+      }
+    } else {
+      Task callback = std::move(it->second.callback);
+      timers_.erase(it);
+      callback();
+    }
+  }
+}
+
+void EventLoop::Post(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(posted_mutex_);
+    posted_.push_back(std::move(task));
+  }
+  Wake();
+}
+
+void EventLoop::RunPostedTasks() {
+  {
+    std::lock_guard<std::mutex> lock(posted_mutex_);
+    if (posted_.empty()) return;
+    running_tasks_.swap(posted_);
+  }
+  for (auto& task : running_tasks_) {
+    task();
+  }
+  running_tasks_.clear();
+}
+
+void EventLoop::RequestStop() {
+  stop_requested_.store(true, std::memory_order_release);
+  Wake();
+}
+
+bool EventLoop::StopRequested() const {
+  return stop_requested_.load(std::memory_order_acquire);
+}
+
+void EventLoop::ResetStop() {
+  stop_requested_.store(false, std::memory_order_release);
+}
+
+void EventLoop::Run() {
+  while (!StopRequested()) {
+    RunOnce(-1);
+  }
+}
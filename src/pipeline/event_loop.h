@@ -0,0 +1,113 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <poll.h>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// Single-threaded readiness loop: file descriptors, one-shot and periodic
+// timers, and tasks posted from other threads. On Linux it is built on
+// epoll, with an eventfd for wakeups and one timerfd armed to the earliest
+// timer deadline, so the loop sleeps until exactly the next event. Other
+// platforms fall back to poll() with a self-pipe and a poll timeout.
+//
+// All methods except Post(), Wake() and RequestStop() must be called from
+// the thread running the loop (or before it starts). Wake() and
+// RequestStop() are async-signal-safe.
+class EventLoop {
+ public:
+  using TimerId = uint64_t;
+  // revents uses poll() flags (POLLIN, POLLOUT, POLLERR, POLLHUP).
+  using FdCallback = std::function<void(int fd, short revents)>;
+  using Task = std::function<void()>;
+
+  EventLoop();
+  ~EventLoop();
+
+  EventLoop(const EventLoop&) = delete;
+  EventLoop& operator=(const EventLoop&) = delete;
+
+  // events uses poll() flags. Re-adding a watched fd replaces it.
+  void AddFd(int fd, short events, FdCallback callback);
+  void ModifyFd(int fd, short events);
+  void RemoveFd(int fd);
+
+  // Fires after delay_ns, then every interval_ns if interval_ns > 0.
+  TimerId AddTimer(int64_t delay_ns, int64_t interval_ns, Task callback);
+  void CancelTimer(TimerId id);
+
+  // Runs task on the loop thread at the next iteration.
+  void Post(Task task);
+  void Wake();
+
+  // Makes Run() return after the current iteration.
+  void RequestStop();
+  bool StopRequested() const;
+  // Clears a previous stop request so the loop can run again.
+  void ResetStop();
+
+  void Run();
+  // One wait-and-dispatch round; timeout_ms < 0 waits for the next event.
+  void RunOnce(int timeout_ms);
+
+  // Steady-clock nanoseconds, the time base for timers.
+  static int64_t NowNanos();
+
+ private:
+  struct FdEntry {
+    short events;
+    FdCallback callback;
+  };
+
+  struct Timer {
+    int64_t interval;
+    Task callback;
+  };
+
+  struct Deadline {
+    int64_t when;
+    TimerId id;
+    bool operator>(const Deadline& other) const { return when > other.when; }
+  };
+
+  void DispatchFd(int fd, short revents);
+  void DrainWakeups();
+  void RunPostedTasks();
+  void RunDueTimers();
+  int64_t NextDeadline();
+  void ArmTimer();
+
+  // Indexed by fd; a null callback marks an unwatched slot.
+  std::vector<FdEntry> fds_;
+  // Callbacks removed while dispatching, freed once the round finishes.
+  std::vector<FdCallback> retired_;
+
+  std::unordered_map<TimerId, Timer> timers_;
+  // Cancelled timers leave stale entries here that are skipped on expiry.
+  std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines_;
+  TimerId next_timer_id_;
+
+  std::mutex posted_mutex_;
+  std::vector<Task> posted_;
+  std::vector<Task> running_tasks_;
+
+  std::atomic<bool> stop_requested_;
+
+#if defined(__linux__)
+  int epoll_fd_;
+  int wake_fd_;
+  int timer_fd_;
+  int64_t armed_deadline_;
+#else
+  int wake_pipe_[2];
+  bool poll_set_dirty_;
+  std::vector<struct pollfd> poll_set_;
+#endif
+};
+
+#endif
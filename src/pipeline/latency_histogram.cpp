@@ -0,0 +1,99 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+inline uint64_t Load(const std::atomic<uint64_t>& value) {
+  return value.load(std::memory_order_relaxed);
+}
+
+inline void Bump(std::atomic<uint64_t>& value, uint64_t amount) {
+  value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+LatencyHistogram::LatencyHistogram() {
+  Reset();
+}
+
+size_t LatencyHistogram::IndexOf(int64_t value) {
+  if (value <= 0) return 0;
+  if (value >= kMaxTrackable) value = kMaxTrackable - 1;
+
+  int magnitude = 63 - __builtin_clzll(static_cast<uint64_t>(value) | kSubBucketMask);
+  int bucket = magnitude - kSubBucketHalfCountMagnitude;
+  int64_t sub_bucket = value >> bucket;
+  return static_cast<size_t>(((bucket + 1) << kSubBucketHalfCountMagnitude) + sub_bucket - kSubBucketHalfCount);
+}
+
+int64_t LatencyHistogram::ValueAt(size_t index) {
+  int bucket = static_cast<int>(index >> kSubBucketHalfCountMagnitude) - 1;
+  int64_t sub_bucket = static_cast<int64_t>(index & (kSubBucketHalfCount - 1)) + kSubBucketHalfCount;
+  if (bucket < 0) {
+    bucket = 0;
+    sub_bucket -= kSubBucketHalfCount;
+  }
+  return sub_bucket << bucket;
+}
+
+int64_t LatencyHistogram::HighestEquivalent(size_t index) {
+  int bucket = std::max(0, static_cast<int>(index >> kSubBucketHalfCountMagnitude) - 1);
+  return ValueAt(index) + (int64_t(1) << bucket) - 1;
+}
+
+void LatencyHistogram::Record(int64_t value) {
+  Bump(counts_[IndexOf(value)], 1);
+  Bump(total_, 1);
+  if (value > max_.load(std::memory_order_relaxed)) {
+    max_.store(value, std::memory_order_relaxed);
+  }
+}
+
+void LatencyHistogram::Reset() {
+  for (auto& count : counts_) {
+    count.store(0, std::memory_order_relaxed);
+  }
+  total_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (size_t i = 0; i < kCountsLength; i++) {
+    uint64_t count = Load(other.counts_[i]);
+    if (count) Bump(counts_[i], count);
+  }
+  Bump(total_, Load(other.total_));
+  int64_t other_max = other.max_.load(std::memory_order_relaxed);
+  if (other_max > max_.load(std::memory_order_relaxed)) {
+    max_.store(other_max, std::memory_order_relaxed);
+  }
+}
+
+uint64_t LatencyHistogram::Count() const {
+  return Load(total_);
+}
+
+int64_t LatencyHistogram::Max() const {
+  return max_.load(std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::ValueAtPercentile(double percentile) const {
+  // Sum the buckets rather than trusting total_, which a concurrent writer
+  // may have bumped before or after the bucket we would stop at.
+  uint64_t total = 0;
+  for (const auto& count : counts_) total += Load(count);
+  if (total == 0) return 0;
+
+  double clamped = std::min(std::max(percentile, 0.0), 100.0);
+  uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * total)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kCountsLength; i++) {
+    seen += Load(counts_[i]);
+    if (seen >= target) {
+      return std::min(HighestEquivalent(i), Max());
+    }
+  }
+  return Max();
+}
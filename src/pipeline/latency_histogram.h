@@ -0,0 +1,54 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-size log-linear histogram in the style of HdrHistogram: 128 linear
+// sub-buckets per power of two, so any recorded value is reported within
+// 1/64 (about 1.6%) of its true value, from 1 ns up to kMaxTrackable.
+// Larger values land in the top bucket; Max() stays exact.
+//
+// Record() is a handful of integer ops and never allocates. Each histogram
+// has a single writer; counts are relaxed atomics only so a reporter thread
+// can read them while it writes, and a snapshot may be a few samples stale.
+class LatencyHistogram {
+ public:
+  LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void Record(int64_t value);
+  void Reset();
+  // Adds other's counts into this histogram. Not thread-safe for this one.
+  void Merge(const LatencyHistogram& other);
+
+  uint64_t Count() const;
+  int64_t Max() const;
+  // percentile in [0, 100]; 0 for an empty histogram.
+  int64_t ValueAtPercentile(double percentile) const;
+
+  // About 1100 s in nanoseconds.
+  static constexpr int64_t kMaxTrackable = int64_t(1) << 40;
+
+ private:
+  static constexpr int kSubBucketHalfCountMagnitude = 6;
+  static constexpr int64_t kSubBucketHalfCount = int64_t(1) << kSubBucketHalfCountMagnitude;
+  static constexpr int64_t kSubBucketMask = 2 * kSubBucketHalfCount - 1;
+  static constexpr int kBucketCount = 40 - kSubBucketHalfCountMagnitude;
+  static constexpr size_t kCountsLength = (kBucketCount + 1) * kSubBucketHalfCount;
+
+  static size_t IndexOf(int64_t value);
+  static int64_t ValueAt(size_t index);
+  // Largest value that shares index's bucket, as HdrHistogram reports.
+  static int64_t HighestEquivalent(size_t index);
+
+  // Single writer: updated with load + store rather than read-modify-write.
+  std::atomic<uint64_t> counts_[kCountsLength];
+  std::atomic<uint64_t> total_;
+  std::atomic<int64_t> max_;
+};
+
+#endif
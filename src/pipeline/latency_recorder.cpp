@@ -0,0 +1,109 @@
+#include "latency_recorder.h"
+#include "latency_histogram.h"
+#include <algorithm>
+#include <csignal>
+#include <iomanip>
+#include <memory>
+
+namespace {
+
+const int kStageCount = static_cast<int>(LatencyStage::COUNT);
+
+struct ThreadHistograms {
+  LatencyHistogram stages[kStageCount];
+};
+
+// Static so claiming a slot never allocates; about 90 KB per thread.
+ThreadHistograms g_threads[LatencyRecorder::kMaxThreads];
+std::atomic<int> g_threads_claimed(0);
+std::atomic<uint64_t> g_unrecorded(0);
+volatile std::sig_atomic_t g_dump_requested = 0;
+
+thread_local int t_slot = -1;
+thread_local uint64_t t_current_receive = 0;
+
+}  // namespace
+
+std::atomic<bool> LatencyRecorder::enabled_(false);
+
+const char* LatencyStageName(LatencyStage stage) {
+  switch (stage) {
+    case LatencyStage::PARSE: return "parse";
+    case LatencyStage::QUEUE: return "queue";
+    case LatencyStage::MODEL: return "model";
+    case LatencyStage::TICK_TO_SIGNAL: return "tick-to-signal";
+    case LatencyStage::TICK_TO_ORDER: return "tick-to-order";
+    case LatencyStage::COUNT: break;
+  }
+  return "unknown";
+}
+
+void LatencyRecorder::Enable() {
+  TscClock::Calibrate();
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void LatencyRecorder::RecordTicks(LatencyStage stage, uint64_t ticks) {
+  int slot = t_slot;
+  if (slot < 0) {
+    slot = g_threads_claimed.fetch_add(1, std::memory_order_relaxed);
+    t_slot = slot;
+  }
+  if (slot >= kMaxThreads) {
+    g_unrecorded.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  g_threads[slot].stages[static_cast<int>(stage)].Record(TscClock::ToNanos(ticks));
+}
+
+void LatencyRecorder::SetCurrentReceive(uint64_t tsc) {
+  t_current_receive = tsc;
+}
+
+uint64_t LatencyRecorder::CurrentReceive() {
+  return t_current_receive;
+}
+
+void LatencyRecorder::Report(std::ostream& out) {
+  int threads = std::min(g_threads_claimed.load(std::memory_order_relaxed), kMaxThreads);
+  // 90 KB of counts is too much for the reporter's stack.
+  auto merged = std::make_unique<ThreadHistograms>();
+  for (int t = 0; t < threads; t++) {
+    for (int s = 0; s < kStageCount; s++) {
+      merged->stages[s].Merge(g_threads[t].stages[s]);
+    }
+  }
+
+  auto micros = [](int64_t nanos) { return nanos / 1000.0; };
+  std::ios_base::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out << "Latency (us)      " << std::setw(10) << "count" << std::setw(10) << "p50"
+      << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << "\n";
+  out << std::fixed << std::setprecision(2);
+  for (int s = 0; s < kStageCount; s++) {
+    const LatencyHistogram& histogram = merged->stages[s];
+    out << std::left << std::setw(18) << LatencyStageName(static_cast<LatencyStage>(s)) << std::right
+        << std::setw(10) << histogram.Count()
+        << std::setw(10) << micros(histogram.ValueAtPercentile(50.0))
+        << std::setw(10) << micros(histogram.ValueAtPercentile(99.0))
+        << std::setw(10) << micros(histogram.ValueAtPercentile(99.9))
+        << std::setw(10) << micros(histogram.Max()) << "\n";
+  }
+  uint64_t unrecorded = g_unrecorded.load(std::memory_order_relaxed);
+  if (unrecorded > 0) {
+    out << unrecorded << " sample(s) dropped: more than " << kMaxThreads << " recording threads\n";
+  }
+  out.flush();
+  out.flags(flags);
+  out.precision(precision);
+}
+
+void LatencyRecorder::RequestDump() {
+  g_dump_requested = 1;
+}
+
+bool LatencyRecorder::TakeDumpRequest() {
+  if (!g_dump_requested) return false;
+  g_dump_requested = 0;
+  return true;
+}
@@ -0,0 +1,67 @@
+#ifndef LATENCY_RECORDER_H
+#define LATENCY_RECORDER_H
+
+#include "tsc_clock.h"
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+enum class LatencyStage : uint8_t {
+  // Frame received to market event published (socket thread).
+  PARSE,
+  // Event published to dequeued by the strategy thread.
+  QUEUE,
+  // Model update for one candle.
+  MODEL,
+  // Frame received to signal logged by the trader.
+  TICK_TO_SIGNAL,
+  // Frame received to order frame queued for the exchange.
+  TICK_TO_ORDER,
+  COUNT
+};
+
+const char* LatencyStageName(LatencyStage stage);
+
+// Process-wide hot-path latency instrumentation. Each thread records into
+// its own set of histograms, claimed from a static table on first use, so
+// Record() costs two TSC reads plus a few integer ops and never allocates
+// or contends. Disabled (the default) it is a single relaxed load.
+//
+// Stages that span threads are joined through the "current receive" stamp:
+// the socket thread sets it when a frame arrives, the pipeline carries it in
+// the MarketEvent and the strategy thread restores it before the handler.
+class LatencyRecorder {
+ public:
+  // Calibrates the TSC and starts recording.
+  static void Enable();
+  static bool Enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Records end - start; ignored when disabled or start is 0. An end
+  // before start (TSC skew between cores) records 0 rather than wrapping.
+  static void Record(LatencyStage stage, uint64_t start_tsc, uint64_t end_tsc) {
+    if (Enabled() && start_tsc != 0) RecordTicks(stage, end_tsc > start_tsc ? end_tsc - start_tsc : 0);
+  }
+
+  // Receive stamp of the market data being handled on this thread, 0 if
+  // there is none (backtests, replays).
+  static void SetCurrentReceive(uint64_t tsc);
+  static uint64_t CurrentReceive();
+
+  // Writes count, p50, p99, p99.9 and max per stage, merged over threads.
+  static void Report(std::ostream& out);
+
+  // Async-signal-safe; a reporter thread polls TakeDumpRequest().
+  static void RequestDump();
+  static bool TakeDumpRequest();
+
+  static constexpr int kMaxThreads = 16;
+
+ private:
+  static void RecordTicks(LatencyStage stage, uint64_t ticks);
+
+  static std::atomic<bool> enabled_;
+};
+
+#endif
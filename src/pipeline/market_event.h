@@ -0,0 +1,34 @@
+#ifndef MARKET_EVENT_H
+#define MARKET_EVENT_H
+
+#include "../market_data/candle.h"
+#include "../market_data/order_book.h"
+#include <cstdint>
+#include <type_traits>
+
+enum class MarketEventType : uint8_t {
+  // A bar from the exchange's ohlc channel.
+  CANDLE,
+  // A bar built locally from trades; carried in candle.
+  BAR,
+  TOP_OF_BOOK
+};
+
+// Fixed-size event handed from the network thread to the strategy thread.
+// Payloads are trivially copyable records, so an event is copied into the
+// ring by value and never owns heap memory.
+struct alignas(64) MarketEvent {
+  MarketEventType type;
+  // TscNow() stamps, 0 when latency recording is off. received_tsc is when
+  // the frame carrying this event arrived.
+  uint64_t received_tsc;
+  uint64_t published_tsc;
+  union {
+    Candle candle;
+    TopOfBook top_of_book;
+  };
+};
+
+static_assert(std::is_trivially_copyable<MarketEvent>::value, "MarketEvent must stay trivially copyable");
+
+#endif
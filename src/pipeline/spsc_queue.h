@@ -0,0 +1,86 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+constexpr size_t kCacheLineSize = 64;
+
+// Bounded lock-free ring for exactly one producer thread and one consumer
+// thread. Head and tail live on separate cache lines, and each side keeps a
+// cached copy of the other's index so the shared line is only read when the
+// ring looks full (producer) or empty (consumer). Capacity is rounded up to
+// a power of two.
+template <typename T>
+class SpscQueue {
+  static_assert(std::is_trivially_copyable<T>::value, "SpscQueue holds trivially copyable events");
+
+ public:
+  explicit SpscQueue(size_t capacity)
+      : capacity_(RoundUpPowerOfTwo(capacity < 2 ? 2 : capacity)),
+        mask_(capacity_ - 1),
+        slots_(new T[capacity_]) {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // Producer only. Returns false without blocking when the ring is full.
+  bool TryPush(const T& value) {
+    size_t tail = producer_.index.load(std::memory_order_relaxed);
+    if (tail - producer_.cached_other == capacity_) {
+      producer_.cached_other = consumer_.index.load(std::memory_order_acquire);
+      if (tail - producer_.cached_other == capacity_) return false;
+    }
+
+    slots_[tail & mask_] = value;
+    producer_.index.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Returns false when the ring is empty.
+  bool TryPop(T& value) {
+    size_t head = consumer_.index.load(std::memory_order_relaxed);
+    if (head == consumer_.cached_other) {
+      consumer_.cached_other = producer_.index.load(std::memory_order_acquire);
+      if (head == consumer_.cached_other) return false;
+    }
+
+    value = slots_[head & mask_];
+    consumer_.index.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called concurrently with push or pop.
+  size_t Size() const {
+    size_t tail = producer_.index.load(std::memory_order_acquire);
+    size_t head = consumer_.index.load(std::memory_order_acquire);
+    return tail - head;
+  }
+
+  bool Empty() const { return Size() == 0; }
+  size_t Capacity() const { return capacity_; }
+
+ private:
+  struct alignas(kCacheLineSize) Side {
+    std::atomic<size_t> index{0};
+    // Last observed index of the opposite side; touched by this side only.
+    size_t cached_other = 0;
+  };
+
+  static size_t RoundUpPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<T[]> slots_;
+
+  Side producer_;
+  Side consumer_;
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include "strategy_pipeline.h"
+#include "thread_affinity.h"
+#include "latency_recorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Spins before a blocking consumer parks; long enough to catch back-to-back
+// frames from one socket read without sleeping between them.
+const int kSpinsBeforeSleep = 2000;
+
+const uint64_t kDepthSampleInterval = 64;
+
+const size_t kLaneBatch = 256;
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+}  // namespace
+
+StrategyPipeline::StrategyPipeline(const PipelineConfig& config)
+    : config_(config), running_(false), consumer_sleeping_(false) {
+  if (config_.producers == 0) config_.producers = 1;
+  for (size_t i = 0; i < config_.producers; i++) {
+    lanes_.push_back(std::make_unique<Lane>(config_.queue_capacity));
+  }
+}
+
+StrategyPipeline::~StrategyPipeline() {
+  Stop();
+}
+
+void StrategyPipeline::Start(std::function<void(const MarketEvent&)> handler) {
+  if (running_.load()) return;
+
+  handler_ = std::move(handler);
+  running_.store(true);
+  consumer_ = std::thread(&StrategyPipeline::ConsumerLoop, this);
+}
+
+void StrategyPipeline::Stop() {
+  if (!running_.exchange(false)) return;
+
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    wake_.notify_one();
+  }
+  if (consumer_.joinable()) {
+    consumer_.join();
+  }
+}
+
+bool StrategyPipeline::Publish(const MarketEvent& event, size_t producer) {
+  Lane& lane = *lanes_[producer];
+  if (!lane.queue.TryPush(event)) {
+    lane.dropped.fetch_add(1, std::memory_order_relaxed);
+    lane.max_depth.store(lane.queue.Capacity(), std::memory_order_relaxed);
+    return false;
+  }
+  uint64_t published = lane.published.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  // Reading the depth touches the consumer's cache line, so only sample it.
+  if ((published & (kDepthSampleInterval - 1)) == 0) {
+    size_t depth = lane.queue.Size();
+    if (depth > lane.max_depth.load(std::memory_order_relaxed)) {
+      lane.max_depth.store(depth, std::memory_order_relaxed);
+    }
+  }
+
+  if (config_.wait_mode == WaitMode::BLOCKING) {
+    // Pairs with the fence in WaitForEvents: either the consumer sees the
+    // new tail on its re-check, or we see it asleep here and wake it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (consumer_sleeping_.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(wake_mutex_);
+      wake_.notify_one();
+    }
+  }
+  return true;
+}
+
+bool StrategyPipeline::PublishCandle(const Candle& candle, size_t producer) {
+  MarketEvent event;
+  event.type = MarketEventType::CANDLE;
+  event.candle = candle;
+  return PublishStamped(event, producer);
+}
+
+bool StrategyPipeline::PublishBar(const Candle& bar, size_t producer) {
+  MarketEvent event;
+  event.type = MarketEventType::BAR;
+  event.candle = bar;
+  return PublishStamped(event, producer);
+}
+
+bool StrategyPipeline::PublishTopOfBook(const TopOfBook& top, size_t producer) {
+  MarketEvent event;
+  event.type = MarketEventType::TOP_OF_BOOK;
+  event.top_of_book = top;
+  return PublishStamped(event, producer);
+}
+
+bool StrategyPipeline::PublishStamped(MarketEvent& event, size_t producer) {
+  event.received_tsc = 0;
+  event.published_tsc = 0;
+  if (LatencyRecorder::Enabled()) {
+    event.received_tsc = LatencyRecorder::CurrentReceive();
+    event.published_tsc = TscNow();
+    LatencyRecorder::Record(LatencyStage::PARSE, event.received_tsc, event.published_tsc);
+  }
+  return Publish(event, producer);
+}
+
+void StrategyPipeline::ConsumerLoop() {
+  SetCurrentThreadName("strategy");
+  PinCurrentThread(config_.strategy_cpu);
+
+  while (running_.load(std::memory_order_acquire)) {
+    if (DrainOnce()) continue;
+
+    if (config_.wait_mode == WaitMode::BUSY_POLL) {
+      CpuRelax();
+    } else {
+      WaitForEvents();
+    }
+  }
+
+  // Deliver whatever the producer managed to publish before Stop().
+  while (DrainOnce()) {}
+}
+
+bool StrategyPipeline::DrainOnce() {
+  // Bounded batch per lane so one busy producer cannot starve the others.
+  const size_t batch = lanes_.size() > 1 ? kLaneBatch : SIZE_MAX;
+  MarketEvent event;
+  bool any = false;
+  for (auto& lane : lanes_) {
+    size_t popped = 0;
+    while (popped < batch && lane->queue.TryPop(event)) {
+      if (LatencyRecorder::Enabled()) {
+        LatencyRecorder::Record(LatencyStage::QUEUE, event.published_tsc, TscNow());
+        LatencyRecorder::SetCurrentReceive(event.received_tsc);
+      }
+      handler_(event);
+      popped++;
+    }
+    if (popped > 0) {
+      lane->consumed.fetch_add(popped, std::memory_order_relaxed);
+      any = true;
+    }
+  }
+  return any;
+}
+
+bool StrategyPipeline::AnyQueued() const {
+  for (const auto& lane : lanes_) {
+    if (!lane->queue.Empty()) return true;
+  }
+  return false;
+}
+
+void StrategyPipeline::WaitForEvents() {
+  for (int spin = 0; spin < kSpinsBeforeSleep; spin++) {
+    if (AnyQueued() || !running_.load(std::memory_order_relaxed)) return;
+    CpuRelax();
+  }
+
+  std::unique_lock<std::mutex> lock(wake_mutex_);
+  consumer_sleeping_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!AnyQueued() && running_.load(std::memory_order_relaxed)) {
+    // The timeout is only a backstop; wakeups normally come from Publish().
+    wake_.wait_for(lock, std::chrono::milliseconds(100));
+  }
+  consumer_sleeping_.store(false, std::memory_order_relaxed);
+}
+
+PipelineStats StrategyPipeline::ProducerStats(size_t producer) const {
+  const Lane& lane = *lanes_.at(producer);
+  PipelineStats stats;
+  stats.published = lane.published.load(std::memory_order_relaxed);
+  stats.consumed = lane.consumed.load(std::memory_order_relaxed);
+  stats.dropped = lane.dropped.load(std::memory_order_relaxed);
+  stats.depth = lane.queue.Size();
+  stats.max_depth = lane.max_depth.load(std::memory_order_relaxed);
+  stats.capacity = lane.queue.Capacity();
+  return stats;
+}
+
+PipelineStats StrategyPipeline::Stats() const {
+  PipelineStats total = {};
+  for (size_t i = 0; i < lanes_.size(); i++) {
+    PipelineStats lane = ProducerStats(i);
+    total.published += lane.published;
+    total.consumed += lane.consumed;
+    total.dropped += lane.dropped;
+    total.depth = std::max(total.depth, lane.depth);
+    total.max_depth = std::max(total.max_depth, lane.max_depth);
+    total.capacity = lane.capacity;
+  }
+  return total;
+}
+
+const PipelineConfig& StrategyPipeline::Config() const {
+  return config_;
+}
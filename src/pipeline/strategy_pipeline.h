@@ -0,0 +1,105 @@
+#ifndef STRATEGY_PIPELINE_H
+#define STRATEGY_PIPELINE_H
+
+#include "market_event.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class WaitMode {
+  // Consumer spins on the ring; lowest latency, burns a core.
+  BUSY_POLL,
+  // Consumer spins briefly, then sleeps until the producer wakes it.
+  BLOCKING
+};
+
+struct PipelineConfig {
+  // Capacity of each producer's ring.
+  size_t queue_capacity = 4096;
+  // Number of publishing threads; each gets its own SPSC ring.
+  size_t producers = 1;
+  WaitMode wait_mode = WaitMode::BLOCKING;
+  // CPU for the strategy thread, -1 to leave it unpinned.
+  int strategy_cpu = -1;
+};
+
+struct PipelineStats {
+  uint64_t published;
+  uint64_t consumed;
+  // Events rejected because the ring was full.
+  uint64_t dropped;
+  size_t depth;
+  size_t max_depth;
+  size_t capacity;
+};
+
+// Decouples the socket threads from strategy work. Each network thread
+// calls Publish() with its own producer index after parsing, which never
+// blocks: if that ring is full the event is dropped and counted. A single
+// strategy thread drains the rings in turn and runs the handler, so a slow
+// model step delays the next signal but never the next socket read.
+class StrategyPipeline {
+ public:
+  explicit StrategyPipeline(const PipelineConfig& config = PipelineConfig());
+  ~StrategyPipeline();
+
+  StrategyPipeline(const StrategyPipeline&) = delete;
+  StrategyPipeline& operator=(const StrategyPipeline&) = delete;
+
+  // Starts the strategy thread; handler runs on it for every event.
+  void Start(std::function<void(const MarketEvent&)> handler);
+  // Drains the ring, then joins the strategy thread. Safe to call twice.
+  void Stop();
+
+  // Producer side; each producer index must be used by one thread only.
+  bool Publish(const MarketEvent& event, size_t producer = 0);
+  bool PublishCandle(const Candle& candle, size_t producer = 0);
+  bool PublishBar(const Candle& bar, size_t producer = 0);
+  bool PublishTopOfBook(const TopOfBook& top, size_t producer = 0);
+
+  // Totals over all producers; depth fields are the deepest single ring.
+  PipelineStats Stats() const;
+  PipelineStats ProducerStats(size_t producer) const;
+  const PipelineConfig& Config() const;
+
+ private:
+  // Stamps the latency fields of a parsed event and publishes it.
+  bool PublishStamped(MarketEvent& event, size_t producer);
+  void ConsumerLoop();
+  bool DrainOnce();
+  void WaitForEvents();
+
+  // One ring plus its producer-side counters, padded so producers never
+  // share a cache line.
+  struct alignas(kCacheLineSize) Lane {
+    explicit Lane(size_t capacity) : queue(capacity), published(0), dropped(0), max_depth(0), consumed(0) {}
+
+    SpscQueue<MarketEvent> queue;
+    std::atomic<uint64_t> published;
+    std::atomic<uint64_t> dropped;
+    std::atomic<size_t> max_depth;
+    alignas(kCacheLineSize) std::atomic<uint64_t> consumed;
+  };
+
+  bool AnyQueued() const;
+
+  PipelineConfig config_;
+  std::vector<std::unique_ptr<Lane>> lanes_;
+  std::function<void(const MarketEvent&)> handler_;
+  std::thread consumer_;
+  std::atomic<bool> running_;
+
+  // Set by a consumer about to sleep; the producer only takes the mutex
+  // when it sees this flag, keeping Publish() lock-free in the common case.
+  std::atomic<bool> consumer_sleeping_;
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+};
+
+#endif
@@ -0,0 +1,33 @@
+#include "thread_affinity.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+bool PinCurrentThread(int cpu) {
+  if (cpu < 0) return true;
+
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  // macOS only offers affinity hints through thread_policy_set; leave the
+  // scheduler alone rather than pretend.
+  return false;
+#endif
+}
+
+void SetCurrentThreadName(const std::string& name) {
+#if defined(__linux__)
+  pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+#elif defined(__APPLE__)
+  pthread_setname_np(name.c_str());
+#else
+  (void)name;
+#endif
+}
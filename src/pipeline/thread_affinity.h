@@ -0,0 +1,13 @@
+#ifndef THREAD_AFFINITY_H
+#define THREAD_AFFINITY_H
+
+#include <string>
+
+// Pins the calling thread to one CPU. A negative cpu leaves the thread
+// unpinned. Returns false if pinning is unsupported or the kernel refused.
+bool PinCurrentThread(int cpu);
+
+// Names the calling thread for top/perf; truncated to 15 characters on Linux.
+void SetCurrentThreadName(const std::string& name);
+
+#endif
@@ -0,0 +1,33 @@
+#include "tsc_clock.h"
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const auto kCalibrationWindow = std::chrono::milliseconds(20);
+
+}  // namespace
+
+std::atomic<double> TscClock::nanos_per_tick_(1.0);
+
+void TscClock::Calibrate() {
+#if defined(__x86_64__) || defined(__i386__)
+  static std::once_flag once;
+  std::call_once(once, []() {
+    auto wall_start = std::chrono::steady_clock::now();
+    uint64_t tsc_start = TscNow();
+    std::this_thread::sleep_for(kCalibrationWindow);
+    auto wall_end = std::chrono::steady_clock::now();
+    uint64_t tsc_end = TscNow();
+
+    double nanos = std::chrono::duration<double, std::nano>(wall_end - wall_start).count();
+    if (tsc_end > tsc_start) {
+      nanos_per_tick_.store(nanos / static_cast<double>(tsc_end - tsc_start), std::memory_order_relaxed);
+    }
+  });
+#endif
+}
+
+double TscClock::NanosPerTick() {
+  return nanos_per_tick_.load(std::memory_order_relaxed);
+}
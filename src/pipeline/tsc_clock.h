@@ -0,0 +1,41 @@
+#ifndef TSC_CLOCK_H
+#define TSC_CLOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Cheapest available timestamp: the invariant TSC on x86 (~7 ns, no
+// syscall, comparable across cores on anything built since Nehalem),
+// steady_clock nanoseconds elsewhere. Only differences are meaningful;
+// convert them with TscClock::ToNanos.
+inline uint64_t TscNow() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+class TscClock {
+ public:
+  // Measures the TSC rate against steady_clock over a few milliseconds.
+  // Idempotent; call once before any conversions are needed.
+  static void Calibrate();
+  static double NanosPerTick();
+
+  static int64_t ToNanos(uint64_t ticks) {
+    return static_cast<int64_t>(static_cast<double>(ticks) * nanos_per_tick_.load(std::memory_order_relaxed));
+  }
+
+ private:
+  // Written once by Calibrate(), possibly while other threads convert.
+  static std::atomic<double> nanos_per_tick_;
+};
+
+#endif
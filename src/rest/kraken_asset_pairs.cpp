@@ -0,0 +1,127 @@
+#include "kraken_asset_pairs.h"
+#include "kraken_ohlc_history.h"
+#include "../market_data/decimal.h"
+#include "../websocket/json_cursor.h"
+#include <stdexcept>
+
+namespace {
+
+bool ParseErrorArray(JsonCursor& cursor, std::string& error) {
+  if (!cursor.EnterArray()) return false;
+  std::string_view message;
+  while (cursor.NextElement()) {
+    if (!cursor.ReadString(message)) return false;
+    if (!error.empty()) error += "; ";
+    error.append(message.data(), message.size());
+  }
+  return !cursor.Failed();
+}
+
+bool ParsePair(JsonCursor& cursor, PairPrecision& pair) {
+  if (!cursor.EnterObject()) return false;
+
+  bool has_altname = false;
+  int64_t price_decimals = -1;
+  int64_t qty_decimals = -1;
+  std::string_view key;
+  std::string_view text;
+  while (cursor.NextKey(key)) {
+    if (key == "altname" && cursor.ReadString(text)) {
+      pair.altname.assign(text.data(), text.size());
+      has_altname = true;
+    } else if (key == "pair_decimals") {
+      if (!cursor.ReadInt64(price_decimals)) return false;
+    } else if (key == "lot_decimals") {
+      if (!cursor.ReadInt64(qty_decimals)) return false;
+    } else if (!cursor.Failed()) {
+      cursor.SkipValue();
+    }
+  }
+
+  if (cursor.Failed() || !has_altname) return false;
+  if (price_decimals < 0 || price_decimals > kMaxDecimalScale || qty_decimals < 0 || qty_decimals > kMaxDecimalScale) {
+    return false;
+  }
+  pair.price_decimals = static_cast<int>(price_decimals);
+  pair.qty_decimals = static_cast<int>(qty_decimals);
+  return true;
+}
+
+}  // namespace
+
+bool ParseAssetPairs(const char* data, size_t length, std::vector<PairPrecision>& pairs, std::string& error) {
+  JsonCursor cursor(data, data + length);
+  if (!cursor.EnterObject()) {
+    error = "malformed AssetPairs response";
+    return false;
+  }
+
+  bool result_seen = false;
+  std::string_view key;
+  while (cursor.NextKey(key)) {
+    if (key == "error") {
+      if (!ParseErrorArray(cursor, error)) break;
+    } else if (key == "result") {
+      if (!cursor.EnterObject()) break;
+      // One member per pair, named after Kraken's canonical pair.
+      std::string_view pair_key;
+      while (cursor.NextKey(pair_key)) {
+        PairPrecision pair;
+        if (!ParsePair(cursor, pair)) {
+          error = "malformed AssetPairs entry " + std::string(pair_key);
+          return false;
+        }
+        pairs.push_back(std::move(pair));
+      }
+      result_seen = true;
+    } else {
+      cursor.SkipValue();
+    }
+  }
+
+  if (cursor.Failed()) {
+    error = "malformed AssetPairs response";
+    return false;
+  }
+  if (!error.empty()) return false;
+  if (!result_seen) {
+    error = "AssetPairs response without pairs";
+    return false;
+  }
+  return true;
+}
+
+void FetchPairPrecision(KrakenBase& kraken, const std::vector<std::string>& symbols) {
+  std::string query = "pair=";
+  for (size_t i = 0; i < symbols.size(); i++) {
+    if (i > 0) query += ',';
+    query += KrakenRestPair(symbols[i]);
+  }
+
+  RestResponse response = kraken.PublicRequest("AssetPairs", query);
+  if (!response.error.empty() || response.status != 200) {
+    throw std::runtime_error("AssetPairs: " + (response.error.empty()
+        ? "HTTP " + std::to_string(response.status) : response.error));
+  }
+  std::vector<PairPrecision> pairs;
+  std::string error;
+  if (!ParseAssetPairs(response.body.data(), response.body.size(), pairs, error)) {
+    throw std::runtime_error("AssetPairs: " + error);
+  }
+
+  for (const std::string& symbol : symbols) {
+    std::string rest_pair = KrakenRestPair(symbol);
+    const PairPrecision* listed = nullptr;
+    for (const PairPrecision& pair : pairs) {
+      if (pair.altname == rest_pair) listed = &pair;
+    }
+    if (!listed) {
+      throw std::runtime_error("AssetPairs: " + symbol + " is not listed");
+    }
+    SymbolId id = SymbolRegistry::Global().Intern(symbol);
+    if (id == kInvalidSymbol) {
+      throw std::runtime_error("Symbol registry is full");
+    }
+    PrecisionTable::Global().Set(id, listed->price_decimals, listed->qty_decimals);
+  }
+}
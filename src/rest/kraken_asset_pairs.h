@@ -0,0 +1,30 @@
+#ifndef KRAKEN_ASSET_PAIRS_H
+#define KRAKEN_ASSET_PAIRS_H
+
+#include "kraken_base.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A pair's listing from REST AssetPairs: its REST name ("XBTUSD"), price
+// decimals (pair_decimals) and volume decimals (lot_decimals).
+struct PairPrecision {
+  std::string altname;
+  int price_decimals;
+  int qty_decimals;
+};
+
+// Parses one REST AssetPairs response body ({"error":[],"result":{PAIR:
+// {"altname":...,"pair_decimals":N,"lot_decimals":N,...},...}}), appending
+// one entry per pair to pairs. Returns false with error set on a Kraken
+// error or a malformed body.
+bool ParseAssetPairs(const char* data, size_t length, std::vector<PairPrecision>& pairs, std::string& error);
+
+// Looks up every symbol's price and volume decimals in one request and
+// stores them in PrecisionTable::Global(), so books, orders and the router
+// all work at the pair's own tick and lot. Throws std::runtime_error if
+// the request fails or a symbol is not listed. Do not call from a REST
+// callback.
+void FetchPairPrecision(KrakenBase& kraken, const std::vector<std::string>& symbols);
+
+#endif
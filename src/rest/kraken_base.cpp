@@ -1,85 +1,329 @@
 #include "kraken_base.h"
 #include <curl/curl.h>
-#include <openssl/hmac.h>
-#include <openssl/sha.h>
-#include <openssl/bio.h>
-#include <openssl/buffer.h>
-#include <ctime>
+#include <cctype>
+#include <future>
 #include <iostream>
+#include <stdexcept>
 
-KrakenBase::KrakenBase(const std::string& api_key, const std::string& private_key, const std::string& base_endpoint): 
-    api_key_(api_key), 
-    api_secret_(private_key), 
-    base_endpoint_(base_endpoint) {}
+namespace {
+
+const long kDefaultTimeoutMs = 10000;
+// Upper bound on idle time in curl_multi_poll; submissions wake it early.
+const int kPollTimeoutMs = 1000;
 
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s) {
-  s->append((char*)contents, size * nmemb);
+size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userdata) {
+  static_cast<std::string*>(userdata)->append(static_cast<char*>(contents), size * nmemb);
   return size * nmemb;
 }
 
-std::string Base64Decode(const std::string& encoded) {
-  BIO *bio = BIO_new_mem_buf(encoded.c_str(), encoded.length());
-  BIO *b64 = BIO_new(BIO_f_base64());
-  bio = BIO_push(b64, bio);
-  BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
+void GlobalInit() {
+  static std::once_flag once;
+  std::call_once(once, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+}  // namespace
+
+KrakenBase::KrakenBase(const std::string& api_key, const std::string& private_key, const std::string& base_endpoint): 
+    api_key_(api_key), 
+    base_endpoint_(base_endpoint),
+    timeout_ms_(kDefaultTimeoutMs),
+    multi_(nullptr), share_(nullptr), in_flight_(0),
+    outstanding_(0), stopping_(false) {
+  if (!private_key.empty()) {
+    signer_ = std::make_unique<KrakenSigner>(private_key);
+  }
   
-  std::vector<char> buffer(encoded.length());
-  int len = BIO_read(bio, buffer.data(), encoded.length());
-  BIO_free_all(bio);
+  GlobalInit();
+  multi_ = curl_multi_init();
+  share_ = curl_share_init();
+  if (!multi_ || !share_) {
+    curl_multi_cleanup(multi_);
+    curl_share_cleanup(share_);
+    throw std::runtime_error("Failed to initialise curl");
+  }
+  // Only the worker thread uses the share, so no lock callbacks are needed.
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
   
-  return std::string(buffer.data(), len);
+  worker_ = std::thread(&KrakenBase::WorkerLoop, this);
 }
 
-std::string Base64Encode(const unsigned char* buf, size_t len) {
-  BIO *b64 = BIO_new(BIO_f_base64());
-  BIO *bio = BIO_new(BIO_s_mem());
-  bio = BIO_push(b64, bio);
-  BIO_set_flags(bio, BIO_FLAGS_BASE64_NO_NL);
-  BIO_write(bio, buf, len);
-  BIO_flush(bio);
+KrakenBase::~KrakenBase() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  curl_multi_wakeup(multi_);
+  if (worker_.joinable()) {
+    worker_.join();
+  }
   
-  BUF_MEM *ptr;
-  BIO_get_mem_ptr(bio, &ptr);
-  std::string result(ptr->data, ptr->length);
-  BIO_free_all(bio);
+  for (CURL* easy : idle_handles_) {
+    curl_easy_cleanup(easy);
+  }
+  curl_multi_cleanup(multi_);
+  curl_share_cleanup(share_);
+}
+
+std::string KrakenBase::UrlEncode(const std::string& value) {
+  static const char kHex[] = "0123456789ABCDEF";
+  std::string encoded;
+  encoded.reserve(value.size());
+  for (unsigned char c : value) {
+    if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+      encoded.push_back(static_cast<char>(c));
+    } else {
+      encoded.push_back('%');
+      encoded.push_back(kHex[c >> 4]);
+      encoded.push_back(kHex[c & 15]);
+    }
+  }
+  return encoded;
+}
+
+void KrakenBase::AppendParam(std::string& form, const std::string& key, const std::string& value) {
+  if (!form.empty()) form.push_back('&');
+  form += key;
+  form.push_back('=');
+  form += UrlEncode(value);
+}
+
+void KrakenBase::SetTimeoutMs(long timeout_ms) {
+  timeout_ms_.store(timeout_ms, std::memory_order_relaxed);
+}
+
+void KrakenBase::Submit(std::unique_ptr<Request> request) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_) {
+      throw std::logic_error("KrakenBase is shutting down");
+    }
+    queued_.push_back(std::move(request));
+    outstanding_++;
+  }
+  curl_multi_wakeup(multi_);
+}
+
+RestResponse KrakenBase::SubmitAndWait(std::unique_ptr<Request> request) {
+  if (std::this_thread::get_id() == worker_.get_id()) {
+    throw std::logic_error("Blocking Kraken request issued from a REST callback");
+  }
   
-  return result;
+  std::promise<RestResponse> promise;
+  std::future<RestResponse> result = promise.get_future();
+  request->callback = [&promise](const RestResponse& response) { promise.set_value(response); };
+  Submit(std::move(request));
+  return result.get();
+}
+
+void KrakenBase::PublicRequestAsync(const std::string& method, const std::string& query, RestCallback callback) {
+  auto request = std::make_unique<Request>();
+  request->path = "/0/public/" + method;
+  request->params = query;
+  request->is_private = false;
+  request->callback = std::move(callback);
+  Submit(std::move(request));
+}
+
+void KrakenBase::PrivateRequestAsync(const std::string& method, const std::string& params, RestCallback callback) {
+  if (!signer_) {
+    throw std::logic_error("Private Kraken request without an API secret");
+  }
+  auto request = std::make_unique<Request>();
+  request->path = "/0/private/" + method;
+  request->params = params;
+  request->is_private = true;
+  request->callback = std::move(callback);
+  Submit(std::move(request));
+}
+
+RestResponse KrakenBase::PublicRequest(const std::string& method, const std::string& query) {
+  auto request = std::make_unique<Request>();
+  request->path = "/0/public/" + method;
+  request->params = query;
+  request->is_private = false;
+  return SubmitAndWait(std::move(request));
+}
+
+RestResponse KrakenBase::PrivateRequest(const std::string& method, const std::string& params) {
+  if (!signer_) {
+    throw std::logic_error("Private Kraken request without an API secret");
+  }
+  auto request = std::make_unique<Request>();
+  request->path = "/0/private/" + method;
+  request->params = params;
+  request->is_private = true;
+  return SubmitAndWait(std::move(request));
 }
 
 std::string KrakenBase::GetAccountBalance() {
-  CURL* curl = curl_easy_init();
-  std::string response;
-  std::string path = "/0/private/Balance";
-  std::string nonce = std::to_string(std::time(nullptr) * 1000);
-  std::string postdata = "nonce=" + nonce;
+  RestResponse response = PrivateRequest("Balance", "");
+  if (!response.error.empty()) {
+    std::cerr << "Balance request failed: " << response.error << std::endl;
+  }
+  return response.body;
+}
+
+void KrakenBase::AddOrder(const KrakenOrder& order, RestCallback callback) {
+  std::string params;
+  AppendParam(params, "ordertype", order.order_type);
+  AppendParam(params, "type", order.side);
+  AppendParam(params, "volume", order.volume);
+  AppendParam(params, "pair", order.pair);
+  if (!order.price.empty()) AppendParam(params, "price", order.price);
+  if (order.userref != 0) AppendParam(params, "userref", std::to_string(order.userref));
+  if (order.validate) AppendParam(params, "validate", "true");
+  PrivateRequestAsync("AddOrder", params, std::move(callback));
+}
+
+void KrakenBase::CancelOrder(const std::string& txid, RestCallback callback) {
+  std::string params;
+  AppendParam(params, "txid", txid);
+  PrivateRequestAsync("CancelOrder", params, std::move(callback));
+}
+
+void KrakenBase::OpenOrders(RestCallback callback) {
+  PrivateRequestAsync("OpenOrders", "", std::move(callback));
+}
+
+void KrakenBase::OHLC(const std::string& pair, int interval, int64_t since, RestCallback callback) {
+  std::string query;
+  AppendParam(query, "pair", pair);
+  AppendParam(query, "interval", std::to_string(interval));
+  if (since > 0) AppendParam(query, "since", std::to_string(since));
+  PublicRequestAsync("OHLC", query, std::move(callback));
+}
+
+void KrakenBase::WaitForPending() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]() { return outstanding_ == 0; });
+}
+
+CURL* KrakenBase::AcquireHandle() {
+  if (!idle_handles_.empty()) {
+    CURL* easy = idle_handles_.back();
+    idle_handles_.pop_back();
+    return easy;
+  }
   
-  // Create signature
-  std::string decoded_secret = Base64Decode(api_secret_);
-  unsigned char sha256[SHA256_DIGEST_LENGTH];
-  SHA256((unsigned char*)(nonce + postdata).c_str(), (nonce + postdata).length(), sha256);
+  // Options that never change are set once per handle; the handle keeps
+  // them across requests along with its connection.
+  CURL* easy = curl_easy_init();
+  curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+  curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, WriteCallback);
+  curl_easy_setopt(easy, CURLOPT_TCP_NODELAY, 1L);
+  curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+  curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+  curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+  curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(easy, CURLOPT_USERAGENT, "Algo-Trading/1.0");
+  return easy;
+}
+
+void KrakenBase::StartTransfer(std::unique_ptr<Request> request) {
+  CURL* easy = AcquireHandle();
+  request->headers = nullptr;
+  request->started = std::chrono::steady_clock::now();
   
-  std::string msg = path + std::string((char*)sha256, SHA256_DIGEST_LENGTH);
-  unsigned char hmac[EVP_MAX_MD_SIZE];
-  unsigned int hmac_len;
-  HMAC(EVP_sha512(), decoded_secret.c_str(), decoded_secret.length(),
-       (unsigned char*)msg.c_str(), msg.length(), hmac, &hmac_len);
+  if (request->is_private) {
+    // Signed here rather than at submission so nonces reach curl in order.
+    std::string nonce = std::to_string(nonce_.Next());
+    request->body = "nonce=" + nonce;
+    if (!request->params.empty()) {
+      request->body.push_back('&');
+      request->body += request->params;
+    }
+    std::string signature = signer_->Sign(request->path, nonce, request->body);
+    request->headers = curl_slist_append(request->headers, ("API-Key: " + api_key_).c_str());
+    request->headers = curl_slist_append(request->headers, ("API-Sign: " + signature).c_str());
+    
+    curl_easy_setopt(easy, CURLOPT_URL, (base_endpoint_ + request->path).c_str());
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDS, request->body.c_str());
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(request->body.size()));
+  } else {
+    std::string url = base_endpoint_ + request->path;
+    if (!request->params.empty()) {
+      url += "?" + request->params;
+    }
+    curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(easy, CURLOPT_HTTPGET, 1L);
+  }
   
-  std::string signature = Base64Encode(hmac, hmac_len);
+  curl_easy_setopt(easy, CURLOPT_HTTPHEADER, request->headers);
+  curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, timeout_ms_.load(std::memory_order_relaxed));
+  curl_easy_setopt(easy, CURLOPT_WRITEDATA, &request->response);
+  curl_easy_setopt(easy, CURLOPT_PRIVATE, request.get());
   
-  // Setup request
-  struct curl_slist* headers = nullptr;
-  headers = curl_slist_append(headers, ("API-Key: " + api_key_).c_str());
-  headers = curl_slist_append(headers, ("API-Sign: " + signature).c_str());
+  curl_multi_add_handle(multi_, easy);
+  in_flight_++;
+  request.release();
+}
+
+void KrakenBase::FinishTransfer(CURL* easy, int result) {
+  Request* raw = nullptr;
+  curl_easy_getinfo(easy, CURLINFO_PRIVATE, &raw);
+  std::unique_ptr<Request> request(raw);
   
-  curl_easy_setopt(curl, CURLOPT_URL, (base_endpoint_ + path).c_str());
-  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-  curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postdata.c_str());
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+  RestResponse response;
+  response.status = 0;
+  curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status);
+  response.body = std::move(request->response);
+  if (result != CURLE_OK) {
+    response.error = curl_easy_strerror(static_cast<CURLcode>(result));
+  }
+  response.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - request->started).count();
   
-  curl_easy_perform(curl);
-  curl_slist_free_all(headers);
-  curl_easy_cleanup(curl);
+  curl_multi_remove_handle(multi_, easy);
+  curl_slist_free_all(request->headers);
+  idle_handles_.push_back(easy);
+  in_flight_--;
   
-  return response;
-}
\ No newline at end of file
+  if (request->callback) {
+    try {
+      request->callback(response);
+    } catch (const std::exception& e) {
+      std::cerr << "REST callback threw: " << e.what() << std::endl;
+    }
+  }
+  
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    outstanding_--;
+  }
+  idle_.notify_all();
+}
+
+void KrakenBase::WorkerLoop() {
+  std::deque<std::unique_ptr<Request>> batch;
+  
+  while (true) {
+    // stopping_ is set by the destructor, so the poll below uses this copy.
+    bool stopping;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batch.swap(queued_);
+      stopping = stopping_;
+      if (stopping && batch.empty() && in_flight_ == 0) break;
+    }
+    
+    for (auto& request : batch) {
+      StartTransfer(std::move(request));
+    }
+    batch.clear();
+    
+    int running = 0;
+    curl_multi_perform(multi_, &running);
+    
+    int remaining = 0;
+    while (CURLMsg* message = curl_multi_info_read(multi_, &remaining)) {
+      if (message->msg == CURLMSG_DONE) {
+        FinishTransfer(message->easy_handle, message->data.result);
+      }
+    }
+    
+    if (in_flight_ > 0 || !stopping) {
+      curl_multi_poll(multi_, nullptr, 0, kPollTimeoutMs, nullptr);
+    }
+  }
+}
@@ -1,15 +1,131 @@
+#ifndef KRAKEN_BASE_H
+#define KRAKEN_BASE_H
+
+#include "kraken_signer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+typedef void CURLM;
+typedef void CURLSH;
+typedef void CURL;
+
+struct RestResponse {
+  // HTTP status, 0 if the request never got a response.
+  long status;
+  std::string body;
+  // Transport error from curl, empty on success. Kraken API errors are in
+  // the body's "error" array.
+  std::string error;
+  double seconds;
+};
+
+using RestCallback = std::function<void(const RestResponse&)>;
+
+struct KrakenOrder {
+  std::string pair;
+  // "buy" or "sell".
+  std::string side;
+  // "market", "limit", ...
+  std::string order_type;
+  // Decimal strings, passed through verbatim.
+  std::string volume;
+  std::string price;
+  // Optional client order id; 0 leaves it unset.
+  int64_t userref = 0;
+  // Validate only, do not submit.
+  bool validate = false;
+};
+
+// Kraken REST client. Requests run on one worker thread that owns a curl
+// multi handle with a shared DNS/TLS-session/connection cache and a pool of
+// reused easy handles, so after the first call each request costs one
+// round trip on a kept-alive connection.
+//
+// Private requests are signed when they are handed to curl, in submission
+// order, with nanosecond nonces. Requests in flight at the same time can
+// still reach Kraken out of order; give the API key a nonce window when
+// issuing private calls concurrently.
+//
+// Callbacks run on the worker thread and must not call the blocking
+// methods. Blocking methods may be called from any other thread.
 class KrakenBase {
  public:
   KrakenBase(const std::string& api_key, const std::string& private_key, const std::string& base_endpoint);
-  virtual ~KrakenBase() = default;
+  virtual ~KrakenBase();
+  
+  KrakenBase(const KrakenBase&) = delete;
+  KrakenBase& operator=(const KrakenBase&) = delete;
+  
   std::string GetAccountBalance();
   
-
+  // method is the path after /0/public/ or /0/private/, e.g. "OHLC".
+  // query/params are url-encoded key=value pairs without the nonce.
+  void PublicRequestAsync(const std::string& method, const std::string& query, RestCallback callback);
+  void PrivateRequestAsync(const std::string& method, const std::string& params, RestCallback callback);
+  RestResponse PublicRequest(const std::string& method, const std::string& query);
+  RestResponse PrivateRequest(const std::string& method, const std::string& params);
+  
+  void AddOrder(const KrakenOrder& order, RestCallback callback);
+  void CancelOrder(const std::string& txid, RestCallback callback);
+  void OpenOrders(RestCallback callback);
+  // since is a Unix timestamp in seconds, 0 for the most recent bars.
+  void OHLC(const std::string& pair, int interval, int64_t since, RestCallback callback);
+  
+  // Blocks until every request submitted so far has completed.
+  void WaitForPending();
+  void SetTimeoutMs(long timeout_ms);
+  
+  static std::string UrlEncode(const std::string& value);
+  static void AppendParam(std::string& form, const std::string& key, const std::string& value);
+  
  private:
+  struct Request {
+    std::string path;
+    std::string params;
+    bool is_private;
+    RestCallback callback;
+    // Filled on the worker thread.
+    std::string body;
+    std::string response;
+    struct curl_slist* headers;
+    std::chrono::steady_clock::time_point started;
+  };
+  
+  void Submit(std::unique_ptr<Request> request);
+  RestResponse SubmitAndWait(std::unique_ptr<Request> request);
+  void WorkerLoop();
+  void StartTransfer(std::unique_ptr<Request> request);
+  void FinishTransfer(CURL* easy, int result);
+  CURL* AcquireHandle();
+  
   std::string api_key_;
-  std::string api_secret_;
+  std::unique_ptr<KrakenSigner> signer_;
+  NonceGenerator nonce_;
   std::string base_endpoint_;
-};
\ No newline at end of file
+  // Set from any thread, read by the worker per transfer.
+  std::atomic<long> timeout_ms_;
+  
+  CURLM* multi_;
+  CURLSH* share_;
+  // Only touched by the worker thread.
+  std::vector<CURL*> idle_handles_;
+  size_t in_flight_;
+  
+  std::mutex mutex_;
+  std::condition_variable idle_;
+  std::deque<std::unique_ptr<Request>> queued_;
+  size_t outstanding_;
+  bool stopping_;
+  std::thread worker_;
+};
+
+#endif
@@ -0,0 +1,216 @@
+#include "kraken_ohlc_history.h"
+#include "../backtest/backtest_engine.h"
+#include "../websocket/json_cursor.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+const int64_t kNanosPerSecond = 1000000000LL;
+// Kraken returns at most this many bars per OHLC call.
+const size_t kPageBars = 720;
+// Upper bound on pages per symbol in case the cursor stops advancing.
+const int kMaxPages = 64;
+
+bool ParseErrorArray(JsonCursor& cursor, std::string& error) {
+  if (!cursor.EnterArray()) return false;
+  std::string_view message;
+  while (cursor.NextElement()) {
+    if (!cursor.ReadString(message)) return false;
+    if (!error.empty()) error += "; ";
+    error.append(message.data(), message.size());
+  }
+  return !cursor.Failed();
+}
+
+bool ParseRow(JsonCursor& cursor, const SymbolPrecision& precision, Candle& candle) {
+  if (!cursor.EnterArray()) return false;
+
+  int64_t seconds;
+  int64_t count;
+  std::string_view text;
+  if (!cursor.NextElement() || !cursor.ReadInt64(seconds)) return false;
+  int64_t* fields[] = {&candle.open, &candle.high, &candle.low, &candle.close, &candle.vwap, &candle.volume};
+  for (int64_t* field : fields) {
+    int scale = field == &candle.volume ? precision.qty_decimals : precision.price_decimals;
+    if (!cursor.NextElement() || !cursor.ReadNumberText(text) || !ParseMantissa(text, scale, *field)) return false;
+  }
+  if (!cursor.NextElement() || !cursor.ReadInt64(count)) return false;
+  while (cursor.NextElement()) {
+    cursor.SkipValue();
+  }
+
+  candle.interval_begin = seconds * kNanosPerSecond;
+  candle.trades = static_cast<uint32_t>(count);
+  return !cursor.Failed();
+}
+
+bool ParseRows(JsonCursor& cursor, SymbolId symbol, int interval, std::vector<Candle>& candles) {
+  if (!cursor.EnterArray()) return false;
+
+  Candle candle = {};
+  candle.symbol = symbol;
+  candle.interval = static_cast<uint16_t>(interval);
+  SymbolPrecision precision = MarketPrecision(symbol);
+  while (cursor.NextElement()) {
+    if (!ParseRow(cursor, precision, candle)) return false;
+    candles.push_back(candle);
+  }
+  return !cursor.Failed();
+}
+
+// Per-symbol paging state, only touched on the REST worker thread until
+// the symbol is done.
+struct HistoryFetch {
+  std::string pair;
+  SymbolId symbol;
+  int pages;
+  std::vector<Candle> candles;
+  std::string error;
+};
+
+}  // namespace
+
+bool ParseOhlcHistory(const char* data, size_t length, SymbolId symbol, int interval,
+                      std::vector<Candle>& candles, int64_t& last, std::string& error) {
+  JsonCursor cursor(data, data + length);
+  if (!cursor.EnterObject()) {
+    error = "malformed OHLC response";
+    return false;
+  }
+
+  bool rows_seen = false;
+  std::string_view key;
+  while (cursor.NextKey(key)) {
+    if (key == "error") {
+      if (!ParseErrorArray(cursor, error)) break;
+    } else if (key == "result") {
+      if (!cursor.EnterObject()) break;
+      // One member named after Kraken's canonical pair ("XXBTZUSD") plus
+      // the cursor.
+      std::string_view result_key;
+      while (cursor.NextKey(result_key)) {
+        if (result_key == "last") {
+          if (!cursor.ReadInt64(last)) break;
+        } else if (!rows_seen) {
+          if (!ParseRows(cursor, symbol, interval, candles)) break;
+          rows_seen = true;
+        } else {
+          cursor.SkipValue();
+        }
+      }
+    } else {
+      cursor.SkipValue();
+    }
+  }
+
+  if (cursor.Failed()) {
+    error = "malformed OHLC response";
+    return false;
+  }
+  if (!error.empty()) return false;
+  if (!rows_seen) {
+    error = "OHLC response without bars";
+    return false;
+  }
+  return true;
+}
+
+std::string KrakenRestPair(const std::string& symbol) {
+  std::string base = symbol;
+  std::string quote;
+  size_t slash = symbol.find('/');
+  if (slash != std::string::npos) {
+    base = symbol.substr(0, slash);
+    quote = symbol.substr(slash + 1);
+  }
+  // REST still uses the legacy ISO codes for these two.
+  if (base == "BTC") base = "XBT";
+  if (base == "DOGE") base = "XDG";
+  if (quote == "BTC") quote = "XBT";
+  return base + quote;
+}
+
+std::vector<Candle> FetchOhlcHistory(KrakenBase& kraken, const std::vector<std::string>& symbols,
+                                     int interval, int64_t since_ns, int64_t now_ns) {
+  std::vector<HistoryFetch> fetches(symbols.size());
+  std::mutex mutex;
+  std::condition_variable done;
+  size_t remaining = symbols.size();
+  const int64_t interval_ns = static_cast<int64_t>(interval) * 60 * kNanosPerSecond;
+
+  // Each callback either issues the symbol's next page or marks it done.
+  std::function<void(HistoryFetch&, int64_t)> request_page;
+  auto finish = [&]() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--remaining == 0) done.notify_all();
+  };
+  request_page = [&](HistoryFetch& fetch, int64_t since_s) {
+    kraken.OHLC(fetch.pair, interval, since_s, [&, since_s](const RestResponse& response) {
+      if (!response.error.empty() || response.status != 200) {
+        fetch.error = fetch.pair + ": " + (response.error.empty()
+            ? "HTTP " + std::to_string(response.status) : response.error);
+        finish();
+        return;
+      }
+      size_t before = fetch.candles.size();
+      int64_t last = 0;
+      if (!ParseOhlcHistory(response.body.data(), response.body.size(), fetch.symbol, interval,
+                            fetch.candles, last, fetch.error)) {
+        fetch.error = fetch.pair + ": " + fetch.error;
+        finish();
+        return;
+      }
+      fetch.pages++;
+      size_t received = fetch.candles.size() - before;
+      bool caught_up = last * kNanosPerSecond + interval_ns > now_ns;
+      if (received < kPageBars || caught_up || last <= since_s || fetch.pages >= kMaxPages) {
+        finish();
+        return;
+      }
+      request_page(fetch, last);
+    });
+  };
+
+  for (size_t i = 0; i < symbols.size(); i++) {
+    fetches[i].pair = KrakenRestPair(symbols[i]);
+    fetches[i].symbol = SymbolRegistry::Global().Intern(symbols[i]);
+    fetches[i].pages = 0;
+    if (fetches[i].symbol == kInvalidSymbol) {
+      throw std::runtime_error("Symbol registry is full");
+    }
+  }
+  for (HistoryFetch& fetch : fetches) {
+    request_page(fetch, since_ns / kNanosPerSecond);
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&remaining]() { return remaining == 0; });
+  }
+
+  std::vector<std::vector<Candle>> streams;
+  for (HistoryFetch& fetch : fetches) {
+    if (!fetch.error.empty()) {
+      throw std::runtime_error("OHLC history: " + fetch.error);
+    }
+    std::vector<Candle>& candles = fetch.candles;
+    std::stable_sort(candles.begin(), candles.end(), [](const Candle& a, const Candle& b) {
+      return a.interval_begin < b.interval_begin;
+    });
+    // Pages overlap at the cursor; keep the later copy of each bar.
+    std::vector<Candle> bars;
+    bars.reserve(candles.size());
+    for (const Candle& candle : candles) {
+      if (candle.interval_begin < since_ns || candle.interval_begin + interval_ns > now_ns) continue;
+      if (!bars.empty() && bars.back().interval_begin == candle.interval_begin) {
+        bars.back() = candle;
+      } else {
+        bars.push_back(candle);
+      }
+    }
+    streams.push_back(std::move(bars));
+  }
+  return MergeCandleStreams(std::move(streams));
+}
@@ -0,0 +1,32 @@
+#ifndef KRAKEN_OHLC_HISTORY_H
+#define KRAKEN_OHLC_HISTORY_H
+
+#include "kraken_base.h"
+#include "../market_data/candle.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Parses one REST OHLC response body ({"error":[],"result":{PAIR:[[time,
+// open,high,low,close,vwap,volume,count],...],"last":T}}) into candles for
+// symbol, appending to candles, and stores the paging cursor in last.
+// Returns false with error set on a Kraken error or a malformed body.
+bool ParseOhlcHistory(const char* data, size_t length, SymbolId symbol, int interval,
+                      std::vector<Candle>& candles, int64_t& last, std::string& error);
+
+// The REST pair name for a WebSocket v2 symbol: "BTC/USD" -> "XBTUSD".
+std::string KrakenRestPair(const std::string& symbol);
+
+// Fetches the completed bars of every symbol that opened at or after
+// since_ns, all symbols in parallel and each following Kraken's "last"
+// cursor page by page. The bar still in progress at now_ns is dropped so
+// the first live bar from the stream continues the series. The result is
+// merged, deduplicated and sorted by bar time. Kraken only serves the most
+// recent 720 bars of an interval; older history is silently cut off.
+// Throws std::runtime_error if any request fails. Do not call from a REST
+// callback.
+std::vector<Candle> FetchOhlcHistory(KrakenBase& kraken, const std::vector<std::string>& symbols,
+                                     int interval, int64_t since_ns, int64_t now_ns);
+
+#endif
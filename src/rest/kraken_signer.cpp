@@ -0,0 +1,106 @@
+#include "kraken_signer.h"
+#include <chrono>
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/sha.h>
+#include <stdexcept>
+#include <vector>
+
+std::string Base64Encode(const unsigned char* data, size_t length) {
+  std::string encoded(4 * ((length + 2) / 3), '\0');
+  int written = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&encoded[0]), data, static_cast<int>(length));
+  encoded.resize(written > 0 ? written : 0);
+  return encoded;
+}
+
+bool Base64Decode(const std::string& encoded, std::string& decoded) {
+  if (encoded.size() % 4 != 0) return false;
+
+  decoded.assign(3 * encoded.size() / 4, '\0');
+  int written = EVP_DecodeBlock(reinterpret_cast<unsigned char*>(&decoded[0]),
+                                reinterpret_cast<const unsigned char*>(encoded.data()),
+                                static_cast<int>(encoded.size()));
+  if (written < 0) return false;
+
+  // EVP_DecodeBlock counts padding as zero bytes; trim them.
+  size_t padding = 0;
+  if (!encoded.empty() && encoded.back() == '=') padding++;
+  if (encoded.size() > 1 && encoded[encoded.size() - 2] == '=') padding++;
+  decoded.resize(written - padding);
+  return true;
+}
+
+KrakenSigner::KrakenSigner(const std::string& api_secret)
+    : mac_(nullptr), hmac_(nullptr), sha256_(nullptr) {
+  std::string key;
+  if (!Base64Decode(api_secret, key) || key.empty()) {
+    throw std::runtime_error("Kraken API secret is not valid base64");
+  }
+
+  mac_ = EVP_MAC_fetch(nullptr, "HMAC", nullptr);
+  hmac_ = mac_ ? EVP_MAC_CTX_new(mac_) : nullptr;
+  sha256_ = EVP_MD_CTX_new();
+
+  char digest[] = "SHA512";
+  OSSL_PARAM params[] = {
+    OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+    OSSL_PARAM_construct_end()
+  };
+  bool keyed = hmac_ && sha256_ &&
+               EVP_MAC_init(hmac_, reinterpret_cast<const unsigned char*>(key.data()), key.size(), params) == 1;
+
+  // The decoded key now lives only inside the HMAC context.
+  OPENSSL_cleanse(&key[0], key.size());
+
+  if (!keyed) {
+    EVP_MD_CTX_free(sha256_);
+    EVP_MAC_CTX_free(hmac_);
+    EVP_MAC_free(mac_);
+    throw std::runtime_error("Failed to initialise HMAC-SHA512");
+  }
+}
+
+KrakenSigner::~KrakenSigner() {
+  EVP_MD_CTX_free(sha256_);
+  EVP_MAC_CTX_free(hmac_);
+  EVP_MAC_free(mac_);
+}
+
+std::string KrakenSigner::Sign(const std::string& path, const std::string& nonce, const std::string& postdata) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  unsigned int digest_length = 0;
+  EVP_DigestInit_ex(sha256_, EVP_sha256(), nullptr);
+  EVP_DigestUpdate(sha256_, nonce.data(), nonce.size());
+  EVP_DigestUpdate(sha256_, postdata.data(), postdata.size());
+  EVP_DigestFinal_ex(sha256_, digest, &digest_length);
+
+  // A null key re-initialises the context with the key set in the
+  // constructor.
+  unsigned char mac[EVP_MAX_MD_SIZE];
+  size_t mac_length = 0;
+  if (EVP_MAC_init(hmac_, nullptr, 0, nullptr) != 1 ||
+      EVP_MAC_update(hmac_, reinterpret_cast<const unsigned char*>(path.data()), path.size()) != 1 ||
+      EVP_MAC_update(hmac_, digest, digest_length) != 1 ||
+      EVP_MAC_final(hmac_, mac, &mac_length, sizeof(mac)) != 1) {
+    throw std::runtime_error("HMAC-SHA512 signing failed");
+  }
+
+  return Base64Encode(mac, mac_length);
+}
+
+NonceGenerator::NonceGenerator() : last_(0) {}
+
+uint64_t NonceGenerator::Next() {
+  uint64_t now = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+
+  uint64_t last = last_.load(std::memory_order_relaxed);
+  uint64_t next;
+  do {
+    next = now > last ? now : last + 1;
+  } while (!last_.compare_exchange_weak(last, next, std::memory_order_relaxed));
+  return next;
+}
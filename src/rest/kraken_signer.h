@@ -0,0 +1,55 @@
+#ifndef KRAKEN_SIGNER_H
+#define KRAKEN_SIGNER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+typedef struct evp_mac_st EVP_MAC;
+typedef struct evp_mac_ctx_st EVP_MAC_CTX;
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+std::string Base64Encode(const unsigned char* data, size_t length);
+// Returns false on malformed input.
+bool Base64Decode(const std::string& encoded, std::string& decoded);
+
+// Computes Kraken's API-Sign header:
+//   base64(HMAC-SHA512(key = base64decode(secret), path + SHA256(nonce + postdata)))
+// The secret is decoded once and the keyed HMAC context is reused across
+// calls, so signing costs two digests and no allocations beyond the result.
+// Sign() is serialized internally and safe to call from any thread.
+class KrakenSigner {
+ public:
+  // Throws std::runtime_error if the secret is not valid base64 or OpenSSL
+  // cannot provide HMAC-SHA512.
+  explicit KrakenSigner(const std::string& api_secret);
+  ~KrakenSigner();
+
+  KrakenSigner(const KrakenSigner&) = delete;
+  KrakenSigner& operator=(const KrakenSigner&) = delete;
+
+  std::string Sign(const std::string& path, const std::string& nonce, const std::string& postdata);
+
+ private:
+  std::mutex mutex_;
+  EVP_MAC* mac_;
+  EVP_MAC_CTX* hmac_;
+  EVP_MD_CTX* sha256_;
+};
+
+// Strictly increasing nonces in nanoseconds since the epoch. Two calls in
+// the same clock tick, or a clock stepped backwards, still yield increasing
+// values. Thread-safe.
+class NonceGenerator {
+ public:
+  NonceGenerator();
+
+  uint64_t Next();
+
+ private:
+  std::atomic<uint64_t> last_;
+};
+
+#endif
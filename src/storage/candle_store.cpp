@@ -0,0 +1,488 @@
+#include "candle_store.h"
+#include "../market_data/timestamp.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kColumnMagic[8] = {'A', 'T', 'C', 'A', 'N', 'D', 'L', 'E'};
+const char kIndexMagic[8] = {'A', 'T', 'C', 'I', 'N', 'D', 'E', 'X'};
+// Version 1 stored prices and volume as doubles.
+const uint32_t kStoreVersion = 2;
+const size_t kColumnCount = static_cast<size_t>(CandleColumn::COUNT);
+const uint32_t kUnmappedSymbol = 0xFFFFFFFF;
+
+struct ColumnSpec {
+  const char* file_name;
+  uint32_t element_size;
+};
+
+const ColumnSpec kColumns[kColumnCount] = {
+  {"timestamp.col", sizeof(int64_t)},
+  {"symbol.col", sizeof(uint32_t)},
+  {"open.col", sizeof(int64_t)},
+  {"high.col", sizeof(int64_t)},
+  {"low.col", sizeof(int64_t)},
+  {"close.col", sizeof(int64_t)},
+  {"vwap.col", sizeof(int64_t)},
+  {"volume.col", sizeof(int64_t)},
+  {"trades.col", sizeof(int32_t)},
+  {"interval.col", sizeof(int32_t)},
+};
+
+std::string JoinPath(const std::string& directory, const char* file_name) {
+  return (std::filesystem::path(directory) / file_name).string();
+}
+
+ColumnHeader MakeColumnHeader(uint32_t element_size, uint64_t rows) {
+  ColumnHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kColumnMagic, sizeof(header.magic));
+  header.version = kStoreVersion;
+  header.element_size = element_size;
+  header.row_count = rows;
+  return header;
+}
+
+void ReadSymbolTable(const std::string& directory, std::vector<std::string>& symbols,
+                     std::vector<SymbolPrecision>& precisions) {
+  std::ifstream file(JoinPath(directory, "symbols.txt"));
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty()) continue;
+    std::istringstream fields(line);
+    std::string name;
+    SymbolPrecision precision;
+    if (!(fields >> name >> precision.price_decimals >> precision.qty_decimals) ||
+        precision.price_decimals < 0 || precision.price_decimals > kMaxDecimalScale ||
+        precision.qty_decimals < 0 || precision.qty_decimals > kMaxDecimalScale) {
+      throw std::runtime_error("Bad symbol table line in " + directory + ": " + line);
+    }
+    symbols.push_back(name);
+    precisions.push_back(precision);
+  }
+}
+
+bool SamePrecision(const SymbolPrecision& a, const SymbolPrecision& b) {
+  return a.price_decimals == b.price_decimals && a.qty_decimals == b.qty_decimals;
+}
+
+// Moves a candle's prices and volume from one precision to another,
+// rounding when narrowing. False, with candle partly moved, on overflow.
+bool RescaleCandle(Candle& candle, const SymbolPrecision& from, const SymbolPrecision& to) {
+  int64_t* values[] = {&candle.open, &candle.high, &candle.low, &candle.close, &candle.vwap, &candle.volume};
+  for (int64_t* value : values) {
+    bool volume = value == &candle.volume;
+    Decimal decimal = {*value, volume ? from.qty_decimals : from.price_decimals};
+    if (!Rescale(decimal, volume ? to.qty_decimals : to.price_decimals)) return false;
+    *value = decimal.mantissa;
+  }
+  return true;
+}
+
+// Why a column with header cannot be read as spec, or nullptr if it can.
+const char* ColumnHeaderProblem(const ColumnHeader& header, const ColumnSpec& spec) {
+  if (std::memcmp(header.magic, kColumnMagic, sizeof(header.magic)) != 0 || header.element_size != spec.element_size) {
+    return "Corrupt candle column: ";
+  }
+  if (header.version != kStoreVersion) return "Candle column from another store version: ";
+  return nullptr;
+}
+
+std::vector<SymbolIndexEntry> ReadIndex(const std::string& directory) {
+  std::vector<SymbolIndexEntry> index;
+  std::ifstream file(JoinPath(directory, "index.bin"), std::ios::binary);
+  if (!file.is_open()) return index;
+
+  IndexHeader header;
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, kIndexMagic, sizeof(header.magic)) != 0) {
+    return index;
+  }
+
+  index.resize(header.symbol_count);
+  file.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(SymbolIndexEntry));
+  if (!file) index.clear();
+  return index;
+}
+
+}  // namespace
+
+CandleStoreWriter::CandleStoreWriter(const std::string& directory, size_t flush_interval)
+    : directory_(directory),
+      flush_interval_(flush_interval > 0 ? flush_interval : 1),
+      symbols_file_(nullptr),
+      rows_(0),
+      committed_rows_(0) {
+  std::fill(std::begin(columns_), std::end(columns_), nullptr);
+  std::filesystem::create_directories(directory_);
+
+  if (std::filesystem::exists(JoinPath(directory_, kColumns[0].file_name))) {
+    OpenExisting();
+  } else {
+    CreateNew();
+  }
+
+  symbols_file_ = std::fopen(JoinPath(directory_, "symbols.txt").c_str(), "a");
+  if (!symbols_file_) {
+    Close();
+    throw std::runtime_error("Failed to open symbol table in " + directory_);
+  }
+}
+
+CandleStoreWriter::~CandleStoreWriter() {
+  Close();
+}
+
+void CandleStoreWriter::CreateNew() {
+  for (size_t i = 0; i < kColumnCount; i++) {
+    columns_[i] = std::fopen(JoinPath(directory_, kColumns[i].file_name).c_str(), "w+b");
+    if (!columns_[i]) {
+      Close();
+      throw std::runtime_error("Failed to create candle column in " + directory_);
+    }
+    ColumnHeader header = MakeColumnHeader(kColumns[i].element_size, 0);
+    std::fwrite(&header, sizeof(header), 1, columns_[i]);
+  }
+  std::fclose(std::fopen(JoinPath(directory_, "symbols.txt").c_str(), "w"));
+}
+
+void CandleStoreWriter::OpenExisting() {
+  std::vector<std::string> symbols;
+  ReadSymbolTable(directory_, symbols, precisions_);
+  for (uint32_t id = 0; id < symbols.size(); id++) {
+    SymbolId symbol = SymbolRegistry::Global().Intern(symbols[id]);
+    if (symbol == kInvalidSymbol) continue;
+    if (symbol >= store_ids_.size()) store_ids_.resize(symbol + 1, kUnmappedSymbol);
+    store_ids_[symbol] = id;
+  }
+  // The committed row count is the smallest header count; anything written
+  // past it belongs to an interrupted flush and is discarded.
+  uint64_t rows = UINT64_MAX;
+  for (size_t i = 0; i < kColumnCount; i++) {
+    std::string path = JoinPath(directory_, kColumns[i].file_name);
+    columns_[i] = std::fopen(path.c_str(), "r+b");
+    ColumnHeader header;
+    const char* problem = !columns_[i] || std::fread(&header, sizeof(header), 1, columns_[i]) != 1
+                              ? "Corrupt candle column: "
+                              : ColumnHeaderProblem(header, kColumns[i]);
+    if (problem) {
+      Close();
+      throw std::runtime_error(problem + path);
+    }
+    rows = std::min(rows, header.row_count);
+  }
+
+  for (size_t i = 0; i < kColumnCount; i++) {
+    std::string path = JoinPath(directory_, kColumns[i].file_name);
+    std::filesystem::resize_file(path, sizeof(ColumnHeader) + rows * kColumns[i].element_size);
+  }
+
+  // index.bin may count rows the truncation just discarded, so it is
+  // rebuilt from the committed symbol and timestamp columns.
+  index_.assign(symbols.size(), SymbolIndexEntry{0, 0, 0, 0, 0});
+  for (uint32_t id = 0; id < index_.size(); id++) {
+    index_[id].symbol_id = id;
+  }
+  std::FILE* timestamp_file = columns_[static_cast<size_t>(CandleColumn::TIMESTAMP)];
+  std::FILE* symbol_file = columns_[static_cast<size_t>(CandleColumn::SYMBOL)];
+  std::fseek(timestamp_file, sizeof(ColumnHeader), SEEK_SET);
+  std::fseek(symbol_file, sizeof(ColumnHeader), SEEK_SET);
+  std::vector<int64_t> timestamps(4096);
+  std::vector<uint32_t> symbol_ids(timestamps.size());
+  for (uint64_t row = 0; row < rows;) {
+    size_t count = static_cast<size_t>(std::min<uint64_t>(timestamps.size(), rows - row));
+    if (std::fread(timestamps.data(), sizeof(int64_t), count, timestamp_file) != count ||
+        std::fread(symbol_ids.data(), sizeof(uint32_t), count, symbol_file) != count) {
+      Close();
+      throw std::runtime_error("Truncated candle column in " + directory_);
+    }
+    for (size_t i = 0; i < count; i++) {
+      if (symbol_ids[i] >= index_.size()) {
+        Close();
+        throw std::runtime_error("Candle row names a symbol missing from symbols.txt in " + directory_);
+      }
+      SymbolIndexEntry& entry = index_[symbol_ids[i]];
+      if (entry.row_count == 0) entry.first_timestamp = timestamps[i];
+      entry.last_timestamp = timestamps[i];
+      entry.row_count++;
+    }
+    row += count;
+  }
+
+  for (size_t i = 0; i < kColumnCount; i++) {
+    std::fseek(columns_[i], 0, SEEK_END);
+  }
+
+  rows_ = rows;
+  committed_rows_ = rows;
+  WriteIndex();
+}
+
+uint32_t CandleStoreWriter::StoreSymbol(SymbolId symbol) {
+  if (symbol < store_ids_.size() && store_ids_[symbol] != kUnmappedSymbol) {
+    return store_ids_[symbol];
+  }
+
+  uint32_t id = static_cast<uint32_t>(index_.size());
+  if (symbol >= store_ids_.size()) store_ids_.resize(symbol + 1, kUnmappedSymbol);
+  store_ids_[symbol] = id;
+  index_.push_back(SymbolIndexEntry{id, 0, 0, 0, 0});
+  SymbolPrecision precision = MarketPrecision(symbol);
+  precisions_.push_back(precision);
+
+  std::fprintf(symbols_file_, "%s %d %d\n", SymbolRegistry::Global().Name(symbol).c_str(), precision.price_decimals,
+               precision.qty_decimals);
+  std::fflush(symbols_file_);
+  return id;
+}
+
+void CandleStoreWriter::Append(const Candle& input) {
+  if (!columns_[0]) return;
+
+  uint32_t symbol_id = StoreSymbol(input.symbol);
+  Candle candle = input;
+  SymbolPrecision precision = MarketPrecision(candle.symbol);
+  if (!SamePrecision(precision, precisions_[symbol_id]) && !RescaleCandle(candle, precision, precisions_[symbol_id])) {
+    std::cerr << "Candle of " << SymbolRegistry::Global().Name(candle.symbol)
+              << " overflows the store's precision; skipped" << std::endl;
+    return;
+  }
+  int64_t timestamp = candle.interval_begin;
+  int32_t trades = static_cast<int32_t>(candle.trades);
+  int32_t interval = candle.interval;
+
+  std::fwrite(&timestamp, sizeof(timestamp), 1, columns_[static_cast<size_t>(CandleColumn::TIMESTAMP)]);
+  std::fwrite(&symbol_id, sizeof(symbol_id), 1, columns_[static_cast<size_t>(CandleColumn::SYMBOL)]);
+  std::fwrite(&candle.open, sizeof(int64_t), 1, columns_[static_cast<size_t>(CandleColumn::OPEN)]);
+  std::fwrite(&candle.high, sizeof(int64_t), 1, columns_[static_cast<size_t>(CandleColumn::HIGH)]);
+  std::fwrite(&candle.low, sizeof(int64_t), 1, columns_[static_cast<size_t>(CandleColumn::LOW)]);
+  std::fwrite(&candle.close, sizeof(int64_t), 1, columns_[static_cast<size_t>(CandleColumn::CLOSE)]);
+  std::fwrite(&candle.vwap, sizeof(int64_t), 1, columns_[static_cast<size_t>(CandleColumn::VWAP)]);
+  std::fwrite(&candle.volume, sizeof(int64_t), 1, columns_[static_cast<size_t>(CandleColumn::VOLUME)]);
+  std::fwrite(&trades, sizeof(trades), 1, columns_[static_cast<size_t>(CandleColumn::TRADES)]);
+  std::fwrite(&interval, sizeof(interval), 1, columns_[static_cast<size_t>(CandleColumn::INTERVAL)]);
+
+  SymbolIndexEntry& entry = index_[symbol_id];
+  if (entry.row_count == 0) entry.first_timestamp = timestamp;
+  entry.last_timestamp = timestamp;
+  entry.row_count++;
+  rows_++;
+
+  if (rows_ - committed_rows_ >= flush_interval_) {
+    Flush();
+  }
+}
+
+void CandleStoreWriter::Flush() {
+  if (!columns_[0] || rows_ == committed_rows_) return;
+
+  for (size_t i = 0; i < kColumnCount; i++) {
+    std::fflush(columns_[i]);
+  }
+
+  for (size_t i = 0; i < kColumnCount; i++) {
+    ColumnHeader header = MakeColumnHeader(kColumns[i].element_size, rows_);
+    std::fseek(columns_[i], 0, SEEK_SET);
+    std::fwrite(&header, sizeof(header), 1, columns_[i]);
+    std::fflush(columns_[i]);
+    std::fseek(columns_[i], 0, SEEK_END);
+  }
+
+  WriteIndex();
+  committed_rows_ = rows_;
+}
+
+void CandleStoreWriter::WriteIndex() {
+  IndexHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kIndexMagic, sizeof(header.magic));
+  header.version = kStoreVersion;
+  header.symbol_count = static_cast<uint32_t>(index_.size());
+  header.row_count = rows_;
+
+  std::string index_path = JoinPath(directory_, "index.bin");
+  std::string temp_path = index_path + ".tmp";
+  std::FILE* index_file = std::fopen(temp_path.c_str(), "wb");
+  if (index_file) {
+    std::fwrite(&header, sizeof(header), 1, index_file);
+    std::fwrite(index_.data(), sizeof(SymbolIndexEntry), index_.size(), index_file);
+    std::fclose(index_file);
+    std::rename(temp_path.c_str(), index_path.c_str());
+  }
+}
+
+void CandleStoreWriter::Close() {
+  Flush();
+
+  for (size_t i = 0; i < kColumnCount; i++) {
+    if (columns_[i]) {
+      std::fclose(columns_[i]);
+      columns_[i] = nullptr;
+    }
+  }
+  if (symbols_file_) {
+    std::fclose(symbols_file_);
+    symbols_file_ = nullptr;
+  }
+}
+
+uint64_t CandleStoreWriter::RowCount() const {
+  return rows_;
+}
+
+CandleStoreReader::CandleStoreReader(const std::string& directory) : rows_(0), sorted_(true) {
+  for (auto& column : columns_) {
+    column = MappedColumn{nullptr, 0, nullptr};
+  }
+
+  // The destructor does not run when the constructor throws.
+  try {
+    Open(directory);
+  } catch (...) {
+    Unmap();
+    throw;
+  }
+}
+
+void CandleStoreReader::Open(const std::string& directory) {
+  uint64_t rows = UINT64_MAX;
+  for (size_t i = 0; i < kColumnCount; i++) {
+    std::string path = JoinPath(directory, kColumns[i].file_name);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || ::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ColumnHeader)) {
+      if (fd >= 0) ::close(fd);
+      throw std::runtime_error("Missing or truncated candle column: " + path);
+    }
+
+    size_t length = static_cast<size_t>(info.st_size);
+    void* base = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+      throw std::runtime_error("Failed to map candle column: " + path);
+    }
+    columns_[i] = MappedColumn{base, length, static_cast<const char*>(base) + sizeof(ColumnHeader)};
+
+    const ColumnHeader* header = static_cast<const ColumnHeader*>(base);
+    if (const char* problem = ColumnHeaderProblem(*header, kColumns[i])) {
+      throw std::runtime_error(problem + path);
+    }
+
+    uint64_t available = (length - sizeof(ColumnHeader)) / header->element_size;
+    rows = std::min(rows, std::min<uint64_t>(header->row_count, available));
+  }
+
+  rows_ = static_cast<size_t>(rows);
+  ReadSymbolTable(directory, symbols_, precisions_);
+  index_ = ReadIndex(directory);
+
+  registry_ids_.reserve(symbols_.size());
+  for (const auto& symbol : symbols_) {
+    registry_ids_.push_back(SymbolRegistry::Global().Intern(symbol));
+  }
+
+  const int64_t* timestamps = Timestamps();
+  sorted_ = std::is_sorted(timestamps, timestamps + rows_);
+}
+
+void CandleStoreReader::Unmap() {
+  for (auto& column : columns_) {
+    if (column.base) {
+      ::munmap(column.base, column.length);
+      column = MappedColumn{nullptr, 0, nullptr};
+    }
+  }
+}
+
+CandleStoreReader::~CandleStoreReader() {
+  Unmap();
+}
+
+size_t CandleStoreReader::Size() const {
+  return rows_;
+}
+
+const int64_t* CandleStoreReader::Timestamps() const { return Column<int64_t>(CandleColumn::TIMESTAMP); }
+const uint32_t* CandleStoreReader::SymbolIds() const { return Column<uint32_t>(CandleColumn::SYMBOL); }
+const int64_t* CandleStoreReader::Opens() const { return Column<int64_t>(CandleColumn::OPEN); }
+const int64_t* CandleStoreReader::Highs() const { return Column<int64_t>(CandleColumn::HIGH); }
+const int64_t* CandleStoreReader::Lows() const { return Column<int64_t>(CandleColumn::LOW); }
+const int64_t* CandleStoreReader::Closes() const { return Column<int64_t>(CandleColumn::CLOSE); }
+const int64_t* CandleStoreReader::Vwaps() const { return Column<int64_t>(CandleColumn::VWAP); }
+const int64_t* CandleStoreReader::Volumes() const { return Column<int64_t>(CandleColumn::VOLUME); }
+const int32_t* CandleStoreReader::Trades() const { return Column<int32_t>(CandleColumn::TRADES); }
+const int32_t* CandleStoreReader::Intervals() const { return Column<int32_t>(CandleColumn::INTERVAL); }
+
+size_t CandleStoreReader::SymbolCount() const {
+  return symbols_.size();
+}
+
+const std::string& CandleStoreReader::SymbolName(uint32_t symbol_id) const {
+  return symbols_.at(symbol_id);
+}
+
+SymbolPrecision CandleStoreReader::StoredPrecision(uint32_t symbol_id) const {
+  return precisions_.at(symbol_id);
+}
+
+const std::vector<SymbolIndexEntry>& CandleStoreReader::Index() const {
+  return index_;
+}
+
+bool CandleStoreReader::Sorted() const {
+  return sorted_;
+}
+
+size_t CandleStoreReader::LowerBound(int64_t timestamp) const {
+  if (!sorted_) {
+    throw std::runtime_error("Candle store rows are not in time order");
+  }
+  const int64_t* begin = Timestamps();
+  return std::lower_bound(begin, begin + rows_, timestamp) - begin;
+}
+
+Candle CandleStoreReader::ReadCandle(size_t row) const {
+  Candle candle = {};
+  uint32_t symbol_id = SymbolIds()[row];
+  candle.symbol = symbol_id < registry_ids_.size() ? registry_ids_[symbol_id] : kInvalidSymbol;
+  candle.open = Opens()[row];
+  candle.high = Highs()[row];
+  candle.low = Lows()[row];
+  candle.close = Closes()[row];
+  candle.vwap = Vwaps()[row];
+  candle.volume = Volumes()[row];
+  candle.trades = static_cast<uint32_t>(Trades()[row]);
+  candle.interval_begin = Timestamps()[row];
+  candle.interval = static_cast<uint16_t>(Intervals()[row]);
+
+  if (symbol_id < precisions_.size() && candle.symbol != kInvalidSymbol) {
+    SymbolPrecision precision = MarketPrecision(candle.symbol);
+    if (!SamePrecision(precisions_[symbol_id], precision) && !RescaleCandle(candle, precisions_[symbol_id], precision)) {
+      throw std::runtime_error("Candle store row " + std::to_string(row) + " overflows " + symbols_[symbol_id] +
+                               "'s precision");
+    }
+  }
+  return candle;
+}
+
+std::vector<Candle> CandleStoreReader::ReadCandles(size_t begin, size_t end) const {
+  end = std::min(end, rows_);
+  std::vector<Candle> candles;
+  if (begin >= end) return candles;
+
+  candles.reserve(end - begin);
+  for (size_t row = begin; row < end; row++) {
+    candles.push_back(ReadCandle(row));
+  }
+  return candles;
+}
@@ -0,0 +1,171 @@
+#ifndef CANDLE_STORE_H
+#define CANDLE_STORE_H
+
+#include "../market_data/candle.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// A candle store is a directory of fixed-width binary columns, one value per
+// row and rows in append order:
+//   symbols.txt   interned symbol table, line number == symbol id; each
+//                 line is "NAME PRICE_DECIMALS QTY_DECIMALS"
+//   *.col         ColumnHeader followed by the raw column values
+//   index.bin     IndexHeader followed by one SymbolIndexEntry per symbol
+// Prices and volume are Candle mantissas at the decimals their symbol had
+// when it was first stored. Row counts in the headers are only advanced
+// after the data they cover has been written, so a reader never sees a torn
+// row after a crash.
+
+enum class CandleColumn {
+  TIMESTAMP,
+  SYMBOL,
+  OPEN,
+  HIGH,
+  LOW,
+  CLOSE,
+  VWAP,
+  VOLUME,
+  TRADES,
+  INTERVAL,
+  COUNT
+};
+
+struct ColumnHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t element_size;
+  uint64_t row_count;
+  uint8_t reserved[40];
+};
+
+struct IndexHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t symbol_count;
+  uint64_t row_count;
+  uint8_t reserved[8];
+};
+
+struct SymbolIndexEntry {
+  uint32_t symbol_id;
+  uint32_t reserved;
+  uint64_t row_count;
+  int64_t first_timestamp;
+  int64_t last_timestamp;
+};
+
+static_assert(sizeof(ColumnHeader) == 64, "column header must stay 64 bytes");
+static_assert(sizeof(IndexHeader) == 32, "index header must stay 32 bytes");
+static_assert(sizeof(SymbolIndexEntry) == 32, "index entries must stay 32 bytes");
+
+// Appends candles to a store, creating it or continuing an existing one.
+// Intended to sit on KrakenCandleStream::SetCandleCallback; committed every
+// flush_interval rows and on Flush()/destruction. Candles of a symbol whose
+// MarketPrecision() differs from the stored one are rescaled to it.
+class CandleStoreWriter {
+ public:
+  explicit CandleStoreWriter(const std::string& directory, size_t flush_interval = 64);
+  ~CandleStoreWriter();
+
+  CandleStoreWriter(const CandleStoreWriter&) = delete;
+  CandleStoreWriter& operator=(const CandleStoreWriter&) = delete;
+
+  void Append(const Candle& candle);
+  void Flush();
+  void Close();
+
+  uint64_t RowCount() const;
+
+ private:
+  uint32_t StoreSymbol(SymbolId symbol);
+  void OpenExisting();
+  void CreateNew();
+  // Replaces index.bin atomically with index_ as of rows_.
+  void WriteIndex();
+
+  std::string directory_;
+  size_t flush_interval_;
+  std::FILE* columns_[static_cast<size_t>(CandleColumn::COUNT)];
+  std::FILE* symbols_file_;
+  // Store symbol id per SymbolId, kUnmappedSymbol where not yet stored.
+  std::vector<uint32_t> store_ids_;
+  // Column decimals per store symbol id.
+  std::vector<SymbolPrecision> precisions_;
+  std::vector<SymbolIndexEntry> index_;
+  uint64_t rows_;
+  uint64_t committed_rows_;
+};
+
+// Memory-maps every column of a store read-only. Column accessors point
+// straight into the mapping, so replay and random access copy nothing until
+// a row is materialised as a Candle, at the reader's MarketPrecision().
+// Throws std::runtime_error if the store is missing, malformed or from
+// another store version.
+class CandleStoreReader {
+ public:
+  explicit CandleStoreReader(const std::string& directory);
+  ~CandleStoreReader();
+
+  CandleStoreReader(const CandleStoreReader&) = delete;
+  CandleStoreReader& operator=(const CandleStoreReader&) = delete;
+
+  size_t Size() const;
+
+  const int64_t* Timestamps() const;
+  const uint32_t* SymbolIds() const;
+  // Mantissas at StoredPrecision() of the row's symbol.
+  const int64_t* Opens() const;
+  const int64_t* Highs() const;
+  const int64_t* Lows() const;
+  const int64_t* Closes() const;
+  const int64_t* Vwaps() const;
+  const int64_t* Volumes() const;
+  const int32_t* Trades() const;
+  const int32_t* Intervals() const;
+
+  size_t SymbolCount() const;
+  const std::string& SymbolName(uint32_t symbol_id) const;
+  SymbolPrecision StoredPrecision(uint32_t symbol_id) const;
+  const std::vector<SymbolIndexEntry>& Index() const;
+
+  // True if timestamps never decrease, checked once on open. The recorder
+  // appends in arrival order, so a store that saw a reconnect replay older
+  // bars is not sorted; LoadCandlesFromStore plus MergeCandleStreams sorts
+  // one in memory.
+  bool Sorted() const;
+  // First row whose timestamp is >= timestamp, or Size() if none. Binary
+  // search, so it throws std::runtime_error unless Sorted().
+  size_t LowerBound(int64_t timestamp) const;
+
+  // Throws std::runtime_error if a value overflows the reader's scale.
+  Candle ReadCandle(size_t row) const;
+  std::vector<Candle> ReadCandles(size_t begin, size_t end) const;
+
+ private:
+  struct MappedColumn {
+    void* base;
+    size_t length;
+    const char* data;
+  };
+
+  void Open(const std::string& directory);
+  void Unmap();
+
+  template <typename T>
+  const T* Column(CandleColumn column) const {
+    return reinterpret_cast<const T*>(columns_[static_cast<size_t>(column)].data);
+  }
+
+  MappedColumn columns_[static_cast<size_t>(CandleColumn::COUNT)];
+  size_t rows_;
+  bool sorted_;
+  std::vector<std::string> symbols_;
+  std::vector<SymbolPrecision> precisions_;
+  // Registry SymbolId per store symbol id, interned when the store opens.
+  std::vector<SymbolId> registry_ids_;
+  std::vector<SymbolIndexEntry> index_;
+};
+
+#endif
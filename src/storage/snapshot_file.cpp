@@ -0,0 +1,52 @@
+#include "snapshot_file.h"
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <unistd.h>
+
+bool WriteSnapshotFile(const std::string& path, const std::string& bytes) {
+  std::string temporary = path + ".tmp";
+  int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    std::cerr << "Failed to open file: " << temporary << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+
+  size_t offset = 0;
+  while (offset < bytes.size()) {
+    ssize_t written = ::write(fd, bytes.data() + offset, bytes.size() - offset);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    offset += static_cast<size_t>(written);
+  }
+  bool ok = offset == bytes.size() && ::fsync(fd) == 0;
+  ::close(fd);
+
+  if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+    std::cerr << "Failed to write snapshot " << path << ": " << std::strerror(errno) << std::endl;
+    ::unlink(temporary.c_str());
+    return false;
+  }
+
+  // Persist the rename itself.
+  std::string directory = std::filesystem::path(path).parent_path().string();
+  int dir_fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dir_fd >= 0) {
+    ::fsync(dir_fd);
+    ::close(dir_fd);
+  }
+  return true;
+}
+
+bool ReadSnapshotFile(const std::string& path, std::string& bytes) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) return false;
+  bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return !file.bad();
+}
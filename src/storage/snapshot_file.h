@@ -0,0 +1,36 @@
+#ifndef SNAPSHOT_FILE_H
+#define SNAPSHOT_FILE_H
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Snapshots are flat byte strings of raw values in the writing build's
+// layout; each writer puts a magic and version up front and readers reject
+// anything else.
+
+template <typename T>
+void AppendSnapshotValue(std::string& out, const T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Reads one value and advances data; false if fewer than sizeof(T) bytes
+// remain.
+template <typename T>
+bool ReadSnapshotValue(const char*& data, const char* end, T& value) {
+  static_assert(std::is_trivially_copyable<T>::value, "snapshot values must be trivially copyable");
+  if (static_cast<size_t>(end - data) < sizeof(T)) return false;
+  std::memcpy(&value, data, sizeof(T));
+  data += sizeof(T);
+  return true;
+}
+
+// Replaces path with bytes so that a crash leaves either the old file or the
+// new one, never a torn mix: writes a temporary file beside it, fsyncs and
+// renames. Returns false and reports to stderr on failure.
+bool WriteSnapshotFile(const std::string& path, const std::string& bytes);
+// Returns false if the file does not exist or cannot be read.
+bool ReadSnapshotFile(const std::string& path, std::string& bytes);
+
+#endif
@@ -0,0 +1,451 @@
+#include "trade_journal.h"
+#include "../pipeline/thread_affinity.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kSegmentMagic[8] = {'A', 'T', 'J', 'O', 'U', 'R', 'N', 'L'};
+const uint32_t kJournalVersion = 1;
+const size_t kReadBatch = 4096;
+
+// CRC-32C (Castagnoli), which x86 computes in hardware.
+const uint32_t kCrc32cPolynomial = 0x82F63B78u;
+
+std::array<uint32_t, 256> MakeCrcTable() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ kCrc32cPolynomial : crc >> 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+const std::array<uint32_t, 256> kCrcTable = MakeCrcTable();
+
+uint32_t Crc32cTable(const uint8_t* bytes, size_t length, uint32_t crc) {
+  for (size_t i = 0; i < length; i++) {
+    crc = kCrcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2"))) uint32_t Crc32cHardware(const uint8_t* bytes, size_t length, uint32_t crc) {
+  uint64_t wide = crc;
+  for (; length >= sizeof(uint64_t); bytes += sizeof(uint64_t), length -= sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    wide = __builtin_ia32_crc32di(wide, word);
+  }
+  crc = static_cast<uint32_t>(wide);
+  for (; length > 0; bytes++, length--) {
+    crc = __builtin_ia32_crc32qi(crc, *bytes);
+  }
+  return crc;
+}
+
+const bool kHardwareCrc = __builtin_cpu_supports("sse4.2");
+#endif
+
+std::string SegmentPath(const std::string& directory, uint64_t number) {
+  char file_name[32];
+  std::snprintf(file_name, sizeof(file_name), "segment-%06llu.tj", static_cast<unsigned long long>(number));
+  return (std::filesystem::path(directory) / file_name).string();
+}
+
+// Segment numbers present in directory, ascending.
+std::vector<uint64_t> ListSegments(const std::string& directory) {
+  std::vector<uint64_t> numbers;
+  std::error_code error;
+  for (const auto& item : std::filesystem::directory_iterator(directory, error)) {
+    unsigned long long number = 0;
+    char suffix[4] = {0};
+    std::string name = item.path().filename().string();
+    if (std::sscanf(name.c_str(), "segment-%llu.%3s", &number, suffix) == 2 &&
+        std::strcmp(suffix, "tj") == 0 && number > 0) {
+      numbers.push_back(number);
+    }
+  }
+  std::sort(numbers.begin(), numbers.end());
+  return numbers;
+}
+
+bool ValidEntry(const JournalEntry& entry, uint64_t expected_sequence) {
+  return entry.sequence == expected_sequence && entry.length <= sizeof(entry.payload) &&
+         entry.checksum == JournalChecksum(entry.payload, entry.length);
+}
+
+int64_t EpochNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}  // namespace
+
+uint32_t JournalChecksum(const void* data, size_t length) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+#if defined(__x86_64__)
+  if (kHardwareCrc) {
+    return Crc32cHardware(bytes, length, 0xFFFFFFFFu) ^ 0xFFFFFFFFu;
+  }
+#endif
+  return Crc32cTable(bytes, length, 0xFFFFFFFFu) ^ 0xFFFFFFFFu;
+}
+
+void CopyJournalString(char* field, size_t size, std::string_view value) {
+  size_t length = std::min(value.size(), size - 1);
+  std::memcpy(field, value.data(), length);
+  std::memset(field + length, 0, size - length);
+}
+
+TradeJournal::TradeJournal(const std::string& directory, const JournalConfig& config)
+    : directory_(directory),
+      config_(config),
+      current_(nullptr),
+      write_index_(0),
+      next_sequence_(1),
+      committed_(0),
+      next_(nullptr),
+      preparing_next_(false),
+      synced_segment_(0),
+      synced_entries_(0),
+      synced_sequence_(0),
+      sync_requested_(false),
+      closing_(false) {
+  if (config_.entries_per_segment < 2) {
+    throw std::invalid_argument("Journal segments need at least two entries");
+  }
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    throw std::runtime_error("Failed to create journal directory " + directory_ + ": " + error.message());
+  }
+
+  Recover();
+  flusher_ = std::thread(&TradeJournal::FlusherLoop, this);
+}
+
+TradeJournal::~TradeJournal() {
+  Close();
+}
+
+TradeJournal::Segment* TradeJournal::OpenSegment(uint64_t number, uint64_t first_sequence, bool create) {
+  std::string path = SegmentPath(directory_, number);
+  size_t length = sizeof(JournalSegmentHeader) + config_.entries_per_segment * sizeof(JournalEntry);
+
+  int fd = ::open(path.c_str(), create ? (O_RDWR | O_CREAT | O_EXCL) : O_RDWR, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open journal segment " + path + ": " + std::strerror(errno));
+  }
+
+  if (create) {
+    // Reserve the blocks up front so a full disk fails here rather than as
+    // SIGBUS on a hot-path store.
+    int result = ::posix_fallocate(fd, 0, static_cast<off_t>(length));
+    if (result == EOPNOTSUPP || result == EINVAL) {
+      result = ::ftruncate(fd, static_cast<off_t>(length)) == 0 ? 0 : errno;
+    }
+    if (result != 0) {
+      ::close(fd);
+      ::unlink(path.c_str());
+      throw std::runtime_error("Failed to size journal segment " + path + ": " + std::strerror(result));
+    }
+  } else {
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(JournalSegmentHeader)) {
+      ::close(fd);
+      throw std::runtime_error("Corrupt journal segment: " + path);
+    }
+    length = static_cast<size_t>(info.st_size);
+  }
+
+  // Prefault new segments so the writer never takes a page fault into them.
+  int flags = MAP_SHARED | (create ? MAP_POPULATE : 0);
+  void* base = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    throw std::runtime_error("Failed to map journal segment: " + path);
+  }
+
+  JournalSegmentHeader* header = static_cast<JournalSegmentHeader*>(base);
+  if (create) {
+    std::memset(header, 0, sizeof(*header));
+    std::memcpy(header->magic, kSegmentMagic, sizeof(header->magic));
+    header->version = kJournalVersion;
+    header->entry_size = sizeof(JournalEntry);
+    header->segment_number = number;
+    header->capacity = config_.entries_per_segment;
+    header->first_sequence = first_sequence;
+    ::msync(base, sizeof(*header), MS_SYNC);
+  } else if (std::memcmp(header->magic, kSegmentMagic, sizeof(header->magic)) != 0 ||
+             header->entry_size != sizeof(JournalEntry) ||
+             sizeof(JournalSegmentHeader) + header->capacity * sizeof(JournalEntry) > length) {
+    ::munmap(base, length);
+    throw std::runtime_error("Corrupt journal segment: " + path);
+  }
+
+  Segment* segment = new Segment;
+  segment->number = number;
+  segment->first_sequence = header->first_sequence;
+  segment->base = base;
+  segment->length = length;
+  segment->entries = reinterpret_cast<JournalEntry*>(static_cast<char*>(base) + sizeof(JournalSegmentHeader));
+  segment->capacity = header->capacity;
+  return segment;
+}
+
+void TradeJournal::Recover() {
+  std::vector<uint64_t> numbers = ListSegments(directory_);
+
+  // A crash can leave a pre-created segment that was never written to;
+  // drop those so sequences continue from the last real entry.
+  while (!numbers.empty()) {
+    Segment* segment = OpenSegment(numbers.back(), 0, false);
+    size_t count = 0;
+    while (count < segment->capacity && ValidEntry(segment->entries[count], segment->first_sequence + count)) {
+      count++;
+    }
+
+    if (count == 0 && numbers.size() > 1) {
+      UnmapSegment(segment);
+      ::unlink(SegmentPath(directory_, numbers.back()).c_str());
+      numbers.pop_back();
+      continue;
+    }
+
+    // Clear anything past the tear so a later crash cannot resurrect it.
+    for (size_t i = count; i < segment->capacity; i++) {
+      if (segment->entries[i].sequence != 0) segment->entries[i].sequence = 0;
+    }
+
+    current_ = segment;
+    write_index_ = count;
+    next_sequence_ = segment->first_sequence + count;
+    break;
+  }
+
+  if (!current_) {
+    current_ = OpenSegment(1, 1, true);
+  }
+  committed_.store(write_index_, std::memory_order_release);
+  synced_segment_ = current_->number;
+  synced_entries_ = 0;
+  synced_sequence_ = next_sequence_ - 1;
+}
+
+uint64_t TradeJournal::Append(JournalEntryType type, const void* record, size_t length) {
+  if (length > sizeof(JournalEntry::payload)) {
+    throw std::length_error("Journal record too large");
+  }
+  if (!current_) return 0;
+  if (write_index_ == current_->capacity) {
+    Rotate();
+  }
+
+  JournalEntry& entry = current_->entries[write_index_];
+  uint64_t sequence = next_sequence_;
+  std::memcpy(entry.payload, record, length);
+  entry.written_ns = EpochNanos();
+  entry.checksum = JournalChecksum(entry.payload, length);
+  entry.type = static_cast<uint16_t>(type);
+  entry.length = static_cast<uint16_t>(length);
+  std::atomic_thread_fence(std::memory_order_release);
+  entry.sequence = sequence;
+
+  write_index_++;
+  next_sequence_++;
+  committed_.store(write_index_, std::memory_order_release);
+  return sequence;
+}
+
+void TradeJournal::Rotate() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return !preparing_next_; });
+  if (!next_) {
+    // The flusher fell behind; pay for the segment here rather than block.
+    next_ = OpenSegment(current_->number + 1, current_->first_sequence + current_->capacity, true);
+  }
+  retired_.push_back(current_);
+  current_ = next_;
+  next_ = nullptr;
+  write_index_ = 0;
+  committed_.store(0, std::memory_order_release);
+  wake_.notify_one();
+}
+
+void TradeJournal::Sync() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!current_) return;
+  uint64_t target = next_sequence_ - 1;
+  sync_requested_ = true;
+  wake_.notify_one();
+  done_.wait(lock, [this, target] { return synced_sequence_ >= target || closing_; });
+}
+
+void TradeJournal::Close() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!current_) return;
+    closing_ = true;
+  }
+  wake_.notify_one();
+  if (flusher_.joinable()) {
+    flusher_.join();
+  }
+
+  // The flusher synced and unmapped everything retired before it exited.
+  UnmapSegment(current_);
+  current_ = nullptr;
+  if (next_) {
+    std::string path = SegmentPath(directory_, next_->number);
+    UnmapSegment(next_);
+    ::unlink(path.c_str());
+    next_ = nullptr;
+  }
+}
+
+uint64_t TradeJournal::LastSequence() const {
+  return next_sequence_ - 1;
+}
+
+void TradeJournal::FlusherLoop() {
+  SetCurrentThreadName("journal-sync");
+  const auto interval = std::chrono::milliseconds(std::max(1, config_.sync_interval_ms));
+
+  while (true) {
+    bool closing;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait_for(lock, interval, [this] { return sync_requested_ || closing_ || !retired_.empty(); });
+      closing = closing_;
+      sync_requested_ = false;
+    }
+    FlushOnce();
+    if (closing) break;
+    PrepareNextSegment();
+  }
+}
+
+void TradeJournal::FlushOnce() {
+  std::vector<Segment*> retired;
+  Segment* segment;
+  size_t committed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired.swap(retired_);
+    segment = current_;
+    committed = committed_.load(std::memory_order_acquire);
+  }
+
+  for (Segment* old : retired) {
+    size_t begin = old->number == synced_segment_ ? synced_entries_ : 0;
+    SyncRange(old, begin, old->capacity);
+    UnmapSegment(old);
+  }
+
+  if (segment->number != synced_segment_) {
+    synced_segment_ = segment->number;
+    synced_entries_ = 0;
+  }
+  if (committed > synced_entries_) {
+    SyncRange(segment, synced_entries_, committed);
+    synced_entries_ = committed;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    synced_sequence_ = segment->first_sequence + committed - 1;
+  }
+  done_.notify_all();
+}
+
+void TradeJournal::PrepareNextSegment() {
+  uint64_t number;
+  uint64_t first_sequence;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (next_ || committed_.load(std::memory_order_relaxed) < current_->capacity / 2) return;
+    preparing_next_ = true;
+    number = current_->number + 1;
+    first_sequence = current_->first_sequence + current_->capacity;
+  }
+
+  Segment* segment = nullptr;
+  try {
+    segment = OpenSegment(number, first_sequence, true);
+  } catch (const std::exception& e) {
+    // Rotate() retries and reports the failure on the writer thread.
+    std::fprintf(stderr, "%s\n", e.what());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    next_ = segment;
+    preparing_next_ = false;
+  }
+  done_.notify_all();
+}
+
+void TradeJournal::SyncRange(Segment* segment, size_t begin, size_t end) {
+  static const size_t page_size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  size_t first = sizeof(JournalSegmentHeader) + begin * sizeof(JournalEntry);
+  size_t last = sizeof(JournalSegmentHeader) + end * sizeof(JournalEntry);
+  first -= first % page_size;
+  ::msync(static_cast<char*>(segment->base) + first, last - first, MS_SYNC);
+}
+
+void TradeJournal::UnmapSegment(Segment* segment) {
+  ::munmap(segment->base, segment->length);
+  delete segment;
+}
+
+bool ReadJournal(const std::string& directory, const std::function<void(const JournalEntry&)>& callback) {
+  std::vector<uint64_t> numbers = ListSegments(directory);
+  if (numbers.empty()) return false;
+
+  std::vector<JournalEntry> batch(kReadBatch);
+  for (uint64_t number : numbers) {
+    std::ifstream file(SegmentPath(directory, number), std::ios::binary);
+    JournalSegmentHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, kSegmentMagic, sizeof(header.magic)) != 0 ||
+        header.entry_size != sizeof(JournalEntry)) {
+      throw std::runtime_error("Corrupt journal segment: " + SegmentPath(directory, number));
+    }
+
+    uint64_t expected = header.first_sequence;
+    uint64_t remaining = header.capacity;
+    bool intact = true;
+    while (intact && remaining > 0) {
+      size_t wanted = static_cast<size_t>(std::min<uint64_t>(remaining, batch.size()));
+      file.read(reinterpret_cast<char*>(batch.data()), wanted * sizeof(JournalEntry));
+      size_t count = static_cast<size_t>(file.gcount()) / sizeof(JournalEntry);
+      for (size_t i = 0; i < count; i++) {
+        if (!ValidEntry(batch[i], expected)) {
+          intact = false;
+          break;
+        }
+        callback(batch[i]);
+        expected++;
+      }
+      if (count < wanted) break;
+      remaining -= count;
+    }
+  }
+  return true;
+}
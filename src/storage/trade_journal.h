@@ -0,0 +1,183 @@
+#ifndef TRADE_JOURNAL_H
+#define TRADE_JOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A journal is a directory of pre-sized segment files,
+//   segment-000001.tj, segment-000002.tj, ...
+// each a JournalSegmentHeader followed by entries_per_segment fixed-size
+// JournalEntry slots. An entry's sequence is stored last; a slot whose
+// sequence is 0 or whose checksum does not match its payload was never
+// completely written and marks the end of the journal.
+
+enum class JournalEntryType : uint16_t {
+  TRADE = 1,
+  ORDER = 2
+};
+
+struct alignas(64) JournalEntry {
+  // 1-based and contiguous across segments; written last.
+  uint64_t sequence;
+  // Wall clock at append, nanoseconds since the epoch.
+  int64_t written_ns;
+  // CRC-32C of the first length payload bytes.
+  uint32_t checksum;
+  uint16_t type;
+  uint16_t length;
+  uint8_t payload[104];
+};
+
+struct JournalSegmentHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t entry_size;
+  uint64_t segment_number;
+  uint64_t capacity;
+  uint64_t first_sequence;
+  uint8_t reserved[24];
+};
+
+static_assert(sizeof(JournalEntry) == 128, "journal entries must stay 128 bytes");
+static_assert(sizeof(JournalSegmentHeader) == 64, "segment header must stay 64 bytes");
+
+// Journaled records carry symbol names rather than SymbolIds, which are
+// only meaningful inside the process that assigned them.
+struct TradeJournalRecord {
+  int64_t timestamp;
+  double y_price;
+  double x_price;
+  double hedge_ratio;
+  double z_score;
+  double pnl;
+  char y_symbol[16];
+  char x_symbol[16];
+  uint8_t action;
+};
+
+// Order acknowledgement; enums are stored as their raw values.
+struct OrderJournalRecord {
+  uint64_t req_id;
+  int64_t sent_ns;
+  int64_t ack_ns;
+  double quantity;
+  double limit_price;
+  char symbol[16];
+  char order_id[40];
+  uint8_t state;
+  uint8_t side;
+  uint8_t order_type;
+  uint8_t success;
+};
+
+static_assert(sizeof(TradeJournalRecord) <= sizeof(JournalEntry::payload), "trade record must fit an entry");
+static_assert(sizeof(OrderJournalRecord) <= sizeof(JournalEntry::payload), "order record must fit an entry");
+
+// Copies value into a fixed field, truncating and always NUL-terminating.
+void CopyJournalString(char* field, size_t size, std::string_view value);
+
+struct JournalConfig {
+  size_t entries_per_segment = 65536;
+  // How often the flusher msyncs what has been appended.
+  int sync_interval_ms = 100;
+};
+
+// Append-only journal for one writer thread. Append() copies the record
+// into the mapped segment and publishes it with a single store, with no
+// syscall: a background thread msyncs new entries every sync_interval_ms,
+// maps the next segment before the current one fills, and unmaps segments
+// once they are full and synced. Memory use is at most two mapped segments
+// however long the run.
+//
+// A process crash loses nothing that Append() returned from, since the
+// mapping is shared with the page cache; a power loss can lose at most the
+// last sync interval. Reopening a journal continues after its last intact
+// entry.
+class TradeJournal {
+ public:
+  explicit TradeJournal(const std::string& directory, const JournalConfig& config = JournalConfig());
+  ~TradeJournal();
+
+  TradeJournal(const TradeJournal&) = delete;
+  TradeJournal& operator=(const TradeJournal&) = delete;
+
+  // Returns the entry's sequence. Records longer than the payload are
+  // rejected with std::length_error.
+  uint64_t Append(JournalEntryType type, const void* record, size_t length);
+
+  template <typename T>
+  uint64_t Append(JournalEntryType type, const T& record) {
+    static_assert(std::is_trivially_copyable<T>::value, "journal records must be trivially copyable");
+    return Append(type, &record, sizeof(T));
+  }
+
+  // Blocks until everything appended so far has been msynced.
+  void Sync();
+  // Syncs, unmaps and joins the flusher. Safe to call twice.
+  void Close();
+
+  uint64_t LastSequence() const;
+
+ private:
+  struct Segment {
+    uint64_t number;
+    uint64_t first_sequence;
+    void* base;
+    size_t length;
+    JournalEntry* entries;
+    size_t capacity;
+  };
+
+  Segment* OpenSegment(uint64_t number, uint64_t first_sequence, bool create);
+  void Recover();
+  void Rotate();
+  void FlusherLoop();
+  // Syncs retired segments and the committed part of the current one, then
+  // unmaps the retired ones. Flusher thread only.
+  void FlushOnce();
+  void PrepareNextSegment();
+  static void SyncRange(Segment* segment, size_t begin, size_t end);
+  static void UnmapSegment(Segment* segment);
+
+  std::string directory_;
+  JournalConfig config_;
+
+  // Writer state.
+  Segment* current_;
+  size_t write_index_;
+  uint64_t next_sequence_;
+
+  // Entries of current_ published by the writer.
+  std::atomic<size_t> committed_;
+
+  // Guards current_ swaps, next_, retired_ and the sync bookkeeping.
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  Segment* next_;
+  bool preparing_next_;
+  std::vector<Segment*> retired_;
+  uint64_t synced_segment_;
+  size_t synced_entries_;
+  uint64_t synced_sequence_;
+  bool sync_requested_;
+  bool closing_;
+  std::thread flusher_;
+};
+
+// Reads every intact entry of a journal directory in sequence order.
+// Returns false if the directory holds no segments.
+bool ReadJournal(const std::string& directory, const std::function<void(const JournalEntry&)>& callback);
+
+uint32_t JournalChecksum(const void* data, size_t length);
+
+#endif
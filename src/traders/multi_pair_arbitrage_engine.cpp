@@ -0,0 +1,304 @@
+#include "multi_pair_arbitrage_engine.h"
+#include "../market_data/timestamp.h"
+#include "../logging/async_logger.h"
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const char* SignalName(Signal signal) {
+    return signal == Signal::LONG_SPREAD ? "LONG_SPREAD"
+           : signal == Signal::SHORT_SPREAD ? "SHORT_SPREAD" : "EXIT";
+}
+
+}  // namespace
+
+MultiPairArbitrageEngine::MultiPairArbitrageEngine(size_t lookback, double z_entry, double z_exit,
+                                                   HedgeRatioMode hedge_ratio_mode)
+    : lookback_(lookback), z_entry_(z_entry), z_exit_(z_exit),
+      hedge_ratio_mode_(hedge_ratio_mode), verbose_(false),
+      bar_time_(std::numeric_limits<int64_t>::min()), bar_open_(false),
+      trade_log_capacity_(0), trade_log_next_(0), trade_count_(0) {}
+
+SymbolId MultiPairArbitrageEngine::AddSymbol(const std::string& symbol) {
+    SymbolId id = SymbolRegistry::Global().Intern(symbol);
+    if (id == kInvalidSymbol) {
+        throw std::runtime_error("Symbol registry is full");
+    }
+
+    if (id >= in_universe_.size()) {
+        size_t slots = static_cast<size_t>(id) + 1;
+        in_universe_.resize(slots, 0);
+        latest_prices_.resize(slots, 0);
+        has_price_.resize(slots, 0);
+        pairs_by_symbol_.resize(slots);
+        price_windows_.resize(slots, RingBuffer<double>(1));
+    }
+
+    if (!in_universe_[id]) {
+        in_universe_[id] = 1;
+        symbols_.push_back(id);
+        // KALMAN keeps no window; it only reads the newest close.
+        price_windows_[id] = RingBuffer<double>(hedge_ratio_mode_ == HedgeRatioMode::KALMAN ? 1 : lookback_ + 1);
+    }
+    return id;
+}
+
+uint32_t MultiPairArbitrageEngine::AddPair(const std::string& y_symbol, const std::string& x_symbol) {
+    if (y_symbol == x_symbol) {
+        throw std::invalid_argument("Pair legs must differ: " + y_symbol);
+    }
+
+    SymbolId y = AddSymbol(y_symbol);
+    SymbolId x = AddSymbol(x_symbol);
+    if (HasPair(y, x)) {
+        throw std::invalid_argument("Pair already registered: " + y_symbol + " / " + x_symbol);
+    }
+    uint32_t pair = static_cast<uint32_t>(pairs_.size());
+
+    pairs_.push_back(PairState{y, x, Position::NONE, 0, 0, 0.0, 0.0});
+    models_.emplace_back(lookback_, z_entry_, z_exit_, hedge_ratio_mode_, PriceWindows::SHARED);
+    models_.back().SetVerbose(verbose_);
+
+    pairs_by_symbol_[y].push_back(pair);
+    pairs_by_symbol_[x].push_back(pair);
+    return pair;
+}
+
+size_t MultiPairArbitrageEngine::AddScreenedPairs(const std::vector<PairScore>& ranked, size_t max_pairs) {
+    size_t added = 0;
+    for (const auto& score : ranked) {
+        if (added >= max_pairs) break;
+        if (!score.cointegrated) continue;
+
+        // A screened pair may repeat one given explicitly.
+        SymbolId y = SymbolRegistry::Global().Find(score.y_name);
+        SymbolId x = SymbolRegistry::Global().Find(score.x_name);
+        if (y != kInvalidSymbol && x != kInvalidSymbol && HasPair(y, x)) continue;
+
+        AddPair(score.y_name, score.x_name);
+        added++;
+    }
+    return added;
+}
+
+bool MultiPairArbitrageEngine::HasPair(SymbolId a, SymbolId b) const {
+    if (a >= pairs_by_symbol_.size()) return false;
+    for (uint32_t pair : pairs_by_symbol_[a]) {
+        const PairState& state = pairs_[pair];
+        if (state.y_symbol == b || state.x_symbol == b) return true;
+    }
+    return false;
+}
+
+void MultiPairArbitrageEngine::OnCandle(const Candle& candle) {
+    SymbolId id = candle.symbol;
+    if (id >= in_universe_.size() || !in_universe_[id]) return;
+    if (candle.interval_begin < bar_time_) return;
+
+    if (candle.interval_begin > bar_time_) {
+        CloseBar();
+        bar_time_ = candle.interval_begin;
+    }
+    bar_open_ = true;
+    latest_prices_[id] = candle.close;
+    has_price_[id] = 1;
+}
+
+void MultiPairArbitrageEngine::CloseBar() {
+    if (!bar_open_) return;
+    bar_open_ = false;
+
+    for (SymbolId symbol : symbols_) {
+        if (has_price_[symbol]) {
+            price_windows_[symbol].push_back(PriceDecimal(symbol, latest_prices_[symbol]).ToDouble());
+        }
+    }
+    for (uint32_t pair = 0; pair < pairs_.size(); pair++) {
+        UpdatePair(pair, bar_time_);
+    }
+}
+
+void MultiPairArbitrageEngine::UpdatePair(uint32_t pair, int64_t timestamp) {
+    PairState& state = pairs_[pair];
+    if (!has_price_[state.y_symbol] || !has_price_[state.x_symbol]) return;
+
+    int64_t y_price = latest_prices_[state.y_symbol];
+    int64_t x_price = latest_prices_[state.x_symbol];
+    StatisticalArbitrageModel& model = models_[pair];
+
+    Signal signal = model.GenerateSignal(price_windows_[state.y_symbol], price_windows_[state.x_symbol]);
+    if (signal == Signal::NONE) return;
+
+    if (signal == Signal::EXIT) {
+        state.realized_pnl += PairPnL(state);
+        state.position = Position::NONE;
+    } else {
+        state.position = signal == Signal::LONG_SPREAD ? Position::LONG_SPREAD : Position::SHORT_SPREAD;
+        state.entry_y_price = y_price;
+        state.entry_x_price = x_price;
+        state.entry_hedge_ratio = model.GetCurrentHedgeRatio();
+    }
+
+    PairTrade trade;
+    trade.timestamp = timestamp;
+    trade.pair = pair;
+    trade.signal = signal;
+    trade.y_price = PriceDecimal(state.y_symbol, y_price);
+    trade.x_price = PriceDecimal(state.x_symbol, x_price);
+    trade.hedge_ratio = model.GetCurrentHedgeRatio();
+    trade.z_score = model.GetCurrentZScore();
+    trade.pnl = state.realized_pnl;
+    if (trade_log_capacity_ == 0 || trade_log_.size() < trade_log_capacity_) {
+        trade_log_.push_back(trade);
+    } else {
+        trade_log_[trade_log_next_] = trade;
+        trade_log_next_ = (trade_log_next_ + 1) % trade_log_capacity_;
+    }
+    trade_count_++;
+
+    if (verbose_) {
+        const SymbolRegistry& symbols = SymbolRegistry::Global();
+        ASYNC_LOG("SIGNAL {} / {} {} | Z: {} | Hedge: {}", symbols.Name(state.y_symbol), symbols.Name(state.x_symbol),
+                  SignalName(signal), trade.z_score, trade.hedge_ratio);
+    }
+
+    if (signal_callback_) {
+        signal_callback_(trade);
+    }
+}
+
+double MultiPairArbitrageEngine::PairPnL(const PairState& state) const {
+    if (state.position == Position::NONE) return 0.0;
+
+    double y_move = PriceDecimal(state.y_symbol, latest_prices_[state.y_symbol] - state.entry_y_price).ToDouble();
+    double x_move = PriceDecimal(state.x_symbol, latest_prices_[state.x_symbol] - state.entry_x_price).ToDouble();
+    double spread_move = y_move - state.entry_hedge_ratio * x_move;
+
+    return state.position == Position::LONG_SPREAD ? spread_move : -spread_move;
+}
+
+void MultiPairArbitrageEngine::SetSignalCallback(std::function<void(const PairTrade&)> callback) {
+    signal_callback_ = callback;
+}
+
+void MultiPairArbitrageEngine::SetVerbose(bool verbose) {
+    verbose_ = verbose;
+    for (auto& model : models_) {
+        model.SetVerbose(verbose);
+    }
+}
+
+void MultiPairArbitrageEngine::SetTradeLogCapacity(size_t capacity) {
+    std::vector<PairTrade> recent = RecentTrades();
+    if (capacity > 0 && recent.size() > capacity) {
+        recent.erase(recent.begin(), recent.end() - static_cast<std::ptrdiff_t>(capacity));
+    }
+    trade_log_ = std::move(recent);
+    trade_log_.reserve(capacity);
+    trade_log_capacity_ = capacity;
+    trade_log_next_ = 0;
+}
+
+size_t MultiPairArbitrageEngine::SymbolCount() const {
+    return symbols_.size();
+}
+
+size_t MultiPairArbitrageEngine::PairCount() const {
+    return pairs_.size();
+}
+
+const std::string& MultiPairArbitrageEngine::SymbolName(SymbolId symbol) const {
+    return SymbolRegistry::Global().Name(symbol);
+}
+
+const std::string& MultiPairArbitrageEngine::PairYSymbol(uint32_t pair) const {
+    return SymbolRegistry::Global().Name(pairs_.at(pair).y_symbol);
+}
+
+const std::string& MultiPairArbitrageEngine::PairXSymbol(uint32_t pair) const {
+    return SymbolRegistry::Global().Name(pairs_.at(pair).x_symbol);
+}
+
+const StatisticalArbitrageModel& MultiPairArbitrageEngine::PairModel(uint32_t pair) const {
+    return models_.at(pair);
+}
+
+double MultiPairArbitrageEngine::GetRealizedPnL() const {
+    double pnl = 0.0;
+    for (const auto& state : pairs_) {
+        pnl += state.realized_pnl;
+    }
+    return pnl;
+}
+
+double MultiPairArbitrageEngine::GetEquity() const {
+    double equity = 0.0;
+    for (const auto& state : pairs_) {
+        equity += state.realized_pnl + PairPnL(state);
+    }
+    return equity;
+}
+
+uint64_t MultiPairArbitrageEngine::TradeCount() const {
+    return trade_count_;
+}
+
+std::vector<PairTrade> MultiPairArbitrageEngine::RecentTrades() const {
+    if (trade_log_capacity_ == 0 || trade_log_.size() < trade_log_capacity_) {
+        return trade_log_;
+    }
+    // Full ring: the oldest trade sits where the next one will be written.
+    size_t oldest = trade_log_next_;
+    std::vector<PairTrade> trades(trade_log_.begin() + static_cast<std::ptrdiff_t>(oldest), trade_log_.end());
+    trades.insert(trades.end(), trade_log_.begin(), trade_log_.begin() + static_cast<std::ptrdiff_t>(oldest));
+    return trades;
+}
+
+void MultiPairArbitrageEngine::SaveTradesToCSV(const std::string& filename) const {
+    std::ofstream file(filename);
+
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file: " << filename << std::endl;
+        return;
+    }
+
+    file << "timestamp,action,y_symbol,x_symbol,y_price,x_price,hedge_ratio,z_score,pnl\n";
+
+    for (const auto& trade : RecentTrades()) {
+        file << FormatTimestampNanos(trade.timestamp) << ","
+             << SignalName(trade.signal) << ","
+             << PairYSymbol(trade.pair) << ","
+             << PairXSymbol(trade.pair) << ","
+             << ToString(trade.y_price) << ","
+             << ToString(trade.x_price) << ","
+             << std::fixed << std::setprecision(4) << trade.hedge_ratio << ","
+             << std::setprecision(3) << trade.z_score << ","
+             << std::setprecision(2) << trade.pnl << "\n";
+    }
+
+    file.close();
+    std::cout << "Trades saved to " << filename << std::endl;
+}
+
+bool ParsePairList(const std::string& text, std::vector<std::pair<std::string, std::string>>& pairs) {
+    std::stringstream list(text);
+    for (std::string item; std::getline(list, item, ',');) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        std::string y = item.substr(0, colon);
+        std::string x = item.substr(colon + 1);
+        if (y.empty() || x.empty() || y == x) return false;
+        for (const auto& listed : pairs) {
+            if ((listed.first == y && listed.second == x) || (listed.first == x && listed.second == y)) {
+                return false;
+            }
+        }
+        pairs.emplace_back(y, x);
+    }
+    return !pairs.empty();
+}
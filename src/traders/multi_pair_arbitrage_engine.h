@@ -0,0 +1,135 @@
+#ifndef MULTI_PAIR_ARBITRAGE_ENGINE_H
+#define MULTI_PAIR_ARBITRAGE_ENGINE_H
+
+#include "../models/statistical_arbitrage_model.h"
+#include "../models/pair_screener.h"
+#include "../market_data/candle.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct PairTrade {
+    // Bar open time of the triggering candle, nanoseconds since the epoch.
+    int64_t timestamp;
+    uint32_t pair;
+    Signal signal;
+    Decimal y_price;
+    Decimal x_price;
+    double hedge_ratio;
+    double z_score;
+    double pnl;
+};
+
+// Runs one StatisticalArbitrageModel per pair over a shared symbol universe.
+// Each symbol keeps one price window, a ring of one close per bar, and
+// every pair model reads its legs' windows from there, so a symbol that is
+// a leg of many pairs still holds its history once. A bar closes when the
+// first candle of a later bar arrives (or on CloseBar()): every symbol's
+// window takes its latest close, carried forward if it did not trade, and
+// each pair with both legs priced updates once.
+//
+// Candles older than the open bar, e.g. a reconnect replay, are ignored.
+class MultiPairArbitrageEngine {
+private:
+    // Per-pair trading state kept apart from the model windows so a scan over
+    // positions stays within a few cache lines per pair.
+    struct PairState {
+        SymbolId y_symbol;
+        SymbolId x_symbol;
+        Position position;
+        // Mantissas at the legs' MarketPrecision(), like Candle's.
+        int64_t entry_y_price;
+        int64_t entry_x_price;
+        double entry_hedge_ratio;
+        double realized_pnl;
+    };
+
+    size_t lookback_;
+    double z_entry_;
+    double z_exit_;
+    HedgeRatioMode hedge_ratio_mode_;
+    bool verbose_;
+
+    // Symbol universe, structure of arrays indexed by SymbolId. Slots for
+    // registry ids outside the universe stay empty.
+    std::vector<SymbolId> symbols_;
+    std::vector<uint8_t> in_universe_;
+    // Close mantissas, like Candle's.
+    std::vector<int64_t> latest_prices_;
+    std::vector<uint8_t> has_price_;
+    std::vector<std::vector<uint32_t>> pairs_by_symbol_;
+    // lookback + 1 closes per symbol as the models' doubles, so a pair
+    // model can still read the bar leaving its window.
+    std::vector<RingBuffer<double>> price_windows_;
+
+    // interval_begin of the open bar; nothing is open before the first
+    // candle or after CloseBar().
+    int64_t bar_time_;
+    bool bar_open_;
+
+    // Pairs, parallel arrays indexed by pair id.
+    std::vector<PairState> pairs_;
+    std::vector<StatisticalArbitrageModel> models_;
+
+    // Most recent trades; a ring once trade_log_capacity_ is reached.
+    std::vector<PairTrade> trade_log_;
+    size_t trade_log_capacity_;
+    size_t trade_log_next_;
+    uint64_t trade_count_;
+    std::function<void(const PairTrade&)> signal_callback_;
+
+    bool HasPair(SymbolId a, SymbolId b) const;
+    void UpdatePair(uint32_t pair, int64_t timestamp);
+    double PairPnL(const PairState& state) const;
+
+public:
+    MultiPairArbitrageEngine(size_t lookback = 100, double z_entry = 2.0, double z_exit = 0.5,
+                             HedgeRatioMode hedge_ratio_mode = HedgeRatioMode::INCREMENTAL_OLS);
+
+    // Interns symbol and adds it to the universe; returns its SymbolId.
+    SymbolId AddSymbol(const std::string& symbol);
+    // Adds a pair trading y against x and returns its id. Throws
+    // std::invalid_argument if the legs are equal or the pair is already
+    // registered, in either orientation.
+    uint32_t AddPair(const std::string& y_symbol, const std::string& x_symbol);
+    // Adds up to max_pairs cointegrated pairs from a PairScreener ranking,
+    // keeping the screener's leg orientation and skipping pairs already
+    // registered. Returns the number added.
+    size_t AddScreenedPairs(const std::vector<PairScore>& ranked, size_t max_pairs);
+
+    // Allocation-free except when a signal appends to the trade log.
+    void OnCandle(const Candle& candle);
+    // Closes the open bar now, e.g. at the end of a replay.
+    void CloseBar();
+
+    void SetSignalCallback(std::function<void(const PairTrade&)> callback);
+    void SetVerbose(bool verbose);
+    // Keeps at most capacity trades in memory, so long runs stay flat;
+    // 0 (the default) keeps every trade.
+    void SetTradeLogCapacity(size_t capacity);
+
+    size_t SymbolCount() const;
+    size_t PairCount() const;
+    const std::string& SymbolName(SymbolId symbol) const;
+    const std::string& PairYSymbol(uint32_t pair) const;
+    const std::string& PairXSymbol(uint32_t pair) const;
+    const StatisticalArbitrageModel& PairModel(uint32_t pair) const;
+
+    double GetRealizedPnL() const;
+    double GetEquity() const;
+    // Trades since construction, including ones no longer held in memory.
+    uint64_t TradeCount() const;
+    // The trades still held in memory, oldest first.
+    std::vector<PairTrade> RecentTrades() const;
+    // Writes RecentTrades() as CSV, one row per signal with its pair's legs.
+    void SaveTradesToCSV(const std::string& filename) const;
+};
+
+// Parses "Y:X[,Y:X...]", e.g. BTC/USD:ETH/USD,SOL/USD:ETH/USD, since the
+// symbols themselves contain '/'. False on an empty list, a missing leg, a
+// pair of one symbol with itself or a pair listed twice in either order.
+bool ParsePairList(const std::string& text, std::vector<std::pair<std::string, std::string>>& pairs);
+
+#endif
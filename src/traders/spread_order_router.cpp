@@ -0,0 +1,162 @@
+#include "spread_order_router.h"
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+OrderSide Opposite(OrderSide side) {
+    return side == OrderSide::BUY ? OrderSide::SELL : OrderSide::BUY;
+}
+
+// Rounds quantity down to the pair's lot, so a leg never trades more than
+// the model asked for. False if nothing is left to trade.
+bool MarketOrder(SymbolId symbol, OrderSide side, double quantity, OrderRequest& order) {
+    int qty_decimals = MarketPrecision(symbol).qty_decimals;
+    order.symbol = symbol;
+    order.side = side;
+    order.type = OrderType::MARKET;
+    order.limit_price = Decimal{0, 0};
+    return DecimalFromDouble(quantity, qty_decimals, order.quantity, Rounding::DOWN) &&
+           order.quantity.mantissa > 0;
+}
+
+OrderRequest UnwindOrder(const OrderRequest& entry) {
+    OrderRequest order = entry;
+    order.side = Opposite(entry.side);
+    return order;
+}
+
+}  // namespace
+
+SpreadOrderRouter::SpreadOrderRouter(KrakenOrderGateway& gateway, double y_quantity)
+    : gateway_(gateway), y_quantity_(y_quantity), legs_() {
+    for (Leg& leg : legs_) {
+        leg.req_id = 0;
+        leg.state = LegState::FLAT;
+        leg.exit_requested = false;
+    }
+}
+
+void SpreadOrderRouter::OnTrade(const Trade& trade) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Leg& y_leg = legs_[0];
+    Leg& x_leg = legs_[1];
+
+    if (trade.action == TradeAction::EXIT) {
+        for (Leg& leg : legs_) {
+            if (leg.state == LegState::OPENING) leg.exit_requested = true;
+        }
+        if (y_leg.state == LegState::OPEN && x_leg.state == LegState::OPEN) {
+            uint64_t req_ids[2];
+            if (!gateway_.AddSpread(UnwindOrder(y_leg.order), UnwindOrder(x_leg.order), req_ids)) {
+                // Both legs stay open, so the next EXIT tries again.
+                std::cerr << "Failed to send EXIT orders; spread still open" << std::endl;
+                return;
+            }
+            y_leg.req_id = req_ids[0];
+            x_leg.req_id = req_ids[1];
+            y_leg.state = LegState::CLOSING;
+            x_leg.state = LegState::CLOSING;
+        } else {
+            for (Leg& leg : legs_) {
+                if (leg.state == LegState::OPEN) Unwind(leg);
+            }
+        }
+        return;
+    }
+
+    if (AnyLegActive()) {
+        std::cerr << "Skipping " << TradeActionName(trade.action) << ": previous spread not closed yet" << std::endl;
+        return;
+    }
+
+    bool long_spread = trade.action == TradeAction::LONG_SPREAD;
+    // A negative hedge ratio means both legs trade the same direction.
+    double x_quantity = y_quantity_ * std::abs(trade.hedge_ratio);
+    bool x_buy = long_spread == (trade.hedge_ratio < 0.0);
+    OrderRequest y_order;
+    OrderRequest x_order;
+    if (!MarketOrder(trade.y_symbol, long_spread ? OrderSide::BUY : OrderSide::SELL, y_quantity_, y_order) ||
+        !MarketOrder(trade.x_symbol, x_buy ? OrderSide::BUY : OrderSide::SELL, x_quantity, x_order)) {
+        std::cerr << "Skipping " << TradeActionName(trade.action)
+                  << ": a leg rounds to nothing at the pair's lot size" << std::endl;
+        return;
+    }
+
+    uint64_t req_ids[2];
+    if (!gateway_.AddSpread(y_order, x_order, req_ids)) {
+        std::cerr << "Failed to send " << TradeActionName(trade.action) << " orders; nothing was sent" << std::endl;
+        return;
+    }
+    y_leg = Leg{y_order, req_ids[0], LegState::OPENING, false};
+    x_leg = Leg{x_order, req_ids[1], LegState::OPENING, false};
+}
+
+void SpreadOrderRouter::OnOrderAck(const OrderAck& ack) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Leg* leg = nullptr;
+    for (Leg& candidate : legs_) {
+        if (candidate.state != LegState::FLAT && candidate.req_id == ack.req_id) leg = &candidate;
+    }
+    if (!leg) return;
+
+    if (ack.state == OrderState::UNKNOWN) {
+        std::cerr << "Order " << ack.req_id << " for " << SymbolRegistry::Global().Name(ack.request.symbol)
+                  << " lost with the connection; check open orders and positions by hand" << std::endl;
+        leg->state = LegState::FLAT;
+        return;
+    }
+
+    if (leg->state == LegState::OPENING) {
+        if (ack.state == OrderState::ACCEPTED) {
+            leg->state = LegState::OPEN;
+            if (leg->exit_requested) {
+                leg->exit_requested = false;
+                Unwind(*leg);
+            }
+        } else if (ack.state == OrderState::REJECTED) {
+            std::cerr << "Entry order " << ack.req_id << " rejected: " << ack.error << std::endl;
+            leg->state = LegState::FLAT;
+        }
+        HedgeBrokenSpread();
+    } else if (leg->state == LegState::CLOSING) {
+        if (ack.state == OrderState::ACCEPTED) {
+            leg->state = LegState::FLAT;
+        } else if (ack.state == OrderState::REJECTED) {
+            // Still holding the leg; the next EXIT retries the unwind.
+            std::cerr << "Unwind order " << ack.req_id << " rejected: " << ack.error << std::endl;
+            leg->state = LegState::OPEN;
+        }
+    }
+}
+
+bool SpreadOrderRouter::Open() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return AnyLegActive();
+}
+
+void SpreadOrderRouter::Unwind(Leg& leg) {
+    uint64_t req_id = gateway_.AddOrder(UnwindOrder(leg.order));
+    if (req_id == 0) {
+        std::cerr << "Failed to unwind " << SymbolRegistry::Global().Name(leg.order.symbol)
+                  << "; leg still open" << std::endl;
+        return;
+    }
+    leg.req_id = req_id;
+    leg.state = LegState::CLOSING;
+}
+
+void SpreadOrderRouter::HedgeBrokenSpread() {
+    if (legs_[0].state == LegState::OPENING || legs_[1].state == LegState::OPENING) return;
+    bool y_open = legs_[0].state == LegState::OPEN;
+    bool x_open = legs_[1].state == LegState::OPEN;
+    if (y_open == x_open) return;
+
+    Leg& orphan = y_open ? legs_[0] : legs_[1];
+    std::cerr << "Other leg rejected; unwinding " << SymbolRegistry::Global().Name(orphan.order.symbol) << std::endl;
+    Unwind(orphan);
+}
+
+bool SpreadOrderRouter::AnyLegActive() const {
+    return legs_[0].state != LegState::FLAT || legs_[1].state != LegState::FLAT;
+}
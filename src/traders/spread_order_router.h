@@ -0,0 +1,65 @@
+#ifndef SPREAD_ORDER_ROUTER_H
+#define SPREAD_ORDER_ROUTER_H
+
+#include "statistical_arbitrage_trader.h"
+#include "../websocket/kraken_order_gateway.h"
+#include <mutex>
+
+// Turns trader signals into market orders for both legs of the spread:
+// LONG_SPREAD buys y_quantity of Y and sells y_quantity * hedge of X,
+// SHORT_SPREAD does the reverse and EXIT unwinds whatever was opened. Both
+// legs go out through KrakenOrderGateway::AddSpread in one write.
+//
+// Each leg follows the gateway's acks, fed in through OnOrderAck(): a leg
+// counts as open only once its order is ACCEPTED, and EXIT unwinds only
+// open legs. If one entry leg is accepted and the other rejected, the
+// accepted one is unwound at once rather than left unhedged. A leg whose
+// fate was lost with the connection (UNKNOWN) is dropped from tracking and
+// reported, since it has to be reconciled over REST.
+//
+// OnTrade() runs on the strategy thread and OnOrderAck() on the gateway's
+// service thread; a mutex serializes them.
+class SpreadOrderRouter {
+public:
+    SpreadOrderRouter(KrakenOrderGateway& gateway, double y_quantity);
+
+    void OnTrade(const Trade& trade);
+    void OnOrderAck(const OrderAck& ack);
+
+    // True while any leg is being opened, is open or is being unwound.
+    bool Open() const;
+
+private:
+    enum class LegState : uint8_t {
+        FLAT,
+        // Entry order sent, waiting for its ack.
+        OPENING,
+        OPEN,
+        // Unwind order sent, waiting for its ack.
+        CLOSING
+    };
+
+    struct Leg {
+        // The entry order as sent; unwinds flip its side.
+        OrderRequest order;
+        // The entry or unwind order in flight.
+        uint64_t req_id;
+        LegState state;
+        // EXIT arrived while the entry was still in flight.
+        bool exit_requested;
+    };
+
+    // Sends the opposite of leg's entry order on its own. Leaves the leg
+    // OPEN if the gateway refuses it.
+    void Unwind(Leg& leg);
+    // Unwinds a leg left open when its partner was rejected.
+    void HedgeBrokenSpread();
+    bool AnyLegActive() const;
+
+    KrakenOrderGateway& gateway_;
+    double y_quantity_;
+    mutable std::mutex mutex_;
+    Leg legs_[2];
+};
+
+#endif
@@ -1,57 +1,378 @@
 #include "statistical_arbitrage_trader.h"
+#include "../market_data/timestamp.h"
+#include "../pipeline/latency_recorder.h"
+#include "../logging/async_logger.h"
+#include "../storage/snapshot_file.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
+#include <limits>
+#include <stdexcept>
 
-StatisticalArbitrageTrader::StatisticalArbitrageTrader(size_t lookback, double z_entry, double z_exit)
-    : model_(lookback, z_entry, z_exit), pnl_(0.0) {}
+namespace {
 
-void StatisticalArbitrageTrader::OnCandle(const std::string& symbol, double close_price, const std::string& timestamp) {
-    latest_prices_[symbol] = close_price;
+const char kTraderSnapshotMagic[8] = {'A', 'T', 'S', 'N', 'A', 'P', 'S', 'H'};
+const uint32_t kTraderSnapshotVersion = 2;
+const int64_t kNoBar = std::numeric_limits<int64_t>::min();
+
+struct TraderSnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t position;
+    char y_symbol[16];
+    char x_symbol[16];
+    // Price mantissas at y_price_scale and x_price_scale, which a restarted
+    // process may have fetched differently.
+    int64_t entry_y_price;
+    int64_t entry_x_price;
+    double entry_hedge_ratio;
+    double pnl;
+    int64_t y_price;
+    int64_t x_price;
+    int64_t y_last_bar;
+    int64_t x_last_bar;
+    uint64_t trade_count;
+    uint8_t has_y_price;
+    uint8_t has_x_price;
+    uint8_t y_price_scale;
+    uint8_t x_price_scale;
+    uint8_t reserved[4];
+};
+
+// Exact price change of one leg; both prices are at its scale.
+double PriceMove(const Decimal& to, const Decimal& from) {
+    return Decimal{to.mantissa - from.mantissa, to.scale}.ToDouble();
+}
+
+// A snapshot price moved onto symbol's current scale.
+bool RestorePrice(int64_t mantissa, uint8_t scale, SymbolId symbol, Decimal& price) {
+    if (scale > kMaxDecimalScale) return false;
+    Decimal restored = {mantissa, scale};
+    if (!Rescale(restored, MarketPrecision(symbol).price_decimals)) return false;
+    price = restored;
+    return true;
+}
+
+}  // namespace
+
+const char* TradeActionName(TradeAction action) {
+    switch (action) {
+        case TradeAction::LONG_SPREAD: return "LONG_SPREAD";
+        case TradeAction::SHORT_SPREAD: return "SHORT_SPREAD";
+        case TradeAction::EXIT: return "EXIT";
+    }
+    return "UNKNOWN";
+}
+
+StatisticalArbitrageTrader::StatisticalArbitrageTrader(size_t lookback, double z_entry, double z_exit,
+                                                       HedgeRatioMode hedge_ratio_mode,
+                                                       const std::string& y_symbol,
+                                                       const std::string& x_symbol)
+    : model_(lookback, z_entry, z_exit, hedge_ratio_mode),
+      y_symbol_(SymbolRegistry::Global().Intern(y_symbol)),
+      x_symbol_(SymbolRegistry::Global().Intern(x_symbol)),
+      trade_log_capacity_(0), trade_log_next_(0), trade_count_(0), journal_(nullptr),
+      pnl_(0.0), verbose_(true),
+      position_(Position::NONE), entry_y_price_(PriceDecimal(y_symbol_, 0)),
+      entry_x_price_(PriceDecimal(x_symbol_, 0)), entry_hedge_ratio_(0.0) {
+    if (y_symbol_ == kInvalidSymbol || x_symbol_ == kInvalidSymbol) {
+        throw std::runtime_error("Symbol registry is full");
+    }
+    size_t slots = static_cast<size_t>(std::max(y_symbol_, x_symbol_)) + 1;
+    latest_prices_.assign(slots, Decimal{0, 0});
+    has_price_.assign(slots, 0);
+    last_bar_.assign(slots, kNoBar);
+    warm_until_.assign(slots, kNoBar);
+    quotes_.assign(slots, TopOfBook());
+    has_quote_.assign(slots, 0);
+}
+
+void StatisticalArbitrageTrader::OnCandle(const Candle& candle) {
+    if (candle.symbol >= latest_prices_.size()) return;
+    if (candle.interval_begin <= warm_until_[candle.symbol]) return;
+
+    last_bar_[candle.symbol] = candle.interval_begin;
+    latest_prices_[candle.symbol] = PriceDecimal(candle.symbol, candle.close);
+    has_price_[candle.symbol] = 1;
     
-    if (latest_prices_.count("BTC/USD") && latest_prices_.count("ETH/USD")) {
+    if (has_price_[y_symbol_] && has_price_[x_symbol_]) {
+        uint64_t model_start = LatencyRecorder::Enabled() ? TscNow() : 0;
         auto signal = model_.GenerateSignal(
-            latest_prices_["BTC/USD"],
-            latest_prices_["ETH/USD"]
+            latest_prices_[y_symbol_],
+            latest_prices_[x_symbol_]
         );
+        if (model_start != 0) {
+            LatencyRecorder::Record(LatencyStage::MODEL, model_start, TscNow());
+        }
         
         if (signal == Signal::LONG_SPREAD) {
-            std::cout << "🟢 SIGNAL: Long BTC, Short ETH" << std::endl;
-            LogTrade("LONG_SPREAD", timestamp);
+            if (verbose_) ASYNC_LOG("🟢 SIGNAL: Long {}, Short {}", SymbolRegistry::Global().Name(y_symbol_),
+                                    SymbolRegistry::Global().Name(x_symbol_));
+            OpenPosition(Position::LONG_SPREAD);
+            LogTrade(TradeAction::LONG_SPREAD, candle.interval_begin);
         } else if (signal == Signal::SHORT_SPREAD) {
-            std::cout << "🔴 SIGNAL: Short BTC, Long ETH" << std::endl;
-            LogTrade("SHORT_SPREAD", timestamp);
+            if (verbose_) ASYNC_LOG("🔴 SIGNAL: Short {}, Long {}", SymbolRegistry::Global().Name(y_symbol_),
+                                    SymbolRegistry::Global().Name(x_symbol_));
+            OpenPosition(Position::SHORT_SPREAD);
+            LogTrade(TradeAction::SHORT_SPREAD, candle.interval_begin);
         } else if (signal == Signal::EXIT) {
-            std::cout << "⚪ SIGNAL: Exit positions" << std::endl;
-            LogTrade("EXIT", timestamp);
+            if (verbose_) ASYNC_LOG("⚪ SIGNAL: Exit positions");
+            ClosePosition();
+            LogTrade(TradeAction::EXIT, candle.interval_begin);
+        }
+    }
+}
+
+void StatisticalArbitrageTrader::WarmUp(const std::vector<Candle>& history) {
+    for (const Candle& candle : history) {
+        if (candle.symbol >= latest_prices_.size()) continue;
+        if (candle.symbol != y_symbol_ && candle.symbol != x_symbol_) continue;
+        if (candle.interval_begin <= warm_until_[candle.symbol]) continue;
+
+        last_bar_[candle.symbol] = candle.interval_begin;
+        latest_prices_[candle.symbol] = PriceDecimal(candle.symbol, candle.close);
+        has_price_[candle.symbol] = 1;
+        if (has_price_[y_symbol_] && has_price_[x_symbol_]) {
+            model_.WarmUp(latest_prices_[y_symbol_], latest_prices_[x_symbol_]);
         }
     }
+    warm_until_[y_symbol_] = last_bar_[y_symbol_];
+    warm_until_[x_symbol_] = last_bar_[x_symbol_];
+}
+
+void StatisticalArbitrageTrader::OnTopOfBook(const TopOfBook& top) {
+    if (top.symbol >= quotes_.size()) return;
+    quotes_[top.symbol] = top;
+    has_quote_[top.symbol] = 1;
+}
+
+bool StatisticalArbitrageTrader::LatestQuote(SymbolId symbol, TopOfBook& quote) const {
+    if (symbol >= quotes_.size() || !has_quote_[symbol]) return false;
+    quote = quotes_[symbol];
+    return true;
+}
+
+bool StatisticalArbitrageTrader::IsWarm() const {
+    return model_.IsWarm();
+}
+
+size_t StatisticalArbitrageTrader::WarmUpBars() const {
+    return model_.GetLookback();
+}
+
+int64_t StatisticalArbitrageTrader::LastBarTime() const {
+    return std::min(last_bar_[y_symbol_], last_bar_[x_symbol_]);
+}
+
+void StatisticalArbitrageTrader::WriteSnapshot(std::string& out) const {
+    TraderSnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kTraderSnapshotMagic, sizeof(header.magic));
+    header.version = kTraderSnapshotVersion;
+    header.position = static_cast<uint32_t>(position_);
+    CopyJournalString(header.y_symbol, sizeof(header.y_symbol), SymbolRegistry::Global().Name(y_symbol_));
+    CopyJournalString(header.x_symbol, sizeof(header.x_symbol), SymbolRegistry::Global().Name(x_symbol_));
+    // Entry and latest prices of a leg share its scale.
+    header.entry_y_price = entry_y_price_.mantissa;
+    header.entry_x_price = entry_x_price_.mantissa;
+    header.entry_hedge_ratio = entry_hedge_ratio_;
+    header.pnl = pnl_;
+    header.y_price = latest_prices_[y_symbol_].mantissa;
+    header.x_price = latest_prices_[x_symbol_].mantissa;
+    header.y_price_scale = static_cast<uint8_t>(latest_prices_[y_symbol_].scale);
+    header.x_price_scale = static_cast<uint8_t>(latest_prices_[x_symbol_].scale);
+    header.y_last_bar = last_bar_[y_symbol_];
+    header.x_last_bar = last_bar_[x_symbol_];
+    header.trade_count = trade_count_;
+    header.has_y_price = has_price_[y_symbol_];
+    header.has_x_price = has_price_[x_symbol_];
+
+    AppendSnapshotValue(out, header);
+    model_.WriteSnapshot(out);
+}
+
+bool StatisticalArbitrageTrader::RestoreSnapshot(const std::string& bytes) {
+    const char* data = bytes.data();
+    const char* end = data + bytes.size();
+    TraderSnapshotHeader header;
+    if (!ReadSnapshotValue(data, end, header) ||
+        std::memcmp(header.magic, kTraderSnapshotMagic, sizeof(header.magic)) != 0 ||
+        header.version != kTraderSnapshotVersion ||
+        header.position > static_cast<uint32_t>(Position::SHORT_SPREAD)) {
+        return false;
+    }
+    header.y_symbol[sizeof(header.y_symbol) - 1] = '\0';
+    header.x_symbol[sizeof(header.x_symbol) - 1] = '\0';
+    if (SymbolRegistry::Global().Name(y_symbol_) != header.y_symbol ||
+        SymbolRegistry::Global().Name(x_symbol_) != header.x_symbol) {
+        return false;
+    }
+    Decimal entry_y_price, entry_x_price, y_price, x_price;
+    if (!RestorePrice(header.entry_y_price, header.y_price_scale, y_symbol_, entry_y_price) ||
+        !RestorePrice(header.entry_x_price, header.x_price_scale, x_symbol_, entry_x_price) ||
+        !RestorePrice(header.y_price, header.y_price_scale, y_symbol_, y_price) ||
+        !RestorePrice(header.x_price, header.x_price_scale, x_symbol_, x_price)) {
+        return false;
+    }
+    if (!model_.RestoreSnapshot(data, end)) {
+        return false;
+    }
+
+    position_ = static_cast<Position>(header.position);
+    entry_y_price_ = entry_y_price;
+    entry_x_price_ = entry_x_price;
+    entry_hedge_ratio_ = header.entry_hedge_ratio;
+    pnl_ = header.pnl;
+    latest_prices_[y_symbol_] = y_price;
+    latest_prices_[x_symbol_] = x_price;
+    has_price_[y_symbol_] = header.has_y_price;
+    has_price_[x_symbol_] = header.has_x_price;
+    last_bar_[y_symbol_] = header.y_last_bar;
+    last_bar_[x_symbol_] = header.x_last_bar;
+    warm_until_[y_symbol_] = header.y_last_bar;
+    warm_until_[x_symbol_] = header.x_last_bar;
+    trade_count_ = header.trade_count;
+    return true;
+}
+
+bool StatisticalArbitrageTrader::SaveSnapshot(const std::string& path) const {
+    std::string bytes;
+    WriteSnapshot(bytes);
+    return WriteSnapshotFile(path, bytes);
+}
+
+bool StatisticalArbitrageTrader::LoadSnapshot(const std::string& path) {
+    std::string bytes;
+    return ReadSnapshotFile(path, bytes) && RestoreSnapshot(bytes);
+}
+
+void StatisticalArbitrageTrader::OpenPosition(Position position) {
+    position_ = position;
+    entry_y_price_ = latest_prices_[y_symbol_];
+    entry_x_price_ = latest_prices_[x_symbol_];
+    entry_hedge_ratio_ = model_.GetCurrentHedgeRatio();
+}
+
+void StatisticalArbitrageTrader::ClosePosition() {
+    pnl_ += PositionPnL();
+    position_ = Position::NONE;
 }
 
-void StatArbTradingSystem::LogTrade(const std::string& action, const std::string& timestamp) {
+double StatisticalArbitrageTrader::PositionPnL() const {
+    if (position_ == Position::NONE) return 0.0;
+    
+    double y_move = PriceMove(latest_prices_[y_symbol_], entry_y_price_);
+    double x_move = PriceMove(latest_prices_[x_symbol_], entry_x_price_);
+    double spread_move = y_move - entry_hedge_ratio_ * x_move;
+    
+    return position_ == Position::LONG_SPREAD ? spread_move : -spread_move;
+}
+
+void StatisticalArbitrageTrader::LogTrade(TradeAction action, int64_t timestamp) {
     Trade trade;
     trade.timestamp = timestamp;
-    trade.action = action;
-    trade.btc_price = latest_prices_["BTC/USD"];
-    trade.eth_price = latest_prices_["ETH/USD"];
+    trade.y_price = latest_prices_[y_symbol_].mantissa;
+    trade.x_price = latest_prices_[x_symbol_].mantissa;
     trade.hedge_ratio = model_.GetCurrentHedgeRatio();
     trade.z_score = model_.GetCurrentZScore();
+    trade.pnl = pnl_;
+    trade.y_symbol = y_symbol_;
+    trade.x_symbol = x_symbol_;
+    trade.action = action;
+    trade.y_price_scale = static_cast<uint8_t>(latest_prices_[y_symbol_].scale);
+    trade.x_price_scale = static_cast<uint8_t>(latest_prices_[x_symbol_].scale);
     
-    trade_log_.push_back(trade);
+    if (trade_log_capacity_ == 0 || trade_log_.size() < trade_log_capacity_) {
+        trade_log_.push_back(trade);
+    } else {
+        trade_log_[trade_log_next_] = trade;
+        trade_log_next_ = (trade_log_next_ + 1) % trade_log_capacity_;
+    }
+    trade_count_++;
+    if (journal_) {
+        TradeJournalRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.timestamp = trade.timestamp;
+        // Journal records are read without this process's scales.
+        record.y_price = trade.YPrice().ToDouble();
+        record.x_price = trade.XPrice().ToDouble();
+        record.hedge_ratio = trade.hedge_ratio;
+        record.z_score = trade.z_score;
+        record.pnl = trade.pnl;
+        CopyJournalString(record.y_symbol, sizeof(record.y_symbol), SymbolRegistry::Global().Name(y_symbol_));
+        CopyJournalString(record.x_symbol, sizeof(record.x_symbol), SymbolRegistry::Global().Name(x_symbol_));
+        record.action = static_cast<uint8_t>(action);
+        journal_->Append(JournalEntryType::TRADE, record);
+    }
+    LatencyRecorder::Record(LatencyStage::TICK_TO_SIGNAL, LatencyRecorder::CurrentReceive(), TscNow());
+    if (trade_callback_) {
+        trade_callback_(trade);
+    }
 }
 
-const std::vector<Trade>& StatisticalArbitrageTrader::GetTradeLog() const {
-    return trade_log_;
+double StatisticalArbitrageTrader::GetRealizedPnL() const {
+    return pnl_;
+}
+
+double StatisticalArbitrageTrader::GetEquity() const {
+    return pnl_ + PositionPnL();
+}
+
+Position StatisticalArbitrageTrader::CurrentPosition() const {
+    return position_;
+}
+
+void StatisticalArbitrageTrader::SetVerbose(bool verbose) {
+    verbose_ = verbose;
+    model_.SetVerbose(verbose);
+}
+
+void StatisticalArbitrageTrader::SetTradeCallback(std::function<void(const Trade&)> callback) {
+    trade_callback_ = callback;
+}
+
+void StatisticalArbitrageTrader::SetTradeLogCapacity(size_t capacity) {
+    std::vector<Trade> recent = RecentTrades();
+    if (capacity > 0 && recent.size() > capacity) {
+        recent.erase(recent.begin(), recent.end() - static_cast<std::ptrdiff_t>(capacity));
+    }
+    trade_log_ = std::move(recent);
+    trade_log_.reserve(capacity);
+    trade_log_capacity_ = capacity;
+    trade_log_next_ = 0;
+}
+
+void StatisticalArbitrageTrader::SetJournal(TradeJournal* journal) {
+    journal_ = journal;
+}
+
+uint64_t StatisticalArbitrageTrader::TradeCount() const {
+    return trade_count_;
+}
+
+std::vector<Trade> StatisticalArbitrageTrader::RecentTrades() const {
+    if (trade_log_capacity_ == 0 || trade_log_.size() < trade_log_capacity_) {
+        return trade_log_;
+    }
+    // Full ring: the oldest trade sits where the next one will be written.
+    size_t oldest = trade_log_next_;
+    std::vector<Trade> trades(trade_log_.begin() + static_cast<std::ptrdiff_t>(oldest), trade_log_.end());
+    trades.insert(trades.end(), trade_log_.begin(), trade_log_.begin() + static_cast<std::ptrdiff_t>(oldest));
+    return trades;
 }
 
 void StatisticalArbitrageTrader::PrintTradeLog() const {
+    const SymbolRegistry& symbols = SymbolRegistry::Global();
     std::cout << "\n=== TRADE LOG ===" << std::endl;
-    for (const auto& trade : trade_log_) {
+    for (const auto& trade : RecentTrades()) {
         std::cout << std::fixed << std::setprecision(2)
-                  << trade.timestamp << " | " << trade.action 
-                  << " | BTC: " << trade.btc_price 
-                  << " | ETH: " << trade.eth_price 
+                  << FormatTimestampNanos(trade.timestamp) << " | " << TradeActionName(trade.action)
+                  << " | " << symbols.Name(trade.y_symbol) << ": " << ToString(trade.YPrice())
+                  << " | " << symbols.Name(trade.x_symbol) << ": " << ToString(trade.XPrice())
                   << " | Hedge: " << std::setprecision(4) << trade.hedge_ratio 
-                  << " | Z: " << std::setprecision(3) << trade.z_score << std::endl;
+                  << " | Z: " << std::setprecision(3) << trade.z_score
+                  << " | PnL: " << std::setprecision(2) << trade.pnl << std::endl;
     }
 }
 
@@ -63,17 +384,21 @@ void StatisticalArbitrageTrader::SaveTradesToCSV(const std::string& filename) co
         return;
     }
     
-    file << "timestamp,action,btc_price,eth_price,hedge_ratio,z_score\n";
+    const SymbolRegistry& symbols = SymbolRegistry::Global();
+    file << "timestamp,action,y_symbol,x_symbol,y_price,x_price,hedge_ratio,z_score,pnl\n";
     
-    for (const auto& trade : trade_log_) {
-        file << trade.timestamp << ","
-             << trade.action << ","
-             << std::fixed << std::setprecision(2) << trade.btc_price << ","
-             << trade.eth_price << ","
-             << std::setprecision(4) << trade.hedge_ratio << ","
-             << std::setprecision(3) << trade.z_score << "\n";
+    for (const auto& trade : RecentTrades()) {
+        file << FormatTimestampNanos(trade.timestamp) << ","
+             << TradeActionName(trade.action) << ","
+             << symbols.Name(trade.y_symbol) << ","
+             << symbols.Name(trade.x_symbol) << ","
+             << ToString(trade.YPrice()) << ","
+             << ToString(trade.XPrice()) << ","
+             << std::fixed << std::setprecision(4) << trade.hedge_ratio << ","
+             << std::setprecision(3) << trade.z_score << ","
+             << std::setprecision(2) << trade.pnl << "\n";
     }
     
     file.close();
     std::cout << "Trades saved to " << filename << std::endl;
-}
\ No newline at end of file
+}
@@ -2,37 +2,144 @@
 #define STATISTICAL_ARBITRAGE_TRADER_H
 
 #include "../models/statistical_arbitrage_model.h"
+#include "../market_data/candle.h"
+#include "../market_data/order_book.h"
+#include "../storage/trade_journal.h"
+#include <cstdint>
+#include <functional>
 #include <string>
-#include <map>
+#include <type_traits>
 #include <vector>
 #include <fstream>
 
-struct Trade {
-    std::string timestamp;
-    std::string action;
-    double btc_price;
-    double eth_price;
+enum class TradeAction : uint8_t {
+    LONG_SPREAD,
+    SHORT_SPREAD,
+    EXIT
+};
+
+const char* TradeActionName(TradeAction action);
+
+// One executed signal, trivially copyable and one cache line wide. Two
+// Decimals would not fit, so the leg prices are mantissas with their
+// scales beside them; YPrice() and XPrice() put them back together.
+struct alignas(64) Trade {
+    // Bar open time of the triggering candle, nanoseconds since the epoch.
+    int64_t timestamp;
+    int64_t y_price;
+    int64_t x_price;
     double hedge_ratio;
     double z_score;
+    // Realized PnL after this trade.
+    double pnl;
+    SymbolId y_symbol;
+    SymbolId x_symbol;
+    TradeAction action;
+    uint8_t y_price_scale;
+    uint8_t x_price_scale;
+
+    Decimal YPrice() const { return Decimal{y_price, y_price_scale}; }
+    Decimal XPrice() const { return Decimal{x_price, x_price_scale}; }
 };
 
+static_assert(sizeof(Trade) == 64, "Trade must stay one cache line");
+static_assert(std::is_trivially_copyable<Trade>::value, "Trade must stay trivially copyable");
+
 class StatisticalArbitrageTrader {
 private:
-    StatArbModel model_;
-    std::map<std::string, double> latest_prices_;
+    StatisticalArbitrageModel model_;
+    SymbolId y_symbol_;
+    SymbolId x_symbol_;
+    // Indexed by SymbolId, sized to cover both legs.
+    std::vector<Decimal> latest_prices_;
+    std::vector<uint8_t> has_price_;
+    // Latest bar open time seen per leg, and the newest bar already folded
+    // in by WarmUp or a snapshot; OnCandle ignores bars at or before it so
+    // the live stream's opening snapshot does not replay them.
+    std::vector<int64_t> last_bar_;
+    std::vector<int64_t> warm_until_;
+    // Latest top of book per leg, when a book stream feeds one.
+    std::vector<TopOfBook> quotes_;
+    std::vector<uint8_t> has_quote_;
+    // Most recent trades; a ring once trade_log_capacity_ is reached.
     std::vector<Trade> trade_log_;
+    size_t trade_log_capacity_;
+    size_t trade_log_next_;
+    uint64_t trade_count_;
+    TradeJournal* journal_;
+    std::function<void(const Trade&)> trade_callback_;
     double pnl_;
+    bool verbose_;
+    
+    // Open spread: +1 Y / -hedge X for LONG_SPREAD, the reverse for SHORT_SPREAD.
+    Position position_;
+    Decimal entry_y_price_;
+    Decimal entry_x_price_;
+    double entry_hedge_ratio_;
     
-    void LogTrade(const std::string& action, const std::string& timestamp);
+    void LogTrade(TradeAction action, int64_t timestamp);
+    void OpenPosition(Position position);
+    void ClosePosition();
+    double PositionPnL() const;
     
 public:
-    StatisticalArbitrageTrader(size_t lookback = 100, double z_entry = 2.0, double z_exit = 0.5);
+    StatisticalArbitrageTrader(size_t lookback = 100, double z_entry = 2.0, double z_exit = 0.5,
+                               HedgeRatioMode hedge_ratio_mode = HedgeRatioMode::INCREMENTAL_OLS,
+                               const std::string& y_symbol = "BTC/USD",
+                               const std::string& x_symbol = "ETH/USD");
+    
+    // Allocation-free except when a signal grows the trade log.
+    void OnCandle(const Candle& candle);
+    // Keeps the latest top of book of either leg for pricing; bars still
+    // drive the model. O(1) and allocation-free.
+    void OnTopOfBook(const TopOfBook& top);
+    // False until a quote for symbol has arrived.
+    bool LatestQuote(SymbolId symbol, TopOfBook& quote) const;
+    
+    // Feeds completed historical bars, oldest first, through the model
+    // without trading, skipping bars already seen. Later live bars at or
+    // before the last one are ignored.
+    void WarmUp(const std::vector<Candle>& history);
+    // True once the model has a full window and can signal.
+    bool IsWarm() const;
+    // Bars of history needed to warm a cold trader.
+    size_t WarmUpBars() const;
+    // Open time of the newest bar seen on both legs; INT64_MIN before any.
+    int64_t LastBarTime() const;
+    
+    // Model windows, open position and PnL, to restart without waiting a
+    // full lookback. Snapshots are only read back by a trader with the same
+    // pair, lookback and mode from the same build; anything else is rejected
+    // and leaves the trader untouched. Call from the OnCandle thread.
+    void WriteSnapshot(std::string& out) const;
+    bool RestoreSnapshot(const std::string& bytes);
+    bool SaveSnapshot(const std::string& path) const;
+    bool LoadSnapshot(const std::string& path);
+    
+    // Realized PnL of closed spreads, in quote currency per unit of Y traded.
+    double GetRealizedPnL() const;
+    // Realized PnL plus the open spread marked at the latest prices.
+    double GetEquity() const;
+    // The open spread, NONE when flat.
+    Position CurrentPosition() const;
+    
+    void SetVerbose(bool verbose);
+    // Called on the OnCandle thread right after each trade is logged, e.g.
+    // to route the signal to an order gateway.
+    void SetTradeCallback(std::function<void(const Trade&)> callback);
     
-    void OnCandle(const std::string& symbol, double close_price, const std::string& timestamp);
+    // Keeps at most capacity trades in memory, so long runs stay flat;
+    // 0 (the default) keeps every trade. Use a journal for the full history.
+    void SetTradeLogCapacity(size_t capacity);
+    // Appends every trade to journal from the OnCandle thread; nullptr stops.
+    void SetJournal(TradeJournal* journal);
     
-    const std::vector<Trade>& GetTradeLog() const;
+    // Trades since construction, including ones no longer held in memory.
+    uint64_t TradeCount() const;
+    // The trades still held in memory, oldest first.
+    std::vector<Trade> RecentTrades() const;
     void PrintTradeLog() const;
     void SaveTradesToCSV(const std::string& filename = "trades.csv") const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,39 @@
+#include "book_checksum.h"
+#include <array>
+#include <charconv>
+
+namespace {
+
+const uint32_t kCrc32Polynomial = 0xEDB88320u;
+
+std::array<uint32_t, 256> MakeCrcTable() {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 1) ? (crc >> 1) ^ kCrc32Polynomial : crc >> 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+const std::array<uint32_t, 256> kCrcTable = MakeCrcTable();
+
+}  // namespace
+
+uint32_t Crc32(const void* data, size_t length, uint32_t crc) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < length; i++) {
+    crc = kCrcTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+uint32_t UpdateBookChecksum(uint32_t crc, int64_t price_mantissa, int64_t qty_mantissa) {
+  char digits[48];
+  auto price_end = std::to_chars(digits, digits + sizeof(digits), price_mantissa).ptr;
+  auto qty_end = std::to_chars(price_end, digits + sizeof(digits), qty_mantissa).ptr;
+  return Crc32(digits, static_cast<size_t>(qty_end - digits), crc);
+}
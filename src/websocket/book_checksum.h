@@ -0,0 +1,19 @@
+#ifndef BOOK_CHECKSUM_H
+#define BOOK_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Kraken v2 book checksum: CRC-32 (the zlib polynomial) over the top ten
+// asks, best first, then the top ten bids, best first. Each level
+// contributes its price and then its quantity as printed with the pair's
+// precision, minus the decimal point and leading zeros, which is the
+// decimal text of the fixed-point mantissa.
+
+uint32_t Crc32(const void* data, size_t length, uint32_t crc = 0);
+
+// Folds one level into a running checksum that starts at 0; mantissas are
+// value * 10^decimals. Formats on the stack, so it never allocates.
+uint32_t UpdateBookChecksum(uint32_t crc, int64_t price_mantissa, int64_t qty_mantissa);
+
+#endif
@@ -0,0 +1,181 @@
+#include "book_message_parser.h"
+#include "json_cursor.h"
+#include "../market_data/decimal.h"
+#include "../market_data/timestamp.h"
+
+namespace {
+
+// Parses the whole of text as it was written, e.g. "0.10000000" as
+// (10000000, 8).
+bool ParseDecimal(std::string_view text, Decimal& value) {
+  const char* end = text.data() + text.size();
+  std::from_chars_result result = FromChars(text.data(), end, value);
+  return result.ec == std::errc() && result.ptr == end;
+}
+
+// Moves a parsed level onto the book's scale. Fails on overflow or if a
+// nonzero digit would be dropped; book levels are never rounded.
+bool ToBookScale(Decimal& value, int scale) {
+  if (value.scale > scale && value.mantissa % Pow10(value.scale - scale) != 0) return false;
+  return Rescale(value, scale, Rounding::DOWN);
+}
+
+bool ApplyLevel(OrderBook& book, bool bid, std::string_view price_text, std::string_view qty_text) {
+  Decimal price;
+  Decimal qty;
+  // Book prices and quantities are never negative.
+  if (!ParseDecimal(price_text, price) || !ParseDecimal(qty_text, qty) || price.mantissa < 0 || qty.mantissa < 0) {
+    return false;
+  }
+  if (!book.DecimalsFixed() && (price.scale > book.PriceDecimals() || qty.scale > book.QtyDecimals())) {
+    if (!book.WidenDecimals(price.scale, qty.scale)) return false;
+  }
+  if (!ToBookScale(price, book.PriceDecimals()) || !ToBookScale(qty, book.QtyDecimals())) {
+    return false;
+  }
+  if (bid) {
+    book.ApplyBid(price.mantissa, qty.mantissa);
+  } else {
+    book.ApplyAsk(price.mantissa, qty.mantissa);
+  }
+  return true;
+}
+
+bool ParseLevels(JsonCursor& cursor, OrderBook& book, bool bids) {
+  if (!cursor.EnterArray()) return false;
+
+  std::string_view key;
+  while (cursor.NextElement()) {
+    if (!cursor.EnterObject()) return false;
+    std::string_view price;
+    std::string_view qty;
+    bool has_price = false;
+    bool has_qty = false;
+    while (cursor.NextKey(key)) {
+      if (key == "price" && cursor.ReadNumberText(price)) {
+        has_price = true;
+      } else if (key == "qty" && cursor.ReadNumberText(qty)) {
+        has_qty = true;
+      } else if (!cursor.Failed()) {
+        cursor.SkipValue();
+      }
+    }
+    if (cursor.Failed() || !has_price || !has_qty || !ApplyLevel(book, bids, price, qty)) return false;
+  }
+  return !cursor.Failed();
+}
+
+bool ParseBookEntry(JsonCursor& cursor, bool snapshot, BookMessageHandler& handler) {
+  if (!cursor.EnterObject()) return false;
+
+  bool symbol_seen = false;
+  SymbolId symbol = kInvalidSymbol;
+  OrderBook* book = nullptr;
+  // Kraken sends "symbol" first; levels that come before it are applied
+  // once the book is known.
+  const char* deferred_bids = nullptr;
+  const char* deferred_asks = nullptr;
+  bool has_checksum = false;
+  int64_t checksum = 0;
+  int64_t timestamp = 0;
+
+  std::string_view key;
+  std::string_view text;
+  while (cursor.NextKey(key)) {
+    if (key == "symbol") {
+      if (!cursor.ReadString(text)) break;
+      symbol_seen = true;
+      symbol = SymbolRegistry::Global().Find(text);
+      if (symbol != kInvalidSymbol) book = handler.BeginBook(symbol, snapshot);
+    } else if ((key == "bids" || key == "asks") && symbol_seen) {
+      if (!book) {
+        cursor.SkipValue();
+      } else if (!ParseLevels(cursor, *book, key == "bids")) {
+        return false;
+      }
+    } else if (key == "bids" || key == "asks") {
+      (key == "bids" ? deferred_bids : deferred_asks) = cursor.Position();
+      cursor.SkipValue();
+    } else if (key == "checksum") {
+      has_checksum = cursor.ReadInt64(checksum);
+    } else if (key == "timestamp") {
+      if (cursor.ReadString(text)) ParseTimestampNanos(text.data(), text.size(), timestamp);
+    } else {
+      cursor.SkipValue();
+    }
+  }
+
+  if (cursor.Failed() || !symbol_seen || !has_checksum) return false;
+  if (!book) return true;
+
+  if (deferred_bids) {
+    JsonCursor levels(deferred_bids, cursor.End());
+    if (!ParseLevels(levels, *book, true)) return false;
+  }
+  if (deferred_asks) {
+    JsonCursor levels(deferred_asks, cursor.End());
+    if (!ParseLevels(levels, *book, false)) return false;
+  }
+  book->Truncate();
+  handler.EndBook(symbol, *book, static_cast<uint32_t>(checksum), timestamp);
+  return true;
+}
+
+bool ParseBookArray(JsonCursor& cursor, bool snapshot, BookMessageHandler& handler) {
+  if (!cursor.EnterArray()) return false;
+
+  while (cursor.NextElement()) {
+    if (!ParseBookEntry(cursor, snapshot, handler)) return false;
+  }
+  return !cursor.Failed();
+}
+
+}  // namespace
+
+BookParseResult ParseBookMessage(const char* data, size_t length, BookMessageHandler& handler) {
+  JsonCursor cursor(data, data + length);
+  if (!cursor.EnterObject()) return BookParseResult::MALFORMED;
+
+  bool is_book = false;
+  bool type_seen = false;
+  bool snapshot = false;
+  bool parsed_data = false;
+  const char* deferred_data = nullptr;
+
+  std::string_view key;
+  while (cursor.NextKey(key)) {
+    if (key == "channel") {
+      std::string_view channel;
+      if (!cursor.ReadString(channel)) break;
+      is_book = channel == "book";
+      if (!is_book) return BookParseResult::IGNORED;
+    } else if (key == "type") {
+      std::string_view type;
+      if (!cursor.ReadString(type)) break;
+      type_seen = true;
+      snapshot = type == "snapshot";
+    } else if (key == "data" && is_book && type_seen) {
+      if (!ParseBookArray(cursor, snapshot, handler)) return BookParseResult::MALFORMED;
+      parsed_data = true;
+    } else if (key == "data") {
+      // A snapshot empties the book first, so the type has to be known
+      // before any level is applied.
+      deferred_data = cursor.Position();
+      cursor.SkipValue();
+    } else {
+      cursor.SkipValue();
+    }
+  }
+
+  if (cursor.Failed()) return BookParseResult::MALFORMED;
+  if (!is_book) return BookParseResult::IGNORED;
+
+  if (!parsed_data && deferred_data) {
+    if (!type_seen) return BookParseResult::MALFORMED;
+    JsonCursor data_cursor(deferred_data, data + length);
+    if (!ParseBookArray(data_cursor, snapshot, handler)) return BookParseResult::MALFORMED;
+    parsed_data = true;
+  }
+
+  return parsed_data ? BookParseResult::BOOKS : BookParseResult::IGNORED;
+}
@@ -0,0 +1,36 @@
+#ifndef BOOK_MESSAGE_PARSER_H
+#define BOOK_MESSAGE_PARSER_H
+
+#include "../market_data/order_book.h"
+#include <cstddef>
+#include <cstdint>
+
+enum class BookParseResult {
+  BOOKS,
+  IGNORED,
+  MALFORMED
+};
+
+// Receives each entry of a "book" message's data array.
+class BookMessageHandler {
+ public:
+  virtual ~BookMessageHandler() = default;
+
+  // Returns the book the entry's levels go into, or nullptr to skip the
+  // entry. For a snapshot the handler hands back an emptied book.
+  virtual OrderBook* BeginBook(SymbolId symbol, bool snapshot) = 0;
+  // Called once the entry's levels are applied and the book truncated to
+  // depth; checksum is Kraken's for the book as it should now stand and
+  // timestamp is 0 for snapshots.
+  virtual void EndBook(SymbolId symbol, OrderBook& book, uint32_t checksum, int64_t timestamp) = 0;
+};
+
+// Parses a raw Kraken v2 message and, if it is on the "book" channel,
+// applies every level straight from the buffer to the handler's books as
+// exact fixed-point mantissas. Nothing is allocated. Entries for symbols
+// that were never interned are skipped. Messages on other channels, acks
+// and heartbeats return IGNORED. On MALFORMED the entry last begun may be
+// partly applied and should be resynchronized.
+BookParseResult ParseBookMessage(const char* data, size_t length, BookMessageHandler& handler);
+
+#endif
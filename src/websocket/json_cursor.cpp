@@ -0,0 +1,297 @@
+#include "json_cursor.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// Powers of ten that are exactly representable as doubles.
+const double kExactPowersOfTen[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const uint64_t kMaxExactMantissa = 1ULL << 53;
+
+bool IsDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+}  // namespace
+
+bool ParseJsonDouble(std::string_view text, double& value) {
+  const char* p = text.data();
+  const char* end = p + text.size();
+  if (p == end) return false;
+
+  bool negative = false;
+  if (*p == '-') {
+    negative = true;
+    p++;
+  }
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  bool any_digit = false;
+
+  for (; p < end && IsDigit(*p); p++) {
+    any_digit = true;
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa != 0) digits++;
+    } else {
+      exponent++;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && IsDigit(*p); p++) {
+      any_digit = true;
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa != 0) digits++;
+        exponent--;
+      }
+    }
+  }
+  if (!any_digit) return false;
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    bool negative_exponent = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+      negative_exponent = *p == '-';
+      p++;
+    }
+    int e = 0;
+    for (; p < end && IsDigit(*p); p++) {
+      if (e < 10000) e = e * 10 + (*p - '0');
+    }
+    exponent += negative_exponent ? -e : e;
+  }
+  if (p != end) return false;
+
+  if (mantissa < kMaxExactMantissa && exponent >= -22 && exponent <= 22) {
+    double result = static_cast<double>(mantissa);
+    result = exponent < 0 ? result / kExactPowersOfTen[-exponent] : result * kExactPowersOfTen[exponent];
+    value = negative ? -result : result;
+    return true;
+  }
+
+  char buffer[128];
+  if (text.size() >= sizeof(buffer)) return false;
+  std::memcpy(buffer, text.data(), text.size());
+  buffer[text.size()] = '\0';
+  value = std::strtod(buffer, nullptr);
+  return true;
+}
+
+JsonCursor::JsonCursor(const char* begin, const char* end)
+    : cursor_(begin), end_(end), failed_(false) {}
+
+void JsonCursor::SkipWhitespace() {
+  while (cursor_ < end_ && (*cursor_ == ' ' || *cursor_ == '\n' || *cursor_ == '\r' || *cursor_ == '\t')) {
+    cursor_++;
+  }
+}
+
+bool JsonCursor::Fail() {
+  failed_ = true;
+  return false;
+}
+
+bool JsonCursor::Consume(char expected) {
+  if (failed_) return false;
+  SkipWhitespace();
+  if (cursor_ >= end_ || *cursor_ != expected) return Fail();
+  cursor_++;
+  return true;
+}
+
+bool JsonCursor::EnterObject() {
+  return Consume('{');
+}
+
+bool JsonCursor::EnterArray() {
+  return Consume('[');
+}
+
+bool JsonCursor::NextKey(std::string_view& key) {
+  if (failed_) return false;
+  SkipWhitespace();
+  if (cursor_ >= end_) return Fail();
+
+  if (*cursor_ == '}') {
+    cursor_++;
+    return false;
+  }
+  if (*cursor_ == ',') {
+    cursor_++;
+    SkipWhitespace();
+  }
+
+  if (!ScanString(key)) return Fail();
+  return Consume(':');
+}
+
+bool JsonCursor::NextElement() {
+  if (failed_) return false;
+  SkipWhitespace();
+  if (cursor_ >= end_) return Fail();
+
+  if (*cursor_ == ']') {
+    cursor_++;
+    return false;
+  }
+  if (*cursor_ == ',') {
+    cursor_++;
+  }
+  return true;
+}
+
+bool JsonCursor::ScanString(std::string_view& value) {
+  if (cursor_ >= end_ || *cursor_ != '"') return false;
+
+  const char* start = ++cursor_;
+  while (cursor_ < end_ && *cursor_ != '"') {
+    if (*cursor_ == '\\') cursor_++;
+    cursor_++;
+  }
+  if (cursor_ >= end_) return false;
+
+  value = std::string_view(start, cursor_ - start);
+  cursor_++;
+  return true;
+}
+
+bool JsonCursor::ScanNumber(std::string_view& value) {
+  const char* start = cursor_;
+  while (cursor_ < end_ && (IsDigit(*cursor_) || *cursor_ == '-' || *cursor_ == '+' ||
+                            *cursor_ == '.' || *cursor_ == 'e' || *cursor_ == 'E')) {
+    cursor_++;
+  }
+  if (cursor_ == start) return false;
+
+  value = std::string_view(start, cursor_ - start);
+  return true;
+}
+
+bool JsonCursor::ReadString(std::string_view& value) {
+  if (failed_) return false;
+  SkipWhitespace();
+  if (!ScanString(value)) return Fail();
+  return true;
+}
+
+bool JsonCursor::ReadDouble(double& value) {
+  if (failed_) return false;
+  SkipWhitespace();
+
+  std::string_view text;
+  bool ok = (cursor_ < end_ && *cursor_ == '"') ? ScanString(text) : ScanNumber(text);
+  if (!ok || !ParseJsonDouble(text, value)) return Fail();
+  return true;
+}
+
+bool JsonCursor::ReadInt64(int64_t& value) {
+  if (failed_) return false;
+  SkipWhitespace();
+
+  std::string_view text;
+  bool quoted = cursor_ < end_ && *cursor_ == '"';
+  if (!(quoted ? ScanString(text) : ScanNumber(text)) || text.empty()) return Fail();
+
+  const char* p = text.data();
+  const char* end = p + text.size();
+  bool negative = *p == '-';
+  if (negative) p++;
+  if (p == end) return Fail();
+
+  // Accumulated as a magnitude so INT64_MIN still parses.
+  const uint64_t limit = negative ? static_cast<uint64_t>(INT64_MAX) + 1 : static_cast<uint64_t>(INT64_MAX);
+  uint64_t result = 0;
+  for (; p < end; p++) {
+    if (!IsDigit(*p)) return Fail();
+    uint64_t digit = static_cast<uint64_t>(*p - '0');
+    if (result > (limit - digit) / 10) return Fail();
+    result = result * 10 + digit;
+  }
+  value = negative ? static_cast<int64_t>(0 - result) : static_cast<int64_t>(result);
+  return true;
+}
+
+bool JsonCursor::ReadNumberText(std::string_view& text) {
+  if (failed_) return false;
+  SkipWhitespace();
+
+  bool quoted = cursor_ < end_ && *cursor_ == '"';
+  if (!(quoted ? ScanString(text) : ScanNumber(text)) || text.empty()) return Fail();
+  return true;
+}
+
+bool JsonCursor::ReadBool(bool& value) {
+  if (failed_) return false;
+  SkipWhitespace();
+
+  if (end_ - cursor_ >= 4 && std::memcmp(cursor_, "true", 4) == 0) {
+    cursor_ += 4;
+    value = true;
+    return true;
+  }
+  if (end_ - cursor_ >= 5 && std::memcmp(cursor_, "false", 5) == 0) {
+    cursor_ += 5;
+    value = false;
+    return true;
+  }
+  return Fail();
+}
+
+bool JsonCursor::SkipValue() {
+  if (failed_) return false;
+  SkipWhitespace();
+  if (cursor_ >= end_) return Fail();
+
+  char c = *cursor_;
+  if (c == '"') {
+    std::string_view ignored;
+    return ScanString(ignored) || Fail();
+  }
+
+  if (c == '{' || c == '[') {
+    // Strings are skipped whole so brackets inside them are not counted.
+    int depth = 0;
+    while (cursor_ < end_) {
+      c = *cursor_;
+      if (c == '"') {
+        std::string_view ignored;
+        if (!ScanString(ignored)) return Fail();
+        continue;
+      }
+      if (c == '{' || c == '[') depth++;
+      if (c == '}' || c == ']') depth--;
+      cursor_++;
+      if (depth == 0) return true;
+    }
+    return Fail();
+  }
+
+  // Number, true, false or null.
+  const char* start = cursor_;
+  while (cursor_ < end_ && *cursor_ != ',' && *cursor_ != '}' && *cursor_ != ']' &&
+         *cursor_ != ' ' && *cursor_ != '\n' && *cursor_ != '\r' && *cursor_ != '\t') {
+    cursor_++;
+  }
+  return cursor_ != start || Fail();
+}
+
+const char* JsonCursor::Position() {
+  SkipWhitespace();
+  return cursor_;
+}
+
+const char* JsonCursor::End() const {
+  return end_;
+}
+
+bool JsonCursor::Failed() const {
+  return failed_;
+}
@@ -0,0 +1,66 @@
+#ifndef JSON_CURSOR_H
+#define JSON_CURSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Forward-only, on-demand JSON reader over a caller-owned buffer. Values are
+// read in document order straight into typed outputs; strings come back as
+// views into the buffer with escapes left undecoded. Nothing is allocated.
+// Any structural error latches Failed() and makes later reads return false.
+//
+//   JsonCursor cursor(data, length);
+//   std::string_view key;
+//   cursor.EnterObject();
+//   while (cursor.NextKey(key)) {
+//     if (key == "channel") cursor.ReadString(channel);
+//     else cursor.SkipValue();
+//   }
+class JsonCursor {
+ public:
+  JsonCursor(const char* begin, const char* end);
+
+  bool EnterObject();
+  bool EnterArray();
+
+  // Advances to the next member of the current object. Returns false and
+  // consumes the closing brace when the object is exhausted.
+  bool NextKey(std::string_view& key);
+  // Advances to the next element of the current array. Returns false and
+  // consumes the closing bracket when the array is exhausted.
+  bool NextElement();
+
+  bool ReadString(std::string_view& value);
+  // Accepts a JSON number or a number wrapped in a string.
+  bool ReadDouble(double& value);
+  bool ReadInt64(int64_t& value);
+  bool ReadBool(bool& value);
+  // Returns the text of a number, bare or wrapped in a string, for callers
+  // that parse it exactly (fixed-point prices).
+  bool ReadNumberText(std::string_view& text);
+  bool SkipValue();
+
+  // Position of the next value, for re-reading a section with a new cursor.
+  const char* Position();
+  const char* End() const;
+
+  bool Failed() const;
+
+ private:
+  const char* cursor_;
+  const char* end_;
+  bool failed_;
+
+  void SkipWhitespace();
+  bool Fail();
+  bool Consume(char expected);
+  bool ScanString(std::string_view& value);
+  bool ScanNumber(std::string_view& value);
+};
+
+// Decimal text to double. Uses an exact fast path for up to 19 significant
+// digits and small exponents and falls back to strtod otherwise.
+bool ParseJsonDouble(std::string_view text, double& value);
+
+#endif
@@ -0,0 +1,519 @@
+#include "kraken_order_gateway.h"
+#include "json_cursor.h"
+#include "../pipeline/event_loop.h"
+#include "../pipeline/latency_recorder.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// Bounded appender for hand-built JSON frames. Any overflow latches ok to
+// false and the frame is discarded.
+struct FrameWriter {
+  char* out;
+  const char* end;
+  bool ok;
+
+  void Append(std::string_view text) {
+    if (!ok || static_cast<size_t>(end - out) < text.size()) {
+      ok = false;
+      return;
+    }
+    std::memcpy(out, text.data(), text.size());
+    out += text.size();
+  }
+
+  void AppendUint(uint64_t value) {
+    if (!ok) return;
+    auto result = std::to_chars(out, const_cast<char*>(end), value);
+    if (result.ec != std::errc()) {
+      ok = false;
+      return;
+    }
+    out = result.ptr;
+  }
+
+  // Exactly value.scale decimals, e.g. 0.10000000 for 10000000 at scale
+  // 8; the caller picks the scale to match the pair's lot or tick.
+  void AppendDecimal(const Decimal& value) {
+    if (!ok) return;
+    auto result = ToChars(out, const_cast<char*>(end), value);
+    if (result.ec != std::errc()) {
+      ok = false;
+      return;
+    }
+    out = result.ptr;
+  }
+};
+
+const char* SideName(OrderSide side) {
+  return side == OrderSide::BUY ? "buy" : "sell";
+}
+
+const char* TypeName(OrderType type) {
+  return type == OrderType::MARKET ? "market" : "limit";
+}
+
+bool IsInFlight(OrderState state) {
+  return state == OrderState::PENDING || state == OrderState::CANCEL_PENDING;
+}
+
+void CopyTruncated(char* destination, size_t capacity, std::string_view source) {
+  size_t length = std::min(source.size(), capacity - 1);
+  std::memcpy(destination, source.data(), length);
+  destination[length] = '\0';
+}
+
+size_t RoundUpToPowerOfTwo(size_t value) {
+  size_t power = 1;
+  while (power < value) power <<= 1;
+  return power;
+}
+
+}  // namespace
+
+const char* OrderStateName(OrderState state) {
+  switch (state) {
+    case OrderState::FREE: return "FREE";
+    case OrderState::PENDING: return "PENDING";
+    case OrderState::ACCEPTED: return "ACCEPTED";
+    case OrderState::REJECTED: return "REJECTED";
+    case OrderState::CANCEL_PENDING: return "CANCEL_PENDING";
+    case OrderState::CANCELLED: return "CANCELLED";
+    case OrderState::UNKNOWN: return "UNKNOWN";
+    case OrderState::CLAIMING: return "CLAIMING";
+  }
+  return "UNKNOWN";
+}
+
+KrakenOrderGateway::KrakenOrderGateway(const std::string& ws_endpoint, KrakenBase& rest, size_t max_orders)
+    : KrakenWebSocketBase(ws_endpoint),
+      rest_(rest),
+      slots_(new OrderSlot[RoundUpToPowerOfTwo(std::max<size_t>(max_orders, 2))]),
+      mask_(RoundUpToPowerOfTwo(std::max<size_t>(max_orders, 2)) - 1),
+      next_req_id_(1),
+      validate_only_(false),
+      token_length_(0),
+      token_request_pending_(false),
+      token_from_rest_(false) {
+  for (size_t i = 0; i <= mask_; i++) {
+    slots_[i].req_id.store(0, std::memory_order_relaxed);
+    slots_[i].state.store(OrderState::FREE, std::memory_order_relaxed);
+  }
+}
+
+void KrakenOrderGateway::Authenticate() {
+  RestResponse response = rest_.PrivateRequest("GetWebSocketsToken", "");
+  if (!response.error.empty()) {
+    throw std::runtime_error("WebSocket token request failed: " + response.error);
+  }
+
+  json body = json::parse(response.body, nullptr, false);
+  if (body.is_discarded() || !body.contains("result") || !body["result"].contains("token")) {
+    throw std::runtime_error("WebSocket token request failed: " + response.body);
+  }
+  const std::string& token = body["result"]["token"].get_ref<const std::string&>();
+  if (token.size() >= kMaxTokenSize) {
+    throw std::runtime_error("WebSocket token too long");
+  }
+
+  std::lock_guard<std::mutex> lock(token_mutex_);
+  std::memcpy(token_, token.data(), token.size());
+  token_length_ = token.size();
+  token_from_rest_ = true;
+}
+
+void KrakenOrderGateway::SetToken(std::string_view token) {
+  if (token.size() >= kMaxTokenSize) {
+    throw std::runtime_error("WebSocket token too long");
+  }
+  std::lock_guard<std::mutex> lock(token_mutex_);
+  std::memcpy(token_, token.data(), token.size());
+  token_length_ = token.size();
+  token_from_rest_ = false;
+}
+
+void KrakenOrderGateway::RequestToken() {
+  if (token_request_pending_.exchange(true)) return;
+
+  rest_.PrivateRequestAsync("GetWebSocketsToken", "", [this](const RestResponse& response) {
+    json body = json::parse(response.body, nullptr, false);
+    if (response.error.empty() && !body.is_discarded() && body.contains("result") &&
+        body["result"].contains("token")) {
+      const std::string& token = body["result"]["token"].get_ref<const std::string&>();
+      if (token.size() < kMaxTokenSize) {
+        std::lock_guard<std::mutex> lock(token_mutex_);
+        std::memcpy(token_, token.data(), token.size());
+        token_length_ = token.size();
+      }
+    } else {
+      std::cerr << "WebSocket token refresh failed: "
+                << (response.error.empty() ? response.body : response.error) << std::endl;
+    }
+    token_request_pending_ = false;
+  });
+}
+
+bool KrakenOrderGateway::AppendToken(char*& out, const char* end) const {
+  std::lock_guard<std::mutex> lock(token_mutex_);
+  if (token_length_ == 0 || static_cast<size_t>(end - out) < token_length_) return false;
+  std::memcpy(out, token_, token_length_);
+  out += token_length_;
+  return true;
+}
+
+void KrakenOrderGateway::SetValidateOnly(bool validate_only) {
+  validate_only_ = validate_only;
+}
+
+void KrakenOrderGateway::SetOrderCallback(std::function<void(const OrderAck&)> callback) {
+  order_callback_ = callback;
+}
+
+void KrakenOrderGateway::OnConnected() {
+  std::cout << "✓ Order gateway ready" << (validate_only_ ? " (validate only)" : "") << std::endl;
+}
+
+void KrakenOrderGateway::OnConnectionLost() {
+  // Replies for anything still in flight went down with the socket.
+  for (size_t i = 0; i <= mask_; i++) {
+    OrderSlot& slot = slots_[i];
+    OrderState state = slot.state.load(std::memory_order_acquire);
+    if (IsInFlight(state)) {
+      Complete(slot.req_id.load(std::memory_order_relaxed), state == OrderState::CANCEL_PENDING,
+               false, {}, "connection lost", true);
+    }
+  }
+
+  // A token stays valid only while its connection lives; fetch a new one
+  // during the reconnect backoff.
+  if (token_from_rest_) RequestToken();
+}
+
+KrakenOrderGateway::OrderSlot* KrakenOrderGateway::Claim(uint64_t req_id, const OrderRequest& order) {
+  OrderSlot& slot = slots_[req_id & mask_];
+  OrderState state = slot.state.load(std::memory_order_acquire);
+  if (IsInFlight(state) || state == OrderState::CLAIMING ||
+      !slot.state.compare_exchange_strong(state, OrderState::CLAIMING, std::memory_order_acq_rel)) {
+    std::cerr << "Order table full, order " << req_id << " refused" << std::endl;
+    return nullptr;
+  }
+
+  // The new req_id is stored before PENDING is published, so a late reply
+  // for the slot's previous order can never match this one.
+  slot.request = order;
+  slot.sent_ns = EventLoop::NowNanos();
+  slot.ack_ns = 0;
+  slot.order_id[0] = '\0';
+  slot.error[0] = '\0';
+  slot.req_id.store(req_id, std::memory_order_relaxed);
+  slot.state.store(OrderState::PENDING, std::memory_order_release);
+  return &slot;
+}
+
+void KrakenOrderGateway::Unclaim(OrderSlot* slot) {
+  CopyTruncated(slot->error, kErrorSize, "not sent");
+  slot->state.store(OrderState::REJECTED, std::memory_order_release);
+}
+
+size_t KrakenOrderGateway::FormatAddOrder(char* buffer, size_t capacity, uint64_t req_id,
+                                          const OrderRequest& order) {
+  FrameWriter writer{buffer, buffer + capacity, true};
+  writer.Append(R"({"method":"add_order","params":{"order_type":")");
+  writer.Append(TypeName(order.type));
+  writer.Append(R"(","side":")");
+  writer.Append(SideName(order.side));
+  writer.Append(R"(","order_qty":)");
+  writer.AppendDecimal(order.quantity);
+  if (order.type == OrderType::LIMIT) {
+    writer.Append(R"(,"limit_price":)");
+    writer.AppendDecimal(order.limit_price);
+  }
+  writer.Append(R"(,"symbol":")");
+  writer.Append(SymbolRegistry::Global().Name(order.symbol));
+  if (validate_only_.load(std::memory_order_relaxed)) {
+    writer.Append(R"(","validate":true,"token":")");
+  } else {
+    writer.Append(R"(","token":")");
+  }
+  if (writer.ok && !AppendToken(writer.out, writer.end)) {
+    return 0;
+  }
+  writer.Append(R"("},"req_id":)");
+  writer.AppendUint(req_id);
+  writer.Append("}");
+  return writer.ok ? static_cast<size_t>(writer.out - buffer) : 0;
+}
+
+bool KrakenOrderGateway::QueueAddOrder(const OrderRequest& order, uint64_t& req_id) {
+  req_id = next_req_id_.fetch_add(1, std::memory_order_relaxed);
+  OrderSlot* slot = Claim(req_id, order);
+  if (!slot) return false;
+
+  char frame[kMaxFrameSize];
+  size_t length = FormatAddOrder(frame, sizeof(frame), req_id, order);
+  if (length == 0 || !QueueMessage(frame, length)) {
+    Unclaim(slot);
+    return false;
+  }
+  LatencyRecorder::Record(LatencyStage::TICK_TO_ORDER, LatencyRecorder::CurrentReceive(), TscNow());
+  return true;
+}
+
+uint64_t KrakenOrderGateway::AddOrder(const OrderRequest& order) {
+  uint64_t req_id = 0;
+  if (!QueueAddOrder(order, req_id)) return 0;
+  FlushMessages();
+  return req_id;
+}
+
+bool KrakenOrderGateway::AddSpread(const OrderRequest& first, const OrderRequest& second, uint64_t req_ids[2]) {
+  req_ids[0] = 0;
+  req_ids[1] = 0;
+  uint64_t first_req_id = next_req_id_.fetch_add(2, std::memory_order_relaxed);
+  OrderSlot* slots[2] = {Claim(first_req_id, first), nullptr};
+  if (!slots[0]) return false;
+  slots[1] = Claim(first_req_id + 1, second);
+  if (!slots[1]) {
+    Unclaim(slots[0]);
+    return false;
+  }
+
+  // Both frames are built and queued as one chain before the socket wakes,
+  // so either both legs reach the wire or neither does.
+  char frames[2][kMaxFrameSize];
+  std::string_view messages[2];
+  const OrderRequest* orders[2] = {&first, &second};
+  for (size_t i = 0; i < 2; i++) {
+    size_t length = FormatAddOrder(frames[i], kMaxFrameSize, first_req_id + i, *orders[i]);
+    messages[i] = std::string_view(frames[i], length);
+  }
+  if (messages[0].empty() || messages[1].empty() || !QueueMessages(messages, 2)) {
+    Unclaim(slots[0]);
+    Unclaim(slots[1]);
+    return false;
+  }
+  LatencyRecorder::Record(LatencyStage::TICK_TO_ORDER, LatencyRecorder::CurrentReceive(), TscNow());
+  FlushMessages();
+  req_ids[0] = first_req_id;
+  req_ids[1] = first_req_id + 1;
+  return true;
+}
+
+uint64_t KrakenOrderGateway::BatchAdd(const OrderRequest* orders, size_t count) {
+  if (count < 2 || count > kMaxBatchOrders) return 0;
+  for (size_t i = 1; i < count; i++) {
+    if (orders[i].symbol != orders[0].symbol) return 0;
+  }
+
+  uint64_t first_req_id = next_req_id_.fetch_add(count, std::memory_order_relaxed);
+  OrderSlot* claimed[kMaxBatchOrders];
+  for (size_t i = 0; i < count; i++) {
+    claimed[i] = Claim(first_req_id + i, orders[i]);
+    if (!claimed[i]) {
+      for (size_t j = 0; j < i; j++) Unclaim(claimed[j]);
+      return 0;
+    }
+  }
+
+  char frame[kMaxFrameSize];
+  FrameWriter writer{frame, frame + sizeof(frame), true};
+  writer.Append(R"({"method":"batch_add","params":{"orders":[)");
+  for (size_t i = 0; i < count; i++) {
+    const OrderRequest& order = orders[i];
+    writer.Append(i == 0 ? R"({"order_type":")" : R"(,{"order_type":")");
+    writer.Append(TypeName(order.type));
+    writer.Append(R"(","side":")");
+    writer.Append(SideName(order.side));
+    writer.Append(R"(","order_qty":)");
+    writer.AppendDecimal(order.quantity);
+    if (order.type == OrderType::LIMIT) {
+      writer.Append(R"(,"limit_price":)");
+      writer.AppendDecimal(order.limit_price);
+    }
+    writer.Append("}");
+  }
+  writer.Append(R"(],"symbol":")");
+  writer.Append(SymbolRegistry::Global().Name(orders[0].symbol));
+  if (validate_only_.load(std::memory_order_relaxed)) {
+    writer.Append(R"(","validate":true,"token":")");
+  } else {
+    writer.Append(R"(","token":")");
+  }
+  if (writer.ok && !AppendToken(writer.out, writer.end)) {
+    writer.ok = false;
+  }
+  writer.Append(R"("},"req_id":)");
+  writer.AppendUint(first_req_id);
+  writer.Append("}");
+
+  if (!writer.ok || !SendMessage(frame, static_cast<size_t>(writer.out - frame))) {
+    for (size_t i = 0; i < count; i++) Unclaim(claimed[i]);
+    return 0;
+  }
+  return first_req_id;
+}
+
+bool KrakenOrderGateway::CancelOrder(uint64_t req_id) {
+  OrderSlot& slot = slots_[req_id & mask_];
+  if (slot.req_id.load(std::memory_order_acquire) != req_id) return false;
+
+  OrderState expected = OrderState::ACCEPTED;
+  if (!slot.state.compare_exchange_strong(expected, OrderState::CANCEL_PENDING, std::memory_order_acq_rel)) {
+    return false;
+  }
+  // The slot may have been reused, and the new order accepted, since the
+  // check above.
+  if (slot.req_id.load(std::memory_order_relaxed) != req_id) {
+    slot.state.store(OrderState::ACCEPTED, std::memory_order_release);
+    return false;
+  }
+
+  char frame[kMaxFrameSize];
+  FrameWriter writer{frame, frame + sizeof(frame), true};
+  writer.Append(R"({"method":"cancel_order","params":{"order_id":[")");
+  writer.Append(slot.order_id);
+  writer.Append(R"("],"token":")");
+  if (writer.ok && !AppendToken(writer.out, writer.end)) {
+    writer.ok = false;
+  }
+  writer.Append(R"("},"req_id":)");
+  writer.AppendUint(req_id | kCancelFlag);
+  writer.Append("}");
+
+  if (!writer.ok || !SendMessage(frame, static_cast<size_t>(writer.out - frame))) {
+    slot.state.store(OrderState::ACCEPTED, std::memory_order_release);
+    return false;
+  }
+  return true;
+}
+
+OrderState KrakenOrderGateway::State(uint64_t req_id) const {
+  const OrderSlot& slot = slots_[req_id & mask_];
+  OrderState state = slot.state.load(std::memory_order_acquire);
+  if (state == OrderState::CLAIMING || slot.req_id.load(std::memory_order_relaxed) != req_id) {
+    return OrderState::FREE;
+  }
+  return state;
+}
+
+void KrakenOrderGateway::Complete(uint64_t req_id, bool is_cancel, bool success, std::string_view order_id,
+                                  std::string_view error, bool connection_lost) {
+  uint64_t order_req_id = req_id & ~kCancelFlag;
+  OrderSlot& slot = slots_[order_req_id & mask_];
+  // State first: the acquire makes the req_id stored before it visible.
+  OrderState state = slot.state.load(std::memory_order_acquire);
+  if (state != (is_cancel ? OrderState::CANCEL_PENDING : OrderState::PENDING)) return;
+  if (slot.req_id.load(std::memory_order_relaxed) != order_req_id) return;
+
+  OrderState next;
+  if (connection_lost) {
+    next = OrderState::UNKNOWN;
+  } else if (is_cancel) {
+    // A refused cancel leaves the order as it was.
+    next = success ? OrderState::CANCELLED : OrderState::ACCEPTED;
+  } else {
+    next = success ? OrderState::ACCEPTED : OrderState::REJECTED;
+  }
+
+  slot.ack_ns = EventLoop::NowNanos();
+  if (!order_id.empty()) CopyTruncated(slot.order_id, kOrderIdSize, order_id);
+  CopyTruncated(slot.error, kErrorSize, error);
+  slot.state.store(next, std::memory_order_release);
+
+  if (order_callback_) {
+    OrderAck ack;
+    ack.req_id = order_req_id;
+    ack.state = next;
+    ack.success = success;
+    ack.request = slot.request;
+    ack.sent_ns = slot.sent_ns;
+    ack.ack_ns = slot.ack_ns;
+    ack.order_id = slot.order_id;
+    ack.error = slot.error;
+    order_callback_(ack);
+  }
+}
+
+void KrakenOrderGateway::HandleRawMessage(const char* data, size_t length) {
+  // Keys may come in any order, so record where result starts and read it
+  // once method, req_id and success are known.
+  JsonCursor cursor(data, data + length);
+  std::string_view key;
+  std::string_view method;
+  std::string_view error;
+  int64_t req_id = 0;
+  bool success = false;
+  const char* result = nullptr;
+
+  if (!cursor.EnterObject()) return;
+  while (cursor.NextKey(key)) {
+    if (key == "method") {
+      cursor.ReadString(method);
+    } else if (key == "req_id") {
+      cursor.ReadInt64(req_id);
+    } else if (key == "success") {
+      cursor.ReadBool(success);
+    } else if (key == "error") {
+      cursor.ReadString(error);
+    } else if (key == "result") {
+      result = cursor.Position();
+      cursor.SkipValue();
+    } else {
+      cursor.SkipValue();
+    }
+  }
+  if (cursor.Failed()) {
+    std::cerr << "Error parsing order reply: malformed message" << std::endl;
+    return;
+  }
+
+  bool is_add = method == "add_order";
+  bool is_batch = method == "batch_add";
+  bool is_cancel = method == "cancel_order";
+  if ((!is_add && !is_batch && !is_cancel) || req_id <= 0) return;
+
+  if (!result || !success) {
+    uint64_t count = is_batch ? kMaxBatchOrders : 1;
+    for (uint64_t i = 0; i < count; i++) {
+      // Slots past the end of a batch belong to other orders and are
+      // skipped by the PENDING check in Complete().
+      if (is_batch && i > 0 && State(static_cast<uint64_t>(req_id) + i) != OrderState::PENDING) break;
+      Complete(static_cast<uint64_t>(req_id) + i, is_cancel, success, {}, error);
+    }
+    return;
+  }
+
+  JsonCursor reader(result, cursor.End());
+  std::string_view order_id;
+  if (is_batch) {
+    if (!reader.EnterArray()) return;
+    for (uint64_t i = 0; reader.NextElement(); i++) {
+      order_id = {};
+      if (reader.EnterObject()) {
+        while (reader.NextKey(key)) {
+          if (key == "order_id") reader.ReadString(order_id);
+          else reader.SkipValue();
+        }
+      }
+      Complete(static_cast<uint64_t>(req_id) + i, false, true, order_id, {});
+    }
+    return;
+  }
+
+  if (reader.EnterObject()) {
+    while (reader.NextKey(key)) {
+      if (key == "order_id") reader.ReadString(order_id);
+      else reader.SkipValue();
+    }
+  }
+  Complete(static_cast<uint64_t>(req_id), is_cancel, true, order_id, {});
+}
+
+void KrakenOrderGateway::HandleMessage(const json& message) {
+  std::string text = message.dump();
+  HandleRawMessage(text.data(), text.size());
+}
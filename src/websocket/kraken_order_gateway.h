@@ -0,0 +1,161 @@
+#ifndef KRAKEN_ORDER_GATEWAY_H
+#define KRAKEN_ORDER_GATEWAY_H
+
+#include "kraken_websocket_base.h"
+#include "../market_data/decimal.h"
+#include "../market_data/symbol_registry.h"
+#include "../rest/kraken_base.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+enum class OrderSide : uint8_t {
+  BUY,
+  SELL
+};
+
+enum class OrderType : uint8_t {
+  MARKET,
+  LIMIT
+};
+
+enum class OrderState : uint8_t {
+  FREE,
+  // Sent, waiting for the add_order acknowledgement.
+  PENDING,
+  ACCEPTED,
+  REJECTED,
+  CANCEL_PENDING,
+  CANCELLED,
+  // The connection dropped before the add or cancel was acknowledged;
+  // check OpenOrders over REST to find out what happened.
+  UNKNOWN,
+  // A submitting thread is filling the slot in; never reported.
+  CLAIMING
+};
+
+const char* OrderStateName(OrderState state);
+
+struct OrderRequest {
+  SymbolId symbol;
+  OrderSide side;
+  OrderType type;
+  // Sent exactly as given, so the scales should match the pair's lot and
+  // tick decimals.
+  Decimal quantity;
+  // Ignored for market orders.
+  Decimal limit_price;
+};
+
+// Delivered on the gateway's service thread; the strings are only valid for
+// the duration of the callback.
+struct OrderAck {
+  uint64_t req_id;
+  OrderState state;
+  bool success;
+  OrderRequest request;
+  int64_t sent_ns;
+  int64_t ack_ns;
+  const char* order_id;
+  const char* error;
+};
+
+// Order entry over Kraken's authenticated v2 WebSocket. Requests are
+// formatted on the caller's thread into a stack buffer, queued on the
+// outbound frame pool and tracked by req_id in a fixed table of max_orders
+// slots (rounded up to a power of two), so submitting an order never
+// allocates.
+//
+// The table keeps the most recent orders only: a slot is reused once its
+// order is no longer in flight, after which CancelOrder() on the old req_id
+// fails. A submission that would overwrite an in-flight order is refused.
+class KrakenOrderGateway : public KrakenWebSocketBase {
+ public:
+  KrakenOrderGateway(const std::string& ws_endpoint, KrakenBase& rest, size_t max_orders = 1024);
+
+  // Fetches a WebSocket token over REST. Call before Connect(); throws
+  // std::runtime_error if Kraken refuses. Reconnects refresh it as needed.
+  void Authenticate();
+  // Uses a token obtained elsewhere instead, e.g. a local mock server's.
+  // It is kept across reconnects rather than refreshed over REST. Throws
+  // std::runtime_error if it is too long.
+  void SetToken(std::string_view token);
+
+  // Sends add_order with validate set, so Kraken checks but never books.
+  void SetValidateOnly(bool validate_only);
+  void SetOrderCallback(std::function<void(const OrderAck&)> callback);
+
+  // All of these are safe to call from any thread and return 0 or false
+  // when not connected, not authenticated or out of slots.
+  uint64_t AddOrder(const OrderRequest& order);
+  // Both legs or neither: the slots are claimed and both frames formatted
+  // and queued as one chain before the socket wakes, so they leave back to
+  // back in the same writeable callback. Returns false, with req_ids 0 and
+  // nothing sent, if either leg cannot go out.
+  bool AddSpread(const OrderRequest& first, const OrderRequest& second, uint64_t req_ids[2]);
+  // One batch_add for 2..kMaxBatchOrders orders on the same symbol. Orders
+  // get consecutive req_ids starting at the returned one.
+  uint64_t BatchAdd(const OrderRequest* orders, size_t count);
+  bool CancelOrder(uint64_t req_id);
+
+  OrderState State(uint64_t req_id) const;
+
+  static constexpr size_t kMaxBatchOrders = 15;
+
+ protected:
+  void HandleMessage(const json& message) override;
+  void HandleRawMessage(const char* data, size_t length) override;
+  void OnConnected() override;
+  void OnConnectionLost() override;
+
+ private:
+  static constexpr size_t kOrderIdSize = 40;
+  static constexpr size_t kErrorSize = 96;
+  static constexpr size_t kMaxFrameSize = 4096;
+  static constexpr size_t kMaxTokenSize = 256;
+  // Set in the req_id of a cancel_order so its reply maps back to the order.
+  static constexpr uint64_t kCancelFlag = 1ull << 48;
+
+  struct alignas(64) OrderSlot {
+    std::atomic<uint64_t> req_id;
+    std::atomic<OrderState> state;
+    OrderRequest request;
+    int64_t sent_ns;
+    int64_t ack_ns;
+    // Written on the service thread before state is published.
+    char order_id[kOrderIdSize];
+    char error[kErrorSize];
+  };
+
+  OrderSlot* Claim(uint64_t req_id, const OrderRequest& order);
+  void Unclaim(OrderSlot* slot);
+  // Formats one add_order; returns the length or 0 if it did not fit.
+  size_t FormatAddOrder(char* buffer, size_t capacity, uint64_t req_id, const OrderRequest& order);
+  bool QueueAddOrder(const OrderRequest& order, uint64_t& req_id);
+  void Complete(uint64_t req_id, bool is_cancel, bool success, std::string_view order_id,
+                std::string_view error, bool connection_lost = false);
+  void RequestToken();
+  // Appends the current token; returns false if there is none yet.
+  bool AppendToken(char*& out, const char* end) const;
+
+  KrakenBase& rest_;
+  std::unique_ptr<OrderSlot[]> slots_;
+  size_t mask_;
+  std::atomic<uint64_t> next_req_id_;
+  std::atomic<bool> validate_only_;
+  std::function<void(const OrderAck&)> order_callback_;
+
+  // Read by every submitter, replaced on reconnect.
+  mutable std::mutex token_mutex_;
+  char token_[kMaxTokenSize];
+  size_t token_length_;
+  std::atomic<bool> token_request_pending_;
+  // Set by Authenticate(): the token is fetched again after a disconnect.
+  std::atomic<bool> token_from_rest_;
+};
+
+#endif
@@ -1,40 +1,120 @@
 #include "kraken_websocket_base.h"
+#include "../pipeline/latency_recorder.h"
+#include <algorithm>
 #include <iostream>
 #include <cstring>
 
+namespace {
+
+// Initial reassembly capacity; large snapshots grow it once and it stays.
+const size_t kReceiveBufferReserve = 64 * 1024;
+
+// lws expects lws_service_fd(context, NULL) about once a second to run its
+// internal timeouts when the application owns the poll loop.
+const int64_t kHousekeepingIntervalNs = 1000000000;
+const int64_t kDefaultHeartbeatTimeoutMs = 10000;
+
+const int64_t kInitialReconnectDelayNs = 500000000;
+const int64_t kMaxReconnectDelayNs = 30000000000;
+
+}  // namespace
+
+bool ParseWebSocketEndpoint(const std::string& url, WebSocketEndpoint& endpoint) {
+  std::string rest;
+  if (url.compare(0, 6, "wss://") == 0) {
+    endpoint.use_tls = true;
+    endpoint.port = 443;
+    rest = url.substr(6);
+  } else if (url.compare(0, 5, "ws://") == 0) {
+    endpoint.use_tls = false;
+    endpoint.port = 80;
+    rest = url.substr(5);
+  } else {
+    return false;
+  }
+  
+  size_t slash = rest.find('/');
+  std::string authority = rest.substr(0, slash);
+  endpoint.path = slash == std::string::npos ? "/" : rest.substr(slash);
+  
+  size_t colon = authority.rfind(':');
+  if (colon != std::string::npos) {
+    std::string port = authority.substr(colon + 1);
+    if (port.empty() || port.find_first_not_of("0123456789") != std::string::npos) return false;
+    endpoint.port = std::stoi(port);
+    authority.resize(colon);
+  }
+  endpoint.host = authority;
+  return !endpoint.host.empty() && endpoint.port > 0 && endpoint.port < 65536;
+}
+
 KrakenWebSocketBase::KrakenWebSocketBase(const std::string& ws_endpoint)
-    : ws_endpoint_(ws_endpoint), context_(nullptr), wsi_(nullptr), running_(false), connected_(false) {}
+    : ws_endpoint_(ws_endpoint), context_(nullptr), wsi_(nullptr), running_(false), connected_(false),
+      service_thread_(std::thread::id()), housekeeping_timer_(0), reconnect_timer_(0),
+      heartbeat_timeout_ns_(kDefaultHeartbeatTimeoutMs * 1000000), last_receive_ns_(0),
+      reconnect_(false), reconnect_delay_ns_(kInitialReconnectDelayNs) {
+  rx_buffer_.reserve(kReceiveBufferReserve);
+}
 
 KrakenWebSocketBase::~KrakenWebSocketBase() {
-  Stop();
+  DestroyContext();
 }
 
 int KrakenWebSocketBase::WebSocketCallback(struct lws* wsi, enum lws_callback_reasons reason,
                                            void* user, void* in, size_t len) {
+  (void)user;
   KrakenWebSocketBase* ws = static_cast<KrakenWebSocketBase*>(lws_context_user(lws_get_context(wsi)));
   
   switch (reason) {
+    // External poll integration: lws reports every socket it wants watched.
+    case LWS_CALLBACK_ADD_POLL_FD: {
+      auto* args = static_cast<struct lws_pollargs*>(in);
+      ws->loop_.AddFd(args->fd, static_cast<short>(args->events),
+                      [ws](int fd, short revents) { ws->ServiceFd(fd, revents); });
+      break;
+    }
+    
+    case LWS_CALLBACK_DEL_POLL_FD:
+      ws->loop_.RemoveFd(static_cast<struct lws_pollargs*>(in)->fd);
+      break;
+    
+    case LWS_CALLBACK_CHANGE_MODE_POLL_FD: {
+      auto* args = static_cast<struct lws_pollargs*>(in);
+      ws->loop_.ModifyFd(args->fd, static_cast<short>(args->events));
+      break;
+    }
+    
     case LWS_CALLBACK_CLIENT_ESTABLISHED:
-      std::cout << "✓ WebSocket connected" << std::endl;
+      std::cout << "✓ WebSocket connected to " << ws->endpoint_.host << std::endl;
       ws->connected_ = true;
-      ws->SendPendingSubscription();
+      ws->last_receive_ns_ = EventLoop::NowNanos();
+      ws->reconnect_delay_ns_ = kInitialReconnectDelayNs;
+      ws->SendSubscriptions();
+      ws->OnConnected();
       break;
       
-    case LWS_CALLBACK_CLIENT_RECEIVE: {
-      std::string message((char*)in, len);
-      try {
-        json j = json::parse(message);
-        ws->HandleMessage(j);
-      } catch (const std::exception& e) {
-        std::cerr << "Error parsing message: " << e.what() << std::endl;
+    case LWS_CALLBACK_CLIENT_WRITEABLE:
+      if (!ws->DrainOutbound(wsi)) {
+        return -1;
       }
       break;
-    }
+    
+    // Raised on the service thread by lws_cancel_service() from a sender on
+    // another thread.
+    case LWS_CALLBACK_EVENT_WAIT_CANCELLED:
+      if (ws->wsi_ && ws->connected_ && !ws->outbound_.Empty()) {
+        lws_callback_on_writable(ws->wsi_);
+      }
+      break;
+      
+    case LWS_CALLBACK_CLIENT_RECEIVE:
+      ws->last_receive_ns_ = EventLoop::NowNanos();
+      ws->OnReceive(wsi, static_cast<const char*>(in), len);
+      break;
     
     case LWS_CALLBACK_CLIENT_CLOSED:
       std::cout << "WebSocket closed" << std::endl;
-      ws->running_ = false;
-      ws->connected_ = false;
+      ws->OnDisconnected();
       break;
       
     case LWS_CALLBACK_CLIENT_CONNECTION_ERROR:
@@ -43,8 +123,7 @@ int KrakenWebSocketBase::WebSocketCallback(struct lws* wsi, enum lws_callback_re
         std::cerr << ": " << (char*)in;
       }
       std::cerr << std::endl;
-      ws->running_ = false;
-      ws->connected_ = false;
+      ws->OnDisconnected();
       break;
       
     default:
@@ -54,15 +133,102 @@ int KrakenWebSocketBase::WebSocketCallback(struct lws* wsi, enum lws_callback_re
   return 0;
 }
 
-void KrakenWebSocketBase::Connect() {
+void KrakenWebSocketBase::OnReceive(struct lws* wsi, const char* data, size_t length) {
+  bool complete = lws_is_final_fragment(wsi) && lws_remaining_packet_payload(wsi) == 0;
+  // A fragmented message is stamped when its first piece arrives.
+  if (rx_buffer_.empty() && LatencyRecorder::Enabled()) {
+    LatencyRecorder::SetCurrentReceive(TscNow());
+  }
+
+  // Common case: the whole message arrived in one piece, parse it in place.
+  if (complete && rx_buffer_.empty()) {
+    HandleRawMessage(data, length);
+    return;
+  }
+
+  rx_buffer_.append(data, length);
+  if (complete) {
+    HandleRawMessage(rx_buffer_.data(), rx_buffer_.size());
+    rx_buffer_.clear();
+  }
+}
+
+void KrakenWebSocketBase::ServiceFd(int fd, short revents) {
+  if (!context_) return;
+  
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = revents;
+  pfd.revents = revents;
+  lws_service_fd(context_, &pfd);
+}
+
+void KrakenWebSocketBase::CheckHeartbeat() {
+  if (!connected_ || heartbeat_timeout_ns_ <= 0) return;
+  
+  int64_t silent_ns = EventLoop::NowNanos() - last_receive_ns_;
+  if (silent_ns > heartbeat_timeout_ns_) {
+    std::cerr << "WebSocket silent for " << silent_ns / 1000000 << " ms, dropping connection" << std::endl;
+    if (reconnect_ && wsi_) {
+      // Closing reports CLIENT_CLOSED, which schedules the reconnect.
+      lws_set_timeout(wsi_, PENDING_TIMEOUT_USER_OK, LWS_TO_KILL_ASYNC);
+    } else {
+      Stop();
+    }
+  }
+}
+
+void KrakenWebSocketBase::OnDisconnected() {
+  wsi_ = nullptr;
+  connected_ = false;
+  rx_buffer_.clear();
+  
+  // Anything still queued was meant for the old session; subscriptions are
+  // replayed from subscriptions_ and orders must not fire late.
+  size_t dropped = outbound_.Clear();
+  if (dropped > 0) {
+    std::cerr << "Dropped " << dropped << " unsent frame(s)" << std::endl;
+  }
+  OnConnectionLost();
+  
+  if (!running_ || !reconnect_) {
+    running_ = false;
+    loop_.RequestStop();
+    return;
+  }
+  
+  if (reconnect_timer_) return;
+  std::cerr << "Reconnecting in " << reconnect_delay_ns_ / 1000000 << " ms" << std::endl;
+  reconnect_timer_ = loop_.AddTimer(reconnect_delay_ns_, 0, [this]() {
+    reconnect_timer_ = 0;
+    if (running_ && !ConnectClient()) {
+      OnDisconnected();
+    }
+  });
+  reconnect_delay_ns_ = std::min(reconnect_delay_ns_ * 2, kMaxReconnectDelayNs);
+}
+
+void KrakenWebSocketBase::HandleRawMessage(const char* data, size_t length) {
+  try {
+    json j = json::parse(data, data + length);
+    HandleMessage(j);
+  } catch (const std::exception& e) {
+    std::cerr << "Error parsing message: " << e.what() << std::endl;
+  }
+}
+
+void KrakenWebSocketBase::CreateContext() {
   static struct lws_protocols protocols[] = {
     {
       "kraken-protocol",
       WebSocketCallback,
       0,
       4096,
+      0,
+      NULL,
+      0,
     },
-    { NULL, NULL, 0, 0 }
+    { NULL, NULL, 0, 0, 0, NULL, 0 }
   };
   
   struct lws_context_creation_info info;
@@ -79,64 +245,210 @@ void KrakenWebSocketBase::Connect() {
   if (!context_) {
     throw std::runtime_error("Failed to create WebSocket context");
   }
-  
+}
+
+bool KrakenWebSocketBase::ConnectClient() {
   struct lws_client_connect_info ccinfo;
   memset(&ccinfo, 0, sizeof(ccinfo));
   
+  // endpoint_ outlives the connection, so lws may keep these pointers.
   ccinfo.context = context_;
-  ccinfo.address = "ws.kraken.com";
-  ccinfo.port = 443;
-  ccinfo.path = "/v2";
+  ccinfo.address = endpoint_.host.c_str();
+  ccinfo.port = endpoint_.port;
+  ccinfo.path = endpoint_.path.c_str();
   ccinfo.host = ccinfo.address;
   ccinfo.origin = ccinfo.address;
-  ccinfo.ssl_connection = LCCSCF_USE_SSL;
-  ccinfo.protocol = protocols[0].name;
+  ccinfo.ssl_connection = endpoint_.use_tls ? LCCSCF_USE_SSL : 0;
+  ccinfo.protocol = "kraken-protocol";
   
   wsi_ = lws_client_connect_via_info(&ccinfo);
-  if (!wsi_) {
-    lws_context_destroy(context_);
+  return wsi_ != nullptr;
+}
+
+void KrakenWebSocketBase::Connect() {
+  if (!ParseWebSocketEndpoint(ws_endpoint_, endpoint_)) {
+    throw std::runtime_error("Invalid WebSocket endpoint: " + ws_endpoint_);
+  }
+  
+  if (!context_) {
+    CreateContext();
+  }
+  
+  if (!ConnectClient()) {
+    DestroyContext();
     throw std::runtime_error("Failed to connect to WebSocket");
   }
   
   running_ = true;
+  if (!housekeeping_timer_) {
+    housekeeping_timer_ = loop_.AddTimer(kHousekeepingIntervalNs, kHousekeepingIntervalNs, [this]() {
+      if (context_) lws_service_fd(context_, nullptr);
+      CheckHeartbeat();
+    });
+  }
 }
 
 void KrakenWebSocketBase::Subscribe(const json& subscription) {
-  pending_subscription_ = subscription.dump();
-  
-  if (connected_) {
-    SendPendingSubscription();
+  // Hop onto the loop thread so subscriptions_ and the socket are only ever
+  // touched there; before Run() the task simply waits in the queue.
+  loop_.Post([this, subscription]() {
+    subscriptions_.push_back(subscription);
+    if (connected_) {
+      SendMessage(subscription.dump());
+    }
+  });
+}
+
+void KrakenWebSocketBase::Unsubscribe(const json& unsubscription) {
+  loop_.Post([this, unsubscription]() {
+    const json& params = unsubscription["params"];
+    for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+      json& recorded = (*it)["params"];
+      bool same_channel = recorded.value("channel", "") == params.value("channel", "") &&
+                          (!params.contains("interval") || recorded.value("interval", 0) == params["interval"]);
+      if (same_channel && recorded.contains("symbol") && params.contains("symbol")) {
+        json remaining = json::array();
+        for (const auto& symbol : recorded["symbol"]) {
+          if (std::find(params["symbol"].begin(), params["symbol"].end(), symbol) == params["symbol"].end()) {
+            remaining.push_back(symbol);
+          }
+        }
+        recorded["symbol"] = remaining;
+      }
+      it = same_channel && recorded["symbol"].empty() ? subscriptions_.erase(it) : it + 1;
+    }
+    if (connected_) {
+      SendMessage(unsubscription.dump());
+    }
+  });
+}
+
+bool KrakenWebSocketBase::SendMessage(const std::string& message) {
+  return SendMessage(message.data(), message.size());
+}
+
+bool KrakenWebSocketBase::SendMessage(const char* data, size_t length) {
+  if (!QueueMessage(data, length)) return false;
+  FlushMessages();
+  return true;
+}
+
+bool KrakenWebSocketBase::QueueMessage(const char* data, size_t length) {
+  if (!connected_) return false;
+  if (!outbound_.Enqueue(data, length)) {
+    std::cerr << "WebSocket send queue full, message dropped" << std::endl;
+    return false;
   }
+  return true;
 }
 
-void KrakenWebSocketBase::SendMessage(const std::string& message) {
-  if (!wsi_) return;
-  
-  unsigned char buf[LWS_PRE + 2048];
-  memcpy(&buf[LWS_PRE], message.c_str(), message.length());
-  lws_write(wsi_, &buf[LWS_PRE], message.length(), LWS_WRITE_TEXT);
+bool KrakenWebSocketBase::QueueMessages(const std::string_view* messages, size_t count) {
+  if (!connected_) return false;
+  if (!outbound_.EnqueueAll(messages, count)) {
+    std::cerr << "WebSocket send queue full, messages dropped" << std::endl;
+    return false;
+  }
+  return true;
 }
 
-void KrakenWebSocketBase::SendPendingSubscription() {
-  if (pending_subscription_.empty() || !wsi_) {
-    return;
+void KrakenWebSocketBase::FlushMessages() {
+  // lws_callback_on_writable is only legal on the service thread; other
+  // threads wake it through lws_cancel_service, which is thread-safe.
+  if (std::this_thread::get_id() == service_thread_.load(std::memory_order_relaxed)) {
+    if (wsi_) lws_callback_on_writable(wsi_);
+  } else if (context_) {
+    lws_cancel_service(context_);
+  }
+}
+
+bool KrakenWebSocketBase::DrainOutbound(struct lws* wsi) {
+  while (OutboundFrame* frame = outbound_.Pop()) {
+    int length = static_cast<int>(frame->length);
+    int written = lws_write(wsi, frame->Payload(), frame->length,
+                            static_cast<enum lws_write_protocol>(frame->write_flags));
+    outbound_.Release(frame);
+    if (written < length) {
+      std::cerr << "WebSocket write failed" << std::endl;
+      return false;
+    }
+    
+    // Keep writing within this callback while the socket has room; once it
+    // chokes, wait for the next writeable callback.
+    if (lws_send_pipe_choked(wsi)) {
+      lws_callback_on_writable(wsi);
+      return true;
+    }
   }
   
-  std::cout << "✓ Subscribed to channel" << std::endl;
-  SendMessage(pending_subscription_);
-  pending_subscription_.clear();
+  // A producer may still be linking a chain; its lws_cancel_service()
+  // brings us back.
+  return true;
+}
+
+void KrakenWebSocketBase::SendSubscriptions() {
+  for (const auto& subscription : subscriptions_) {
+    SendMessage(subscription.dump());
+  }
+  if (!subscriptions_.empty()) {
+    std::cout << "✓ Subscribed to " << subscriptions_.size() << " channel request(s)" << std::endl;
+  }
 }
 
 void KrakenWebSocketBase::Run() {
-  while (running_) {
-    lws_service(context_, 50);
+  if (!context_) return;
+  service_thread_.store(std::this_thread::get_id());
+  
+  // Blocks in epoll until a socket, timer or Stop() needs attention, so a
+  // stop request is handled immediately instead of at the next poll tick.
+  while (running_ && !loop_.StopRequested()) {
+    loop_.RunOnce(-1);
   }
+  
+  DestroyContext();
+  service_thread_.store(std::thread::id());
+  // A Stop() that arrived before Run() still ends that run; clear it only
+  // now so the stream can be connected and run again.
+  loop_.ResetStop();
 }
 
 void KrakenWebSocketBase::Stop() {
+  running_.store(false);
+  loop_.RequestStop();
+}
+
+EventLoop& KrakenWebSocketBase::Loop() {
+  return loop_;
+}
+
+void KrakenWebSocketBase::SetHeartbeatTimeout(int64_t timeout_ms) {
+  heartbeat_timeout_ns_ = timeout_ms * 1000000;
+}
+
+void KrakenWebSocketBase::SetReconnect(bool enabled) {
+  reconnect_ = enabled;
+}
+
+bool KrakenWebSocketBase::IsConnected() const {
+  return connected_;
+}
+
+void KrakenWebSocketBase::DestroyContext() {
+  // Cleared first so the CLIENT_CLOSED raised during destruction does not
+  // schedule a reconnect.
   running_ = false;
+  if (housekeeping_timer_) {
+    loop_.CancelTimer(housekeeping_timer_);
+    housekeeping_timer_ = 0;
+  }
+  if (reconnect_timer_) {
+    loop_.CancelTimer(reconnect_timer_);
+    reconnect_timer_ = 0;
+  }
   if (context_) {
+    // Destruction closes the socket and reports DEL_POLL_FD for every fd.
     lws_context_destroy(context_);
     context_ = nullptr;
   }
+  wsi_ = nullptr;
+  connected_ = false;
 }
\ No newline at end of file
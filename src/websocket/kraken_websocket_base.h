@@ -1,38 +1,120 @@
 #ifndef KRAKEN_WEBSOCKET_BASE_H
 #define KRAKEN_WEBSOCKET_BASE_H
 
+#include "../pipeline/event_loop.h"
+#include "outbound_queue.h"
+#include <atomic>
+#include <cstdint>
 #include <string>
+#include <thread>
+#include <vector>
 #include <libwebsockets.h>
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
+struct WebSocketEndpoint {
+  std::string host;
+  int port;
+  std::string path;
+  bool use_tls;
+};
+
+// Splits ws[s]://host[:port][/path]. Defaults: port 443 for wss, 80 for ws,
+// path "/". Returns false for other schemes or an empty host.
+bool ParseWebSocketEndpoint(const std::string& url, WebSocketEndpoint& endpoint);
+
 class KrakenWebSocketBase {
  public:
   KrakenWebSocketBase(const std::string& ws_endpoint);
   virtual ~KrakenWebSocketBase();
   
+  // Connects to ws_endpoint; throws std::runtime_error if the endpoint is
+  // malformed or the connection cannot be started.
   void Connect();
+  // Services the connection on the calling thread until Stop(), or until
+  // the connection closes with reconnects disabled, then tears down.
   void Run();
+  // Async-signal-safe: only flags the loop and wakes it.
   void Stop();
   
+  // The loop Run() drives; add timers (bar-close deadlines, heartbeats)
+  // here to have them fire on the socket thread without polling.
+  EventLoop& Loop();
+  // Drops the connection if connected and silent for longer than
+  // timeout_ms (Kraken sends a heartbeat every second). 0 disables it.
+  void SetHeartbeatTimeout(int64_t timeout_ms);
+  // When enabled, a dropped connection is retried with exponential backoff
+  // and every active subscription is replayed once it is back.
+  void SetReconnect(bool enabled);
+  
+  bool IsConnected() const;
+  
  protected:
   virtual void HandleMessage(const json& message) = 0;
+  // Receives each complete, reassembled message. The default builds a json
+  // DOM and forwards to HandleMessage; hot channels override this to parse
+  // the bytes directly. data is only valid for the duration of the call.
+  virtual void HandleRawMessage(const char* data, size_t length);
   
+  // Records a subscribe request and sends it when connected. Requests are
+  // kept and replayed on every reconnect. Safe to call from any thread.
   void Subscribe(const json& subscription);
-  void SendMessage(const std::string& message);
+  // Sends an unsubscribe request and drops its symbols from the recorded
+  // subscriptions of the same channel. Safe to call from any thread.
+  void Unsubscribe(const json& unsubscription);
+  // Queues a text message for the next writeable callback. Never blocks;
+  // returns false if not connected or the frame pool is exhausted. Safe to
+  // call from any thread.
+  bool SendMessage(const std::string& message);
+  bool SendMessage(const char* data, size_t length);
+  // Queues without waking the service thread; pair with FlushMessages() to
+  // put several frames on the wire in one writeable callback.
+  bool QueueMessage(const char* data, size_t length);
+  // Queues every message or, if the frame pool cannot hold them all, none.
+  bool QueueMessages(const std::string_view* messages, size_t count);
+  void FlushMessages();
+  
+  // Called on the service thread after the handshake, once subscriptions
+  // have been replayed, and after every disconnect.
+  virtual void OnConnected() {}
+  virtual void OnConnectionLost() {}
   
   std::string ws_endpoint_;
+  WebSocketEndpoint endpoint_;
+  EventLoop loop_;
   struct lws_context* context_;
   struct lws* wsi_;
-  bool running_;
-  bool connected_;
-  std::string pending_subscription_;
+  std::atomic<bool> running_;
+  std::atomic<bool> connected_;
+  // Subscribe messages to replay on connect; only touched on the loop thread.
+  std::vector<json> subscriptions_;
+  OutboundQueue outbound_;
+  std::atomic<std::thread::id> service_thread_;
+  // Reassembly buffer for fragmented messages; cleared, never shrunk.
+  std::string rx_buffer_;
   
  private:
-  void SendPendingSubscription();
+  void OnReceive(struct lws* wsi, const char* data, size_t length);
+  void ServiceFd(int fd, short revents);
+  void CheckHeartbeat();
+  void CreateContext();
+  bool ConnectClient();
+  void OnDisconnected();
+  void SendSubscriptions();
+  // Writes queued frames until the queue empties or the socket chokes.
+  // Returns false if lws_write failed and the connection should close.
+  bool DrainOutbound(struct lws* wsi);
+  void DestroyContext();
   static int WebSocketCallback(struct lws* wsi, enum lws_callback_reasons reason,
                                void* user, void* in, size_t len);
+  
+  EventLoop::TimerId housekeeping_timer_;
+  EventLoop::TimerId reconnect_timer_;
+  int64_t heartbeat_timeout_ns_;
+  int64_t last_receive_ns_;
+  bool reconnect_;
+  int64_t reconnect_delay_ns_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,182 @@
+#include "kraken_websocket_book_stream.h"
+#include "../market_data/decimal.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+KrakenBookStream::KrakenBookStream(const std::string& ws_endpoint, size_t depth)
+    : KrakenWebSocketBase(ws_endpoint), depth_(depth), current_symbol_(kInvalidSymbol) {
+  books_.resize(SymbolRegistry::kMaxSymbols);
+  std::memset(&stats_, 0, sizeof(stats_));
+}
+
+void KrakenBookStream::SubscribeBook(const std::string& symbol) {
+  SubscribeBook(std::vector<std::string>{symbol});
+}
+
+void KrakenBookStream::SubscribeBook(const std::vector<std::string>& symbols) {
+  for (size_t begin = 0; begin < symbols.size(); begin += kMaxSymbolsPerRequest) {
+    size_t end = std::min(begin + kMaxSymbolsPerRequest, symbols.size());
+    json batch = json::array();
+    for (size_t i = begin; i < end; i++) {
+      SymbolId id = SymbolRegistry::Global().Intern(symbols[i]);
+      if (id == kInvalidSymbol) {
+        std::cerr << "Cannot subscribe book for " << symbols[i] << ": symbol registry is full" << std::endl;
+        continue;
+      }
+      // Queued ahead of the subscribe, so the book exists before its
+      // snapshot can arrive.
+      loop_.Post([this, id]() { EnsureBook(id); });
+      batch.push_back(symbols[i]);
+    }
+    if (!batch.empty()) {
+      Subscribe(BookRequest("subscribe", batch, true));
+    }
+  }
+}
+
+void KrakenBookStream::UnsubscribeBook(const std::string& symbol) {
+  UnsubscribeBook(std::vector<std::string>{symbol});
+}
+
+void KrakenBookStream::UnsubscribeBook(const std::vector<std::string>& symbols) {
+  Unsubscribe(BookRequest("unsubscribe", symbols, false));
+  loop_.Post([this, symbols]() {
+    for (const std::string& symbol : symbols) {
+      BookState* state = State(SymbolRegistry::Global().Find(symbol));
+      if (state) state->synced = false;
+    }
+  });
+}
+
+void KrakenBookStream::SetPrecision(const std::string& symbol, int price_decimals, int qty_decimals) {
+  SymbolId id = SymbolRegistry::Global().Intern(symbol);
+  if (id == kInvalidSymbol) return;
+  loop_.Post([this, id, price_decimals, qty_decimals]() {
+    EnsureBook(id);
+    books_[id]->book.SetDecimals(price_decimals, qty_decimals);
+    books_[id]->synced = false;
+  });
+}
+
+void KrakenBookStream::SetTopOfBookCallback(std::function<void(const TopOfBook&)> callback) {
+  top_callback_ = callback;
+}
+
+size_t KrakenBookStream::Depth() const {
+  return depth_;
+}
+
+const OrderBook* KrakenBookStream::Book(SymbolId symbol) const {
+  BookState* state = State(symbol);
+  return state && state->synced ? &state->book : nullptr;
+}
+
+BookStreamStats KrakenBookStream::Stats() const {
+  return stats_;
+}
+
+void KrakenBookStream::HandleMessage(const json& message) {
+  // Every message goes through HandleRawMessage.
+  (void)message;
+}
+
+void KrakenBookStream::HandleRawMessage(const char* data, size_t length) {
+  current_symbol_ = kInvalidSymbol;
+  if (ParseBookMessage(data, length, *this) == BookParseResult::MALFORMED) {
+    stats_.malformed++;
+    std::cerr << "Error parsing book data: malformed book message" << std::endl;
+    if (current_symbol_ != kInvalidSymbol) {
+      Resync(current_symbol_);
+    }
+  }
+}
+
+void KrakenBookStream::OnConnectionLost() {
+  // The replayed subscriptions bring a snapshot for every book.
+  for (auto& state : books_) {
+    if (state) state->synced = false;
+  }
+}
+
+OrderBook* KrakenBookStream::BeginBook(SymbolId symbol, bool snapshot) {
+  BookState* state = State(symbol);
+  if (!state) return nullptr;
+  if (snapshot) {
+    state->book.Clear();
+    state->synced = false;
+    stats_.snapshots++;
+  } else if (!state->synced) {
+    return nullptr;
+  } else {
+    stats_.updates++;
+  }
+  current_symbol_ = symbol;
+  return &state->book;
+}
+
+void KrakenBookStream::EndBook(SymbolId symbol, OrderBook& book, uint32_t checksum, int64_t timestamp) {
+  current_symbol_ = kInvalidSymbol;
+  if (book.Checksum() != checksum) {
+    stats_.checksum_failures++;
+    std::cerr << "Book checksum mismatch for " << SymbolRegistry::Global().Name(symbol)
+              << ", resubscribing" << std::endl;
+    Resync(symbol);
+    return;
+  }
+
+  BookState& state = *books_[symbol];
+  state.synced = true;
+  if (!book.HasTop()) return;
+
+  TopOfBook top = book.Top(symbol, timestamp);
+  TopOfBook& last = state.last_top;
+  if (top.bid_price == last.bid_price && top.bid_qty == last.bid_qty &&
+      top.ask_price == last.ask_price && top.ask_qty == last.ask_qty) {
+    return;
+  }
+  last = top;
+  if (top_callback_) {
+    top_callback_(top);
+  }
+}
+
+void KrakenBookStream::Resync(SymbolId symbol) {
+  BookState* state = State(symbol);
+  if (!state) return;
+  state->synced = false;
+  state->book.Clear();
+  stats_.resyncs++;
+  json symbols = json::array({SymbolRegistry::Global().Name(symbol)});
+  Unsubscribe(BookRequest("unsubscribe", symbols, false));
+  Subscribe(BookRequest("subscribe", symbols, true));
+}
+
+json KrakenBookStream::BookRequest(const char* method, const json& symbols, bool with_snapshot) const {
+  json request = {
+    {"method", method},
+    {"params", {
+      {"channel", "book"},
+      {"symbol", symbols},
+      {"depth", depth_}
+    }}
+  };
+  if (with_snapshot) {
+    request["params"]["snapshot"] = true;
+  }
+  return request;
+}
+
+KrakenBookStream::BookState* KrakenBookStream::State(SymbolId symbol) const {
+  return symbol < books_.size() ? books_[symbol].get() : nullptr;
+}
+
+void KrakenBookStream::EnsureBook(SymbolId symbol) {
+  if (!books_[symbol]) {
+    books_[symbol] = std::make_unique<BookState>(depth_);
+    SymbolPrecision precision;
+    if (PrecisionTable::Global().Find(symbol, precision)) {
+      books_[symbol]->book.SetDecimals(precision.price_decimals, precision.qty_decimals);
+    }
+  }
+}
@@ -0,0 +1,96 @@
+#ifndef KRAKEN_WEBSOCKET_BOOK_STREAM_H
+#define KRAKEN_WEBSOCKET_BOOK_STREAM_H
+
+#include "kraken_websocket_base.h"
+#include "book_message_parser.h"
+#include "../market_data/order_book.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct BookStreamStats {
+  uint64_t snapshots;
+  uint64_t updates;
+  uint64_t checksum_failures;
+  uint64_t malformed;
+  // Unsubscribe/subscribe round trips to fetch a fresh snapshot.
+  uint64_t resyncs;
+};
+
+// Level 2 books from the v2 "book" channel. Each subscribed symbol gets an
+// OrderBook sized once for the subscribed depth; every message is applied
+// in place from the receive buffer and checked against Kraken's checksum.
+// A book that fails the check, or a malformed message for it, is marked
+// stale and resubscribed, and updates for it are ignored until the fresh
+// snapshot arrives. A reconnect replays the subscriptions, which restarts
+// every book from a snapshot too.
+class KrakenBookStream : public KrakenWebSocketBase, private BookMessageHandler {
+ public:
+  // depth: levels per side, one of Kraken's 10, 25, 100, 500 or 1000.
+  KrakenBookStream(const std::string& ws_endpoint, size_t depth = 10);
+
+  void SubscribeBook(const std::string& symbol);
+  // Subscribes all symbols with one request per kMaxSymbolsPerRequest.
+  void SubscribeBook(const std::vector<std::string>& symbols);
+  void UnsubscribeBook(const std::string& symbol);
+  void UnsubscribeBook(const std::vector<std::string>& symbols);
+
+  static constexpr size_t kMaxSymbolsPerRequest = 100;
+
+  // Pins a pair's decimals to its listed precision (the instrument
+  // channel's price_precision and qty_precision). Without it the book
+  // learns them from the widest price and quantity seen, which Kraken's
+  // trimmed trailing zeros can leave short until a full-width value
+  // arrives; the first checksums may then fail and resync. Books created
+  // after FetchPairPrecision() are pinned from PrecisionTable already.
+  void SetPrecision(const std::string& symbol, int price_decimals, int qty_decimals);
+
+  // Called on the socket thread after a verified message moved the best
+  // bid or ask price or size of a book.
+  void SetTopOfBookCallback(std::function<void(const TopOfBook&)> callback);
+
+  size_t Depth() const;
+  // The live book, or nullptr if the symbol is not subscribed or its book
+  // is waiting for a snapshot. Only valid on the socket thread, e.g. from
+  // the callback.
+  const OrderBook* Book(SymbolId symbol) const;
+  // Only consistent once Run() has returned.
+  BookStreamStats Stats() const;
+
+ protected:
+  void HandleMessage(const json& message) override;
+  void HandleRawMessage(const char* data, size_t length) override;
+  void OnConnectionLost() override;
+
+ private:
+  struct BookState {
+    explicit BookState(size_t depth) : book(depth), synced(false), last_top() {}
+
+    OrderBook book;
+    // Set by a snapshot that passed its checksum, cleared by any failure.
+    bool synced;
+    TopOfBook last_top;
+  };
+
+  OrderBook* BeginBook(SymbolId symbol, bool snapshot) override;
+  void EndBook(SymbolId symbol, OrderBook& book, uint32_t checksum, int64_t timestamp) override;
+  // Drops a book and asks Kraken for a fresh snapshot.
+  void Resync(SymbolId symbol);
+  json BookRequest(const char* method, const json& symbols, bool with_snapshot) const;
+  BookState* State(SymbolId symbol) const;
+  // Creates the symbol's book on the loop thread if it has none yet.
+  void EnsureBook(SymbolId symbol);
+
+  size_t depth_;
+  // Indexed by SymbolId; created on the loop thread when first subscribed.
+  std::vector<std::unique_ptr<BookState>> books_;
+  // Book of the entry being parsed, resynced if the message turns out
+  // malformed halfway through it.
+  SymbolId current_symbol_;
+  std::function<void(const TopOfBook&)> top_callback_;
+  BookStreamStats stats_;
+};
+
+#endif
@@ -1,34 +1,66 @@
 #include "kraken_websocket_candle_stream.h"
+#include "ohlc_message_parser.h"
+#include "../market_data/timestamp.h"
+#include <algorithm>
 #include <iostream>
 
+namespace {
+
+// nlohmann has already turned numbers into doubles; dump() gives back the
+// shortest text that round-trips, which parses exactly.
+bool ReadMantissa(const json& value, int scale, int64_t& mantissa) {
+  std::string text = value.is_string() ? value.get<std::string>() : value.dump();
+  return ParseMantissa(text, scale, mantissa);
+}
+
+}  // namespace
+
 KrakenCandleStream::KrakenCandleStream(const std::string& ws_endpoint)
     : KrakenWebSocketBase(ws_endpoint) {}
 
 void KrakenCandleStream::SubscribeCandles(const std::string& symbol, int interval, bool snapshot) {
-  json subscribe_msg = {
-    {"method", "subscribe"},
-    {"params", {
-      {"channel", "ohlc"},
-      {"symbol", {symbol}},
-      {"interval", interval},
-      {"snapshot", snapshot}
-    }}
-  };
-  
-  Subscribe(subscribe_msg);
+  SubscribeCandles(std::vector<std::string>{symbol}, interval, snapshot);
+}
+
+void KrakenCandleStream::SubscribeCandles(const std::vector<std::string>& symbols, int interval, bool snapshot) {
+  for (size_t begin = 0; begin < symbols.size(); begin += kMaxSymbolsPerRequest) {
+    size_t end = std::min(begin + kMaxSymbolsPerRequest, symbols.size());
+    json batch = json::array();
+    for (size_t i = begin; i < end; i++) {
+      // Assign the id now so the receive path only ever does lock-free lookups.
+      SymbolRegistry::Global().Intern(symbols[i]);
+      batch.push_back(symbols[i]);
+    }
+    
+    json subscribe_msg = {
+      {"method", "subscribe"},
+      {"params", {
+        {"channel", "ohlc"},
+        {"symbol", batch},
+        {"interval", interval},
+        {"snapshot", snapshot}
+      }}
+    };
+    
+    Subscribe(subscribe_msg);
+  }
 }
 
 void KrakenCandleStream::UnsubscribeCandles(const std::string& symbol, int interval) {
+  UnsubscribeCandles(std::vector<std::string>{symbol}, interval);
+}
+
+void KrakenCandleStream::UnsubscribeCandles(const std::vector<std::string>& symbols, int interval) {
   json unsubscribe_msg = {
     {"method", "unsubscribe"},
     {"params", {
       {"channel", "ohlc"},
-      {"symbol", {symbol}},
+      {"symbol", symbols},
       {"interval", interval}
     }}
   };
   
-  SendMessage(unsubscribe_msg.dump());
+  Unsubscribe(unsubscribe_msg);
 }
 
 void KrakenCandleStream::SetCandleCallback(std::function<void(const Candle&)> callback) {
@@ -47,19 +79,38 @@ void KrakenCandleStream::HandleMessage(const json& message) {
   }
 }
 
+void KrakenCandleStream::HandleRawMessage(const char* data, size_t length) {
+  if (ParseOhlcMessage(data, length, candle_, candle_callback_) == OhlcParseResult::MALFORMED) {
+    std::cerr << "Error parsing candle data: malformed ohlc message" << std::endl;
+  }
+}
+
 void KrakenCandleStream::ParseCandleData(const json& candle_data) {
   try {
-    Candle candle;
-    candle.symbol = candle_data["symbol"];
-    candle.open = candle_data["open"];
-    candle.high = candle_data["high"];
-    candle.low = candle_data["low"];
-    candle.close = candle_data["close"];
-    candle.vwap = candle_data["vwap"];
-    candle.volume = candle_data["volume"];
+    Candle candle = {};
+    const std::string& symbol = candle_data["symbol"].get_ref<const std::string&>();
+    candle.symbol = SymbolRegistry::Global().Intern(symbol);
+    if (candle.symbol == kInvalidSymbol) {
+      std::cerr << "Error parsing candle data: symbol registry is full" << std::endl;
+      return;
+    }
+    SymbolPrecision precision = MarketPrecision(candle.symbol);
+    if (!ReadMantissa(candle_data["open"], precision.price_decimals, candle.open) ||
+        !ReadMantissa(candle_data["high"], precision.price_decimals, candle.high) ||
+        !ReadMantissa(candle_data["low"], precision.price_decimals, candle.low) ||
+        !ReadMantissa(candle_data["close"], precision.price_decimals, candle.close) ||
+        !ReadMantissa(candle_data["vwap"], precision.price_decimals, candle.vwap) ||
+        !ReadMantissa(candle_data["volume"], precision.qty_decimals, candle.volume)) {
+      std::cerr << "Error parsing candle data: bad price or volume" << std::endl;
+      return;
+    }
     candle.trades = candle_data["trades"];
-    candle.interval_begin = candle_data["interval_begin"];
     candle.interval = candle_data["interval"];
+    const std::string& interval_begin = candle_data["interval_begin"].get_ref<const std::string&>();
+    if (!ParseTimestampNanos(interval_begin.data(), interval_begin.size(), candle.interval_begin)) {
+      std::cerr << "Error parsing candle data: bad interval_begin" << std::endl;
+      return;
+    }
     
     if (candle_callback_) {
       candle_callback_(candle);
@@ -2,34 +2,31 @@
 #define KRAKEN_WEBSOCKET_CANDLE_STREAM_H
 
 #include "kraken_websocket_base.h"
+#include "../market_data/candle.h"
 #include <functional>
-
-struct Candle {
-  std::string symbol;
-  double open;
-  double high;
-  double low;
-  double close;
-  double vwap;
-  double volume;
-  int trades;
-  std::string interval_begin;
-  int interval;
-};
+#include <vector>
 
 class KrakenCandleStream : public KrakenWebSocketBase {
  public:
   KrakenCandleStream(const std::string& ws_endpoint);
   
   void SubscribeCandles(const std::string& symbol, int interval, bool snapshot = true);
+  // Subscribes all symbols with one request per kMaxSymbolsPerRequest.
+  void SubscribeCandles(const std::vector<std::string>& symbols, int interval, bool snapshot = true);
   void UnsubscribeCandles(const std::string& symbol, int interval);
+  void UnsubscribeCandles(const std::vector<std::string>& symbols, int interval);
+  
+  static constexpr size_t kMaxSymbolsPerRequest = 100;
   void SetCandleCallback(std::function<void(const Candle&)> callback);
   
  protected:
   void HandleMessage(const json& message) override;
+  void HandleRawMessage(const char* data, size_t length) override;
   
  private:
   std::function<void(const Candle&)> candle_callback_;
+  // Scratch record filled in place by the raw parser.
+  Candle candle_;
   void ParseCandleData(const json& candle_data);
 };
 
@@ -0,0 +1,65 @@
+#include "kraken_websocket_trade_stream.h"
+#include "trade_message_parser.h"
+#include <algorithm>
+#include <iostream>
+
+KrakenTradeStream::KrakenTradeStream(const std::string& ws_endpoint)
+    : KrakenWebSocketBase(ws_endpoint), trade_() {}
+
+void KrakenTradeStream::SubscribeTrades(const std::string& symbol, bool snapshot) {
+  SubscribeTrades(std::vector<std::string>{symbol}, snapshot);
+}
+
+void KrakenTradeStream::SubscribeTrades(const std::vector<std::string>& symbols, bool snapshot) {
+  for (size_t begin = 0; begin < symbols.size(); begin += kMaxSymbolsPerRequest) {
+    size_t end = std::min(begin + kMaxSymbolsPerRequest, symbols.size());
+    json batch = json::array();
+    for (size_t i = begin; i < end; i++) {
+      // Assign the id now so the receive path only ever does lock-free lookups.
+      SymbolRegistry::Global().Intern(symbols[i]);
+      batch.push_back(symbols[i]);
+    }
+
+    json subscribe_msg = {
+      {"method", "subscribe"},
+      {"params", {
+        {"channel", "trade"},
+        {"symbol", batch},
+        {"snapshot", snapshot}
+      }}
+    };
+
+    Subscribe(subscribe_msg);
+  }
+}
+
+void KrakenTradeStream::UnsubscribeTrades(const std::string& symbol) {
+  UnsubscribeTrades(std::vector<std::string>{symbol});
+}
+
+void KrakenTradeStream::UnsubscribeTrades(const std::vector<std::string>& symbols) {
+  json unsubscribe_msg = {
+    {"method", "unsubscribe"},
+    {"params", {
+      {"channel", "trade"},
+      {"symbol", symbols}
+    }}
+  };
+
+  Unsubscribe(unsubscribe_msg);
+}
+
+void KrakenTradeStream::SetTradeCallback(std::function<void(const TradeTick&)> callback) {
+  trade_callback_ = callback;
+}
+
+void KrakenTradeStream::HandleMessage(const json& message) {
+  // Every message goes through HandleRawMessage.
+  (void)message;
+}
+
+void KrakenTradeStream::HandleRawMessage(const char* data, size_t length) {
+  if (ParseTradeMessage(data, length, trade_, trade_callback_) == TradeParseResult::MALFORMED) {
+    std::cerr << "Error parsing trade data: malformed trade message" << std::endl;
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef KRAKEN_WEBSOCKET_TRADE_STREAM_H
+#define KRAKEN_WEBSOCKET_TRADE_STREAM_H
+
+#include "kraken_websocket_base.h"
+#include "../market_data/trade_tick.h"
+#include <functional>
+#include <vector>
+
+// Public trades from the v2 "trade" channel, parsed straight from the
+// receive buffer into one reused TradeTick.
+class KrakenTradeStream : public KrakenWebSocketBase {
+ public:
+  KrakenTradeStream(const std::string& ws_endpoint);
+
+  // Without a snapshot only trades printed after the subscription arrive,
+  // which is what a bar builder wants; with one, Kraken first replays the
+  // last 50 trades per symbol, on every reconnect too.
+  void SubscribeTrades(const std::string& symbol, bool snapshot = false);
+  // Subscribes all symbols with one request per kMaxSymbolsPerRequest.
+  void SubscribeTrades(const std::vector<std::string>& symbols, bool snapshot = false);
+  void UnsubscribeTrades(const std::string& symbol);
+  void UnsubscribeTrades(const std::vector<std::string>& symbols);
+
+  static constexpr size_t kMaxSymbolsPerRequest = 100;
+  // Runs on the socket thread for every trade.
+  void SetTradeCallback(std::function<void(const TradeTick&)> callback);
+
+ protected:
+  void HandleMessage(const json& message) override;
+  void HandleRawMessage(const char* data, size_t length) override;
+
+ private:
+  std::function<void(const TradeTick&)> trade_callback_;
+  // Scratch record filled in place by the raw parser.
+  TradeTick trade_;
+};
+
+#endif
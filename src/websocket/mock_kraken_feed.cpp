@@ -0,0 +1,394 @@
+#include "mock_kraken_feed.h"
+#include "book_checksum.h"
+#include "../market_data/decimal.h"
+#include "../market_data/timestamp.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <map>
+#include <random>
+
+namespace {
+
+const int64_t kMinuteNanos = 60LL * 1000000000LL;
+const int kQtyDecimals = 8;
+
+// Coarser ticks for expensive coins, roughly as Kraken lists them.
+int PriceDecimals(double price) {
+  if (price >= 1000.0) return 1;
+  if (price >= 10.0) return 2;
+  if (price >= 0.1) return 4;
+  return 6;
+}
+
+void AppendFixed(std::string& out, int64_t mantissa, int decimals) {
+  char text[32];
+  auto result = ToChars(text, text + sizeof(text), Decimal{mantissa, decimals});
+  out.append(text, result.ptr);
+}
+
+void AppendInteger(std::string& out, int64_t value) {
+  char digits[24];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  out.append(digits, result.ptr);
+}
+
+// Prices and volume go out exactly as the candle holds them.
+void RenderOhlc(const Candle& candle, int64_t timestamp_ns, std::string& out) {
+  SymbolPrecision precision = MarketPrecision(candle.symbol);
+  std::string timestamp = FormatTimestampNanos(timestamp_ns);
+  out += "{\"channel\":\"ohlc\",\"type\":\"update\",\"timestamp\":\"";
+  out += timestamp;
+  out += "\",\"data\":[{\"symbol\":\"";
+  out += SymbolRegistry::Global().Name(candle.symbol);
+  out += "\",\"open\":";
+  AppendFixed(out, candle.open, precision.price_decimals);
+  out += ",\"high\":";
+  AppendFixed(out, candle.high, precision.price_decimals);
+  out += ",\"low\":";
+  AppendFixed(out, candle.low, precision.price_decimals);
+  out += ",\"close\":";
+  AppendFixed(out, candle.close, precision.price_decimals);
+  out += ",\"trades\":";
+  AppendInteger(out, candle.trades);
+  out += ",\"volume\":";
+  AppendFixed(out, candle.volume, precision.qty_decimals);
+  out += ",\"vwap\":";
+  AppendFixed(out, candle.vwap, precision.price_decimals);
+  out += ",\"interval_begin\":\"";
+  out += FormatTimestampNanos(candle.interval_begin);
+  out += "\",\"interval\":";
+  AppendInteger(out, candle.interval);
+  out += ",\"timestamp\":\"";
+  out += timestamp;
+  out += "\"}]}";
+}
+
+// A candle's prices as doubles, to simulate the path traded inside it.
+struct BarPrices {
+  double open;
+  double high;
+  double low;
+  double close;
+};
+
+BarPrices PricesOf(const Candle& candle) {
+  int scale = MarketPrecision(candle.symbol).price_decimals;
+  return BarPrices{Decimal{candle.open, scale}.ToDouble(), Decimal{candle.high, scale}.ToDouble(),
+                   Decimal{candle.low, scale}.ToDouble(), Decimal{candle.close, scale}.ToDouble()};
+}
+
+// Price at fraction t of the bar on an open-low-high-close path for up bars
+// and open-high-low-close for down bars.
+double PathPrice(const BarPrices& bar, double t) {
+  bool up = bar.close >= bar.open;
+  double first = up ? bar.low : bar.high;
+  double second = up ? bar.high : bar.low;
+  if (t <= 1.0 / 3.0) return bar.open + (first - bar.open) * t * 3.0;
+  if (t <= 2.0 / 3.0) return first + (second - first) * (t * 3.0 - 1.0);
+  return second + (bar.close - second) * (t * 3.0 - 2.0);
+}
+
+int64_t ToMantissa(double value, int scale) {
+  Decimal decimal = {};
+  DecimalFromDouble(value, scale, decimal);
+  return decimal.mantissa;
+}
+
+using Levels = std::map<int64_t, int64_t>;
+
+struct SymbolState {
+  bool initialized = false;
+  int price_decimals = 2;
+  double price_scale = 100.0;
+  int64_t next_trade_id = 1;
+  double last_trade_price = 0.0;
+  // Price mantissa -> quantity mantissa.
+  Levels bids;
+  Levels asks;
+  size_t updates_since_snapshot = 0;
+};
+
+class FeedBuilder {
+ public:
+  FeedBuilder(const MockFeedOptions& options, int64_t origin_ns)
+      : options_(options), origin_ns_(origin_ns), rng_(options.seed) {}
+
+  void AddCandle(const Candle& candle) {
+    SymbolState& state = states_[candle.symbol];
+    SymbolPrecision precision = MarketPrecision(candle.symbol);
+    BarPrices bar = PricesOf(candle);
+    if (!state.initialized) {
+      state.initialized = true;
+      state.price_decimals = PriceDecimals(bar.open);
+      state.price_scale = static_cast<double>(Pow10(state.price_decimals));
+      state.last_trade_price = bar.open;
+    }
+
+    const size_t events = std::max<size_t>(1, options_.events_per_bar);
+    const int64_t bar_ns = std::max<int64_t>(1, candle.interval) * kMinuteNanos;
+    Candle partial = candle;
+    partial.high = candle.open;
+    partial.low = candle.open;
+    double notional = 0.0;
+    double volume = 0.0;
+    bool first_book = state.bids.empty();
+
+    for (size_t k = 0; k < events; k++) {
+      double t = static_cast<double>(k + 1) / static_cast<double>(events);
+      int64_t timestamp = candle.interval_begin + static_cast<int64_t>(static_cast<double>(bar_ns) * t);
+      double price = PathPrice(bar, t);
+      double qty = QtyDecimal(candle.symbol, candle.volume).ToDouble() / static_cast<double>(events);
+
+      if (options_.trades) {
+        AddTrade(candle.symbol, state, price, qty, timestamp);
+      }
+      if (options_.book) {
+        MoveBook(candle.symbol, state, price, timestamp, first_book);
+        first_book = false;
+      }
+
+      // The last update carries the finished candle exactly.
+      if (k + 1 == events) {
+        partial = candle;
+      } else {
+        int64_t price_mantissa = ToMantissa(price, precision.price_decimals);
+        partial.high = std::max(partial.high, price_mantissa);
+        partial.low = std::min(partial.low, price_mantissa);
+        partial.close = price_mantissa;
+        notional += price * qty;
+        volume += qty;
+        partial.volume = ToMantissa(volume, precision.qty_decimals);
+        partial.vwap = volume > 0.0 ? ToMantissa(notional / volume, precision.price_decimals) : price_mantissa;
+        partial.trades = static_cast<uint32_t>(std::llround(candle.trades * t));
+      }
+      std::string& text = Begin(timestamp, candle.symbol, MockChannel::OHLC, 0);
+      RenderOhlc(partial, timestamp, text);
+      Commit();
+    }
+  }
+
+  MockFeed Finish() {
+    // Symbols were expanded bar by bar; interleave them by send time.
+    std::vector<size_t> order(pending_.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      return pending_[a].offset_ns < pending_[b].offset_ns;
+    });
+
+    MockFeed feed;
+    feed.messages.reserve(pending_.size());
+    feed.text.reserve(text_bytes_);
+    for (size_t index : order) {
+      const Pending& pending = pending_[index];
+      MockFeedMessage message;
+      message.offset_ns = pending.offset_ns;
+      message.begin = feed.text.size();
+      message.length = static_cast<uint32_t>(pending.text.size());
+      message.symbol = pending.symbol;
+      message.channel = pending.channel;
+      message.flags = pending.flags;
+      feed.text += pending.text;
+      feed.messages.push_back(message);
+    }
+    pending_.clear();
+    return feed;
+  }
+
+ private:
+  struct Pending {
+    int64_t offset_ns;
+    SymbolId symbol;
+    MockChannel channel;
+    uint8_t flags;
+    std::string text;
+  };
+
+  std::string& Begin(int64_t timestamp, SymbolId symbol, MockChannel channel, uint8_t flags) {
+    pending_.push_back(Pending{timestamp - origin_ns_, symbol, channel, flags, std::string()});
+    return pending_.back().text;
+  }
+
+  void Commit() {
+    text_bytes_ += pending_.back().text.size();
+  }
+
+  void AddTrade(SymbolId symbol, SymbolState& state, double price, double qty, int64_t timestamp) {
+    int64_t price_mantissa = std::llround(price * state.price_scale);
+    int64_t qty_mantissa = std::max<int64_t>(1, std::llround(qty * 1e8));
+    const char* side = price >= state.last_trade_price ? "buy" : "sell";
+    state.last_trade_price = price;
+
+    std::string& text = Begin(timestamp, symbol, MockChannel::TRADE, 0);
+    text += "{\"channel\":\"trade\",\"type\":\"update\",\"data\":[{\"symbol\":\"";
+    text += SymbolRegistry::Global().Name(symbol);
+    text += "\",\"side\":\"";
+    text += side;
+    text += "\",\"price\":";
+    AppendFixed(text, price_mantissa, state.price_decimals);
+    text += ",\"qty\":";
+    AppendFixed(text, qty_mantissa, kQtyDecimals);
+    text += ",\"ord_type\":\"market\",\"trade_id\":";
+    AppendInteger(text, state.next_trade_id++);
+    text += ",\"timestamp\":\"";
+    text += FormatTimestampNanos(timestamp);
+    text += "\"}]}";
+    Commit();
+  }
+
+  int64_t RandomQty() {
+    std::uniform_int_distribution<int64_t> qty(100000, 200000000);
+    return qty(rng_);
+  }
+
+  // Recenters book_depth levels per side around price, one tick-rounded
+  // basis point apart, keeping quantities of levels that stay and jittering
+  // one at random.
+  void MoveBook(SymbolId symbol, SymbolState& state, double price, int64_t timestamp, bool first) {
+    const int64_t depth = static_cast<int64_t>(std::max<size_t>(1, options_.book_depth));
+    int64_t mid = std::llround(price * state.price_scale);
+    int64_t spacing = std::max<int64_t>(1, std::llround(static_cast<double>(mid) * 1e-4));
+    int64_t best_bid = mid - spacing / 2 - 1;
+    int64_t best_ask = best_bid + spacing;
+
+    Levels bids;
+    Levels asks;
+    for (int64_t j = 0; j < depth; j++) {
+      int64_t bid = best_bid - j * spacing;
+      int64_t ask = best_ask + j * spacing;
+      if (bid > 0) {
+        auto old = state.bids.find(bid);
+        bids[bid] = old != state.bids.end() ? old->second : RandomQty();
+      }
+      auto old = state.asks.find(ask);
+      asks[ask] = old != state.asks.end() ? old->second : RandomQty();
+    }
+    std::uniform_int_distribution<int64_t> level(0, depth - 1);
+    Levels& jittered = level(rng_) % 2 == 0 ? bids : asks;
+    if (!jittered.empty()) {
+      auto it = jittered.begin();
+      std::advance(it, static_cast<size_t>(level(rng_)) % jittered.size());
+      it->second = RandomQty();
+    }
+
+    Levels old_bids;
+    Levels old_asks;
+    old_bids.swap(state.bids);
+    old_asks.swap(state.asks);
+    state.bids = bids;
+    state.asks = asks;
+
+    if (first) {
+      AddBookSnapshot(symbol, state, timestamp);
+      return;
+    }
+
+    std::string& text = Begin(timestamp, symbol, MockChannel::BOOK, 0);
+    text += "{\"channel\":\"book\",\"type\":\"update\",\"data\":[{\"symbol\":\"";
+    text += SymbolRegistry::Global().Name(symbol);
+    text += "\",\"bids\":[";
+    AppendLevelChanges(text, state, old_bids, bids, true);
+    text += "],\"asks\":[";
+    AppendLevelChanges(text, state, old_asks, asks, false);
+    text += "],\"checksum\":";
+    AppendInteger(text, Checksum(state));
+    text += ",\"timestamp\":\"";
+    text += FormatTimestampNanos(timestamp);
+    text += "\"}]}";
+    Commit();
+
+    if (options_.book_snapshot_every > 0 && ++state.updates_since_snapshot >= options_.book_snapshot_every) {
+      AddBookSnapshot(symbol, state, timestamp);
+    }
+  }
+
+  void AddBookSnapshot(SymbolId symbol, SymbolState& state, int64_t timestamp) {
+    state.updates_since_snapshot = 0;
+    std::string& text = Begin(timestamp, symbol, MockChannel::BOOK, kMockBookSnapshot);
+    text += "{\"channel\":\"book\",\"type\":\"snapshot\",\"data\":[{\"symbol\":\"";
+    text += SymbolRegistry::Global().Name(symbol);
+    text += "\",\"bids\":[";
+    bool first = true;
+    for (auto it = state.bids.rbegin(); it != state.bids.rend(); ++it) {
+      AppendLevel(text, state, it->first, it->second, first);
+    }
+    text += "],\"asks\":[";
+    first = true;
+    for (const auto& level : state.asks) {
+      AppendLevel(text, state, level.first, level.second, first);
+    }
+    text += "],\"checksum\":";
+    AppendInteger(text, Checksum(state));
+    text += "}]}";
+    Commit();
+  }
+
+  void AppendLevel(std::string& text, const SymbolState& state, int64_t price, int64_t qty, bool& first) {
+    if (!first) text += ',';
+    first = false;
+    text += "{\"price\":";
+    AppendFixed(text, price, state.price_decimals);
+    text += ",\"qty\":";
+    AppendFixed(text, qty, kQtyDecimals);
+    text += '}';
+  }
+
+  // Removals (qty 0) first, then new and changed levels, best price first.
+  void AppendLevelChanges(std::string& text, const SymbolState& state, const Levels& before,
+                          const Levels& after, bool descending) {
+    bool first = true;
+    auto removals = [&](int64_t price, int64_t) {
+      if (after.find(price) == after.end()) AppendLevel(text, state, price, 0, first);
+    };
+    auto changes = [&](int64_t price, int64_t qty) {
+      auto old = before.find(price);
+      if (old == before.end() || old->second != qty) AppendLevel(text, state, price, qty, first);
+    };
+    ForEachLevel(before, descending, removals);
+    ForEachLevel(after, descending, changes);
+  }
+
+  template <typename Visit>
+  static void ForEachLevel(const Levels& levels, bool descending, Visit visit) {
+    if (descending) {
+      for (auto it = levels.rbegin(); it != levels.rend(); ++it) visit(it->first, it->second);
+    } else {
+      for (const auto& level : levels) visit(level.first, level.second);
+    }
+  }
+
+  static uint32_t Checksum(const SymbolState& state) {
+    uint32_t crc = 0;
+    size_t count = 0;
+    for (auto it = state.asks.begin(); it != state.asks.end() && count < 10; ++it, ++count) {
+      crc = UpdateBookChecksum(crc, it->first, it->second);
+    }
+    count = 0;
+    for (auto it = state.bids.rbegin(); it != state.bids.rend() && count < 10; ++it, ++count) {
+      crc = UpdateBookChecksum(crc, it->first, it->second);
+    }
+    return crc;
+  }
+
+  MockFeedOptions options_;
+  int64_t origin_ns_;
+  std::mt19937_64 rng_;
+  std::map<SymbolId, SymbolState> states_;
+  std::vector<Pending> pending_;
+  size_t text_bytes_ = 0;
+};
+
+}  // namespace
+
+MockFeed BuildMockFeed(const std::vector<Candle>& candles, const MockFeedOptions& options) {
+  if (candles.empty()) return MockFeed();
+  FeedBuilder builder(options, candles.front().interval_begin);
+  for (const Candle& candle : candles) {
+    builder.AddCandle(candle);
+  }
+  return builder.Finish();
+}
+
+void RenderOhlcUpdate(const Candle& candle, std::string& out) {
+  RenderOhlc(candle, candle.interval_begin + std::max<int64_t>(1, candle.interval) * kMinuteNanos, out);
+}
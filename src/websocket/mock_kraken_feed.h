@@ -0,0 +1,67 @@
+#ifndef MOCK_KRAKEN_FEED_H
+#define MOCK_KRAKEN_FEED_H
+
+#include "../market_data/candle.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class MockChannel : uint8_t {
+  OHLC,
+  BOOK,
+  TRADE
+};
+
+// A full book snapshot. A server starts a connection's book at the first
+// snapshot it reaches and sends it updates from there on.
+const uint8_t kMockBookSnapshot = 1u << 0;
+
+struct MockFeedMessage {
+  // When the exchange would send it, relative to the first message.
+  int64_t offset_ns;
+  // Byte range in MockFeed::text.
+  uint64_t begin;
+  uint32_t length;
+  SymbolId symbol;
+  MockChannel channel;
+  uint8_t flags;
+};
+
+// A replayable Kraken v2 session: every message pre-rendered into one
+// arena, in send order.
+struct MockFeed {
+  std::vector<MockFeedMessage> messages;
+  std::string text;
+
+  std::string_view Text(const MockFeedMessage& message) const {
+    return std::string_view(text.data() + message.begin, message.length);
+  }
+  int64_t Duration() const { return messages.empty() ? 0 : messages.back().offset_ns; }
+};
+
+struct MockFeedOptions {
+  // Market events per candle, spread evenly over the bar. Each event
+  // updates the bar in progress and, if enabled, prints a trade and moves
+  // the book.
+  size_t events_per_bar = 10;
+  bool book = true;
+  bool trades = true;
+  size_t book_depth = 10;
+  // Inline book snapshots every this many updates per symbol, so a client
+  // joining mid-feed can start a book; 0 emits only the opening one.
+  size_t book_snapshot_every = 1000;
+  uint64_t seed = 7;
+};
+
+// Expands candles (sorted by bar time) into the messages Kraken would have
+// sent while they formed: ohlc updates of the bar in progress, trades along
+// an open-high-low-close path, and a book of book_depth levels per side
+// around the last price, with valid checksums.
+MockFeed BuildMockFeed(const std::vector<Candle>& candles, const MockFeedOptions& options);
+
+// One Kraken v2 "ohlc" update carrying a single candle.
+void RenderOhlcUpdate(const Candle& candle, std::string& out);
+
+#endif
@@ -0,0 +1,580 @@
+#include "mock_kraken_server.h"
+#include "../market_data/timestamp.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+using json = nlohmann::json;
+
+namespace {
+
+const int64_t kHousekeepingIntervalNs = 1000000000;
+// Feed messages per writeable callback at line rate, so one fast reader
+// cannot starve the other connections.
+const size_t kLineRateBatch = 256;
+
+std::string WallClockTimestamp() {
+  return FormatTimestampNanos(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+}  // namespace
+
+MockKrakenServer::MockKrakenServer(const MockFeed& feed, const MockServerConfig& config)
+    : feed_(feed), config_(config), feed_symbols_(SymbolRegistry::kMaxSymbols, 0), context_(nullptr),
+      housekeeping_timer_(0), heartbeat_timer_(0), running_(false), resume_cursor_(0), next_session_id_(1),
+      order_mode_(config.order_mode), order_requests_(0), next_order_id_(1), stats_() {
+  for (const MockFeedMessage& message : feed_.messages) {
+    if (message.symbol < feed_symbols_.size()) feed_symbols_[message.symbol] = 1;
+  }
+}
+
+MockKrakenServer::~MockKrakenServer() {
+  DestroyContext();
+}
+
+int MockKrakenServer::WebSocketCallback(struct lws* wsi, enum lws_callback_reasons reason,
+                                        void* user, void* in, size_t len) {
+  (void)user;
+  MockKrakenServer* server = static_cast<MockKrakenServer*>(lws_context_user(lws_get_context(wsi)));
+
+  switch (reason) {
+    case LWS_CALLBACK_ADD_POLL_FD: {
+      auto* args = static_cast<struct lws_pollargs*>(in);
+      server->loop_.AddFd(args->fd, static_cast<short>(args->events),
+                          [server](int fd, short revents) { server->ServiceFd(fd, revents); });
+      break;
+    }
+
+    case LWS_CALLBACK_DEL_POLL_FD:
+      server->loop_.RemoveFd(static_cast<struct lws_pollargs*>(in)->fd);
+      break;
+
+    case LWS_CALLBACK_CHANGE_MODE_POLL_FD: {
+      auto* args = static_cast<struct lws_pollargs*>(in);
+      server->loop_.ModifyFd(args->fd, static_cast<short>(args->events));
+      break;
+    }
+
+    case LWS_CALLBACK_ESTABLISHED:
+      server->OnEstablished(wsi);
+      break;
+
+    case LWS_CALLBACK_RECEIVE: {
+      auto it = server->sessions_.find(wsi);
+      if (it != server->sessions_.end()) {
+        server->OnReceive(*it->second, static_cast<const char*>(in), len);
+      }
+      break;
+    }
+
+    case LWS_CALLBACK_SERVER_WRITEABLE: {
+      auto it = server->sessions_.find(wsi);
+      if (it != server->sessions_.end() && !server->OnWriteable(*it->second)) {
+        return -1;
+      }
+      break;
+    }
+
+    case LWS_CALLBACK_CLOSED:
+      server->OnClosed(wsi);
+      break;
+
+    default:
+      break;
+  }
+
+  return 0;
+}
+
+void MockKrakenServer::ServiceFd(int fd, short revents) {
+  if (!context_) return;
+
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = revents;
+  pfd.revents = revents;
+  lws_service_fd(context_, &pfd);
+}
+
+void MockKrakenServer::OnEstablished(struct lws* wsi) {
+  auto session = std::make_unique<Session>();
+  session->wsi = wsi;
+  session->id = next_session_id_++;
+  session->subscribed.assign(SymbolRegistry::kMaxSymbols, 0);
+  session->started = false;
+  session->cursor = 0;
+  session->start_cursor = 0;
+  session->start_ns = 0;
+  session->burst_left = 0;
+  session->partial = nullptr;
+  session->partial_length = 0;
+  session->partial_sent = 0;
+  session->sent = 0;
+  session->bytes = 0;
+  session->pacing_timer = 0;
+  session->finished = false;
+  session->close_requested = false;
+  stats_.connections++;
+
+  Session& ref = *session;
+  sessions_[wsi] = std::move(session);
+  std::cout << "Connection " << ref.id << " opened" << std::endl;
+
+  json status = {
+    {"channel", "status"},
+    {"type", "update"},
+    {"data", json::array({{
+      {"version", "2.0.0"}, {"system", "online"}, {"api_version", "v2"}, {"connection_id", ref.id}
+    }})}
+  };
+  SendControl(ref, status.dump());
+}
+
+void MockKrakenServer::OnReceive(Session& session, const char* data, size_t length) {
+  session.rx_buffer.append(data, length);
+  if (!lws_is_final_fragment(session.wsi) || lws_remaining_packet_payload(session.wsi) != 0) {
+    return;
+  }
+  std::string text;
+  text.swap(session.rx_buffer);
+  HandleRequest(session, text);
+}
+
+void MockKrakenServer::HandleRequest(Session& session, const std::string& text) {
+  std::string time_in = WallClockTimestamp();
+  json request = json::parse(text, nullptr, false);
+  if (request.is_discarded() || !request.is_object()) {
+    SendControl(session, json({{"error", "Malformed request"}, {"success", false}}).dump());
+    return;
+  }
+
+  std::string method = request.value("method", "");
+  json reply = {{"method", method}};
+  if (request.contains("req_id")) reply["req_id"] = request["req_id"];
+
+  if (method == "ping") {
+    reply["method"] = "pong";
+    reply["time_in"] = time_in;
+    reply["time_out"] = WallClockTimestamp();
+    SendControl(session, reply.dump());
+    return;
+  }
+
+  if (method == "add_order" || method == "batch_add" || method == "cancel_order") {
+    HandleOrderRequest(session, method, request, reply);
+    return;
+  }
+
+  if (method != "subscribe" && method != "unsubscribe") {
+    reply["error"] = "Method not found";
+    reply["success"] = false;
+    SendControl(session, reply.dump());
+    return;
+  }
+
+  const json& params = request.contains("params") ? request["params"] : json::object();
+  std::string channel = params.is_object() ? params.value("channel", "") : "";
+  if (channel == "heartbeat" || channel == "status") {
+    reply["result"] = {{"channel", channel}};
+    reply["success"] = true;
+    SendControl(session, reply.dump());
+    return;
+  }
+
+  uint8_t bit = channel == "ohlc" ? kSubscribedOhlc
+              : channel == "book" ? kSubscribedBook
+              : channel == "trade" ? kSubscribedTrade : 0;
+  if (bit == 0 || !params.contains("symbol") || !params["symbol"].is_array()) {
+    reply["error"] = channel.empty() ? "Channel missing" : "Channel " + channel + " not supported";
+    reply["success"] = false;
+    SendControl(session, reply.dump());
+    return;
+  }
+
+  bool subscribe = method == "subscribe";
+  for (const json& entry : params["symbol"]) {
+    json ack = reply;
+    std::string symbol = entry.is_string() ? entry.get<std::string>() : "";
+    SymbolId id = SymbolRegistry::Global().Find(symbol);
+    if (id == kInvalidSymbol || !feed_symbols_[id]) {
+      ack["error"] = "Currency pair not supported " + symbol;
+      ack["success"] = false;
+      ack["symbol"] = symbol;
+      SendControl(session, ack.dump());
+      continue;
+    }
+
+    uint8_t& bits = session.subscribed[id];
+    bits = static_cast<uint8_t>(subscribe ? bits | bit : bits & ~bit);
+    // A (re)subscribed book waits for the feed's next snapshot.
+    if (bit == kSubscribedBook) bits = static_cast<uint8_t>(bits & ~kBookSynced);
+
+    json result = {{"channel", channel}, {"symbol", symbol}};
+    if (params.contains("interval")) result["interval"] = params["interval"];
+    if (params.contains("depth")) result["depth"] = params["depth"];
+    if (subscribe) result["snapshot"] = true;
+    ack["result"] = result;
+    ack["success"] = true;
+    ack["time_in"] = time_in;
+    ack["time_out"] = WallClockTimestamp();
+    SendControl(session, ack.dump());
+  }
+
+  if (subscribe && !session.started) {
+    session.started = true;
+    session.cursor = std::min(resume_cursor_, feed_.messages.size());
+    session.start_cursor = session.cursor;
+    session.start_ns = EventLoop::NowNanos();
+  }
+}
+
+void MockKrakenServer::HandleOrderRequest(Session& session, const std::string& method, const json& request,
+                                          json& reply) {
+  MockOrderMode mode = order_mode_.load(std::memory_order_relaxed);
+  if (mode == MockOrderMode::DISCONNECT) {
+    session.close_requested = true;
+    stats_.disconnects_injected++;
+    lws_callback_on_writable(session.wsi);
+    return;
+  }
+
+  const json& params = request.contains("params") ? request["params"] : json::object();
+  if (!params.is_object() || params.value("token", "") != config_.order_token) {
+    reply["error"] = "EAPI:Invalid token";
+    reply["success"] = false;
+    SendControl(session, reply.dump());
+    return;
+  }
+
+  auto new_order_id = [this]() {
+    char id[32];
+    std::snprintf(id, sizeof(id), "OMOCK-%06llu", static_cast<unsigned long long>(next_order_id_++));
+    return std::string(id);
+  };
+  bool validate = params.value("validate", false);
+  reply["time_in"] = WallClockTimestamp();
+
+  if (method == "cancel_order") {
+    const json& ids = params.contains("order_id") ? params["order_id"] : json::array();
+    std::string order_id = ids.is_array() && !ids.empty() && ids[0].is_string() ? ids[0].get<std::string>() : "";
+    if (open_orders_.erase(order_id) == 0) {
+      reply["error"] = "EOrder:Unknown order";
+      reply["success"] = false;
+    } else {
+      reply["result"] = {{"order_id", order_id}};
+      reply["success"] = true;
+      stats_.orders_cancelled++;
+    }
+  } else if (method == "add_order") {
+    if (NextOrderRejected()) {
+      reply["error"] = "EOrder:Insufficient funds";
+      reply["success"] = false;
+      stats_.orders_rejected++;
+    } else {
+      std::string order_id = new_order_id();
+      if (!validate) open_orders_.insert(order_id);
+      reply["result"] = {{"order_id", order_id}};
+      reply["success"] = true;
+      stats_.orders_accepted++;
+    }
+  } else {
+    // Kraken takes or refuses a batch as a whole.
+    const json& orders = params.contains("orders") ? params["orders"] : json::array();
+    size_t count = orders.is_array() ? orders.size() : 0;
+    if (count < 2 || NextOrderRejected()) {
+      reply["error"] = count < 2 ? "EGeneral:Invalid arguments:orders" : "EOrder:Insufficient funds";
+      reply["success"] = false;
+      stats_.orders_rejected += count;
+    } else {
+      json result = json::array();
+      for (size_t i = 0; i < count; i++) {
+        std::string order_id = new_order_id();
+        if (!validate) open_orders_.insert(order_id);
+        result.push_back({{"order_id", order_id}});
+      }
+      reply["result"] = result;
+      reply["success"] = true;
+      stats_.orders_accepted += count;
+    }
+  }
+
+  reply["time_out"] = WallClockTimestamp();
+  SendControl(session, reply.dump());
+}
+
+bool MockKrakenServer::NextOrderRejected() {
+  switch (order_mode_.load(std::memory_order_relaxed)) {
+    case MockOrderMode::ACCEPT:
+      return false;
+    case MockOrderMode::ALTERNATE:
+      return order_requests_++ % 2 == 1;
+    default:
+      return true;
+  }
+}
+
+void MockKrakenServer::SetOrderMode(MockOrderMode mode) {
+  order_mode_.store(mode, std::memory_order_relaxed);
+}
+
+void MockKrakenServer::OnClosed(struct lws* wsi) {
+  auto it = sessions_.find(wsi);
+  if (it == sessions_.end()) return;
+  Session& session = *it->second;
+
+  if (session.pacing_timer) {
+    loop_.CancelTimer(session.pacing_timer);
+  }
+  if (session.started) {
+    resume_cursor_ = std::max(resume_cursor_, session.cursor);
+    double seconds = static_cast<double>(EventLoop::NowNanos() - session.start_ns) / 1e9;
+    std::cout << "Connection " << session.id << " closed after " << session.sent << " messages ("
+              << session.bytes / 1024 << " KiB) in " << seconds << " s, "
+              << (seconds > 0.0 ? static_cast<double>(session.sent) / seconds : 0.0) << " msgs/s" << std::endl;
+  } else {
+    std::cout << "Connection " << session.id << " closed" << std::endl;
+  }
+  sessions_.erase(it);
+}
+
+void MockKrakenServer::SendControl(Session& session, std::string message) {
+  session.control.push_back(std::move(message));
+  lws_callback_on_writable(session.wsi);
+}
+
+void MockKrakenServer::SendHeartbeats() {
+  for (auto& entry : sessions_) {
+    if (entry.second->started) {
+      SendControl(*entry.second, "{\"channel\":\"heartbeat\"}");
+    }
+  }
+}
+
+const MockFeedMessage* MockKrakenServer::NextMessage(Session& session) {
+  while (session.cursor < feed_.messages.size()) {
+    const MockFeedMessage& message = feed_.messages[session.cursor];
+    uint8_t bits = session.subscribed[message.symbol];
+    bool wanted = false;
+    switch (message.channel) {
+      case MockChannel::OHLC:
+        wanted = (bits & kSubscribedOhlc) != 0;
+        break;
+      case MockChannel::TRADE:
+        wanted = (bits & kSubscribedTrade) != 0;
+        break;
+      case MockChannel::BOOK: {
+        // Updates only follow a snapshot the connection has seen.
+        bool synced = (bits & kBookSynced) != 0;
+        bool snapshot = (message.flags & kMockBookSnapshot) != 0;
+        wanted = (bits & kSubscribedBook) != 0 && snapshot != synced;
+        break;
+      }
+    }
+    if (wanted) return &message;
+    session.cursor++;
+  }
+  return nullptr;
+}
+
+int64_t MockKrakenServer::DueNanos(const Session& session, const MockFeedMessage& message) const {
+  int64_t origin = feed_.messages[session.start_cursor].offset_ns;
+  return session.start_ns + static_cast<int64_t>(static_cast<double>(message.offset_ns - origin) / config_.speed);
+}
+
+bool MockKrakenServer::WritePartial(Session& session, bool& failed) {
+  failed = false;
+  while (session.partial_sent < session.partial_length) {
+    size_t remaining = session.partial_length - session.partial_sent;
+    size_t chunk = config_.fragment_bytes > 0 ? std::min(config_.fragment_bytes, remaining) : remaining;
+    bool first = session.partial_sent == 0;
+    bool last = chunk == remaining;
+    int flags = first ? LWS_WRITE_TEXT : LWS_WRITE_CONTINUATION;
+    if (!last) flags |= LWS_WRITE_NO_FIN;
+
+    if (write_buffer_.size() < LWS_PRE + chunk) {
+      write_buffer_.resize(LWS_PRE + chunk);
+    }
+    std::memcpy(write_buffer_.data() + LWS_PRE, session.partial + session.partial_sent, chunk);
+    int written = lws_write(session.wsi, write_buffer_.data() + LWS_PRE, chunk,
+                            static_cast<enum lws_write_protocol>(flags));
+    if (written < static_cast<int>(chunk)) {
+      std::cerr << "Connection " << session.id << ": write failed" << std::endl;
+      failed = true;
+      return false;
+    }
+    session.partial_sent += chunk;
+
+    if (!last && lws_send_pipe_choked(session.wsi)) {
+      lws_callback_on_writable(session.wsi);
+      return false;
+    }
+  }
+  session.partial = nullptr;
+  return true;
+}
+
+bool MockKrakenServer::OnWriteable(Session& session) {
+  if (session.close_requested) return false;
+  bool failed = false;
+  // A fragmented message must finish before any other frame.
+  if (session.partial && !WritePartial(session, failed)) {
+    return !failed;
+  }
+
+  while (!session.control.empty()) {
+    const std::string& message = session.control.front();
+    if (write_buffer_.size() < LWS_PRE + message.size()) {
+      write_buffer_.resize(LWS_PRE + message.size());
+    }
+    std::memcpy(write_buffer_.data() + LWS_PRE, message.data(), message.size());
+    int written = lws_write(session.wsi, write_buffer_.data() + LWS_PRE, message.size(), LWS_WRITE_TEXT);
+    if (written < static_cast<int>(message.size())) {
+      std::cerr << "Connection " << session.id << ": write failed" << std::endl;
+      return false;
+    }
+    session.control.pop_front();
+    if (lws_send_pipe_choked(session.wsi)) {
+      lws_callback_on_writable(session.wsi);
+      return true;
+    }
+  }
+
+  if (!session.started) return true;
+
+  const bool paced = config_.speed > 0.0;
+  size_t written = 0;
+  while (const MockFeedMessage* message = NextMessage(session)) {
+    if (paced && session.burst_left == 0) {
+      int64_t wait_ns = DueNanos(session, *message) - EventLoop::NowNanos();
+      if (wait_ns > 0) {
+        if (!session.pacing_timer) {
+          struct lws* wsi = session.wsi;
+          session.pacing_timer = loop_.AddTimer(wait_ns, 0, [this, wsi]() {
+            auto it = sessions_.find(wsi);
+            if (it == sessions_.end()) return;
+            it->second->pacing_timer = 0;
+            lws_callback_on_writable(wsi);
+          });
+        }
+        return true;
+      }
+      session.burst_left = std::max<size_t>(1, config_.burst);
+    }
+
+    if (message->channel == MockChannel::BOOK && (message->flags & kMockBookSnapshot)) {
+      session.subscribed[message->symbol] |= kBookSynced;
+    }
+    session.cursor++;
+    if (paced) session.burst_left--;
+    session.sent++;
+    session.bytes += message->length;
+    stats_.messages++;
+    stats_.bytes += message->length;
+
+    session.partial = feed_.text.data() + message->begin;
+    session.partial_length = message->length;
+    session.partial_sent = 0;
+    if (!WritePartial(session, failed)) {
+      return !failed;
+    }
+
+    if (config_.disconnect_every > 0 && session.sent % config_.disconnect_every == 0) {
+      static const char kReason[] = "injected disconnect";
+      std::cout << "Connection " << session.id << ": injecting disconnect" << std::endl;
+      stats_.disconnects_injected++;
+      lws_close_reason(session.wsi, LWS_CLOSE_STATUS_GOINGAWAY,
+                       reinterpret_cast<unsigned char*>(const_cast<char*>(kReason)), sizeof(kReason) - 1);
+      return false;
+    }
+    if (lws_send_pipe_choked(session.wsi) || (!paced && ++written >= kLineRateBatch)) {
+      lws_callback_on_writable(session.wsi);
+      return true;
+    }
+  }
+
+  if (!session.finished) {
+    session.finished = true;
+    double seconds = static_cast<double>(EventLoop::NowNanos() - session.start_ns) / 1e9;
+    std::cout << "Connection " << session.id << " reached the end of the feed: " << session.sent
+              << " messages in " << seconds << " s" << std::endl;
+  }
+  return true;
+}
+
+void MockKrakenServer::Start() {
+  static struct lws_protocols protocols[] = {
+    {
+      "kraken-protocol",
+      WebSocketCallback,
+      0,
+      4096,
+      0,
+      NULL,
+      0,
+    },
+    { NULL, NULL, 0, 0, 0, NULL, 0 }
+  };
+
+  struct lws_context_creation_info info;
+  memset(&info, 0, sizeof(info));
+  info.port = config_.port;
+  info.iface = config_.bind_address.empty() ? nullptr : config_.bind_address.c_str();
+  info.protocols = protocols;
+  info.gid = -1;
+  info.uid = -1;
+  info.user = this;
+
+  context_ = lws_create_context(&info);
+  if (!context_) {
+    throw std::runtime_error("Failed to listen on port " + std::to_string(config_.port));
+  }
+
+  running_ = true;
+  housekeeping_timer_ = loop_.AddTimer(kHousekeepingIntervalNs, kHousekeepingIntervalNs, [this]() {
+    if (context_) lws_service_fd(context_, nullptr);
+  });
+  if (config_.heartbeat_interval_ms > 0) {
+    int64_t interval_ns = config_.heartbeat_interval_ms * 1000000;
+    heartbeat_timer_ = loop_.AddTimer(interval_ns, interval_ns, [this]() { SendHeartbeats(); });
+  }
+}
+
+void MockKrakenServer::Run() {
+  while (running_ && !loop_.StopRequested()) {
+    loop_.RunOnce(-1);
+  }
+  DestroyContext();
+  loop_.ResetStop();
+}
+
+void MockKrakenServer::Stop() {
+  running_.store(false);
+  loop_.RequestStop();
+}
+
+MockServerStats MockKrakenServer::Stats() const {
+  return stats_;
+}
+
+void MockKrakenServer::DestroyContext() {
+  running_ = false;
+  if (housekeeping_timer_) {
+    loop_.CancelTimer(housekeeping_timer_);
+    housekeeping_timer_ = 0;
+  }
+  if (heartbeat_timer_) {
+    loop_.CancelTimer(heartbeat_timer_);
+    heartbeat_timer_ = 0;
+  }
+  if (context_) {
+    // Closes every connection, which reports CLOSED for each session.
+    lws_context_destroy(context_);
+    context_ = nullptr;
+  }
+  sessions_.clear();
+}
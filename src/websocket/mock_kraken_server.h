@@ -0,0 +1,172 @@
+#ifndef MOCK_KRAKEN_SERVER_H
+#define MOCK_KRAKEN_SERVER_H
+
+#include "mock_kraken_feed.h"
+#include "../pipeline/event_loop.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <libwebsockets.h>
+#include <nlohmann/json.hpp>
+
+// How the server answers add_order, batch_add and cancel_order.
+enum class MockOrderMode : uint8_t {
+  ACCEPT,
+  // Every order fails with an insufficient-funds error.
+  REJECT,
+  // Accepts and rejects in turn, one add_order or batch_add at a time, so
+  // the two legs of a spread get opposite answers.
+  ALTERNATE,
+  // Drops the connection instead of replying.
+  DISCONNECT
+};
+
+struct MockServerConfig {
+  // Address to bind; empty listens on every interface.
+  std::string bind_address = "127.0.0.1";
+  int port = 8765;
+  // Multiple of real time the feed is replayed at; 0 sends at line rate,
+  // as fast as each socket drains.
+  double speed = 1.0;
+  // Messages released together: a burst goes out back to back in one
+  // writeable callback when its first message is due.
+  size_t burst = 1;
+  // Splits every message into continuation frames of at most this many
+  // bytes; 0 sends whole frames.
+  size_t fragment_bytes = 0;
+  // Drops each connection after it was sent this many feed messages; 0
+  // never. The next connection resumes the feed where it stopped.
+  uint64_t disconnect_every = 0;
+  int64_t heartbeat_interval_ms = 1000;
+  MockOrderMode order_mode = MockOrderMode::ACCEPT;
+  // Order requests must carry this token.
+  std::string order_token = "mock-token";
+};
+
+struct MockServerStats {
+  uint64_t connections;
+  uint64_t disconnects_injected;
+  uint64_t messages;
+  uint64_t bytes;
+  uint64_t orders_accepted;
+  uint64_t orders_rejected;
+  uint64_t orders_cancelled;
+};
+
+// Local stand-in for wss://ws.kraken.com/v2 for offline and load tests.
+// Speaks the v2 subscribe/unsubscribe/ping methods for the ohlc, book and
+// trade channels, sends status and heartbeats, and replays a MockFeed to
+// each connection filtered to its subscriptions. It also takes orders like
+// the authenticated endpoint: add_order, batch_add and cancel_order are
+// answered per MockOrderMode, with accepted non-validate orders kept open
+// until cancelled. A connection's replay
+// clock starts at its first subscription. Plain ws:// only; point the
+// client at it with BASE_WS_ENDPOINT=ws://127.0.0.1:<port>.
+//
+// lws runs on the same EventLoop integration as KrakenWebSocketBase, so
+// pacing timers and sockets share one epoll wait.
+class MockKrakenServer {
+ public:
+  MockKrakenServer(const MockFeed& feed, const MockServerConfig& config);
+  ~MockKrakenServer();
+
+  MockKrakenServer(const MockKrakenServer&) = delete;
+  MockKrakenServer& operator=(const MockKrakenServer&) = delete;
+
+  // Binds the listening socket; throws std::runtime_error on failure.
+  void Start();
+  // Serves connections on the calling thread until Stop().
+  void Run();
+  // Async-signal-safe.
+  void Stop();
+
+  // Safe to call from any thread; applies to the next order request.
+  void SetOrderMode(MockOrderMode mode);
+
+  // Only consistent once Run() has returned.
+  MockServerStats Stats() const;
+
+ private:
+  // Per-channel subscription bits in Session::subscribed.
+  static const uint8_t kSubscribedOhlc = 1u << 0;
+  static const uint8_t kSubscribedBook = 1u << 1;
+  static const uint8_t kSubscribedTrade = 1u << 2;
+  static const uint8_t kBookSynced = 1u << 3;
+
+  struct Session {
+    struct lws* wsi;
+    uint64_t id;
+    // Indexed by SymbolId.
+    std::vector<uint8_t> subscribed;
+    // Replies, status and heartbeats; sent ahead of feed messages.
+    std::deque<std::string> control;
+    bool started;
+    size_t cursor;
+    size_t start_cursor;
+    int64_t start_ns;
+    // Feed messages still allowed in the current burst.
+    size_t burst_left;
+    // Message being fragmented and how much of it is out.
+    const char* partial;
+    size_t partial_length;
+    size_t partial_sent;
+    uint64_t sent;
+    uint64_t bytes;
+    EventLoop::TimerId pacing_timer;
+    bool finished;
+    // Closes the connection at the next writeable callback.
+    bool close_requested;
+    std::string rx_buffer;
+  };
+
+  static int WebSocketCallback(struct lws* wsi, enum lws_callback_reasons reason,
+                               void* user, void* in, size_t len);
+  void ServiceFd(int fd, short revents);
+  void OnEstablished(struct lws* wsi);
+  void OnReceive(Session& session, const char* data, size_t length);
+  void HandleRequest(Session& session, const std::string& text);
+  void HandleOrderRequest(Session& session, const std::string& method, const nlohmann::json& request,
+                          nlohmann::json& reply);
+  // Whether the next add_order or batch_add is rejected under the mode.
+  bool NextOrderRejected();
+  void OnClosed(struct lws* wsi);
+  // Returns false when the connection should close.
+  bool OnWriteable(Session& session);
+  // Writes the rest of session.partial; false if the pipe choked first.
+  bool WritePartial(Session& session, bool& failed);
+  // Advances past messages the session is not subscribed to and returns
+  // the next one to send, or nullptr at the end of the feed.
+  const MockFeedMessage* NextMessage(Session& session);
+  int64_t DueNanos(const Session& session, const MockFeedMessage& message) const;
+  void SendControl(Session& session, std::string message);
+  void SendHeartbeats();
+  void DestroyContext();
+
+  const MockFeed& feed_;
+  MockServerConfig config_;
+  // Indexed by SymbolId: symbols the feed has messages for.
+  std::vector<uint8_t> feed_symbols_;
+  EventLoop loop_;
+  struct lws_context* context_;
+  std::unordered_map<struct lws*, std::unique_ptr<Session>> sessions_;
+  EventLoop::TimerId housekeeping_timer_;
+  EventLoop::TimerId heartbeat_timer_;
+  std::atomic<bool> running_;
+  // Where the next connection starts: the furthest point a dropped
+  // connection reached.
+  size_t resume_cursor_;
+  uint64_t next_session_id_;
+  std::vector<unsigned char> write_buffer_;
+  std::atomic<MockOrderMode> order_mode_;
+  uint64_t order_requests_;
+  uint64_t next_order_id_;
+  std::unordered_set<std::string> open_orders_;
+  MockServerStats stats_;
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "ohlc_message_parser.h"
+#include "json_cursor.h"
+#include "../market_data/timestamp.h"
+
+namespace {
+
+enum CandleField : unsigned {
+  FIELD_SYMBOL = 1u << 0,
+  FIELD_OPEN = 1u << 1,
+  FIELD_HIGH = 1u << 2,
+  FIELD_LOW = 1u << 3,
+  FIELD_CLOSE = 1u << 4,
+  FIELD_VWAP = 1u << 5,
+  FIELD_VOLUME = 1u << 6,
+  FIELD_TRADES = 1u << 7,
+  FIELD_INTERVAL_BEGIN = 1u << 8,
+  FIELD_INTERVAL = 1u << 9,
+  FIELD_ALL = (1u << 10) - 1
+};
+
+bool ParseCandleObject(JsonCursor& cursor, Candle& candle) {
+  if (!cursor.EnterObject()) return false;
+
+  unsigned seen = 0;
+  std::string_view key;
+  std::string_view text;
+  int64_t integer;
+  // Price and volume text, parsed once the symbol and so its scale is known.
+  std::string_view open, high, low, close, vwap, volume;
+
+  while (cursor.NextKey(key)) {
+    if (key == "symbol" && cursor.ReadString(text)) {
+      // Subscribed symbols are interned up front, so Intern() only takes its
+      // lock the first time an unexpected symbol shows up.
+      candle.symbol = SymbolRegistry::Global().Find(text);
+      if (candle.symbol == kInvalidSymbol) {
+        candle.symbol = SymbolRegistry::Global().Intern(text);
+      }
+      if (candle.symbol != kInvalidSymbol) seen |= FIELD_SYMBOL;
+    } else if (key == "open" && cursor.ReadNumberText(open)) {
+      seen |= FIELD_OPEN;
+    } else if (key == "high" && cursor.ReadNumberText(high)) {
+      seen |= FIELD_HIGH;
+    } else if (key == "low" && cursor.ReadNumberText(low)) {
+      seen |= FIELD_LOW;
+    } else if (key == "close" && cursor.ReadNumberText(close)) {
+      seen |= FIELD_CLOSE;
+    } else if (key == "vwap" && cursor.ReadNumberText(vwap)) {
+      seen |= FIELD_VWAP;
+    } else if (key == "volume" && cursor.ReadNumberText(volume)) {
+      seen |= FIELD_VOLUME;
+    } else if (key == "trades" && cursor.ReadInt64(integer)) {
+      candle.trades = static_cast<uint32_t>(integer);
+      seen |= FIELD_TRADES;
+    } else if (key == "interval_begin" && cursor.ReadString(text)) {
+      if (ParseTimestampNanos(text.data(), text.size(), candle.interval_begin)) {
+        seen |= FIELD_INTERVAL_BEGIN;
+      }
+    } else if (key == "interval" && cursor.ReadInt64(integer)) {
+      candle.interval = static_cast<uint16_t>(integer);
+      seen |= FIELD_INTERVAL;
+    } else if (!cursor.Failed()) {
+      cursor.SkipValue();
+    }
+  }
+
+  if (cursor.Failed() || seen != FIELD_ALL) return false;
+
+  SymbolPrecision precision = MarketPrecision(candle.symbol);
+  return ParseMantissa(open, precision.price_decimals, candle.open) &&
+         ParseMantissa(high, precision.price_decimals, candle.high) &&
+         ParseMantissa(low, precision.price_decimals, candle.low) &&
+         ParseMantissa(close, precision.price_decimals, candle.close) &&
+         ParseMantissa(vwap, precision.price_decimals, candle.vwap) &&
+         ParseMantissa(volume, precision.qty_decimals, candle.volume);
+}
+
+bool ParseCandleArray(JsonCursor& cursor, Candle& scratch,
+                      const std::function<void(const Candle&)>& on_candle) {
+  if (!cursor.EnterArray()) return false;
+
+  while (cursor.NextElement()) {
+    if (!ParseCandleObject(cursor, scratch)) return false;
+    if (on_candle) on_candle(scratch);
+  }
+  return !cursor.Failed();
+}
+
+}  // namespace
+
+OhlcParseResult ParseOhlcMessage(const char* data, size_t length, Candle& scratch,
+                                 const std::function<void(const Candle&)>& on_candle) {
+  JsonCursor cursor(data, data + length);
+  if (!cursor.EnterObject()) return OhlcParseResult::MALFORMED;
+
+  bool is_ohlc = false;
+  bool channel_seen = false;
+  bool parsed_data = false;
+  const char* deferred_data = nullptr;
+
+  std::string_view key;
+  while (cursor.NextKey(key)) {
+    if (key == "channel") {
+      std::string_view channel;
+      if (!cursor.ReadString(channel)) break;
+      channel_seen = true;
+      is_ohlc = channel == "ohlc";
+      if (!is_ohlc) return OhlcParseResult::IGNORED;
+    } else if (key == "data" && channel_seen) {
+      if (!ParseCandleArray(cursor, scratch, on_candle)) return OhlcParseResult::MALFORMED;
+      parsed_data = true;
+    } else if (key == "data") {
+      // Kraken sends "channel" first; tolerate the other order by coming back.
+      deferred_data = cursor.Position();
+      cursor.SkipValue();
+    } else {
+      cursor.SkipValue();
+    }
+  }
+
+  if (cursor.Failed()) return OhlcParseResult::MALFORMED;
+  if (!is_ohlc) return OhlcParseResult::IGNORED;
+
+  if (!parsed_data && deferred_data) {
+    JsonCursor data_cursor(deferred_data, data + length);
+    if (!ParseCandleArray(data_cursor, scratch, on_candle)) return OhlcParseResult::MALFORMED;
+    parsed_data = true;
+  }
+
+  return parsed_data ? OhlcParseResult::CANDLES : OhlcParseResult::IGNORED;
+}
@@ -0,0 +1,21 @@
+#ifndef OHLC_MESSAGE_PARSER_H
+#define OHLC_MESSAGE_PARSER_H
+
+#include "../market_data/candle.h"
+#include <cstddef>
+#include <functional>
+
+enum class OhlcParseResult {
+  CANDLES,
+  IGNORED,
+  MALFORMED
+};
+
+// Parses a raw Kraken v2 message and, if it is on the "ohlc" channel, fills
+// scratch with each entry of "data" and hands it to on_candle; parsing
+// allocates nothing. Messages on other channels, acks and heartbeats return
+// IGNORED.
+OhlcParseResult ParseOhlcMessage(const char* data, size_t length, Candle& scratch,
+                                 const std::function<void(const Candle&)>& on_candle);
+
+#endif
@@ -0,0 +1,182 @@
+#include "outbound_queue.h"
+#include <algorithm>
+#include <cstring>
+
+OutboundQueue::OutboundQueue(size_t frame_count)
+    : frame_count_(frame_count > 0 ? frame_count : 1),
+      frames_(new OutboundFrame[frame_count_]),
+      free_head_(0), in_use_(0), rejected_(0),
+      stub_(new OutboundFrame) {
+  for (size_t i = 0; i < frame_count_; i++) {
+    frames_[i].index = static_cast<uint32_t>(i);
+    frames_[i].next.store(nullptr, std::memory_order_relaxed);
+    frames_[i].next_free.store(i + 1 < frame_count_ ? static_cast<uint32_t>(i + 2) : 0,
+                               std::memory_order_relaxed);
+  }
+  free_head_.store(1, std::memory_order_relaxed);
+
+  stub_->next.store(nullptr, std::memory_order_relaxed);
+  head_.store(stub_.get(), std::memory_order_relaxed);
+  tail_ = stub_.get();
+}
+
+OutboundFrame* OutboundQueue::AcquireFrame() {
+  uint64_t head = free_head_.load(std::memory_order_acquire);
+  while (true) {
+    uint32_t slot = static_cast<uint32_t>(head);
+    if (slot == 0) return nullptr;
+
+    OutboundFrame* frame = &frames_[slot - 1];
+    uint64_t next = ((head >> 32) + 1) << 32 | frame->next_free.load(std::memory_order_relaxed);
+    if (free_head_.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      in_use_.fetch_add(1, std::memory_order_relaxed);
+      return frame;
+    }
+  }
+}
+
+void OutboundQueue::Release(OutboundFrame* frame) {
+  uint64_t head = free_head_.load(std::memory_order_relaxed);
+  while (true) {
+    frame->next_free.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    uint64_t next = ((head >> 32) + 1) << 32 | (frame->index + 1);
+    if (free_head_.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed)) {
+      in_use_.fetch_sub(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+}
+
+bool OutboundQueue::Enqueue(const char* data, size_t length, bool binary) {
+  OutboundFrame* first = nullptr;
+  OutboundFrame* last = nullptr;
+  if (!BuildChain(data, length, binary, first, last)) {
+    rejected_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  PushChain(first, last);
+  return true;
+}
+
+bool OutboundQueue::EnqueueAll(const std::string_view* messages, size_t count) {
+  OutboundFrame* first = nullptr;
+  OutboundFrame* last = nullptr;
+  for (size_t i = 0; i < count; i++) {
+    OutboundFrame* chain_first = nullptr;
+    OutboundFrame* chain_last = nullptr;
+    if (!BuildChain(messages[i].data(), messages[i].size(), false, chain_first, chain_last)) {
+      ReleaseChain(first);
+      rejected_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    if (last) {
+      last->next.store(chain_first, std::memory_order_relaxed);
+    } else {
+      first = chain_first;
+    }
+    last = chain_last;
+  }
+  if (first) PushChain(first, last);
+  return true;
+}
+
+bool OutboundQueue::BuildChain(const char* data, size_t length, bool binary,
+                               OutboundFrame*& first, OutboundFrame*& last) {
+  size_t fragments = length == 0 ? 1 : (length + OutboundFrame::kPayloadCapacity - 1) / OutboundFrame::kPayloadCapacity;
+  first = nullptr;
+  last = nullptr;
+  size_t offset = 0;
+
+  for (size_t i = 0; i < fragments; i++) {
+    OutboundFrame* frame = AcquireFrame();
+    if (!frame) {
+      // Give back what was taken so a partial message is never sent.
+      ReleaseChain(first);
+      first = nullptr;
+      last = nullptr;
+      return false;
+    }
+
+    size_t chunk = std::min(length - offset, OutboundFrame::kPayloadCapacity);
+    std::memcpy(frame->Payload(), data + offset, chunk);
+    frame->length = static_cast<uint32_t>(chunk);
+    frame->write_flags = (i == 0 ? (binary ? LWS_WRITE_BINARY : LWS_WRITE_TEXT) : LWS_WRITE_CONTINUATION) |
+                         (i + 1 < fragments ? LWS_WRITE_NO_FIN : 0);
+    frame->next.store(nullptr, std::memory_order_relaxed);
+    offset += chunk;
+
+    if (last) {
+      last->next.store(frame, std::memory_order_relaxed);
+    } else {
+      first = frame;
+    }
+    last = frame;
+  }
+  return true;
+}
+
+void OutboundQueue::ReleaseChain(OutboundFrame* first) {
+  while (first) {
+    OutboundFrame* next = first->next.load(std::memory_order_relaxed);
+    Release(first);
+    first = next;
+  }
+}
+
+void OutboundQueue::PushChain(OutboundFrame* first, OutboundFrame* last) {
+  last->next.store(nullptr, std::memory_order_relaxed);
+  OutboundFrame* previous = head_.exchange(last, std::memory_order_acq_rel);
+  previous->next.store(first, std::memory_order_release);
+}
+
+OutboundFrame* OutboundQueue::Pop() {
+  OutboundFrame* tail = tail_;
+  OutboundFrame* next = tail->next.load(std::memory_order_acquire);
+
+  if (tail == stub_.get()) {
+    if (!next) return nullptr;
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if (next) {
+    tail_ = next;
+    return tail;
+  }
+
+  // tail is the last linked frame; if a producer has already swung head_
+  // past it, its link is about to appear.
+  if (tail != head_.load(std::memory_order_acquire)) return nullptr;
+
+  // Re-insert the stub behind tail so tail can be handed out.
+  PushChain(stub_.get(), stub_.get());
+  next = tail->next.load(std::memory_order_acquire);
+  if (next) {
+    tail_ = next;
+    return tail;
+  }
+  return nullptr;
+}
+
+size_t OutboundQueue::Clear() {
+  size_t dropped = 0;
+  while (OutboundFrame* frame = Pop()) {
+    Release(frame);
+    dropped++;
+  }
+  return dropped;
+}
+
+bool OutboundQueue::Empty() const {
+  OutboundFrame* tail = tail_;
+  return tail == stub_.get() && tail->next.load(std::memory_order_acquire) == nullptr;
+}
+
+size_t OutboundQueue::FramesInUse() const {
+  return in_use_.load(std::memory_order_relaxed);
+}
+
+uint64_t OutboundQueue::Rejected() const {
+  return rejected_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,89 @@
+#ifndef OUTBOUND_QUEUE_H
+#define OUTBOUND_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <libwebsockets.h>
+
+// One preallocated websocket frame with LWS_PRE bytes of headroom in front
+// of the payload, as lws_write() requires.
+struct OutboundFrame {
+  static constexpr size_t kSize = 4096;
+  static constexpr size_t kHeaderSize = 64;
+  static constexpr size_t kPayloadCapacity = kSize - kHeaderSize - LWS_PRE;
+
+  // Link for the send queue.
+  std::atomic<OutboundFrame*> next;
+  // Free-list link as pool index + 1, 0 terminates.
+  std::atomic<uint32_t> next_free;
+  uint32_t index;
+  uint32_t length;
+  // lws_write_protocol flags for this fragment.
+  int write_flags;
+  alignas(64) unsigned char buffer[LWS_PRE + kPayloadCapacity];
+
+  unsigned char* Payload() { return buffer + LWS_PRE; }
+};
+
+// Bounded outbound path for one connection. Any thread may Enqueue(); the
+// lws service thread is the single consumer that pops frames in
+// LWS_CALLBACK_CLIENT_WRITEABLE and releases them back to the pool.
+//
+// Frames come from a fixed pool with a lock-free, ABA-safe free list, and
+// the queue is an intrusive Vyukov MPSC list, so enqueueing never allocates,
+// blocks or takes a lock. Messages longer than one frame are split into
+// continuation fragments that are linked first and published as one chain,
+// so fragments of concurrent messages never interleave.
+class OutboundQueue {
+ public:
+  explicit OutboundQueue(size_t frame_count = 256);
+
+  OutboundQueue(const OutboundQueue&) = delete;
+  OutboundQueue& operator=(const OutboundQueue&) = delete;
+
+  // Returns false, without sending anything, if the pool cannot hold the
+  // whole message.
+  bool Enqueue(const char* data, size_t length, bool binary = false);
+  // Text messages published as one chain: all of them go out back to back,
+  // or none does if the pool cannot hold every one.
+  bool EnqueueAll(const std::string_view* messages, size_t count);
+
+  // Consumer only. Returns nullptr when empty or while a producer is still
+  // linking its chain; that producer's wakeup will follow.
+  OutboundFrame* Pop();
+  void Release(OutboundFrame* frame);
+  // Consumer only. Drops every queued frame; returns how many.
+  size_t Clear();
+
+  // Consumer only.
+  bool Empty() const;
+  size_t FramesInUse() const;
+  uint64_t Rejected() const;
+
+ private:
+  OutboundFrame* AcquireFrame();
+  // Copies one message into linked frames without publishing them.
+  bool BuildChain(const char* data, size_t length, bool binary, OutboundFrame*& first, OutboundFrame*& last);
+  void ReleaseChain(OutboundFrame* first);
+  void PushChain(OutboundFrame* first, OutboundFrame* last);
+
+  size_t frame_count_;
+  std::unique_ptr<OutboundFrame[]> frames_;
+
+  // Free list head: (tag << 32) | (index + 1); the tag changes on every
+  // update so a stale head can never win a compare-exchange.
+  alignas(64) std::atomic<uint64_t> free_head_;
+  std::atomic<size_t> in_use_;
+  std::atomic<uint64_t> rejected_;
+
+  // Producers swing head_; the consumer owns tail_. stub_ keeps the list
+  // non-empty so push and pop never touch the same pointer.
+  alignas(64) std::atomic<OutboundFrame*> head_;
+  alignas(64) OutboundFrame* tail_;
+  std::unique_ptr<OutboundFrame> stub_;
+};
+
+#endif
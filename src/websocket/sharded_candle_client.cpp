@@ -0,0 +1,109 @@
+#include "sharded_candle_client.h"
+#include "../pipeline/thread_affinity.h"
+#include <algorithm>
+#include <iostream>
+
+ShardedCandleClient::ShardedCandleClient(const std::string& ws_endpoint, size_t shard_count) {
+  if (shard_count == 0) shard_count = 1;
+  for (size_t i = 0; i < shard_count; i++) {
+    shards_.push_back(std::make_unique<KrakenCandleStream>(ws_endpoint));
+  }
+  shard_symbols_.resize(shard_count);
+}
+
+ShardedCandleClient::~ShardedCandleClient() {
+  Stop();
+  Join();
+}
+
+void ShardedCandleClient::SubscribeCandles(const std::vector<std::string>& symbols, int interval, bool snapshot) {
+  std::vector<std::vector<std::string>> batches(shards_.size());
+
+  for (const auto& symbol : symbols) {
+    auto it = symbol_shards_.find(symbol);
+    size_t shard;
+    if (it != symbol_shards_.end()) {
+      shard = it->second;
+    } else {
+      shard = 0;
+      for (size_t i = 1; i < shards_.size(); i++) {
+        if (shard_symbols_[i].size() < shard_symbols_[shard].size()) shard = i;
+      }
+      symbol_shards_.emplace(symbol, shard);
+      shard_symbols_[shard].push_back(symbol);
+    }
+    batches[shard].push_back(symbol);
+  }
+
+  for (size_t i = 0; i < shards_.size(); i++) {
+    if (!batches[i].empty()) {
+      shards_[i]->SubscribeCandles(batches[i], interval, snapshot);
+    }
+  }
+}
+
+void ShardedCandleClient::SetCandleCallback(std::function<void(size_t shard, const Candle&)> callback) {
+  for (size_t i = 0; i < shards_.size(); i++) {
+    shards_[i]->SetCandleCallback([callback, i](const Candle& candle) { callback(i, candle); });
+  }
+}
+
+void ShardedCandleClient::SetShardCpus(const std::vector<int>& cpus) {
+  cpus_ = cpus;
+}
+
+void ShardedCandleClient::SetReconnect(bool enabled) {
+  for (auto& shard : shards_) {
+    shard->SetReconnect(enabled);
+  }
+}
+
+void ShardedCandleClient::SetHeartbeatTimeout(int64_t timeout_ms) {
+  for (auto& shard : shards_) {
+    shard->SetHeartbeatTimeout(timeout_ms);
+  }
+}
+
+void ShardedCandleClient::Start() {
+  for (size_t i = 0; i < shards_.size(); i++) {
+    threads_.emplace_back(&ShardedCandleClient::ServiceShard, this, i);
+  }
+}
+
+void ShardedCandleClient::ServiceShard(size_t shard) {
+  SetCurrentThreadName("ws-shard-" + std::to_string(shard));
+  int cpu = shard < cpus_.size() ? cpus_[shard] : -1;
+  if (cpu >= 0 && !PinCurrentThread(cpu)) {
+    std::cerr << "Could not pin shard " << shard << " to CPU " << cpu << std::endl;
+  }
+
+  // The lws context is created on the thread that services it.
+  try {
+    shards_[shard]->Connect();
+  } catch (const std::exception& e) {
+    std::cerr << "Shard " << shard << ": " << e.what() << std::endl;
+    return;
+  }
+  shards_[shard]->Run();
+}
+
+void ShardedCandleClient::Stop() {
+  for (auto& shard : shards_) {
+    shard->Stop();
+  }
+}
+
+void ShardedCandleClient::Join() {
+  for (auto& thread : threads_) {
+    if (thread.joinable()) thread.join();
+  }
+  threads_.clear();
+}
+
+size_t ShardedCandleClient::ShardCount() const {
+  return shards_.size();
+}
+
+const std::vector<std::string>& ShardedCandleClient::ShardSymbols(size_t shard) const {
+  return shard_symbols_.at(shard);
+}
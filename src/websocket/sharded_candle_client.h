@@ -0,0 +1,54 @@
+#ifndef SHARDED_CANDLE_CLIENT_H
+#define SHARDED_CANDLE_CLIENT_H
+
+#include "kraken_websocket_candle_stream.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Spreads a symbol universe over several KrakenCandleStream connections,
+// each serviced by its own thread (optionally pinned). Symbols go to the
+// least-loaded shard and are subscribed in batched requests; every shard
+// reconnects and replays its own subscriptions independently.
+class ShardedCandleClient {
+ public:
+  ShardedCandleClient(const std::string& ws_endpoint, size_t shard_count);
+  ~ShardedCandleClient();
+
+  ShardedCandleClient(const ShardedCandleClient&) = delete;
+  ShardedCandleClient& operator=(const ShardedCandleClient&) = delete;
+
+  // Symbols already assigned stay on their shard.
+  void SubscribeCandles(const std::vector<std::string>& symbols, int interval, bool snapshot = true);
+  // Runs on the owning shard's service thread; shard is a stable index in
+  // [0, ShardCount()), suitable as a StrategyPipeline producer index.
+  void SetCandleCallback(std::function<void(size_t shard, const Candle&)> callback);
+  // CPU per shard thread, -1 to leave a shard unpinned.
+  void SetShardCpus(const std::vector<int>& cpus);
+  void SetReconnect(bool enabled);
+  void SetHeartbeatTimeout(int64_t timeout_ms);
+
+  // Connects every shard on its own service thread.
+  void Start();
+  // Async-signal-safe.
+  void Stop();
+  // Waits for every service thread to finish.
+  void Join();
+
+  size_t ShardCount() const;
+  const std::vector<std::string>& ShardSymbols(size_t shard) const;
+
+ private:
+  void ServiceShard(size_t shard);
+
+  std::vector<std::unique_ptr<KrakenCandleStream>> shards_;
+  std::vector<std::vector<std::string>> shard_symbols_;
+  std::unordered_map<std::string, size_t> symbol_shards_;
+  std::vector<int> cpus_;
+  std::vector<std::thread> threads_;
+};
+
+#endif
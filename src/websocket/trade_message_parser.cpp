@@ -0,0 +1,114 @@
+#include "trade_message_parser.h"
+#include "json_cursor.h"
+#include "../market_data/timestamp.h"
+
+namespace {
+
+enum TradeField : unsigned {
+  FIELD_SYMBOL = 1u << 0,
+  FIELD_SIDE = 1u << 1,
+  FIELD_PRICE = 1u << 2,
+  FIELD_QTY = 1u << 3,
+  FIELD_TRADE_ID = 1u << 4,
+  FIELD_TIMESTAMP = 1u << 5,
+  FIELD_ALL = (1u << 6) - 1
+};
+
+bool ParseTradeObject(JsonCursor& cursor, TradeTick& trade) {
+  if (!cursor.EnterObject()) return false;
+
+  unsigned seen = 0;
+  std::string_view key;
+  std::string_view text;
+  int64_t integer;
+  // Parsed once the symbol and so its scale is known.
+  std::string_view price, qty;
+
+  while (cursor.NextKey(key)) {
+    if (key == "symbol" && cursor.ReadString(text)) {
+      trade.symbol = SymbolRegistry::Global().Find(text);
+      if (trade.symbol == kInvalidSymbol) {
+        trade.symbol = SymbolRegistry::Global().Intern(text);
+      }
+      if (trade.symbol != kInvalidSymbol) seen |= FIELD_SYMBOL;
+    } else if (key == "side" && cursor.ReadString(text)) {
+      if (text == "buy" || text == "sell") {
+        trade.side = text == "buy" ? TradeSide::BUY : TradeSide::SELL;
+        seen |= FIELD_SIDE;
+      }
+    } else if (key == "price" && cursor.ReadNumberText(price)) {
+      seen |= FIELD_PRICE;
+    } else if (key == "qty" && cursor.ReadNumberText(qty)) {
+      seen |= FIELD_QTY;
+    } else if (key == "trade_id" && cursor.ReadInt64(integer)) {
+      trade.trade_id = static_cast<uint64_t>(integer);
+      seen |= FIELD_TRADE_ID;
+    } else if (key == "timestamp" && cursor.ReadString(text)) {
+      if (ParseTimestampNanos(text.data(), text.size(), trade.timestamp)) {
+        seen |= FIELD_TIMESTAMP;
+      }
+    } else if (!cursor.Failed()) {
+      cursor.SkipValue();
+    }
+  }
+
+  if (cursor.Failed() || seen != FIELD_ALL) return false;
+
+  SymbolPrecision precision = MarketPrecision(trade.symbol);
+  return ParseMantissa(price, precision.price_decimals, trade.price) &&
+         ParseMantissa(qty, precision.qty_decimals, trade.qty);
+}
+
+bool ParseTradeArray(JsonCursor& cursor, TradeTick& scratch,
+                     const std::function<void(const TradeTick&)>& on_trade) {
+  if (!cursor.EnterArray()) return false;
+
+  while (cursor.NextElement()) {
+    if (!ParseTradeObject(cursor, scratch)) return false;
+    if (on_trade) on_trade(scratch);
+  }
+  return !cursor.Failed();
+}
+
+}  // namespace
+
+TradeParseResult ParseTradeMessage(const char* data, size_t length, TradeTick& scratch,
+                                   const std::function<void(const TradeTick&)>& on_trade) {
+  JsonCursor cursor(data, data + length);
+  if (!cursor.EnterObject()) return TradeParseResult::MALFORMED;
+
+  bool is_trade = false;
+  bool channel_seen = false;
+  bool parsed_data = false;
+  const char* deferred_data = nullptr;
+
+  std::string_view key;
+  while (cursor.NextKey(key)) {
+    if (key == "channel") {
+      std::string_view channel;
+      if (!cursor.ReadString(channel)) break;
+      channel_seen = true;
+      is_trade = channel == "trade";
+      if (!is_trade) return TradeParseResult::IGNORED;
+    } else if (key == "data" && channel_seen) {
+      if (!ParseTradeArray(cursor, scratch, on_trade)) return TradeParseResult::MALFORMED;
+      parsed_data = true;
+    } else if (key == "data") {
+      deferred_data = cursor.Position();
+      cursor.SkipValue();
+    } else {
+      cursor.SkipValue();
+    }
+  }
+
+  if (cursor.Failed()) return TradeParseResult::MALFORMED;
+  if (!is_trade) return TradeParseResult::IGNORED;
+
+  if (!parsed_data && deferred_data) {
+    JsonCursor data_cursor(deferred_data, data + length);
+    if (!ParseTradeArray(data_cursor, scratch, on_trade)) return TradeParseResult::MALFORMED;
+    parsed_data = true;
+  }
+
+  return parsed_data ? TradeParseResult::TRADES : TradeParseResult::IGNORED;
+}
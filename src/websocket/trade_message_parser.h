@@ -0,0 +1,21 @@
+#ifndef TRADE_MESSAGE_PARSER_H
+#define TRADE_MESSAGE_PARSER_H
+
+#include "../market_data/trade_tick.h"
+#include <cstddef>
+#include <functional>
+
+enum class TradeParseResult {
+  TRADES,
+  IGNORED,
+  MALFORMED
+};
+
+// Parses a raw Kraken v2 message and, if it is on the "trade" channel,
+// fills scratch with each entry of "data" and hands it to on_trade.
+// Nothing is allocated. Messages on other channels, acks and heartbeats
+// return IGNORED.
+TradeParseResult ParseTradeMessage(const char* data, size_t length, TradeTick& scratch,
+                                   const std::function<void(const TradeTick&)>& on_trade);
+
+#endif
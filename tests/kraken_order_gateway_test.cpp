@@ -0,0 +1,279 @@
+#include "backtest/synthetic_feed.h"
+#include "rest/kraken_base.h"
+#include "traders/spread_order_router.h"
+#include "websocket/kraken_order_gateway.h"
+#include "websocket/mock_kraken_server.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// OrderAck with its strings copied out of the gateway's slot.
+struct RecordedAck {
+    uint64_t req_id;
+    OrderState state;
+    OrderRequest request;
+    std::string order_id;
+    std::string error;
+};
+
+OrderRequest Market(const char* symbol, OrderSide side, int64_t quantity) {
+    OrderRequest order;
+    order.symbol = SymbolRegistry::Global().Intern(symbol);
+    order.side = side;
+    order.type = OrderType::MARKET;
+    order.quantity = Decimal{quantity, 8};
+    order.limit_price = Decimal{0, 0};
+    return order;
+}
+
+// A mock exchange and a gateway connected to it, each on its own thread.
+// Every test gets a fresh port so a closing listener never gets in the way.
+class OrderGatewayTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        static int next_port = 18765;
+        int port = next_port++;
+
+        feed_ = BuildMockFeed(GeneratePairCandles(10, "BTC/USD", "ETH/USD", 0), MockFeedOptions());
+        MockServerConfig config;
+        config.port = port;
+        config.heartbeat_interval_ms = 0;
+        server_ = std::make_unique<MockKrakenServer>(feed_, config);
+        server_->Start();
+        server_thread_ = std::thread([this]() { server_->Run(); });
+
+        // Never reached: the token comes from SetToken() and the refresh
+        // after a disconnect fails harmlessly.
+        rest_ = std::make_unique<KrakenBase>("", "", "http://127.0.0.1:9");
+        gateway_ = std::make_unique<KrakenOrderGateway>("ws://127.0.0.1:" + std::to_string(port), *rest_);
+        gateway_->SetToken("mock-token");
+        gateway_->SetOrderCallback([this](const OrderAck& ack) {
+            if (router_) router_->OnOrderAck(ack);
+            std::lock_guard<std::mutex> lock(mutex_);
+            acks_.push_back({ack.req_id, ack.state, ack.request, ack.order_id, ack.error});
+            changed_.notify_all();
+        });
+        gateway_->Connect();
+        gateway_thread_ = std::thread([this]() { gateway_->Run(); });
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!gateway_->IsConnected() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        ASSERT_TRUE(gateway_->IsConnected());
+    }
+
+    void TearDown() override {
+        gateway_->Stop();
+        if (gateway_thread_.joinable()) gateway_thread_.join();
+        server_->Stop();
+        if (server_thread_.joinable()) server_thread_.join();
+    }
+
+    // Waits until at least count acks arrived and returns them.
+    std::vector<RecordedAck> WaitForAcks(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait_for(lock, std::chrono::seconds(5), [&]() { return acks_.size() >= count; });
+        return acks_;
+    }
+
+    // Gives stray replies time to arrive, then returns everything so far.
+    std::vector<RecordedAck> SettledAcks() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        std::lock_guard<std::mutex> lock(mutex_);
+        return acks_;
+    }
+
+    MockFeed feed_;
+    std::unique_ptr<MockKrakenServer> server_;
+    std::thread server_thread_;
+    std::unique_ptr<KrakenBase> rest_;
+    std::unique_ptr<KrakenOrderGateway> gateway_;
+    std::thread gateway_thread_;
+    std::unique_ptr<SpreadOrderRouter> router_;
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<RecordedAck> acks_;
+};
+
+TEST_F(OrderGatewayTest, AcceptedOrderIsMatchedByReqId) {
+    uint64_t req_id = gateway_->AddOrder(Market("BTC/USD", OrderSide::BUY, 1000000));
+    ASSERT_NE(req_id, 0u);
+
+    std::vector<RecordedAck> acks = WaitForAcks(1);
+    ASSERT_EQ(acks.size(), 1u);
+    EXPECT_EQ(acks[0].req_id, req_id);
+    EXPECT_EQ(acks[0].state, OrderState::ACCEPTED);
+    EXPECT_EQ(acks[0].order_id.rfind("OMOCK-", 0), 0u);
+    EXPECT_EQ(acks[0].request.quantity.mantissa, 1000000);
+    EXPECT_EQ(gateway_->State(req_id), OrderState::ACCEPTED);
+}
+
+TEST_F(OrderGatewayTest, RejectedOrderCarriesTheError) {
+    server_->SetOrderMode(MockOrderMode::REJECT);
+    uint64_t req_id = gateway_->AddOrder(Market("BTC/USD", OrderSide::SELL, 1000000));
+    ASSERT_NE(req_id, 0u);
+
+    std::vector<RecordedAck> acks = WaitForAcks(1);
+    ASSERT_EQ(acks.size(), 1u);
+    EXPECT_EQ(acks[0].req_id, req_id);
+    EXPECT_EQ(acks[0].state, OrderState::REJECTED);
+    EXPECT_EQ(acks[0].error, "EOrder:Insufficient funds");
+}
+
+TEST_F(OrderGatewayTest, BatchAckFansOutToEveryOrder) {
+    OrderRequest orders[3] = {
+        Market("ETH/USD", OrderSide::BUY, 1000000),
+        Market("ETH/USD", OrderSide::BUY, 2000000),
+        Market("ETH/USD", OrderSide::SELL, 3000000),
+    };
+    uint64_t first = gateway_->BatchAdd(orders, 3);
+    ASSERT_NE(first, 0u);
+
+    std::vector<RecordedAck> acks = WaitForAcks(3);
+    ASSERT_EQ(acks.size(), 3u);
+    for (size_t i = 0; i < 3; i++) {
+        EXPECT_EQ(acks[i].req_id, first + i);
+        EXPECT_EQ(acks[i].state, OrderState::ACCEPTED);
+        EXPECT_EQ(acks[i].request.quantity.mantissa, orders[i].quantity.mantissa);
+    }
+    EXPECT_NE(acks[0].order_id, acks[1].order_id);
+    EXPECT_NE(acks[1].order_id, acks[2].order_id);
+}
+
+TEST_F(OrderGatewayTest, RejectedBatchRejectsEveryOrder) {
+    server_->SetOrderMode(MockOrderMode::REJECT);
+    OrderRequest orders[2] = {
+        Market("ETH/USD", OrderSide::BUY, 1000000),
+        Market("ETH/USD", OrderSide::BUY, 2000000),
+    };
+    uint64_t first = gateway_->BatchAdd(orders, 2);
+    ASSERT_NE(first, 0u);
+
+    std::vector<RecordedAck> acks = SettledAcks();
+    ASSERT_EQ(acks.size(), 2u);
+    EXPECT_EQ(acks[0].req_id, first);
+    EXPECT_EQ(acks[1].req_id, first + 1);
+    EXPECT_EQ(acks[0].state, OrderState::REJECTED);
+    EXPECT_EQ(acks[1].state, OrderState::REJECTED);
+}
+
+TEST_F(OrderGatewayTest, CancelsAnAcceptedOrder) {
+    uint64_t req_id = gateway_->AddOrder(Market("BTC/USD", OrderSide::BUY, 1000000));
+    ASSERT_EQ(WaitForAcks(1).size(), 1u);
+    ASSERT_EQ(gateway_->State(req_id), OrderState::ACCEPTED);
+
+    ASSERT_TRUE(gateway_->CancelOrder(req_id));
+    std::vector<RecordedAck> acks = WaitForAcks(2);
+    ASSERT_EQ(acks.size(), 2u);
+    EXPECT_EQ(acks[1].req_id, req_id);
+    EXPECT_EQ(acks[1].state, OrderState::CANCELLED);
+    EXPECT_EQ(gateway_->State(req_id), OrderState::CANCELLED);
+    // Already cancelled: nothing left to cancel.
+    EXPECT_FALSE(gateway_->CancelOrder(req_id));
+}
+
+TEST_F(OrderGatewayTest, InFlightOrderBecomesUnknownOnDisconnect) {
+    server_->SetOrderMode(MockOrderMode::DISCONNECT);
+    uint64_t req_id = gateway_->AddOrder(Market("BTC/USD", OrderSide::BUY, 1000000));
+    ASSERT_NE(req_id, 0u);
+
+    std::vector<RecordedAck> acks = WaitForAcks(1);
+    ASSERT_EQ(acks.size(), 1u);
+    EXPECT_EQ(acks[0].req_id, req_id);
+    EXPECT_EQ(acks[0].state, OrderState::UNKNOWN);
+    EXPECT_EQ(gateway_->State(req_id), OrderState::UNKNOWN);
+}
+
+TEST_F(OrderGatewayTest, SpreadSendsBothLegs) {
+    uint64_t req_ids[2];
+    ASSERT_TRUE(gateway_->AddSpread(Market("BTC/USD", OrderSide::BUY, 1000000),
+                                    Market("ETH/USD", OrderSide::SELL, 20000000), req_ids));
+    EXPECT_EQ(req_ids[1], req_ids[0] + 1);
+
+    std::vector<RecordedAck> acks = WaitForAcks(2);
+    ASSERT_EQ(acks.size(), 2u);
+    EXPECT_EQ(acks[0].state, OrderState::ACCEPTED);
+    EXPECT_EQ(acks[1].state, OrderState::ACCEPTED);
+}
+
+TEST_F(OrderGatewayTest, RouterUnwindsTheAcceptedLegWhenTheOtherIsRejected) {
+    router_ = std::make_unique<SpreadOrderRouter>(*gateway_, 0.01);
+    server_->SetOrderMode(MockOrderMode::ALTERNATE);
+
+    Trade entry = {};
+    entry.action = TradeAction::LONG_SPREAD;
+    entry.hedge_ratio = 2.0;
+    entry.y_symbol = SymbolRegistry::Global().Intern("BTC/USD");
+    entry.x_symbol = SymbolRegistry::Global().Intern("ETH/USD");
+    router_->OnTrade(entry);
+
+    // Y is accepted, X rejected, then Y is sold back.
+    std::vector<RecordedAck> acks = WaitForAcks(3);
+    ASSERT_EQ(acks.size(), 3u);
+    EXPECT_EQ(acks[0].state, OrderState::ACCEPTED);
+    EXPECT_EQ(acks[1].state, OrderState::REJECTED);
+    EXPECT_EQ(acks[2].state, OrderState::ACCEPTED);
+    EXPECT_EQ(acks[2].request.symbol, entry.y_symbol);
+    EXPECT_EQ(acks[2].request.side, OrderSide::SELL);
+    EXPECT_EQ(acks[2].request.quantity.mantissa, acks[0].request.quantity.mantissa);
+    EXPECT_FALSE(router_->Open());
+
+    // The model's EXIT finds nothing left to unwind.
+    Trade exit = entry;
+    exit.action = TradeAction::EXIT;
+    router_->OnTrade(exit);
+    EXPECT_EQ(SettledAcks().size(), 3u);
+}
+
+TEST_F(OrderGatewayTest, RouterNeverUnwindsRejectedLegs) {
+    router_ = std::make_unique<SpreadOrderRouter>(*gateway_, 0.01);
+    server_->SetOrderMode(MockOrderMode::REJECT);
+
+    Trade entry = {};
+    entry.action = TradeAction::SHORT_SPREAD;
+    entry.hedge_ratio = 2.0;
+    entry.y_symbol = SymbolRegistry::Global().Intern("BTC/USD");
+    entry.x_symbol = SymbolRegistry::Global().Intern("ETH/USD");
+    router_->OnTrade(entry);
+    ASSERT_EQ(WaitForAcks(2).size(), 2u);
+    EXPECT_FALSE(router_->Open());
+
+    Trade exit = entry;
+    exit.action = TradeAction::EXIT;
+    router_->OnTrade(exit);
+    EXPECT_EQ(SettledAcks().size(), 2u);
+}
+
+TEST_F(OrderGatewayTest, RouterUnwindsBothLegsOnExit) {
+    router_ = std::make_unique<SpreadOrderRouter>(*gateway_, 0.01);
+
+    Trade entry = {};
+    entry.action = TradeAction::LONG_SPREAD;
+    entry.hedge_ratio = -0.5;
+    entry.y_symbol = SymbolRegistry::Global().Intern("BTC/USD");
+    entry.x_symbol = SymbolRegistry::Global().Intern("ETH/USD");
+    router_->OnTrade(entry);
+    ASSERT_EQ(WaitForAcks(2).size(), 2u);
+    EXPECT_TRUE(router_->Open());
+
+    Trade exit = entry;
+    exit.action = TradeAction::EXIT;
+    router_->OnTrade(exit);
+    std::vector<RecordedAck> acks = WaitForAcks(4);
+    ASSERT_EQ(acks.size(), 4u);
+    // A negative hedge ratio buys both legs, so the exit sells both.
+    EXPECT_EQ(acks[2].request.side, OrderSide::SELL);
+    EXPECT_EQ(acks[3].request.side, OrderSide::SELL);
+    EXPECT_FALSE(router_->Open());
+}
+
+}  // namespace